@@ -64,6 +64,11 @@ LRESULT CALLBACK Application::WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARA
         case VK_SPACE: g_Instance->m_Game->m_ShakeStrength = 1.0; break;
         case '0': g_Instance->m_Game->m_FovStep = 0; break;
         case 'Z': g_Instance->m_Game->m_ZLess ^= true; break;
+        case 'B': g_Instance->m_Game->m_Bindless ^= true; break;
+        case 'L':
+            g_Instance->m_Game->m_FrameLatency
+                = g_Instance->m_Game->m_FrameLatency % FrameContexts::MAX_FRAME_LATENCY + 1;
+            break;
         case 'R':
             try
             {
@@ -1,6 +1,8 @@
 #include "Game.hpp"
 #include "Application.hpp"
 #include "MyDXLib/SceneData.hpp"
+#include "MyDXLib/StagingUploader.hpp"
+#include "MyDXLib/VertexCodec.hpp"
 
 using namespace DirectX;
 
@@ -49,9 +51,8 @@ Game::Game(Application *application, int width, int height)
       m_Width(width),
       m_Height(height)
 {
-    PDevice              device       = Application::Get()->GetDevice();
-    CommandQueue        &commandQueue = Application::Get()->GetCommandQueueCopy();
-    PGraphicsCommandList commandList  = commandQueue.ResetCommandList();
+    PDevice       device       = Application::Get()->GetDevice();
+    CommandQueue &commandQueue = Application::Get()->GetCommandQueueCopy();
 
     MeshData cubeData;
     MeshData fullScreenData;
@@ -63,24 +64,48 @@ Game::Game(Application *application, int width, int height)
     // sponzaData.LoadFromFile("C:\\Users\\asurk\\Documents\\3rd-party\\Main.1_Sponza\\NewSponza_Main_glTF_002.gltf");
     std::filesystem::path scenePath
         = std::filesystem::path(__FILE__).remove_filename() / "3rd-party" / "Sponza" / "glTF" / "Sponza.gltf";
-    sponzaData.LoadFromFile(scenePath);
+    SceneImportOptions importOptions;
+    importOptions.Importer       = SCENE_IMPORTER_GLTF;
+    importOptions.Format         = m_SponzaVertexFormat;
+    importOptions.OptimizeMeshes = true;
+    importOptions.NarrowIndices  = true;
+    importOptions.SplitMeshes    = true;
+    importOptions.BuildMeshlets  = true;
+    importOptions.GenerateLods   = true;
+    sponzaData.LoadFromFile(scenePath, importOptions);
+
+    StagingUploader upload(device, commandQueue);
+
+    m_GeometryHeap.emplace(device);
+    m_CubeMesh.QueryInit(*m_GeometryHeap, upload, cubeData);
+    m_ScreenMesh.QueryInit(*m_GeometryHeap, upload, fullScreenData);
 
-    ResourceUploadBatch upload(device.Get());
-    upload.Begin(D3D12_COMMAND_LIST_TYPE_COPY);
+    m_DSVHeap.emplace(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, 1);
+    m_UploadRing.emplace(device);
 
-    m_CubeMesh.QueryInit(device, upload, cubeData);
-    m_ScreenMesh.QueryInit(device, upload, fullScreenData);
+    // The scene's default texture and its textures, the filter's view of the color buffer is written every frame
+    m_Descriptors.emplace(device, 1 + sponzaData.TextureCount(), DescriptorAllocator::DEFAULT_TRANSIENT_COUNT);
 
-    m_DSVHeap.emplace(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, 1);
+    m_SponzaScene.QueryInit(device, upload, *m_GeometryHeap, *m_Descriptors, sponzaData);
+    // The scene staged its geometry, the CPU copy of the vertices and indices is not needed anymore
+    sponzaData.ReleaseGeometry();
 
-    m_TextureHeap.emplace(device.Get(),
-                          D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-                          D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
-                          1 + sponzaData.TextureCount());
+    HeapStats          heapStats = m_GeometryHeap->GetStats();
+    std::wstringstream ss;
+    ss << L"Geometry heaps: " << heapStats.Blocks << L" blocks, " << heapStats.Allocations << L" buffers, "
+       << heapStats.RequestedSize / 1024 << L" of " << heapStats.AllocatedSize / 1024 << L" KiB used, "
+       << 100.0 * heapStats.Fragmentation() << L"% of the free memory fragmented\n";
+    OutputDebugStringW(ss.str().c_str());
 
-    m_SponzaScene.QueryInit(device, upload, *m_TextureHeap, sponzaData);
     ReloadShaders();
-    upload.End(commandQueue.Get().Get()).wait();
+    upload.Finish();
+
+    UploadStats uploadStats = upload.GetStats();
+    ss.str(L"");
+    ss << L"Staging uploads: " << uploadStats.Bytes / 1024 << L" KiB in " << uploadStats.Copies << L" copies, "
+       << uploadStats.Submits << L" submits, " << uploadStats.CreatedChunks << L" chunks, "
+       << uploadStats.MegabytesPerSecond() << L" MB/s\n";
+    OutputDebugStringW(ss.str().c_str());
 
     m_ContentLoaded = true;
     ResizeBuffers(width, height);
@@ -95,11 +120,15 @@ void Game::ReloadShaders()
 
     PBlob objVertexCube   = m_ShaderCompiler.CompileVS(L"VertexCube.hlsl");
     PBlob objVertexFilter = m_ShaderCompiler.CompileVS(L"VertexFilter.hlsl");
-    PBlob objVertexSponza = m_ShaderCompiler.CompileVS(L"VertexSponza.hlsl");
+    PBlob objVertexSponza = m_ShaderCompiler.CompileVS(L"VertexSponza.hlsl",
+                                                       VertexCodec::ShaderDefines(m_SponzaVertexFormat));
     PBlob objPixelCube    = m_ShaderCompiler.CompilePS(L"PixelCube.hlsl");
     PBlob objPixelFilter  = m_ShaderCompiler.CompilePS(L"PixelFilter.hlsl");
     PBlob objPixelSponza  = m_ShaderCompiler.CompilePS(L"PixelSponza.hlsl");
 
+    // The pipelines and root signatures may still be used by frames in flight
+    Application::Get()->Flush();
+
     Assert(device->CreateRootSignature(0,
                                        objVertexCube->GetBufferPointer(),
                                        objVertexCube->GetBufferSize(),
@@ -124,28 +153,7 @@ void Game::ReloadShaders()
          D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
     };
 
-    D3D12_INPUT_ELEMENT_DESC inputLayoutSponza[] = {
-        {"POSITION",
-         0, DXGI_FORMAT_R32G32B32_FLOAT,
-         0, D3D12_APPEND_ALIGNED_ELEMENT,
-         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        {"NORMAL",
-         0, DXGI_FORMAT_R32G32B32_FLOAT,
-         0, D3D12_APPEND_ALIGNED_ELEMENT,
-         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        {"TANGENT",
-         0, DXGI_FORMAT_R32G32B32_FLOAT,
-         0, D3D12_APPEND_ALIGNED_ELEMENT,
-         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        {"BITANGENT",
-         0, DXGI_FORMAT_R32G32B32_FLOAT,
-         0, D3D12_APPEND_ALIGNED_ELEMENT,
-         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        {"UV",
-         0, DXGI_FORMAT_R32G32_FLOAT,
-         0, D3D12_APPEND_ALIGNED_ELEMENT,
-         D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-    };
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayoutSponza = VertexCodec::InputLayout(m_SponzaVertexFormat);
 
     D3D12_INPUT_ELEMENT_DESC inputLayoutFilter[] = {
         {"UV",
@@ -192,8 +200,8 @@ void Game::ReloadShaders()
     gpsDesc.RasterizerState   = CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT());
     gpsDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(CD3DX12_DEFAULT());
 
-    gpsDesc.InputLayout.pInputElementDescs = inputLayoutSponza;
-    gpsDesc.InputLayout.NumElements        = _countof(inputLayoutSponza);
+    gpsDesc.InputLayout.pInputElementDescs = inputLayoutSponza.data();
+    gpsDesc.InputLayout.NumElements        = static_cast<UINT>(inputLayoutSponza.size());
     gpsDesc.PrimitiveTopologyType          = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     gpsDesc.NumRenderTargets               = 1;
     gpsDesc.RTVFormats[0]                  = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -277,6 +285,11 @@ void Game::ResizeBuffers(int width, int height)
         &depthClearValue,
         IID_PPV_ARGS(m_DepthBuffer.ReleaseAndGetAddressOf())));
 
+    // The swap chain recreated the back buffers as well, they are registered again when they are first drawn to
+    m_ResourceStates.Clear();
+    m_ResourceStates.SetState(m_ColorBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ);
+    m_ResourceStates.SetState(m_DepthBuffer.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
     D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
     rtvDesc.Format                        = DXGI_FORMAT_R8G8B8A8_UNORM;
     rtvDesc.ViewDimension                 = D3D12_RTV_DIMENSION_TEXTURE2D;
@@ -288,18 +301,8 @@ void Game::ResizeBuffers(int width, int height)
     dsvDesc.Texture2D.MipSlice            = 0;
     dsvDesc.Flags                         = D3D12_DSV_FLAG_NONE;
 
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format                          = DXGI_FORMAT_R8G8B8A8_UNORM;
-    srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.Texture2D.MostDetailedMip       = 0;
-    srvDesc.Texture2D.MipLevels             = -1;
-    srvDesc.Texture2D.PlaneSlice            = 0;
-    srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
-
     device->CreateRenderTargetView(m_ColorBuffer.Get(), &rtvDesc, Application::Get()->IntermediateRTV());
     device->CreateDepthStencilView(m_DepthBuffer.Get(), &dsvDesc, m_DSVHeap->GetFirstCpuHandle());
-    device->CreateShaderResourceView(m_ColorBuffer.Get(), &srvDesc, m_TextureHeap->GetFirstCpuHandle());
 }
 
 void Game::OnResize(int width, int height)
@@ -367,10 +370,31 @@ void Game::OnUpdate()
     if (elapsedSeconds > 1.0)
     {
         std::wstringstream ss;
-        ss << L"TPS: " << frameCounter / elapsedSeconds << '\n';
+        ss << L"TPS: " << frameCounter / elapsedSeconds;
+        if (m_DrawnFrames != 0)
+        {
+            size_t rejected = m_DrawStats.CulledDraws + m_DrawStats.OccludedDraws;
+            ss << L", draws " << m_DrawStats.Draws / m_DrawnFrames << L", instanced "
+               << m_DrawStats.InstancedDraws / m_DrawnFrames << L", culled "
+               << m_DrawStats.CulledDraws / m_DrawnFrames << L", occluded "
+               << m_DrawStats.OccludedDraws / m_DrawnFrames << L", rejected "
+               << 100.0 * rejected / (std::max)(m_DrawStats.TotalDraws(), size_t(1)) << L"%, culling "
+               << m_DrawStats.CullingMilliseconds / m_DrawnFrames << L" ms, occlusion "
+               << m_DrawStats.OcclusionMilliseconds / m_DrawnFrames << L" ms, sort "
+               << m_DrawStats.SortMilliseconds / m_DrawnFrames << L" ms, transforms "
+               << m_DrawStats.UpdatedTransforms / m_DrawnFrames << L", barriers "
+               << m_BarrierStats.Barriers / m_DrawnFrames << L" in " << m_BarrierStats.BarrierCalls / m_DrawnFrames
+               << L" calls, latency " << m_Frames.GetLatency()
+               << L", GPU wait " << m_FrameWaitMilliseconds / m_DrawnFrames << L" ms";
+        }
+        ss << '\n';
         OutputDebugStringW(ss.str().c_str());
-        frameCounter = 0;
-        tSecond      = t1;
+        frameCounter            = 0;
+        tSecond                 = t1;
+        m_DrawStats             = {};
+        m_BarrierStats          = {};
+        m_FrameWaitMilliseconds = 0.0;
+        m_DrawnFrames           = 0;
     }
 
     double   timeTotal    = std::chrono::duration<double>(t1 - epoch).count();
@@ -404,8 +428,13 @@ void Game::OnUpdate()
 
 void Game::OnRender()
 {
-    CommandQueue        &commandQueue = Application::Get()->GetCommandQueueDirect();
-    PGraphicsCommandList commandList  = commandQueue.ResetCommandList();
+    CommandQueue &commandQueue = Application::Get()->GetCommandQueueDirect();
+
+    m_Frames.SetLatency(m_FrameLatency);
+    m_Frames.Begin(commandQueue);
+    m_FrameWaitMilliseconds += m_Frames.GetWaitMilliseconds();
+    m_UploadRing->Retire(commandQueue.GetCompletedFenceValue());
+    m_Descriptors->Retire(commandQueue.GetCompletedFenceValue());
 
     UINT      currentBackBufferIndex = Application::Get()->GetCurrentBackBufferIndex();
     PResource backBuffer             = Application::Get()->GetCurrentBackBuffer();
@@ -413,23 +442,49 @@ void Game::OnRender()
     auto      rtv                    = Application::Get()->IntermediateRTV();
     auto      dsv                    = m_DSVHeap->GetFirstCpuHandle();
 
-    ID3D12DescriptorHeap *const heapsToSet[] = {m_TextureHeap->Heap()};
-    commandList->SetDescriptorHeaps(1, heapsToSet);
+    XMMATRIX viewMatrix       = m_Camera.CalcMatrix();
+    XMMATRIX projectionMatrix = m_Camera.CalcProjection();
+    // XMMATRIX mvpMatrix        = m_ModelMatrix * cameraMatrix;
 
-    TransitionResource(
-        commandList, m_ColorBuffer, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_RENDER_TARGET);
-    TransitionResource(commandList, backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_SponzaScene.SetLodTarget(static_cast<float>(m_Height));
+    m_SponzaScene.SetBindless(m_Bindless);
+    m_SponzaScene.Prepare(*m_UploadRing,
+                          (m_ZLess ? m_PipelineStateSponzaLess : m_PipelineStateSponzaGreater).Get(),
+                          XMMatrixIdentity(),
+                          viewMatrix,
+                          projectionMatrix);
+    m_DrawStats += m_SponzaScene.GetStats();
+    ++m_DrawnFrames;
+
+    // The frame is submitted as one list clearing the targets, the scene chunks and one list for the filter
+    size_t chunkCount   = m_SceneRecorder.ChunkCount(m_SponzaScene.GetDrawCount());
+    auto   commandLists = commandQueue.ResetCommandLists(chunkCount + 2);
+
+    ID3D12DescriptorHeap *const heapsToSet[] = {m_Descriptors->Heap()};
+
+    CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_Width), static_cast<float>(m_Height));
+    for (auto &&commandList : commandLists)
+    {
+        commandList->SetDescriptorHeaps(1, heapsToSet);
+        commandList->RSSetViewports(1, &viewport);
+        commandList->RSSetScissorRects(1, &m_ScissorRect);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+
+    PGraphicsCommandList commandList = commandLists.front();
+    D3D12RenderBackend   clearBackend(commandList);
+
+    // Back buffers are only ever left in the present state
+    if (!m_ResourceStates.IsTracked(backBuffer.Get()))
+        m_ResourceStates.SetState(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+    m_ResourceStates.Transition(m_ColorBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_ResourceStates.Transition(backBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    m_ResourceStates.Flush(clearBackend);
 
     FLOAT clearColor[] = {1.0f, 0.75f, 0.5f, 1.0f};
     commandList->ClearRenderTargetView(rtv, clearColor, 0, nullptr);
     commandList->ClearRenderTargetView(outRtv, clearColor, 0, nullptr);
 
-    CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_Width), static_cast<float>(m_Height));
-    commandList->RSSetViewports(1, &viewport);
-    commandList->RSSetScissorRects(1, &m_ScissorRect);
-    commandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
     if (m_ZLess)
     {
         commandList->SetPipelineState(m_PipelineStateCubeLess.Get());
@@ -442,33 +497,52 @@ void Game::OnRender()
     }
 
     commandList->SetGraphicsRootSignature(m_RootSignatureCube.Get());
-
-    XMMATRIX viewMatrix       = m_Camera.CalcMatrix();
-    XMMATRIX projectionMatrix = m_Camera.CalcProjection();
-    // XMMATRIX mvpMatrix        = m_ModelMatrix * cameraMatrix;
     // m_CubeMesh.Draw(commandList);
 
-    commandList->SetPipelineState((m_ZLess ? m_PipelineStateSponzaLess : m_PipelineStateSponzaGreater).Get());
-    commandList->SetGraphicsRootSignature(m_RootSignatureSponza.Get());
-    // commandList->SetGraphicsRoot32BitConstants(0, 16, &viewMatrix, 16);
-    // commandList->SetGraphicsRoot32BitConstants(0, 16, &projectionMatrix, 32);
-    // commandList->SetGraphicsRoot32BitConstants(0, 16, &cameraMatrix, 0);
-    m_SponzaScene.Draw(commandList, XMMatrixIdentity(), viewMatrix, projectionMatrix);
+    // Every chunk of the scene is recorded on a thread of its own into the list after the previous chunk
+
+    std::vector<D3D12RenderBackend> chunkBackends;
+    std::vector<RenderBackend *>    backends;
+    chunkBackends.reserve(chunkCount);
+    for (size_t i = 1; i <= chunkCount; ++i)
+    {
+        commandLists[i]->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+        commandLists[i]->SetGraphicsRootSignature(m_RootSignatureSponza.Get());
+        backends.push_back(&chunkBackends.emplace_back(commandLists[i]));
+    }
+    m_SceneRecorder.Record(
+        m_SponzaScene.GetDrawCount(), backends, [&](RenderCommands &commands, size_t begin, size_t end) {
+            m_SponzaScene.Record(commands, begin, end);
+        });
+
+    commandList = commandLists.back();
+    D3D12RenderBackend backend(commandList);
 
-    TransitionResource(
-        commandList, m_ColorBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_GENERIC_READ);
+    m_ResourceStates.Transition(m_ColorBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ);
+    m_ResourceStates.Flush(backend);
 
     commandList->OMSetRenderTargets(1, &outRtv, FALSE, nullptr);
     commandList->SetPipelineState(m_PipelineStateFilter.Get());
     commandList->SetGraphicsRootSignature(m_RootSignatureFilter.Get());
 
-    commandList->SetGraphicsRootDescriptorTable(1, m_TextureHeap->GetFirstGpuHandle());
-
-    m_ScreenMesh.Draw(commandList);
-
-    TransitionResource(commandList, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-
-    UINT64 fenceValue = commandQueue.ExecuteCommandList(commandList);
+    // A resize may replace the color buffer, so its view is written into a transient descriptor every frame
+    size_t colorBufferDescriptor = m_Descriptors->AllocateTransient();
+    Application::Get()->GetDevice()->CreateShaderResourceView(
+        m_ColorBuffer.Get(), nullptr, m_Descriptors->GetCpuHandle(colorBufferDescriptor));
+    commandList->SetGraphicsRootDescriptorTable(1, m_Descriptors->GetGpuHandle(colorBufferDescriptor));
+
+    m_RenderCommands.Clear();
+    m_ScreenMesh.Draw(m_RenderCommands);
+    m_RenderCommands.Replay(backend);
+
+    m_ResourceStates.Transition(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
+    m_ResourceStates.Flush(backend);
+    m_BarrierStats += m_ResourceStates.GetStats();
+    m_ResourceStates.ResetStats();
+
+    UINT64 fenceValue = commandQueue.ExecuteCommandLists(commandLists);
+    m_Frames.End(fenceValue);
+    m_UploadRing->EndFrame(fenceValue);
+    m_Descriptors->EndFrame(fenceValue);
     Application::Get()->Present();
-    commandQueue.WaitForFenceValue(fenceValue);
 }
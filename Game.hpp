@@ -3,6 +3,9 @@
 #include "pch.hpp"
 
 #include "MyDXLib/Camera.hpp"
+#include "MyDXLib/FrameContext.hpp"
+#include "MyDXLib/ParallelRecorder.hpp"
+#include "MyDXLib/ResourceStateTracker.hpp"
 #include "MyDXLib/Scene.hpp"
 #include "MyDXLib/ShaderCompiler.hpp"
 #include "MyDXLib/Utils.hpp"
@@ -11,15 +14,37 @@ class Application;
 
 class Game
 {
+    // Declared before the meshes, which free their buffers into it
+    std::optional<HeapAllocator> m_GeometryHeap;
+
     Mesh  m_CubeMesh;
     Mesh  m_ScreenMesh;
     Scene m_SponzaScene;
 
+    // Recorded by the meshes drawn outside the scene, replayed into the command list right away
+    RenderCommands   m_RenderCommands;
+    ParallelRecorder m_SceneRecorder;
+
+    // Summed over the frames rendered since the last report in OnUpdate
+    SceneDrawStats m_DrawStats;
+    BarrierStats   m_BarrierStats;
+    double         m_FrameWaitMilliseconds = 0.0;
+    uint64_t       m_DrawnFrames           = 0;
+
+    FrameContexts m_Frames;
+
+    // Has to be set before the constructor loads the scene and compiles the shaders
+    VertexFormat m_SponzaVertexFormat = VERTEX_FORMAT_QUANTIZED;
+
     PResource m_ColorBuffer;
     PResource m_DepthBuffer;
 
-    std::optional<DescriptorHeap> m_DSVHeap;
-    std::optional<DescriptorHeap> m_TextureHeap;
+    // The render targets and back buffers, all transitions of the frame go through it
+    ResourceStateTracker m_ResourceStates;
+
+    std::optional<DescriptorHeap>      m_DSVHeap;
+    std::optional<UploadRing>          m_UploadRing; // Constants of the frames in flight
+    std::optional<DescriptorAllocator> m_Descriptors;
 
     ShaderCompiler m_ShaderCompiler{std::move(std::filesystem::path(__FILE__).remove_filename())};
 
@@ -61,19 +86,11 @@ class Game
     int    m_FovStep       = 0;
     double m_ShakeStrength = 0.0;
     bool   m_ZLess         = true;
+    size_t m_FrameLatency  = FrameContexts::DEFAULT_FRAME_LATENCY;
+    bool   m_Bindless      = true;
 
     bool m_MoveForward = false;
     bool m_MoveBack    = false;
     bool m_MoveLeft    = false;
     bool m_MoveRight   = false;
-
-    void TransitionResource(PGraphicsCommandList  commandList,
-                            PResource             resource,
-                            D3D12_RESOURCE_STATES beforeState,
-                            D3D12_RESOURCE_STATES afterState)
-    {
-        CD3DX12_RESOURCE_BARRIER barrier
-            = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), beforeState, afterState);
-        commandList->ResourceBarrier(1, &barrier);
-    }
 };
@@ -1 +1,59 @@
 #include "CommandQueue.hpp"
+
+PGraphicsCommandList CommandQueue::ResetCommandList()
+{
+    PCommandAllocator allocator;
+    if (!m_CommandAllocatorQueue.empty() && IsFenceComplete(m_CommandAllocatorQueue.front().FenceValue))
+    {
+        allocator = std::move(m_CommandAllocatorQueue.front().Allocator);
+        m_CommandAllocatorQueue.pop_front();
+        Assert(allocator->Reset());
+    }
+    else
+    {
+        Assert(m_Device->CreateCommandAllocator(m_CommandListType, IID_PPV_ARGS(&allocator)));
+    }
+
+    PGraphicsCommandList commandList;
+    if (!m_CommandListQueue.empty())
+    {
+        commandList = std::move(m_CommandListQueue.front());
+        m_CommandListQueue.pop_front();
+        Assert(commandList->Reset(allocator.Get(), nullptr));
+    }
+    else
+    {
+        Assert(m_Device->CreateCommandList(
+            0, m_CommandListType, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+    }
+
+    m_RecordingLists.emplace_back(commandList, std::move(allocator));
+    return commandList;
+}
+
+UINT64 CommandQueue::ExecuteCommandLists(const std::vector<PGraphicsCommandList> &commandLists)
+{
+    std::vector<ID3D12CommandList *> lists;
+    lists.reserve(commandLists.size());
+    for (auto &&commandList : commandLists)
+    {
+        Assert(commandList->Close());
+        lists.push_back(commandList.Get());
+    }
+    m_CommandQueue->ExecuteCommandLists(static_cast<UINT>(lists.size()), lists.data());
+
+    UINT64 fenceValue = Signal();
+    for (auto &&commandList : commandLists)
+    {
+        auto it = std::find_if(m_RecordingLists.begin(), m_RecordingLists.end(), [&](auto &&recording) {
+            return recording.first == commandList;
+        });
+        if (it == m_RecordingLists.end())
+            throw std::exception("Command list wasn't reset by this queue");
+
+        m_CommandAllocatorQueue.push_back({fenceValue, std::move(it->second)});
+        m_CommandListQueue.push_back(std::move(it->first));
+        m_RecordingLists.erase(it);
+    }
+    return fenceValue;
+}
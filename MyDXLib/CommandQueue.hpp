@@ -8,13 +8,25 @@ class CommandQueue
 {
     PDevice                 m_Device;
     D3D12_COMMAND_LIST_TYPE m_CommandListType;
-    PCommandAllocator       m_Allocator;
-    PGraphicsCommandList    m_CommandList;
     PCommandQueue           m_CommandQueue;
     PFence                  m_Fence;
     UINT64                  m_FenceValue = 0;
     HANDLE                  m_FenceEvent = nullptr;
 
+    struct CommandAllocatorEntry
+    {
+        UINT64            FenceValue; // Signaled after the last submission of commands recorded into the allocator
+        PCommandAllocator Allocator;
+    };
+
+    // Submitted allocators, oldest first. One is reused once its fence value completes, until then the
+    // pool grows. Command lists can be reset as soon as they are submitted, so they aren't tracked.
+    std::deque<CommandAllocatorEntry> m_CommandAllocatorQueue;
+    std::deque<PGraphicsCommandList>  m_CommandListQueue;
+
+    // Lists handed out by ResetCommandList and not submitted yet, with the allocator they record into
+    std::vector<std::pair<PGraphicsCommandList, PCommandAllocator>> m_RecordingLists;
+
   public:
     CommandQueue(PDevice device, D3D12_COMMAND_LIST_TYPE type)
         : m_Device(device),
@@ -32,22 +44,22 @@ class CommandQueue
         m_FenceEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
         if (!m_FenceEvent)
             throw std::exception("Failed to create fence event");
-
-        Assert(m_Device->CreateCommandAllocator(m_CommandListType, IID_PPV_ARGS(&m_Allocator)));
-        Assert(m_Device->CreateCommandList(
-            0, m_CommandListType, m_Allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandList)));
-        Assert(m_CommandList->Close());
     }
 
     ~CommandQueue() { CloseHandle(m_FenceEvent); }
 
     PCommandQueue Get() const noexcept { return m_CommandQueue; }
 
-    PGraphicsCommandList ResetCommandList() const
+    // Takes a command list and an allocator whose commands the GPU has finished from the pools, creating them
+    // when there are none. Every list has an allocator of its own, so lists can be recorded on different threads.
+    PGraphicsCommandList ResetCommandList();
+
+    std::vector<PGraphicsCommandList> ResetCommandLists(size_t count)
     {
-        Assert(m_Allocator->Reset());
-        Assert(m_CommandList->Reset(m_Allocator.Get(), nullptr));
-        return m_CommandList;
+        std::vector<PGraphicsCommandList> commandLists(count);
+        for (auto &&commandList : commandLists)
+            commandList = ResetCommandList();
+        return commandLists;
     }
 
     PSwapChain CreateSwapChain(
@@ -76,19 +88,11 @@ class CommandQueue
         return chain4;
     }
 
-    UINT64 ExecuteCommandList(PGraphicsCommandList commandList)
-    {
-        Assert(commandList->Close());
-
-        ID3D12CommandList *const commandLists[] = {commandList.Get()};
-        m_CommandQueue->ExecuteCommandLists(1, commandLists);
+    UINT64 ExecuteCommandList(PGraphicsCommandList commandList) { return ExecuteCommandLists({commandList}); }
 
-        UINT64 fenceValue = Signal();
-        // m_CommandAllocatorQueue.push(CommandAllocatorEntry {fenceValue, allocator});
-        // m_CommandListQueue.push(commandList);
-        // allocator->Release();
-        return fenceValue;
-    }
+    // Closes the lists and submits them in order with a single ExecuteCommandLists. Their allocators
+    // go back to the pool tagged with the returned fence value.
+    UINT64 ExecuteCommandLists(const std::vector<PGraphicsCommandList> &commandLists);
 
     UINT64 Signal()
     {
@@ -97,7 +101,8 @@ class CommandQueue
         return fenceValueForSignal;
     }
 
-    bool IsFenceComplete(UINT64 fenceValue) { return m_Fence->GetCompletedValue() >= fenceValue; }
+    UINT64 GetCompletedFenceValue() { return m_Fence->GetCompletedValue(); }
+    bool   IsFenceComplete(UINT64 fenceValue) { return GetCompletedFenceValue() >= fenceValue; }
 
     void WaitForFenceValue(UINT64 fenceValue, DWORD milliseconds = DWORD_MAX)
     {
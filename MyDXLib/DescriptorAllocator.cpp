@@ -0,0 +1,139 @@
+#include "DescriptorAllocator.hpp"
+
+DescriptorRangeAllocator::DescriptorRangeAllocator(size_t persistentCount, size_t transientCount)
+    : m_PersistentCount(persistentCount),
+      m_FreeCount(persistentCount),
+      m_Transient(transientCount)
+{
+    if (persistentCount != 0)
+        m_FreeRanges.push_back({0, persistentCount});
+}
+
+size_t DescriptorRangeAllocator::AllocatePersistent(size_t count)
+{
+    auto it = std::find_if(
+        m_FreeRanges.begin(), m_FreeRanges.end(), [count](const FreeRange &range) { return range.Count >= count; });
+    if (count == 0 || it == m_FreeRanges.end())
+        return INVALID_INDEX;
+
+    size_t index = it->Begin;
+    if (it->Count == count)
+        m_FreeRanges.erase(it);
+    else
+        *it = {index + count, it->Count - count};
+    m_FreeCount -= count;
+    return index;
+}
+
+void DescriptorRangeAllocator::CheckPersistent(size_t index, size_t count) const
+{
+    if (index > m_PersistentCount || count > m_PersistentCount - index)
+        throw std::exception("Freed descriptors are outside of the persistent range");
+}
+
+void DescriptorRangeAllocator::Free(size_t index, size_t count)
+{
+    if (count == 0)
+        return;
+    CheckPersistent(index, count);
+
+    // The range has to end before the next free range and start after the previous one
+    auto next = std::upper_bound(m_FreeRanges.begin(), m_FreeRanges.end(), index, [](size_t i, const FreeRange &range) {
+        return i < range.Begin;
+    });
+    bool mergePrevious = false;
+    bool mergeNext     = false;
+    if (next != m_FreeRanges.end())
+    {
+        if (index + count > next->Begin)
+            throw std::exception("Freed descriptors are already free");
+        mergeNext = index + count == next->Begin;
+    }
+    if (next != m_FreeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->Begin + previous->Count > index)
+            throw std::exception("Freed descriptors are already free");
+        mergePrevious = previous->Begin + previous->Count == index;
+    }
+    m_FreeCount += count;
+
+    if (mergePrevious && mergeNext)
+    {
+        std::prev(next)->Count += count + next->Count;
+        m_FreeRanges.erase(next);
+    }
+    else if (mergePrevious)
+    {
+        std::prev(next)->Count += count;
+    }
+    else if (mergeNext)
+    {
+        *next = {index, next->Count + count};
+    }
+    else
+    {
+        m_FreeRanges.insert(next, {index, count});
+    }
+}
+
+void DescriptorRangeAllocator::FreeDeferred(size_t index, size_t count)
+{
+    if (count == 0)
+        return;
+    CheckPersistent(index, count);
+    m_FrameFrees.push_back({index, count});
+}
+
+void DescriptorRangeAllocator::EndFrame(UINT64 fenceValue)
+{
+    if (!m_FrameFrees.empty())
+        m_DeferredFrees.push_back({fenceValue, std::exchange(m_FrameFrees, {})});
+    m_Transient.EndFrame(fenceValue);
+}
+
+void DescriptorRangeAllocator::Retire(UINT64 completedFenceValue)
+{
+    while (!m_DeferredFrees.empty() && m_DeferredFrees.front().FenceValue <= completedFenceValue)
+    {
+        for (auto &&range : m_DeferredFrees.front().Ranges)
+            Free(range.Begin, range.Count);
+        m_DeferredFrees.pop_front();
+    }
+    m_Transient.Retire(completedFenceValue);
+}
+
+size_t DescriptorRangeAllocator::AllocateTransient(size_t count)
+{
+    if (count == 0)
+        return INVALID_INDEX;
+    size_t offset = m_Transient.Allocate(count, 1);
+    if (offset == RingAllocator::INVALID_OFFSET)
+        return INVALID_INDEX;
+    return m_PersistentCount + offset;
+}
+
+DescriptorAllocator::DescriptorAllocator(PDevice device, size_t persistentCount, size_t transientCount)
+    : m_Heap(device.Get(),
+             D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+             D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
+             persistentCount + transientCount),
+      m_Ranges(persistentCount, transientCount)
+{
+}
+
+size_t DescriptorAllocator::AllocatePersistent(size_t count)
+{
+    size_t index = m_Ranges.AllocatePersistent(count);
+    if (index == DescriptorRangeAllocator::INVALID_INDEX)
+        throw std::exception("Descriptor heap is full");
+    return index;
+}
+
+size_t DescriptorAllocator::AllocateTransient(size_t count)
+{
+    size_t index = m_Ranges.AllocateTransient(count);
+    if (index == DescriptorRangeAllocator::INVALID_INDEX)
+        throw std::exception("Transient descriptors are used up");
+    return index;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "UploadRing.hpp"
+
+// Index ranges of a descriptor heap, kept apart from the heap itself. The first persistentCount indices are
+// handed out first fit from a list of free ranges that merges neighbours when they are freed. The transientCount
+// indices after them form a ring for descriptors written every frame, retired by fence like UploadRing.
+// Persistent ranges the GPU may still read are freed deferred, they go back to the list with the frame's retirement.
+class DescriptorRangeAllocator
+{
+    struct FreeRange
+    {
+        size_t Begin;
+        size_t Count;
+    };
+    struct DeferredFrees
+    {
+        UINT64                 FenceValue;
+        std::vector<FreeRange> Ranges;
+    };
+    std::vector<FreeRange>    m_FreeRanges; // Sorted by Begin, never touching each other
+    std::vector<FreeRange>    m_FrameFrees; // Deferred since the last EndFrame
+    std::deque<DeferredFrees> m_DeferredFrees;
+    size_t                    m_PersistentCount;
+    size_t                    m_FreeCount;
+    RingAllocator             m_Transient;
+
+    void CheckPersistent(size_t index, size_t count) const;
+
+  public:
+    static constexpr size_t INVALID_INDEX = SIZE_MAX;
+
+    DescriptorRangeAllocator(size_t persistentCount, size_t transientCount);
+
+    // INVALID_INDEX when no free range holds count descriptors
+    size_t AllocatePersistent(size_t count);
+    // Throws when a part of the range is not allocated
+    void Free(size_t index, size_t count);
+    // Frees the range once the frame ended by the next EndFrame is retired. Ranges outside of the persistent
+    // indices throw right away, ranges that aren't allocated when Retire frees them.
+    void FreeDeferred(size_t index, size_t count);
+
+    // INVALID_INDEX when the frames in flight use up the ring
+    size_t AllocateTransient(size_t count);
+    void   EndFrame(UINT64 fenceValue);
+    void   Retire(UINT64 completedFenceValue);
+
+    size_t GetCapacity() const noexcept { return m_PersistentCount + m_Transient.GetCapacity(); }
+    size_t GetPersistentCount() const noexcept { return m_PersistentCount; }
+    size_t GetFreePersistentCount() const noexcept { return m_FreeCount; }
+    size_t GetUsedTransientCount() const noexcept { return m_Transient.GetUsedSize(); }
+};
+
+// Shader visible CBV/SRV/UAV heap handed out by a DescriptorRangeAllocator. Shaders that index the whole heap
+// see the descriptors at the indices returned here.
+class DescriptorAllocator
+{
+    DescriptorHeap           m_Heap;
+    DescriptorRangeAllocator m_Ranges;
+
+  public:
+    static constexpr size_t DEFAULT_TRANSIENT_COUNT = 1024;
+
+    DescriptorAllocator(PDevice device, size_t persistentCount, size_t transientCount);
+
+    // Throw when the heap is full
+    size_t AllocatePersistent(size_t count = 1);
+    size_t AllocateTransient(size_t count = 1);
+    // The descriptors are reused once the frame freeing them is retired, frames in flight may still read them
+    void   Free(size_t index, size_t count = 1) { m_Ranges.FreeDeferred(index, count); }
+
+    // The transient descriptors and the persistent ones freed since the last EndFrame may be overwritten once
+    // the fence reaches fenceValue
+    void EndFrame(UINT64 fenceValue) { m_Ranges.EndFrame(fenceValue); }
+    void Retire(UINT64 completedFenceValue) { m_Ranges.Retire(completedFenceValue); }
+
+    ID3D12DescriptorHeap       *Heap() const noexcept { return m_Heap.Heap(); }
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(size_t index) const { return m_Heap.GetCpuHandle(index); }
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(size_t index) const { return m_Heap.GetGpuHandle(index); }
+
+    const DescriptorRangeAllocator &GetRanges() const noexcept { return m_Ranges; }
+};
@@ -0,0 +1,59 @@
+#include "DrawList.hpp"
+
+namespace
+{
+    constexpr size_t DIGIT_BITS  = 8;
+    constexpr size_t DIGIT_COUNT = 64 / DIGIT_BITS;
+    constexpr size_t RADIX       = size_t(1) << DIGIT_BITS;
+} // namespace
+
+uint64_t DrawList::MakeKey(uint32_t pipeline, uint32_t material, float viewDepth) noexcept
+{
+    // The bits of a non-negative float sort like its value, the sign bit is always clear
+    uint32_t depthBits = 0;
+    if (viewDepth > 0.0f)
+        std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+
+    uint64_t depth = depthBits >> (31 - DEPTH_BITS);
+    uint64_t key   = pipeline & ((uint64_t(1) << PIPELINE_BITS) - 1);
+    key            = (key << MATERIAL_BITS) | (material & ((uint64_t(1) << MATERIAL_BITS) - 1));
+    return (key << DEPTH_BITS) | depth;
+}
+
+uint32_t DrawList::PipelineId(ID3D12PipelineState *pipeline)
+{
+    auto it = std::find(m_Pipelines.begin(), m_Pipelines.end(), pipeline);
+    if (it != m_Pipelines.end())
+        return static_cast<uint32_t>(it - m_Pipelines.begin());
+
+    if (m_Pipelines.size() == size_t(1) << PIPELINE_BITS)
+        throw std::exception("Too many pipelines for the draw list sort key");
+    m_Pipelines.push_back(pipeline);
+    return static_cast<uint32_t>(m_Pipelines.size() - 1);
+}
+
+void DrawList::Sort()
+{
+    if (m_Packets.size() < 2)
+        return;
+
+    // One pass builds the histograms of all digits
+    size_t histograms[DIGIT_COUNT][RADIX] = {};
+    for (auto &&packet : m_Packets)
+        for (size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+            ++histograms[digit][(packet.SortKey >> (digit * DIGIT_BITS)) & (RADIX - 1)];
+
+    m_Scratch.resize(m_Packets.size());
+    for (size_t digit = 0; digit < DIGIT_COUNT; ++digit)
+    {
+        size_t *histogram = histograms[digit];
+        size_t  shift     = digit * DIGIT_BITS;
+        if (histogram[(m_Packets[0].SortKey >> shift) & (RADIX - 1)] == m_Packets.size())
+            continue;
+
+        std::exclusive_scan(histogram, histogram + RADIX, histogram, size_t(0));
+        for (auto &&packet : m_Packets)
+            m_Scratch[histogram[(packet.SortKey >> shift) & (RADIX - 1)]++] = packet;
+        m_Packets.swap(m_Scratch);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "pch.hpp"
+
+class Mesh;
+
+struct DrawPacket
+{
+    uint64_t    SortKey;
+    const Mesh *DrawnMesh;
+    uint32_t    Object; // Object of the first instance, its transform decides the visible meshlets
+    uint32_t    Lod;
+    uint32_t    FirstInstance; // Index into the instance transforms of the frame
+    uint32_t    InstanceCount;
+};
+
+// Draws of a frame, recorded in any order and replayed sorted by their keys. A key holds, from the
+// most significant bits down: 16 zero bits, the pipeline, the material and the quantized view depth.
+// Sorting by it groups state changes and orders the draws of a material front to back.
+class DrawList
+{
+    std::vector<DrawPacket>            m_Packets;
+    std::vector<DrawPacket>            m_Scratch;
+    std::vector<ID3D12PipelineState *> m_Pipelines;
+
+  public:
+    static constexpr size_t PIPELINE_BITS = 8;
+    static constexpr size_t MATERIAL_BITS = 24;
+    static constexpr size_t DEPTH_BITS    = 16;
+
+    // Depths are quantized by dropping the low mantissa bits, which keeps 8 bits of relative precision
+    static uint64_t MakeKey(uint32_t pipeline, uint32_t material, float viewDepth) noexcept;
+
+    // Pipelines are numbered in the order they are first seen and stay registered across Clear
+    uint32_t             PipelineId(ID3D12PipelineState *pipeline);
+    ID3D12PipelineState *GetPipeline(uint64_t sortKey) const noexcept
+    {
+        return m_Pipelines[sortKey >> (MATERIAL_BITS + DEPTH_BITS)];
+    }
+
+    void Clear() noexcept { m_Packets.clear(); }
+    void Add(const DrawPacket &packet) { m_Packets.push_back(packet); }
+
+    // LSD radix sort with 8-bit digits, digits that are the same for every key are skipped. Stable.
+    void Sort();
+
+    const std::vector<DrawPacket> &GetPackets() const noexcept { return m_Packets; }
+};
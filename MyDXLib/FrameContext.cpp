@@ -0,0 +1,13 @@
+#include "FrameContext.hpp"
+
+void FrameContexts::Begin(CommandQueue &commandQueue)
+{
+    ++m_FrameNumber;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (m_FrameNumber > m_Latency)
+        commandQueue.WaitForFenceValue(m_FenceValues[(m_FrameNumber - m_Latency) % MAX_FRAME_LATENCY]);
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_WaitMilliseconds = std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
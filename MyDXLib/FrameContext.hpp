@@ -0,0 +1,35 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "CommandQueue.hpp"
+#include "Utils.hpp"
+
+// Keeps up to latency frames in flight. Frame n starts once frame n - latency is finished on the GPU, which is
+// known from the fence value of its last submission. Nothing else is kept per frame: the queue recycles command
+// allocators and the upload ring retires its frames by fence value already.
+class FrameContexts
+{
+  public:
+    static constexpr size_t MAX_FRAME_LATENCY     = BACK_BUFFER_COUNT;
+    static constexpr size_t DEFAULT_FRAME_LATENCY = 2;
+
+  private:
+    UINT64 m_FenceValues[MAX_FRAME_LATENCY] = {}; // Of the last submission of each frame in flight, 0 until used
+    UINT64 m_FrameNumber                    = 0;
+    size_t m_Latency                        = DEFAULT_FRAME_LATENCY;
+    double m_WaitMilliseconds               = 0.0;
+
+  public:
+    // Clamped to [1, MAX_FRAME_LATENCY], 1 waits for the previous frame before recording the next one
+    void   SetLatency(size_t latency) noexcept { m_Latency = std::clamp(latency, size_t(1), MAX_FRAME_LATENCY); }
+    size_t GetLatency() const noexcept { return m_Latency; }
+
+    // Waits until the GPU finished the frame latency frames back
+    void Begin(CommandQueue &commandQueue);
+    // Tags the current frame with the fence value of its last submission
+    void End(UINT64 fenceValue) noexcept { m_FenceValues[m_FrameNumber % MAX_FRAME_LATENCY] = fenceValue; }
+
+    // Time the last Begin spent waiting for the GPU
+    double GetWaitMilliseconds() const noexcept { return m_WaitMilliseconds; }
+};
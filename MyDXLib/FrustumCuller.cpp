@@ -0,0 +1,129 @@
+#include "FrustumCuller.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    XMFLOAT4 NormalizePlane(float a, float b, float c, float d) noexcept
+    {
+        float length = std::sqrt(a * a + b * b + c * c);
+        return XMFLOAT4(a / length, b / length, c / length, d / length);
+    }
+} // namespace
+
+Frustum Frustum::FromMatrix(FXMMATRIX viewProjection)
+{
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, viewProjection);
+
+    // Row vector convention, clip = p * m with 0 <= z <= w
+    auto column = [&](size_t c) { return XMFLOAT4(m(0, c), m(1, c), m(2, c), m(3, c)); };
+    XMFLOAT4 x = column(0);
+    XMFLOAT4 y = column(1);
+    XMFLOAT4 z = column(2);
+    XMFLOAT4 w = column(3);
+
+    Frustum frustum;
+    frustum.Planes[0] = NormalizePlane(w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w);
+    frustum.Planes[1] = NormalizePlane(w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w);
+    frustum.Planes[2] = NormalizePlane(w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w);
+    frustum.Planes[3] = NormalizePlane(w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w);
+    frustum.Planes[4] = NormalizePlane(z.x, z.y, z.z, z.w);
+    frustum.Planes[5] = NormalizePlane(w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w);
+    return frustum;
+}
+
+void BoundingBoxes::Clear() noexcept
+{
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+    m_Count = 0;
+}
+
+void BoundingBoxes::Add(const XMFLOAT3 &boundsMin, const XMFLOAT3 &boundsMax, FXMMATRIX transform)
+{
+    // The padding boxes after m_Count are overwritten first
+    if (m_CenterX.size() == m_Count)
+    {
+        size_t size = m_Count + BATCH_SIZE;
+        m_CenterX.resize(size, 0.0f);
+        m_CenterY.resize(size, 0.0f);
+        m_CenterZ.resize(size, 0.0f);
+        m_ExtentX.resize(size, 0.0f);
+        m_ExtentY.resize(size, 0.0f);
+        m_ExtentZ.resize(size, 0.0f);
+    }
+    Set(m_Count++, boundsMin, boundsMax, transform);
+}
+
+void BoundingBoxes::Set(size_t index, const XMFLOAT3 &boundsMin, const XMFLOAT3 &boundsMax, FXMMATRIX transform)
+{
+    XMVECTOR localMin = XMLoadFloat3(&boundsMin);
+    XMVECTOR localMax = XMLoadFloat3(&boundsMax);
+    XMVECTOR center   = XMVector3TransformCoord((localMin + localMax) * 0.5f, transform);
+
+    // Every axis of the transformed box contributes its absolute projection to the new extent
+    XMVECTOR localExtent = (localMax - localMin) * 0.5f;
+    XMVECTOR extent      = XMVectorAbs(transform.r[0]) * XMVectorSplatX(localExtent);
+    extent               = XMVectorMultiplyAdd(XMVectorAbs(transform.r[1]), XMVectorSplatY(localExtent), extent);
+    extent               = XMVectorMultiplyAdd(XMVectorAbs(transform.r[2]), XMVectorSplatZ(localExtent), extent);
+
+    m_CenterX[index] = XMVectorGetX(center);
+    m_CenterY[index] = XMVectorGetY(center);
+    m_CenterZ[index] = XMVectorGetZ(center);
+    m_ExtentX[index] = XMVectorGetX(extent);
+    m_ExtentY[index] = XMVectorGetY(extent);
+    m_ExtentZ[index] = XMVectorGetZ(extent);
+}
+
+void FrustumCuller::Test(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<uint8_t> &visible)
+{
+    static_assert(BoundingBoxes::BATCH_SIZE == 4, "The kernel works on one XMVECTOR per coordinate");
+
+    // Plane coefficients splatted across the lanes, the extents are weighted with their absolute values
+    XMVECTOR planeX[6];
+    XMVECTOR planeY[6];
+    XMVECTOR planeZ[6];
+    XMVECTOR planeW[6];
+    for (size_t p = 0; p < 6; ++p)
+    {
+        XMVECTOR plane = XMLoadFloat4(&frustum.Planes[p]);
+        planeX[p]      = XMVectorSplatX(plane);
+        planeY[p]      = XMVectorSplatY(plane);
+        planeZ[p]      = XMVectorSplatZ(plane);
+        planeW[p]      = XMVectorSplatW(plane);
+    }
+
+    visible.resize(boxes.Size());
+    for (size_t i = 0; i < boxes.Size(); i += BoundingBoxes::BATCH_SIZE)
+    {
+        XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.CenterX() + i));
+        XMVECTOR centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.CenterY() + i));
+        XMVECTOR centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.CenterZ() + i));
+        XMVECTOR extentX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.ExtentX() + i));
+        XMVECTOR extentY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.ExtentY() + i));
+        XMVECTOR extentZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(boxes.ExtentZ() + i));
+
+        // A box is outside when dot(n, center) + d < -dot(|n|, extent) for any plane
+        XMVECTOR outside = XMVectorFalseInt();
+        for (size_t p = 0; p < 6; ++p)
+        {
+            XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX[p], planeW[p]);
+            distance          = XMVectorMultiplyAdd(centerY, planeY[p], distance);
+            distance          = XMVectorMultiplyAdd(centerZ, planeZ[p], distance);
+            XMVECTOR radius   = extentX * XMVectorAbs(planeX[p]);
+            radius            = XMVectorMultiplyAdd(extentY, XMVectorAbs(planeY[p]), radius);
+            radius            = XMVectorMultiplyAdd(extentZ, XMVectorAbs(planeZ[p]), radius);
+            outside           = XMVectorOrInt(outside, XMVectorLess(distance + radius, XMVectorZero()));
+        }
+
+        uint32_t lanes[4];
+        XMStoreInt4(lanes, outside);
+        for (size_t lane = 0; lane < 4 && i + lane < boxes.Size(); ++lane)
+            visible[i + lane] = lanes[lane] == 0;
+    }
+}
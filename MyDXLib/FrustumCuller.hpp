@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pch.hpp"
+
+struct Frustum
+{
+    DirectX::XMFLOAT4 Planes[6]; // Normalized, a point is inside when dot(n, p) + d >= 0 for all of them
+
+    // Planes of a row vector view projection matrix with 0 <= z <= w, in the space the matrix maps from
+    static Frustum FromMatrix(DirectX::FXMMATRIX viewProjection);
+};
+
+// Axis aligned boxes as centers and extents in structure of arrays layout. The arrays are
+// padded with empty boxes to a multiple of BATCH_SIZE, so they can be read a batch at a time.
+class BoundingBoxes
+{
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_ExtentX;
+    std::vector<float> m_ExtentY;
+    std::vector<float> m_ExtentZ;
+    size_t             m_Count = 0;
+
+  public:
+    static constexpr size_t BATCH_SIZE = 4;
+
+    void   Clear() noexcept;
+    size_t Size() const noexcept { return m_Count; }
+
+    // Adds the box around [boundsMin, boundsMax] after transforming it with a row vector matrix
+    void Add(const DirectX::XMFLOAT3 &boundsMin, const DirectX::XMFLOAT3 &boundsMax, DirectX::FXMMATRIX transform);
+    // Replaces box index the same way
+    void Set(size_t                   index,
+             const DirectX::XMFLOAT3 &boundsMin,
+             const DirectX::XMFLOAT3 &boundsMax,
+             DirectX::FXMMATRIX       transform);
+
+    const float *CenterX() const noexcept { return m_CenterX.data(); }
+    const float *CenterY() const noexcept { return m_CenterY.data(); }
+    const float *CenterZ() const noexcept { return m_CenterZ.data(); }
+    const float *ExtentX() const noexcept { return m_ExtentX.data(); }
+    const float *ExtentY() const noexcept { return m_ExtentY.data(); }
+    const float *ExtentZ() const noexcept { return m_ExtentZ.data(); }
+};
+
+class FrustumCuller
+{
+  public:
+    FrustumCuller() = delete;
+
+    // visible[i] becomes 1 for every box that isn't completely outside one of the planes.
+    // Tests BATCH_SIZE boxes against a plane at once.
+    static void Test(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<uint8_t> &visible);
+};
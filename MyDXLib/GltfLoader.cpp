@@ -0,0 +1,463 @@
+#include "GltfLoader.hpp"
+#include "Json.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+namespace
+{
+    constexpr uint32_t GLB_MAGIC      = 0x46546C67; // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    constexpr uint32_t GLB_CHUNK_BIN  = 0x004E4942; // "BIN\0"
+
+    constexpr uint32_t COMPONENT_UNSIGNED_BYTE  = 5121;
+    constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+    constexpr uint32_t COMPONENT_UNSIGNED_INT   = 5125;
+    constexpr uint32_t COMPONENT_FLOAT          = 5126;
+
+    constexpr size_t MODE_TRIANGLES = 4;
+    constexpr size_t NO_INDEX       = SIZE_MAX;
+
+    [[noreturn]] void Fail(const std::string &what) { throw std::runtime_error("glTF: " + what); }
+
+    size_t ComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case 5120:
+        case 5121: return 1;
+        case 5122:
+        case 5123: return 2;
+        case 5125:
+        case 5126: return 4;
+        default: Fail("unknown component type");
+        }
+    }
+
+    size_t ComponentCount(const std::string &type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4" || type == "MAT2")
+            return 4;
+        if (type == "MAT3")
+            return 9;
+        if (type == "MAT4")
+            return 16;
+        Fail("unknown accessor type " + type);
+    }
+
+    // The JSON of a .gltf file or of the JSON chunk of a .glb file, with the BIN chunk if there is one
+    std::string_view SplitGlb(const MappedFile &file, std::string_view &glbBinary)
+    {
+        std::string_view jsonText(file.Data(), file.Size());
+
+        uint32_t magic = 0;
+        if (file.Size() >= sizeof(magic))
+            std::memcpy(&magic, file.Data(), sizeof(magic));
+        if (magic != GLB_MAGIC)
+            return jsonText;
+
+        // 12 byte header, then a JSON chunk and an optional BIN chunk
+        size_t offset = 12;
+        jsonText      = {};
+        while (offset + 8 <= file.Size())
+        {
+            uint32_t chunkLength = 0;
+            uint32_t chunkType   = 0;
+            std::memcpy(&chunkLength, file.Data() + offset, sizeof(chunkLength));
+            std::memcpy(&chunkType, file.Data() + offset + 4, sizeof(chunkType));
+            offset += 8;
+            if (chunkLength > file.Size() - offset)
+                Fail("GLB chunk exceeds the file size");
+            if (chunkType == GLB_CHUNK_JSON && jsonText.empty())
+                jsonText = std::string_view(file.Data() + offset, chunkLength);
+            else if (chunkType == GLB_CHUNK_BIN && glbBinary.empty())
+                glbBinary = std::string_view(file.Data() + offset, chunkLength);
+            offset += Math::AlignUp(chunkLength, 4);
+        }
+        if (jsonText.empty())
+            Fail("GLB without a JSON chunk");
+        return jsonText;
+    }
+
+    // Strided view into a mapped buffer, nothing is copied until an element is read
+    struct Accessor
+    {
+        const char *Data          = nullptr;
+        size_t      Count         = 0;
+        size_t      Stride        = 0;
+        uint32_t    ComponentType = 0;
+        size_t      Components    = 0;
+
+        template <typename T> T Read(size_t i) const
+        {
+            T result;
+            std::memcpy(&result, Data + i * Stride, sizeof(T));
+            return result;
+        }
+    };
+
+    class GltfDocument
+    {
+        std::vector<MappedFile>       m_Files;
+        std::vector<std::string_view> m_Buffers;
+
+      public:
+        JsonValue Json;
+
+        explicit GltfDocument(const std::filesystem::path &scenePath)
+        {
+            m_Files.emplace_back(scenePath);
+
+            std::string_view glbBinary;
+            Json = JsonValue::Parse(SplitGlb(m_Files.back(), glbBinary));
+
+            std::filesystem::path sceneDir = scenePath;
+            sceneDir.remove_filename();
+
+            const JsonValue &buffers = Json["buffers"];
+            for (size_t i = 0; i < buffers.Size(); ++i)
+            {
+                const JsonValue &buffer     = buffers[i];
+                size_t           byteLength = buffer.GetIndex("byteLength", 0);
+                std::string_view contents;
+                if (!buffer["uri"].IsString())
+                {
+                    if (i != 0 || glbBinary.data() == nullptr)
+                        Fail("buffer without uri outside of GLB");
+                    contents = glbBinary;
+                }
+                else
+                {
+                    const std::string &uri = buffer["uri"].AsString();
+                    if (uri.rfind("data:", 0) == 0)
+                        Fail("embedded data URIs are not supported");
+                    m_Files.emplace_back(sceneDir / std::filesystem::u8path(uri));
+                    contents = std::string_view(m_Files.back().Data(), m_Files.back().Size());
+                }
+                if (contents.size() < byteLength)
+                    Fail("buffer is shorter than its byteLength");
+                m_Buffers.push_back(contents.substr(0, byteLength));
+            }
+        }
+
+        Accessor GetAccessor(size_t index) const
+        {
+            const JsonValue &accessor = Json["accessors"][index];
+            if (!accessor.IsObject())
+                Fail("accessor index out of range");
+            if (!accessor["sparse"].IsNull())
+                Fail("sparse accessors are not supported");
+
+            const JsonValue &view = Json["bufferViews"][accessor.GetIndex("bufferView", NO_INDEX)];
+            if (!view.IsObject())
+                Fail("accessor without a buffer view");
+
+            size_t bufferIdx = view.GetIndex("buffer", NO_INDEX);
+            if (bufferIdx >= m_Buffers.size())
+                Fail("buffer index out of range");
+
+            Accessor result;
+            result.Count         = accessor.GetIndex("count", 0);
+            result.ComponentType = static_cast<uint32_t>(accessor.GetIndex("componentType", 0));
+            result.Components    = ComponentCount(accessor["type"].AsString());
+
+            size_t elementSize = ComponentSize(result.ComponentType) * result.Components;
+            result.Stride      = view.GetIndex("byteStride", elementSize);
+
+            size_t viewOffset = view.GetIndex("byteOffset", 0);
+            size_t viewLength = view.GetIndex("byteLength", 0);
+            size_t offset     = accessor.GetIndex("byteOffset", 0);
+            if (viewOffset + viewLength > m_Buffers[bufferIdx].size()
+                || (result.Count > 0 && offset + result.Stride * (result.Count - 1) + elementSize > viewLength))
+                Fail("accessor range exceeds its buffer view");
+
+            result.Data = m_Buffers[bufferIdx].data() + viewOffset + offset;
+            return result;
+        }
+
+        Accessor GetFloatAttribute(const JsonValue &attributes, const char *name, size_t components) const
+        {
+            size_t idx = attributes.GetIndex(name, NO_INDEX);
+            if (idx == NO_INDEX)
+                Fail(std::string("primitive has no ") + name + ", use the Assimp importer for this file");
+            Accessor result = GetAccessor(idx);
+            if (result.ComponentType != COMPONENT_FLOAT || result.Components != components)
+                Fail(std::string("unsupported format of ") + name);
+            return result;
+        }
+    };
+
+    void ConvertPrimitive(const GltfDocument &doc, const JsonValue &primitive, size_t materialCount, MeshData &meshData)
+    {
+        const JsonValue &attributes = primitive["attributes"];
+
+        Accessor positions = doc.GetFloatAttribute(attributes, "POSITION", 3);
+        Accessor normals   = doc.GetFloatAttribute(attributes, "NORMAL", 3);
+        Accessor tangents  = doc.GetFloatAttribute(attributes, "TANGENT", 4);
+        Accessor uvs       = doc.GetFloatAttribute(attributes, "TEXCOORD_0", 2);
+
+        size_t vertexCount = positions.Count;
+        if (normals.Count != vertexCount || tangents.Count != vertexCount || uvs.Count != vertexCount)
+            Fail("attribute counts differ within a primitive");
+
+        // Indices keep their source width, MeshData and Mesh handle both 16 and 32 bit. A primitive without indices
+        // is a plain triangle list and gets the sequence 0..n-1, every draw goes through an index buffer.
+        Accessor indices;
+        size_t   indexSize  = vertexCount <= UINT16_MAX + size_t(1) ? sizeof(uint16_t) : sizeof(uint32_t);
+        size_t   indicesIdx = primitive.GetIndex("indices", NO_INDEX);
+        if (indicesIdx != NO_INDEX)
+        {
+            indices   = doc.GetAccessor(indicesIdx);
+            indexSize = indices.ComponentType == COMPONENT_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+            if (indices.Components != 1
+                || (indices.ComponentType != COMPONENT_UNSIGNED_BYTE
+                    && indices.ComponentType != COMPONENT_UNSIGNED_SHORT
+                    && indices.ComponentType != COMPONENT_UNSIGNED_INT))
+                Fail("unsupported index format");
+            if (indices.Count % 3 != 0)
+                Fail("index count isn't a multiple of 3");
+        }
+        else if (vertexCount % 3 != 0)
+        {
+            Fail("primitive without indices has a vertex count that isn't a multiple of 3");
+        }
+        size_t indexCount = indicesIdx != NO_INDEX ? indices.Count : vertexCount;
+
+        meshData.Allocate(vertexCount, sizeof(VertexData), indexCount, indexSize);
+        meshData.m_MaterialIndex = primitive.GetIndex("material", materialCount);
+
+        auto vertices = static_cast<VertexData *>(meshData.VertexBufferData());
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            auto normal  = normals.Read<DirectX::XMFLOAT3>(i);
+            auto tangent = tangents.Read<DirectX::XMFLOAT4>(i);
+
+            VertexData &v = vertices[i];
+            v.pos         = positions.Read<DirectX::XMFLOAT3>(i);
+            v.normal      = normal;
+            v.tangent     = DirectX::XMFLOAT3(tangent.x, tangent.y, tangent.z);
+            // glTF stores the handedness in tangent.w instead of a bitangent
+            v.bitangent = DirectX::XMFLOAT3((normal.y * tangent.z - normal.z * tangent.y) * tangent.w,
+                                            (normal.z * tangent.x - normal.x * tangent.z) * tangent.w,
+                                            (normal.x * tangent.y - normal.y * tangent.x) * tangent.w);
+            v.uv        = uvs.Read<DirectX::XMFLOAT2>(i);
+        }
+
+        char *indexOut = static_cast<char *>(meshData.IndexBufferData());
+        if (indicesIdx == NO_INDEX)
+        {
+            if (indexSize == sizeof(uint16_t))
+            {
+                auto out = reinterpret_cast<uint16_t *>(indexOut);
+                std::iota(out, out + indexCount, uint16_t(0));
+            }
+            else
+            {
+                auto out = reinterpret_cast<uint32_t *>(indexOut);
+                std::iota(out, out + indexCount, 0u);
+            }
+        }
+        else if (indices.ComponentType == COMPONENT_UNSIGNED_BYTE)
+        {
+            auto out = reinterpret_cast<uint16_t *>(indexOut);
+            for (size_t i = 0; i < indices.Count; ++i)
+                out[i] = indices.Read<uint8_t>(i);
+        }
+        else if (indices.Count > 0 && indices.Stride == indexSize)
+        {
+            std::memcpy(indexOut, indices.Data, indices.Count * indexSize);
+        }
+        else
+        {
+            for (size_t i = 0; i < indices.Count; ++i)
+                std::memcpy(indexOut + i * indexSize, indices.Data + i * indices.Stride, indexSize);
+        }
+
+        // The import passes index arrays of vertexCount with them, and the GPU fetches vertices with them
+        uint32_t maxIndex = 0;
+        if (indexSize == sizeof(uint16_t))
+        {
+            auto in = reinterpret_cast<const uint16_t *>(indexOut);
+            for (size_t i = 0; i < indexCount; ++i)
+                maxIndex = (std::max)(maxIndex, uint32_t(in[i]));
+        }
+        else
+        {
+            auto in = reinterpret_cast<const uint32_t *>(indexOut);
+            for (size_t i = 0; i < indexCount; ++i)
+                maxIndex = (std::max)(maxIndex, in[i]);
+        }
+        if (indexCount > 0 && maxIndex >= vertexCount)
+            Fail("index out of range");
+    }
+
+    void ReadNodeTransform(const JsonValue &node, DirectX::XMFLOAT4X4 &transform)
+    {
+        const JsonValue &matrix = node["matrix"];
+        if (matrix.Size() == 16)
+        {
+            // glTF matrices are column-major
+            for (size_t r = 0; r < 4; ++r)
+                for (size_t c = 0; c < 4; ++c)
+                    transform(r, c) = static_cast<float>(matrix[c * 4 + r].AsNumber());
+            return;
+        }
+
+        const JsonValue &t = node["translation"];
+        const JsonValue &r = node["rotation"];
+        const JsonValue &s = node["scale"];
+
+        float tx = static_cast<float>(t[0].IsNumber() ? t[0].AsNumber() : 0.0);
+        float ty = static_cast<float>(t[1].IsNumber() ? t[1].AsNumber() : 0.0);
+        float tz = static_cast<float>(t[2].IsNumber() ? t[2].AsNumber() : 0.0);
+        float qx = static_cast<float>(r[0].IsNumber() ? r[0].AsNumber() : 0.0);
+        float qy = static_cast<float>(r[1].IsNumber() ? r[1].AsNumber() : 0.0);
+        float qz = static_cast<float>(r[2].IsNumber() ? r[2].AsNumber() : 0.0);
+        float qw = static_cast<float>(r[3].IsNumber() ? r[3].AsNumber() : 1.0);
+        float sx = static_cast<float>(s[0].IsNumber() ? s[0].AsNumber() : 1.0);
+        float sy = static_cast<float>(s[1].IsNumber() ? s[1].AsNumber() : 1.0);
+        float sz = static_cast<float>(s[2].IsNumber() ? s[2].AsNumber() : 1.0);
+
+        // T * R * S, laid out the same way as aiMatrix4x4 (translation in the last column)
+        transform = DirectX::XMFLOAT4X4();
+        transform(0, 0) = (1.0f - 2.0f * (qy * qy + qz * qz)) * sx;
+        transform(0, 1) = (2.0f * (qx * qy - qz * qw)) * sy;
+        transform(0, 2) = (2.0f * (qx * qz + qy * qw)) * sz;
+        transform(1, 0) = (2.0f * (qx * qy + qz * qw)) * sx;
+        transform(1, 1) = (1.0f - 2.0f * (qx * qx + qz * qz)) * sy;
+        transform(1, 2) = (2.0f * (qy * qz - qx * qw)) * sz;
+        transform(2, 0) = (2.0f * (qx * qz - qy * qw)) * sx;
+        transform(2, 1) = (2.0f * (qy * qz + qx * qw)) * sy;
+        transform(2, 2) = (1.0f - 2.0f * (qx * qx + qy * qy)) * sz;
+        transform(0, 3) = tx;
+        transform(1, 3) = ty;
+        transform(2, 3) = tz;
+        transform(3, 3) = 1.0f;
+    }
+} // namespace
+
+void GltfLoader::Load(const std::filesystem::path &scenePath, SceneData &sceneData)
+{
+    GltfDocument     doc(scenePath);
+    const JsonValue &json = doc.Json;
+
+    std::filesystem::path pathComponents = scenePath;
+    auto                  sceneDirW      = pathComponents.remove_filename().generic_wstring();
+
+    auto texturePath = [&](const JsonValue &textureInfo) -> std::wstring {
+        if (!textureInfo.IsObject())
+            return L"";
+        const JsonValue &texture = json["textures"][textureInfo.GetIndex("index", NO_INDEX)];
+        const JsonValue &image   = json["images"][texture.GetIndex("source", NO_INDEX)];
+        if (!image["uri"].IsString())
+            Fail("only external images are supported");
+        return sceneDirW + std::filesystem::u8path(image["uri"].AsString()).generic_wstring();
+    };
+
+    const JsonValue &materials = json["materials"];
+    sceneData.m_Materials.resize(materials.Size());
+    for (size_t i = 0; i < materials.Size(); ++i)
+    {
+        const JsonValue &material = materials[i];
+        const JsonValue &pbr      = material["pbrMetallicRoughness"];
+
+        // Same slots Assimp fills for glTF 2.0 materials
+        auto &paths                             = sceneData.m_Materials[i].TexturePaths;
+        paths[TEXTURE_TYPE_BASE_COLOR]        = texturePath(pbr["baseColorTexture"]);
+        paths[TEXTURE_TYPE_NORMAL_CAMERA]     = texturePath(material["normalTexture"]);
+        paths[TEXTURE_TYPE_EMISSION_COLOR]    = texturePath(material["emissiveTexture"]);
+        paths[TEXTURE_TYPE_METALNESS]         = texturePath(pbr["metallicRoughnessTexture"]);
+        paths[TEXTURE_TYPE_DIFFUSE_ROUGHNESS] = paths[TEXTURE_TYPE_METALNESS];
+        paths[TEXTURE_TYPE_AMBIENT_OCCLUSION] = texturePath(material["occlusionTexture"]);
+
+        for (auto &&path : paths)
+            if (!path.empty())
+                sceneData.m_TexturePaths.insert(path);
+    }
+
+    // Every triangle primitive becomes its own MeshData, like Assimp does
+    const JsonValue                 &meshes = json["meshes"];
+    std::vector<std::vector<size_t>> meshPrimitives(meshes.Size());
+    std::vector<const JsonValue *>   primitives;
+    for (size_t i = 0; i < meshes.Size(); ++i)
+    {
+        const JsonValue &meshPrimitiveList = meshes[i]["primitives"];
+        for (size_t j = 0; j < meshPrimitiveList.Size(); ++j)
+        {
+            const JsonValue &primitive = meshPrimitiveList[j];
+            if (primitive.GetIndex("mode", MODE_TRIANGLES) != MODE_TRIANGLES)
+                continue;
+            meshPrimitives[i].push_back(primitives.size());
+            primitives.push_back(&primitive);
+        }
+    }
+
+    sceneData.m_Meshes.resize(primitives.size());
+    ThreadPool::Shared().ParallelFor(primitives.size(), [&](size_t i) {
+        ConvertPrimitive(doc, *primitives[i], materials.Size(), sceneData.m_Meshes[i]);
+    });
+
+    const JsonValue &nodes = json["nodes"];
+    std::vector<bool> visited(nodes.Size(), false);
+
+    std::function<void(size_t, uint32_t)> parseNode = [&](size_t nodeIdx, uint32_t parent) {
+        const JsonValue &node = nodes[nodeIdx];
+        if (!node.IsObject() || visited[nodeIdx])
+            Fail("invalid node hierarchy");
+        visited[nodeIdx] = true;
+
+        DirectX::XMFLOAT4X4 transform;
+        ReadNodeTransform(node, transform);
+
+        std::vector<size_t> meshes;
+        size_t              meshIdx = node.GetIndex("mesh", NO_INDEX);
+        if (meshIdx != NO_INDEX)
+        {
+            if (meshIdx >= meshPrimitives.size())
+                Fail("mesh index out of range");
+            meshes = meshPrimitives[meshIdx];
+        }
+        uint32_t object = sceneData.AddObject(parent, transform, meshes);
+
+        const JsonValue &children = node["children"];
+        for (size_t i = 0; i < children.Size(); ++i)
+            parseNode(static_cast<size_t>(children[i].AsNumber()), object);
+    };
+
+    // An identity root holds the scene's root nodes
+    DirectX::XMFLOAT4X4 identity;
+    DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+    sceneData.m_Objects.clear();
+    sceneData.m_ObjectMeshes.clear();
+    uint32_t root = sceneData.AddObject(ObjectData::NO_PARENT, identity, {});
+
+    const JsonValue &sceneRoots = json["scenes"][json.GetIndex("scene", 0)]["nodes"];
+    for (size_t i = 0; i < sceneRoots.Size(); ++i)
+        parseNode(static_cast<size_t>(sceneRoots[i].AsNumber()), root);
+}
+
+std::vector<std::filesystem::path> GltfLoader::BufferPaths(const std::filesystem::path &scenePath)
+{
+    MappedFile       file(scenePath);
+    std::string_view glbBinary;
+    JsonValue        json = JsonValue::Parse(SplitGlb(file, glbBinary));
+
+    std::filesystem::path sceneDir = scenePath;
+    sceneDir.remove_filename();
+
+    std::vector<std::filesystem::path> result;
+    const JsonValue                   &buffers = json["buffers"];
+    for (size_t i = 0; i < buffers.Size(); ++i)
+    {
+        const JsonValue &uri = buffers[i]["uri"];
+        if (uri.IsString() && uri.AsString().rfind("data:", 0) != 0)
+            result.push_back(sceneDir / std::filesystem::u8path(uri.AsString()));
+    }
+    return result;
+}
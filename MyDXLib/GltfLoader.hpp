@@ -0,0 +1,20 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "SceneData.hpp"
+
+// Reads .gltf/.glb files straight into SceneData without going through Assimp.
+// Buffers are memory-mapped and vertex attributes are gathered from the
+// accessor ranges directly. Only triangle lists with POSITION, NORMAL,
+// TANGENT and float TEXCOORD_0 are supported, which covers our assets.
+class GltfLoader
+{
+  public:
+    GltfLoader() = delete;
+
+    static void Load(const std::filesystem::path &scenePath, SceneData &sceneData);
+
+    // External files the buffers of the scene are read from, embedded buffers are a part of the scene file
+    static std::vector<std::filesystem::path> BufferPaths(const std::filesystem::path &scenePath);
+};
@@ -0,0 +1,224 @@
+#include "HeapAllocator.hpp"
+#include "Utils.hpp"
+
+BuddyAllocator::BuddyAllocator(size_t capacity, size_t minBlockSize)
+    : m_MinBlockSize(minBlockSize),
+      m_OrderCount(1)
+{
+    size_t blockCount = minBlockSize == 0 ? 0 : capacity / minBlockSize;
+    if (blockCount == 0 || (blockCount & (blockCount - 1)) != 0 || blockCount * minBlockSize != capacity
+        || (minBlockSize & (minBlockSize - 1)) != 0 || blockCount > NO_BLOCK / 2)
+        throw std::exception("Buddy allocator capacity has to be a power of two times the minimum block size");
+
+    while ((size_t(1) << (m_OrderCount - 1)) < blockCount)
+        ++m_OrderCount;
+
+    m_BlockOrders.resize(blockCount, INTERIOR);
+    m_NextFree.resize(blockCount, NO_BLOCK);
+    m_PreviousFree.resize(blockCount, NO_BLOCK);
+    m_FreeHeads.assign(m_OrderCount, NO_BLOCK);
+    PushFree(0, m_OrderCount - 1);
+}
+
+void BuddyAllocator::PushFree(uint32_t block, size_t order)
+{
+    m_BlockOrders[block]  = static_cast<uint8_t>(FREE_FLAG | order);
+    m_NextFree[block]     = m_FreeHeads[order];
+    m_PreviousFree[block] = NO_BLOCK;
+    if (m_FreeHeads[order] != NO_BLOCK)
+        m_PreviousFree[m_FreeHeads[order]] = block;
+    m_FreeHeads[order] = block;
+}
+
+void BuddyAllocator::RemoveFree(uint32_t block, size_t order)
+{
+    uint32_t next     = m_NextFree[block];
+    uint32_t previous = m_PreviousFree[block];
+    if (next != NO_BLOCK)
+        m_PreviousFree[next] = previous;
+    if (previous != NO_BLOCK)
+        m_NextFree[previous] = next;
+    else
+        m_FreeHeads[order] = next;
+}
+
+size_t BuddyAllocator::Allocate(size_t size, size_t alignment)
+{
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    // Blocks are aligned to their size, so a block of the alignment is aligned as well
+    size_t needed = (std::max)(size, alignment);
+    size_t order  = 0;
+    while (order < m_OrderCount && (m_MinBlockSize << order) < needed)
+        ++order;
+
+    size_t found = order;
+    while (found < m_OrderCount && m_FreeHeads[found] == NO_BLOCK)
+        ++found;
+    if (found >= m_OrderCount)
+        return INVALID_OFFSET;
+
+    uint32_t block = m_FreeHeads[found];
+    RemoveFree(block, found);
+    // The upper halves split off on the way down stay free
+    while (found > order)
+    {
+        --found;
+        PushFree(block + (uint32_t(1) << found), found);
+    }
+    m_BlockOrders[block] = static_cast<uint8_t>(order);
+
+    m_AllocatedSize += m_MinBlockSize << order;
+    m_RequestedSize += size;
+    ++m_AllocationCount;
+    return block * m_MinBlockSize;
+}
+
+void BuddyAllocator::Free(size_t offset, size_t size)
+{
+    size_t index = offset / m_MinBlockSize;
+    if (offset % m_MinBlockSize != 0 || index >= m_BlockOrders.size() || (m_BlockOrders[index] & FREE_FLAG) != 0
+        || m_BlockOrders[index] == INTERIOR)
+        throw std::exception("Freed offset is not allocated");
+
+    auto   block = static_cast<uint32_t>(index);
+    size_t order = m_BlockOrders[block];
+    if (size > m_MinBlockSize << order)
+        throw std::exception("Freed size is larger than the allocated block");
+
+    m_AllocatedSize -= m_MinBlockSize << order;
+    m_RequestedSize -= size;
+    --m_AllocationCount;
+
+    // The buddy always starts a block, it is merged when that block is free and just as large
+    while (order + 1 < m_OrderCount)
+    {
+        uint32_t buddy = block ^ (uint32_t(1) << order);
+        if (m_BlockOrders[buddy] != (FREE_FLAG | order))
+            break;
+        RemoveFree(buddy, order);
+        m_BlockOrders[(std::max)(block, buddy)] = INTERIOR;
+        block                                   = (std::min)(block, buddy);
+        ++order;
+    }
+    PushFree(block, order);
+}
+
+size_t BuddyAllocator::GetLargestFreeBlock() const noexcept
+{
+    for (size_t order = m_OrderCount; order-- > 0;)
+        if (m_FreeHeads[order] != NO_BLOCK)
+            return m_MinBlockSize << order;
+    return 0;
+}
+
+PlacedResource::PlacedResource(PlacedResource &&other) noexcept
+    : m_Allocator(std::exchange(other.m_Allocator, nullptr)),
+      m_Resource(std::move(other.m_Resource)),
+      m_Block(other.m_Block),
+      m_Offset(other.m_Offset),
+      m_Size(other.m_Size)
+{
+}
+
+PlacedResource &PlacedResource::operator=(PlacedResource &&other) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        m_Allocator = std::exchange(other.m_Allocator, nullptr);
+        m_Resource  = std::move(other.m_Resource);
+        m_Block     = other.m_Block;
+        m_Offset    = other.m_Offset;
+        m_Size      = other.m_Size;
+    }
+    return *this;
+}
+
+void PlacedResource::Reset() noexcept
+{
+    m_Resource.Reset();
+    if (m_Allocator)
+        std::exchange(m_Allocator, nullptr)->Free(m_Block, m_Offset, m_Size);
+}
+
+HeapAllocator::HeapAllocator(PDevice device, D3D12_HEAP_TYPE type, size_t blockSize)
+    : m_Device(std::move(device)),
+      m_Type(type),
+      m_BlockSize(blockSize)
+{
+}
+
+PlacedResource HeapAllocator::CreateBuffer(size_t size, D3D12_RESOURCE_STATES initialState)
+{
+    CD3DX12_RESOURCE_DESC          desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    D3D12_RESOURCE_ALLOCATION_INFO info = m_Device->GetResourceAllocationInfo(0, 1, &desc);
+
+    size_t block  = 0;
+    size_t offset = BuddyAllocator::INVALID_OFFSET;
+    for (size_t i = 0; i < m_Blocks.size() && offset == BuddyAllocator::INVALID_OFFSET; ++i)
+    {
+        if (!m_Blocks[i].Heap)
+            continue;
+        block  = i;
+        offset = m_Blocks[i].Allocator.Allocate(info.SizeInBytes, info.Alignment);
+    }
+    if (offset == BuddyAllocator::INVALID_OFFSET)
+    {
+        // Buffers larger than a block get a heap of their own, which is released once it is empty
+        size_t heapSize = m_BlockSize;
+        while (heapSize < info.SizeInBytes)
+            heapSize <<= 1;
+
+        CD3DX12_HEAP_DESC heapDesc(heapSize, m_Type, 0, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+        PHeap             heap;
+        Assert(m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)));
+
+        // Slots of released heaps are reused, the blocks of live resources keep their index
+        Block entry = {std::move(heap), BuddyAllocator(heapSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)};
+        block       = 0;
+        while (block < m_Blocks.size() && m_Blocks[block].Heap)
+            ++block;
+        if (block == m_Blocks.size())
+            m_Blocks.push_back(std::move(entry));
+        else
+            m_Blocks[block] = std::move(entry);
+        offset = m_Blocks[block].Allocator.Allocate(info.SizeInBytes, info.Alignment);
+    }
+
+    PlacedResource resource;
+    resource.m_Allocator = this;
+    resource.m_Block     = block;
+    resource.m_Offset    = offset;
+    resource.m_Size      = info.SizeInBytes;
+    Assert(m_Device->CreatePlacedResource(
+        m_Blocks[block].Heap.Get(), offset, &desc, initialState, nullptr, IID_PPV_ARGS(&resource.m_Resource)));
+    return resource;
+}
+
+void HeapAllocator::Free(size_t block, size_t offset, size_t size)
+{
+    BuddyAllocator &allocator = m_Blocks[block].Allocator;
+    allocator.Free(offset, size);
+    if (allocator.GetAllocationCount() == 0 && allocator.GetCapacity() > m_BlockSize)
+        m_Blocks[block].Heap.Reset();
+}
+
+HeapStats HeapAllocator::GetStats() const noexcept
+{
+    HeapStats stats;
+    for (auto &&block : m_Blocks)
+    {
+        if (!block.Heap)
+            continue;
+        ++stats.Blocks;
+        stats.HeapSize      += block.Allocator.GetCapacity();
+        stats.AllocatedSize += block.Allocator.GetAllocatedSize();
+        stats.RequestedSize += block.Allocator.GetRequestedSize();
+        stats.Allocations   += block.Allocator.GetAllocationCount();
+
+        stats.LargestFreeBlock = (std::max)(stats.LargestFreeBlock, block.Allocator.GetLargestFreeBlock());
+    }
+    return stats;
+}
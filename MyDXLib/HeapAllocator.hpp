@@ -0,0 +1,120 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Buddy allocator over capacity bytes, split into blocks of minBlockSize times a power of two. A block is
+// aligned to its own size, so an alignment up to the block size costs nothing. Needs no device.
+class BuddyAllocator
+{
+    static constexpr uint32_t NO_BLOCK  = UINT32_MAX;
+    static constexpr uint8_t  FREE_FLAG = 0x80;
+    static constexpr uint8_t  INTERIOR  = 0x7F; // Not the first minimum block of a free or allocated block
+
+    size_t m_MinBlockSize;
+    size_t m_OrderCount;
+
+    // Indexed by the first minimum block of a block: its order and FREE_FLAG, and its neighbours in the free
+    // list of its order. The orders of all other minimum blocks are INTERIOR, the free list links are only
+    // valid for the first minimum block of a free block.
+    std::vector<uint8_t>  m_BlockOrders;
+    std::vector<uint32_t> m_NextFree;
+    std::vector<uint32_t> m_PreviousFree;
+    std::vector<uint32_t> m_FreeHeads; // For every order
+
+    size_t m_AllocatedSize   = 0; // Sum of the allocated block sizes
+    size_t m_RequestedSize   = 0; // Sum of the sizes passed to Allocate
+    size_t m_AllocationCount = 0;
+
+    void PushFree(uint32_t block, size_t order);
+    void RemoveFree(uint32_t block, size_t order);
+
+  public:
+    static constexpr size_t INVALID_OFFSET = SIZE_MAX;
+
+    // The capacity has to be minBlockSize times a power of two, minBlockSize a power of two
+    BuddyAllocator(size_t capacity, size_t minBlockSize);
+
+    // INVALID_OFFSET when no free block is large enough
+    size_t Allocate(size_t size, size_t alignment = 1);
+    // size has to be the size passed to Allocate, throws for offsets that don't start an allocated block
+    void Free(size_t offset, size_t size);
+
+    size_t GetCapacity() const noexcept { return m_MinBlockSize << (m_OrderCount - 1); }
+    size_t GetAllocatedSize() const noexcept { return m_AllocatedSize; }
+    size_t GetRequestedSize() const noexcept { return m_RequestedSize; }
+    size_t GetAllocationCount() const noexcept { return m_AllocationCount; }
+    size_t GetLargestFreeBlock() const noexcept;
+};
+
+struct HeapStats
+{
+    size_t Blocks           = 0;
+    size_t HeapSize         = 0;
+    size_t AllocatedSize    = 0; // Including the rounding up to buddy blocks
+    size_t RequestedSize    = 0;
+    size_t Allocations      = 0;
+    size_t LargestFreeBlock = 0;
+
+    // Share of the free memory outside of the largest free block, 0 when all free memory is one block
+    double Fragmentation() const noexcept
+    {
+        size_t freeSize = HeapSize - AllocatedSize;
+        return freeSize == 0 ? 0.0 : 1.0 - static_cast<double>(LargestFreeBlock) / freeSize;
+    }
+};
+
+class HeapAllocator;
+
+// Buffer placed in a heap of a HeapAllocator, its range is freed together with the resource
+class PlacedResource
+{
+    HeapAllocator *m_Allocator = nullptr;
+    PResource      m_Resource;
+    size_t         m_Block  = 0;
+    size_t         m_Offset = 0;
+    size_t         m_Size   = 0;
+
+    friend class HeapAllocator;
+
+  public:
+    PlacedResource() = default;
+    ~PlacedResource() { Reset(); }
+
+    PlacedResource(PlacedResource &&other) noexcept;
+    PlacedResource &operator=(PlacedResource &&other) noexcept;
+
+    void Reset() noexcept;
+
+    ID3D12Resource  *Get() const noexcept { return m_Resource.Get(); }
+    ID3D12Resource  *operator->() const noexcept { return m_Resource.Get(); }
+    const PResource &GetResource() const noexcept { return m_Resource; }
+};
+
+// Places buffers in large heaps of one type instead of creating a committed resource with an implicit heap for
+// each of them. Every heap is managed by a BuddyAllocator, buffers larger than the block size get a heap of their own.
+class HeapAllocator
+{
+    struct Block
+    {
+        PHeap          Heap;
+        BuddyAllocator Allocator;
+    };
+
+    PDevice            m_Device;
+    D3D12_HEAP_TYPE    m_Type;
+    size_t             m_BlockSize;
+    std::vector<Block> m_Blocks;
+
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 << 20;
+
+    explicit HeapAllocator(PDevice         device,
+                           D3D12_HEAP_TYPE type      = D3D12_HEAP_TYPE_DEFAULT,
+                           size_t          blockSize = DEFAULT_BLOCK_SIZE);
+
+    PlacedResource CreateBuffer(size_t size, D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COMMON);
+    // Called by PlacedResource after releasing its resource
+    void Free(size_t block, size_t offset, size_t size);
+
+    HeapStats GetStats() const noexcept;
+};
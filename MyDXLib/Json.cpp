@@ -0,0 +1,259 @@
+#include "Json.hpp"
+
+const JsonValue JsonValue::g_Null;
+
+namespace
+{
+    class JsonParser
+    {
+        std::string_view m_Text;
+        size_t           m_Pos = 0;
+
+        [[noreturn]] void Fail(const char *what) const
+        {
+            std::stringstream ss;
+            ss << "JSON parse error at offset " << m_Pos << ": " << what;
+            throw std::runtime_error(ss.str());
+        }
+
+        void SkipWhitespace() noexcept
+        {
+            while (m_Pos < m_Text.size()
+                   && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' || m_Text[m_Pos] == '\n' || m_Text[m_Pos] == '\r'))
+                ++m_Pos;
+        }
+
+        char Peek()
+        {
+            SkipWhitespace();
+            if (m_Pos >= m_Text.size())
+                Fail("unexpected end of input");
+            return m_Text[m_Pos];
+        }
+
+        void Expect(char c)
+        {
+            if (Peek() != c)
+                Fail("unexpected character");
+            ++m_Pos;
+        }
+
+        bool Consume(std::string_view word)
+        {
+            if (m_Text.substr(m_Pos, word.size()) != word)
+                return false;
+            m_Pos += word.size();
+            return true;
+        }
+
+        static void AppendUtf8(std::string &out, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                out += static_cast<char>(codepoint);
+            }
+            else if (codepoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else if (codepoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+        }
+
+        uint32_t ParseHex4()
+        {
+            if (m_Pos + 4 > m_Text.size())
+                Fail("truncated unicode escape");
+            uint32_t result = 0;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                char c = m_Text[m_Pos++];
+                result <<= 4;
+                if (c >= '0' && c <= '9')
+                    result |= c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    result |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    result |= c - 'A' + 10;
+                else
+                    Fail("bad unicode escape");
+            }
+            return result;
+        }
+
+        std::string ParseString()
+        {
+            Expect('"');
+            std::string result;
+            for (;;)
+            {
+                if (m_Pos >= m_Text.size())
+                    Fail("unterminated string");
+                char c = m_Text[m_Pos++];
+                if (c == '"')
+                    return result;
+                if (c != '\\')
+                {
+                    result += c;
+                    continue;
+                }
+                if (m_Pos >= m_Text.size())
+                    Fail("unterminated escape");
+                switch (m_Text[m_Pos++])
+                {
+                case '"': result += '"'; break;
+                case '\\': result += '\\'; break;
+                case '/': result += '/'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case 'u': {
+                    uint32_t codepoint = ParseHex4();
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && Consume("\\u"))
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (ParseHex4() - 0xDC00);
+                    AppendUtf8(result, codepoint);
+                    break;
+                }
+                default: Fail("unknown escape");
+                }
+            }
+        }
+
+        double ParseNumber()
+        {
+            size_t start = m_Pos;
+            while (m_Pos < m_Text.size() && std::strchr("+-0123456789.eE", m_Text[m_Pos]))
+                ++m_Pos;
+            if (start == m_Pos)
+                Fail("expected a value");
+            // strtod needs a terminated buffer and numbers in glTF headers are short
+            std::string number(m_Text.substr(start, m_Pos - start));
+            char       *end    = nullptr;
+            double      result = std::strtod(number.c_str(), &end);
+            if (end != number.c_str() + number.size())
+                Fail("malformed number");
+            return result;
+        }
+
+      public:
+        explicit JsonParser(std::string_view text)
+            : m_Text(text)
+        {
+        }
+
+        JsonValue ParseValue()
+        {
+            switch (Peek())
+            {
+            case '{': {
+                ++m_Pos;
+                JsonValue::Object object;
+                if (Peek() == '}')
+                {
+                    ++m_Pos;
+                    return object;
+                }
+                for (;;)
+                {
+                    std::string key = ParseString();
+                    Expect(':');
+                    object.insert_or_assign(std::move(key), ParseValue());
+                    if (Peek() == '}')
+                    {
+                        ++m_Pos;
+                        return object;
+                    }
+                    Expect(',');
+                }
+            }
+            case '[': {
+                ++m_Pos;
+                JsonValue::Array array;
+                if (Peek() == ']')
+                {
+                    ++m_Pos;
+                    return array;
+                }
+                for (;;)
+                {
+                    array.push_back(ParseValue());
+                    if (Peek() == ']')
+                    {
+                        ++m_Pos;
+                        return array;
+                    }
+                    Expect(',');
+                }
+            }
+            case '"': return ParseString();
+            case 't':
+                if (!Consume("true"))
+                    Fail("expected true");
+                return true;
+            case 'f':
+                if (!Consume("false"))
+                    Fail("expected false");
+                return false;
+            case 'n':
+                if (!Consume("null"))
+                    Fail("expected null");
+                return JsonValue();
+            default: return ParseNumber();
+            }
+        }
+
+        void ExpectEnd()
+        {
+            SkipWhitespace();
+            if (m_Pos != m_Text.size())
+                Fail("trailing characters");
+        }
+    };
+} // namespace
+
+JsonValue JsonValue::Parse(std::string_view text)
+{
+    JsonParser parser(text);
+    JsonValue  result = parser.ParseValue();
+    parser.ExpectEnd();
+    return result;
+}
+
+const JsonValue &JsonValue::operator[](std::string_view key) const
+{
+    if (!IsObject())
+        return g_Null;
+    auto &&object = AsObject();
+    auto   it     = object.find(key);
+    return it == object.end() ? g_Null : it->second;
+}
+
+const JsonValue &JsonValue::operator[](size_t index) const
+{
+    if (!IsArray() || index >= AsArray().size())
+        return g_Null;
+    return AsArray()[index];
+}
+
+size_t JsonValue::Size() const noexcept
+{
+    if (IsArray())
+        return std::get<Array>(m_Value).size();
+    if (IsObject())
+        return std::get<Object>(m_Value).size();
+    return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <map>
+#include <variant>
+
+// Minimal read-only JSON document, just enough for glTF headers
+class JsonValue
+{
+  public:
+    using Array  = std::vector<JsonValue>;
+    using Object = std::map<std::string, JsonValue, std::less<>>;
+
+  private:
+    std::variant<std::nullptr_t, bool, double, std::string, Array, Object> m_Value;
+
+    static const JsonValue g_Null;
+
+  public:
+    JsonValue() noexcept
+        : m_Value(nullptr)
+    {
+    }
+
+    template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, JsonValue>>>
+    JsonValue(T &&value)
+        : m_Value(std::forward<T>(value))
+    {
+    }
+
+    static JsonValue Parse(std::string_view text);
+
+    bool IsNull() const noexcept { return std::holds_alternative<std::nullptr_t>(m_Value); }
+    bool IsNumber() const noexcept { return std::holds_alternative<double>(m_Value); }
+    bool IsString() const noexcept { return std::holds_alternative<std::string>(m_Value); }
+    bool IsArray() const noexcept { return std::holds_alternative<Array>(m_Value); }
+    bool IsObject() const noexcept { return std::holds_alternative<Object>(m_Value); }
+
+    bool               AsBool() const { return std::get<bool>(m_Value); }
+    double             AsNumber() const { return std::get<double>(m_Value); }
+    const std::string &AsString() const { return std::get<std::string>(m_Value); }
+    const Array       &AsArray() const { return std::get<Array>(m_Value); }
+    const Object      &AsObject() const { return std::get<Object>(m_Value); }
+
+    // Lookups never throw for missing keys or indices, they return a null value instead
+    const JsonValue &operator[](std::string_view key) const;
+    const JsonValue &operator[](size_t index) const;
+    size_t           Size() const noexcept;
+
+    double GetNumber(std::string_view key, double fallback) const
+    {
+        const JsonValue &value = (*this)[key];
+        return value.IsNumber() ? value.AsNumber() : fallback;
+    }
+
+    size_t GetIndex(std::string_view key, size_t fallback) const
+    {
+        const JsonValue &value = (*this)[key];
+        return value.IsNumber() ? static_cast<size_t>(value.AsNumber()) : fallback;
+    }
+};
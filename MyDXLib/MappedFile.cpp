@@ -0,0 +1,151 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path &path)
+{
+    m_File = CreateFileW(path.c_str(),
+                         GENERIC_READ,
+                         FILE_SHARE_READ,
+                         nullptr,
+                         OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                         nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Couldn't open file " + path.string());
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(m_File, &size))
+    {
+        Close();
+        throw std::runtime_error("Couldn't query size of " + path.string());
+    }
+    m_Size = static_cast<size_t>(size.QuadPart);
+
+    // Empty files can't be mapped, but are still valid to read from
+    if (m_Size == 0)
+        return;
+
+    m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping)
+        m_Data = MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_Data)
+    {
+        Close();
+        throw std::runtime_error("Couldn't map file " + path.string());
+    }
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_File(std::exchange(other.m_File, INVALID_HANDLE_VALUE)),
+      m_Mapping(std::exchange(other.m_Mapping, nullptr)),
+      m_Data(std::exchange(other.m_Data, nullptr)),
+      m_Size(std::exchange(other.m_Size, 0))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_File    = std::exchange(other.m_File, INVALID_HANDLE_VALUE);
+        m_Mapping = std::exchange(other.m_Mapping, nullptr);
+        m_Data    = std::exchange(other.m_Data, nullptr);
+        m_Size    = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+void MappedFile::Close() noexcept
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+    m_Data    = nullptr;
+    m_Mapping = nullptr;
+    m_File    = INVALID_HANDLE_VALUE;
+    m_Size    = 0;
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::filesystem::path &path)
+{
+    m_File = open(path.c_str(), O_RDONLY);
+    if (m_File == -1)
+        throw std::runtime_error("Couldn't open file " + path.string());
+
+    struct stat status = {};
+    if (fstat(m_File, &status) != 0)
+    {
+        Close();
+        throw std::runtime_error("Couldn't query size of " + path.string());
+    }
+    m_Size = static_cast<size_t>(status.st_size);
+
+    // Empty files can't be mapped, but are still valid to read from
+    if (m_Size == 0)
+        return;
+
+    void *data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        throw std::runtime_error("Couldn't map file " + path.string());
+    }
+    m_Data = data;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_File(std::exchange(other.m_File, -1)),
+      m_Data(std::exchange(other.m_Data, nullptr)),
+      m_Size(std::exchange(other.m_Size, 0))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_File = std::exchange(other.m_File, -1);
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+void MappedFile::Close() noexcept
+{
+    if (m_Data)
+        munmap(const_cast<void *>(m_Data), m_Size);
+    if (m_File != -1)
+        close(m_File);
+    m_Data = nullptr;
+    m_File = -1;
+    m_Size = 0;
+}
+
+#endif
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed) noexcept
+{
+    // FNV-1a, good enough to detect a changed source file
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t             hash  = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pch.hpp"
+
+class MappedFile
+{
+#ifdef _WIN32
+    HANDLE m_File    = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#else
+    // The tests build outside of Windows
+    int m_File = -1;
+#endif
+    const void *m_Data = nullptr;
+    size_t      m_Size = 0;
+
+    void Close() noexcept;
+
+  public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path &path);
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+#ifdef _WIN32
+    bool IsOpen() const noexcept { return m_Data != nullptr || m_File != INVALID_HANDLE_VALUE; }
+#else
+    bool IsOpen() const noexcept { return m_Data != nullptr || m_File != -1; }
+#endif
+    const char *Data() const noexcept { return static_cast<const char *>(m_Data); }
+    size_t      Size() const noexcept { return m_Size; }
+};
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ull) noexcept;
@@ -0,0 +1,433 @@
+#include "MeshOptimizer.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    // Cache size used for scoring, bigger than any real post-transform cache on purpose
+    constexpr size_t FORSYTH_CACHE_SIZE  = 32;
+    constexpr size_t FORSYTH_MAX_VALENCE = 32;
+
+    class ForsythScores
+    {
+        float m_CacheScores[FORSYTH_CACHE_SIZE];
+        float m_ValenceScores[FORSYTH_MAX_VALENCE + 1];
+
+      public:
+        ForsythScores()
+        {
+            // The last triangle's vertices get a fixed score, so it isn't reused right away
+            for (size_t i = 0; i < 3; ++i)
+                m_CacheScores[i] = 0.75f;
+            for (size_t i = 3; i < FORSYTH_CACHE_SIZE; ++i)
+                m_CacheScores[i] = std::pow(1.0f - float(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+            m_ValenceScores[0] = 0.0f;
+            for (size_t i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+                m_ValenceScores[i] = 2.0f / std::sqrt(float(i));
+        }
+
+        float Score(int cachePosition, uint32_t valence) const noexcept
+        {
+            if (valence == 0)
+                return -1.0f;
+            float score = cachePosition < 0 ? 0.0f : m_CacheScores[cachePosition];
+            return score + m_ValenceScores[(std::min)(valence, uint32_t(FORSYTH_MAX_VALENCE))];
+        }
+    };
+
+    // FIFO cache simulation, a vertex is cached while less than cacheSize misses happened since it was loaded
+    class FifoCache
+    {
+        std::vector<size_t> m_Timestamps;
+        size_t              m_CacheSize;
+        size_t              m_Time;
+
+      public:
+        FifoCache(size_t vertexCount, size_t cacheSize)
+            : m_Timestamps(vertexCount, 0),
+              m_CacheSize(cacheSize),
+              m_Time(cacheSize + 1)
+        {
+        }
+
+        bool Access(uint32_t vertex) noexcept
+        {
+            if (m_Time - m_Timestamps[vertex] <= m_CacheSize)
+                return false;
+            m_Timestamps[vertex] = m_Time++;
+            return true;
+        }
+
+        unsigned Triangle(const uint32_t *triangle) noexcept
+        {
+            return unsigned(Access(triangle[0])) + Access(triangle[1]) + Access(triangle[2]);
+        }
+
+        void Reset() noexcept { m_Time += m_CacheSize + 1; }
+    };
+
+    XMFLOAT3 LoadPosition(const void *positions, size_t stride, uint32_t vertex) noexcept
+    {
+        XMFLOAT3 result;
+        std::memcpy(&result, static_cast<const char *>(positions) + stride * vertex, sizeof(result));
+        return result;
+    }
+} // namespace
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t *indices,
+                                                   size_t          indexCount,
+                                                   size_t          vertexCount,
+                                                   size_t          cacheSize)
+{
+    VertexCacheStats stats;
+    stats.TriangleCount = indexCount / 3;
+
+    std::vector<bool> used(vertexCount, false);
+    FifoCache         cache(vertexCount, cacheSize);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+        stats.Misses += cache.Triangle(indices + i);
+    for (size_t i = 0; i < indexCount; ++i)
+        used[indices[i]] = true;
+
+    stats.VertexCount = std::count(used.begin(), used.end(), true);
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount)
+{
+    static const ForsythScores scores;
+
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles adjacent to every vertex, flattened with offsets
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++valence[indices[i]];
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int>   cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScores[v] = scores.Score(-1, valence[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]]
+                          + vertexScores[indices[3 * t + 2]];
+
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t nextCandidate = 0;
+    size_t best          = 0;
+    while (result.size() < triangleCount * 3)
+    {
+        const uint32_t *triangle = indices + 3 * best;
+        emitted[best]            = true;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        // The emitted triangle goes to the front of the LRU cache
+        newCache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache.push_back(v);
+
+        for (size_t k = 0; k < 3; ++k)
+            --valence[triangle[k]];
+
+        for (size_t i = 0; i < newCache.size(); ++i)
+        {
+            uint32_t v        = newCache[i];
+            cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScores[v]   = scores.Score(cachePositions[v], valence[v]);
+        }
+        if (newCache.size() > FORSYTH_CACHE_SIZE)
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        std::swap(cache, newCache);
+
+        // Only triangles touching the cache changed their score, the best one is picked among them
+        float bestScore = -1.0f;
+        for (uint32_t v : cache)
+        {
+            for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+            {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]]
+                                  + vertexScores[indices[3 * t + 2]];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best      = t;
+                }
+            }
+        }
+
+        if (bestScore < 0.0f)
+        {
+            // Nothing adjacent is left, continue with the next triangle in the input order
+            while (nextCandidate < triangleCount && emitted[nextCandidate])
+                ++nextCandidate;
+            best = nextCandidate;
+        }
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t   *indices,
+                                     size_t      indexCount,
+                                     const void *positions,
+                                     size_t      positionStride,
+                                     size_t      vertexCount,
+                                     float       threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Hard boundaries are where the cache gets fully trashed, so reordering there is free
+    std::vector<size_t> hardBoundaries;
+    {
+        FifoCache cache(vertexCount, STATS_CACHE_SIZE);
+        for (size_t t = 0; t < triangleCount; ++t)
+            if (cache.Triangle(indices + 3 * t) == 3)
+                hardBoundaries.push_back(t);
+        hardBoundaries.push_back(triangleCount);
+    }
+
+    // Soft boundaries split hard clusters further as long as the cache efficiency stays within threshold
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertexCount, STATS_CACHE_SIZE);
+        for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c)
+        {
+            size_t start = hardBoundaries[c];
+            size_t end   = hardBoundaries[c + 1];
+
+            cache.Reset();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t)
+                clusterMisses += cache.Triangle(indices + 3 * t);
+            float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+            cache.Reset();
+            size_t softStart = start;
+            size_t misses    = 0;
+            clusters.push_back(start);
+            for (size_t t = start; t < end; ++t)
+            {
+                misses += cache.Triangle(indices + 3 * t);
+                if (t + 1 < end && float(misses) / float(t + 1 - softStart) <= clusterThreshold)
+                {
+                    clusters.push_back(t + 1);
+                    softStart = t + 1;
+                    misses    = 0;
+                    cache.Reset();
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    XMFLOAT3 meshCenter(0.0f, 0.0f, 0.0f);
+    {
+        std::vector<bool> used(vertexCount, false);
+        size_t            usedCount = 0;
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            if (used[indices[i]])
+                continue;
+            used[indices[i]] = true;
+            XMFLOAT3 p       = LoadPosition(positions, positionStride, indices[i]);
+            meshCenter.x += p.x;
+            meshCenter.y += p.y;
+            meshCenter.z += p.z;
+            ++usedCount;
+        }
+        meshCenter.x /= usedCount;
+        meshCenter.y /= usedCount;
+        meshCenter.z /= usedCount;
+    }
+
+    // Clusters facing away from the mesh center are likely to occlude the rest, so they go first
+    size_t             clusterCount = clusters.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        XMFLOAT3 center(0.0f, 0.0f, 0.0f);
+        XMFLOAT3 normal(0.0f, 0.0f, 0.0f);
+        float    area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            XMFLOAT3 p0 = LoadPosition(positions, positionStride, indices[3 * t]);
+            XMFLOAT3 p1 = LoadPosition(positions, positionStride, indices[3 * t + 1]);
+            XMFLOAT3 p2 = LoadPosition(positions, positionStride, indices[3 * t + 2]);
+
+            XMFLOAT3 e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+            XMFLOAT3 e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+            XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            float    triangleArea = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            center.x += (p0.x + p1.x + p2.x) / 3.0f * triangleArea;
+            center.y += (p0.y + p1.y + p2.y) / 3.0f * triangleArea;
+            center.z += (p0.z + p1.z + p2.z) / 3.0f * triangleArea;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += triangleArea;
+        }
+
+        float normalLength = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (area == 0.0f || normalLength == 0.0f)
+        {
+            sortKeys[c] = 0.0f;
+            continue;
+        }
+        sortKeys[c] = ((center.x / area - meshCenter.x) * normal.x + (center.y / area - meshCenter.y) * normal.y
+                       + (center.z / area - meshCenter.z) * normal.z)
+                    / normalLength;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    for (size_t c : order)
+        result.insert(result.end(), indices + 3 * clusters[c], indices + 3 * clusters[c + 1]);
+    std::copy(result.begin(), result.end(), indices);
+}
+
+std::vector<uint32_t> MeshOptimizer::VertexFetchRemap(const uint32_t *indices, size_t indexCount, size_t vertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t              next = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+        if (remap[indices[i]] == UINT32_MAX)
+            remap[indices[i]] = next++;
+    return remap;
+}
+
+void MeshOptimizer::Optimize(MeshData &mesh, VertexCacheStats &before, VertexCacheStats &after)
+{
+    std::vector<uint32_t> indices    = mesh.GetIndices();
+    size_t                indexCount = indices.size() - indices.size() % 3;
+
+    before = AnalyzeVertexCache(indices.data(), indexCount, mesh.VertexCount());
+    if (indexCount == 0)
+    {
+        after = before;
+        return;
+    }
+
+    OptimizeVertexCache(indices.data(), indexCount, mesh.VertexCount());
+    OptimizeOverdraw(
+        indices.data(), indexCount, mesh.VertexBufferStart(), mesh.SingleVertexSize(), mesh.VertexCount());
+
+    std::vector<uint32_t> remap       = VertexFetchRemap(indices.data(), indices.size(), mesh.VertexCount());
+    size_t                vertexSize  = mesh.SingleVertexSize();
+    size_t                vertexCount = 0;
+    for (uint32_t target : remap)
+        vertexCount += target != UINT32_MAX;
+
+    auto              source = static_cast<const char *>(mesh.VertexBufferStart());
+    std::vector<char> vertices(vertexCount * vertexSize);
+    for (size_t v = 0; v < remap.size(); ++v)
+        if (remap[v] != UINT32_MAX)
+            std::memcpy(vertices.data() + remap[v] * vertexSize, source + v * vertexSize, vertexSize);
+    for (uint32_t &index : indices)
+        index = remap[index];
+
+    mesh.ReplaceVertices(std::move(vertices), vertexCount, vertexSize);
+    mesh.SetIndices(indices, mesh.SingleIndexSize());
+
+    after = AnalyzeVertexCache(indices.data(), indexCount, mesh.VertexCount());
+}
+
+bool MeshOptimizer::NarrowIndices(MeshData &mesh)
+{
+    if (mesh.VertexCount() > MAX_16BIT_VERTICES)
+        return false;
+    if (mesh.SingleIndexSize() != sizeof(uint16_t))
+        mesh.SetIndices(mesh.GetIndices(), sizeof(uint16_t));
+    return true;
+}
+
+std::vector<MeshData> MeshOptimizer::Split(const MeshData &mesh, size_t maxVertices)
+{
+    std::vector<uint32_t> indices    = mesh.GetIndices();
+    size_t                vertexSize = mesh.SingleVertexSize();
+    auto                  source     = static_cast<const char *>(mesh.VertexBufferStart());
+
+    std::vector<MeshData> parts;
+    std::vector<uint32_t> remap(mesh.VertexCount(), UINT32_MAX);
+    std::vector<uint32_t> partVertices;
+    std::vector<uint32_t> partIndices;
+
+    auto flush = [&]() {
+        if (partIndices.empty())
+            return;
+        std::vector<char> vertices(partVertices.size() * vertexSize);
+        for (size_t v = 0; v < partVertices.size(); ++v)
+            std::memcpy(vertices.data() + v * vertexSize, source + partVertices[v] * vertexSize, vertexSize);
+
+        MeshData &part       = parts.emplace_back();
+        part.m_MaterialIndex = mesh.m_MaterialIndex;
+        part.m_VertexFormat  = mesh.m_VertexFormat;
+        part.m_BoundsMin     = mesh.m_BoundsMin;
+        part.m_BoundsMax     = mesh.m_BoundsMax;
+        part.ReplaceVertices(std::move(vertices), partVertices.size(), vertexSize);
+        part.SetIndices(partIndices, mesh.SingleIndexSize());
+
+        for (uint32_t v : partVertices)
+            remap[v] = UINT32_MAX;
+        partVertices.clear();
+        partIndices.clear();
+    };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        uint32_t a           = indices[t];
+        uint32_t b           = indices[t + 1];
+        uint32_t c           = indices[t + 2];
+        size_t   newVertices = size_t(remap[a] == UINT32_MAX) + (remap[b] == UINT32_MAX && b != a)
+                           + (remap[c] == UINT32_MAX && c != a && c != b);
+        if (partVertices.size() + newVertices > maxVertices)
+            flush();
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t &target = remap[indices[t + k]];
+            if (target == UINT32_MAX)
+            {
+                target = static_cast<uint32_t>(partVertices.size());
+                partVertices.push_back(indices[t + k]);
+            }
+            partIndices.push_back(target);
+        }
+    }
+    flush();
+    return parts;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "SceneData.hpp"
+
+// Result of running an index buffer through a FIFO post-transform cache
+struct VertexCacheStats
+{
+    size_t TriangleCount = 0;
+    size_t VertexCount   = 0;
+    size_t Misses        = 0;
+
+    // Average cache miss ratio, transformed vertices per triangle (0.5 is ideal, 3 is worst)
+    double ACMR() const noexcept { return TriangleCount ? static_cast<double>(Misses) / TriangleCount : 0.0; }
+    // Average transform to vertex ratio (1 is ideal)
+    double ATVR() const noexcept { return VertexCount ? static_cast<double>(Misses) / VertexCount : 0.0; }
+
+    VertexCacheStats &operator+=(const VertexCacheStats &other) noexcept
+    {
+        TriangleCount += other.TriangleCount;
+        VertexCount   += other.VertexCount;
+        Misses        += other.Misses;
+        return *this;
+    }
+};
+
+// Import time processing of triangle lists. Nothing here touches the GPU,
+// the passes only permute, split or repack indices and vertices of a MeshData.
+class MeshOptimizer
+{
+  public:
+    static constexpr size_t STATS_CACHE_SIZE   = 16;
+    static constexpr float  OVERDRAW_THRESHOLD = 1.05f;
+    static constexpr size_t MAX_16BIT_VERTICES = 65536;
+
+    MeshOptimizer() = delete;
+
+    static VertexCacheStats AnalyzeVertexCache(const uint32_t *indices,
+                                               size_t          indexCount,
+                                               size_t          vertexCount,
+                                               size_t          cacheSize = STATS_CACHE_SIZE);
+
+    // Forsyth's greedy triangle ordering for an LRU cache
+    static void OptimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount);
+
+    // Splits a cache optimized list into clusters and sorts them so that triangles facing
+    // outwards come first. threshold is the ACMR increase allowed to get smaller clusters.
+    static void OptimizeOverdraw(uint32_t   *indices,
+                                 size_t      indexCount,
+                                 const void *positions,
+                                 size_t      positionStride,
+                                 size_t      vertexCount,
+                                 float       threshold = OVERDRAW_THRESHOLD);
+
+    // Returns the new index of every vertex so that vertices are stored in the order
+    // of first use, unreferenced vertices get UINT32_MAX
+    static std::vector<uint32_t> VertexFetchRemap(const uint32_t *indices, size_t indexCount, size_t vertexCount);
+
+    // Runs all the passes above on a mesh whose vertices start with a float3 position
+    static void Optimize(MeshData &mesh, VertexCacheStats &before, VertexCacheStats &after);
+
+    // Switches to 16-bit indices if every vertex can be addressed by them, returns false otherwise
+    static bool NarrowIndices(MeshData &mesh);
+
+    // Cuts a mesh into consecutive runs of triangles that reference at most maxVertices vertices each.
+    // Triangle order is kept and every part stores its vertices in the order of first use.
+    static std::vector<MeshData> Split(const MeshData &mesh, size_t maxVertices = MAX_16BIT_VERTICES);
+};
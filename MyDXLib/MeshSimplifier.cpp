@@ -0,0 +1,350 @@
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    // A level that keeps more than this part of the previous level's indices isn't worth storing
+    constexpr float MIN_LOD_REDUCTION = 0.85f;
+    // Collapses in a pass may cost up to this times the cost at the first quartile
+    constexpr double PASS_COST_FACTOR = 2.0;
+
+    XMFLOAT3 LoadPosition(const void *positions, size_t stride, uint32_t vertex) noexcept
+    {
+        XMFLOAT3 result;
+        std::memcpy(&result, static_cast<const char *>(positions) + stride * vertex, sizeof(result));
+        return result;
+    }
+
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    // Sum of squared plane distances as a symmetric 4x4 matrix, weighted by triangle area
+    struct Quadric
+    {
+        double A00 = 0.0, A01 = 0.0, A02 = 0.0, A11 = 0.0, A12 = 0.0, A22 = 0.0;
+        double B0  = 0.0, B1 = 0.0, B2 = 0.0, C = 0.0;
+
+        double Weight = 0.0;
+
+        void AddPlane(double a, double b, double c, double d, double weight) noexcept
+        {
+            A00    += weight * a * a;
+            A01    += weight * a * b;
+            A02    += weight * a * c;
+            A11    += weight * b * b;
+            A12    += weight * b * c;
+            A22    += weight * c * c;
+            B0     += weight * a * d;
+            B1     += weight * b * d;
+            B2     += weight * c * d;
+            C      += weight * d * d;
+            Weight += weight;
+        }
+
+        // Mean squared distance of p to the planes
+        double Error(const XMFLOAT3 &p) const noexcept
+        {
+            if (Weight == 0.0)
+                return 0.0;
+            double x = p.x, y = p.y, z = p.z;
+            double e = A00 * x * x + A11 * y * y + A22 * z * z + 2.0 * (A01 * x * y + A02 * x * z + A12 * y * z)
+                     + 2.0 * (B0 * x + B1 * y + B2 * z) + C;
+            return (std::max)(e, 0.0) / Weight;
+        }
+
+        Quadric &operator+=(const Quadric &other) noexcept
+        {
+            A00    += other.A00;
+            A01    += other.A01;
+            A02    += other.A02;
+            A11    += other.A11;
+            A12    += other.A12;
+            A22    += other.A22;
+            B0     += other.B0;
+            B1     += other.B1;
+            B2     += other.B2;
+            C      += other.C;
+            Weight += other.Weight;
+            return *this;
+        }
+    };
+
+    // Keeps the quadrics between runs, so a chain of levels measures the error against the original mesh
+    class Simplifier
+    {
+        struct Collapse
+        {
+            uint32_t From;
+            uint32_t To;
+            double   Cost;
+        };
+
+        const void           *m_Positions;
+        size_t                m_Stride;
+        std::vector<uint32_t> m_Indices;
+        std::vector<Quadric>  m_Quadrics;
+        std::vector<bool>     m_Locked;
+        double                m_MaxError = 0.0;
+
+        // Triangles around every vertex, rebuilt every pass
+        std::vector<uint32_t> m_Offsets;
+        std::vector<uint32_t> m_Adjacency;
+
+        XMFLOAT3 Position(uint32_t vertex) const noexcept { return LoadPosition(m_Positions, m_Stride, vertex); }
+
+        void LockSeamsAndBorders(size_t vertexCount)
+        {
+            // Vertices with equal positions are found by sorting, borders are checked on the welded positions
+            std::vector<uint32_t> order(vertexCount);
+            std::iota(order.begin(), order.end(), 0);
+            auto key = [&](uint32_t v) {
+                XMFLOAT3 p = Position(v);
+                return std::make_tuple(p.x, p.y, p.z);
+            };
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+
+            std::vector<uint32_t> welded(vertexCount);
+            for (size_t begin = 0, end = 0; begin < vertexCount; begin = end)
+            {
+                for (end = begin + 1; end < vertexCount && key(order[end]) == key(order[begin]); ++end)
+                    ;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    welded[order[i]]   = order[begin];
+                    m_Locked[order[i]] = end - begin > 1;
+                }
+            }
+
+            auto edgeKey = [&](uint32_t a, uint32_t b) { return uint64_t(welded[a]) << 32 | welded[b]; };
+
+            std::unordered_map<uint64_t, uint32_t> edges;
+            for (size_t t = 0; t < m_Indices.size(); t += 3)
+                for (size_t k = 0; k < 3; ++k)
+                    ++edges[edgeKey(m_Indices[t + k], m_Indices[t + (k + 1) % 3])];
+
+            // Open and non manifold edges
+            for (size_t t = 0; t < m_Indices.size(); t += 3)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    uint32_t a        = m_Indices[t + k];
+                    uint32_t b        = m_Indices[t + (k + 1) % 3];
+                    auto     opposite = edges.find(edgeKey(b, a));
+                    if (opposite == edges.end() || opposite->second != 1 || edges[edgeKey(a, b)] != 1)
+                    {
+                        m_Locked[a] = true;
+                        m_Locked[b] = true;
+                    }
+                }
+            }
+        }
+
+        void BuildAdjacency()
+        {
+            m_Offsets.assign(m_Quadrics.size() + 1, 0);
+            for (uint32_t v : m_Indices)
+                ++m_Offsets[v + 1];
+            std::partial_sum(m_Offsets.begin(), m_Offsets.end(), m_Offsets.begin());
+
+            std::vector<uint32_t> fill(m_Offsets.begin(), m_Offsets.end() - 1);
+            m_Adjacency.resize(m_Indices.size());
+            for (size_t i = 0; i < m_Indices.size(); ++i)
+                m_Adjacency[fill[m_Indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // True if moving from onto to turns one of the remaining triangles around
+        bool Flips(uint32_t from, uint32_t to) const noexcept
+        {
+            XMFLOAT3 source = Position(from);
+            XMFLOAT3 target = Position(to);
+            for (uint32_t i = m_Offsets[from]; i < m_Offsets[from + 1]; ++i)
+            {
+                const uint32_t *triangle = &m_Indices[m_Adjacency[i] * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    continue;
+
+                size_t   k      = triangle[0] == from ? 0 : triangle[1] == from ? 1 : 2;
+                XMFLOAT3 a      = Position(triangle[(k + 1) % 3]);
+                XMFLOAT3 b      = Position(triangle[(k + 2) % 3]);
+                XMFLOAT3 before = Cross(Sub(a, source), Sub(b, source));
+                XMFLOAT3 after  = Cross(Sub(a, target), Sub(b, target));
+                if (Dot(before, after) <= 0.1f * std::sqrt(Dot(before, before) * Dot(after, after)))
+                    return true;
+            }
+            return false;
+        }
+
+      public:
+        Simplifier(const uint32_t *indices, size_t indexCount, const void *positions, size_t stride, size_t vertexCount)
+            : m_Positions(positions),
+              m_Stride(stride),
+              m_Indices(indices, indices + indexCount - indexCount % 3),
+              m_Quadrics(vertexCount),
+              m_Locked(vertexCount, false)
+        {
+            LockSeamsAndBorders(vertexCount);
+
+            for (size_t t = 0; t < m_Indices.size(); t += 3)
+            {
+                XMFLOAT3 p0     = Position(m_Indices[t]);
+                XMFLOAT3 normal = Cross(Sub(Position(m_Indices[t + 1]), p0), Sub(Position(m_Indices[t + 2]), p0));
+                double   length = std::sqrt(double(Dot(normal, normal)));
+                if (length == 0.0)
+                    continue;
+
+                double a = normal.x / length;
+                double b = normal.y / length;
+                double c = normal.z / length;
+                double d = -(a * p0.x + b * p0.y + c * p0.z);
+                for (size_t k = 0; k < 3; ++k)
+                    m_Quadrics[m_Indices[t + k]].AddPlane(a, b, c, d, length * 0.5);
+            }
+        }
+
+        const std::vector<uint32_t> &Indices() const noexcept { return m_Indices; }
+        float                        Error() const noexcept { return static_cast<float>(std::sqrt(m_MaxError)); }
+
+        void Run(size_t targetIndexCount)
+        {
+            size_t                targetTriangles = targetIndexCount / 3;
+            std::vector<Collapse> collapses;
+            std::vector<bool>     touched;
+            std::vector<uint32_t> remap;
+
+            while (m_Indices.size() / 3 > targetTriangles)
+            {
+                BuildAdjacency();
+
+                // Every interior edge shows up in two triangles, once in each direction
+                collapses.clear();
+                for (size_t t = 0; t < m_Indices.size(); t += 3)
+                {
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        uint32_t a = m_Indices[t + k];
+                        uint32_t b = m_Indices[t + (k + 1) % 3];
+                        if (a > b)
+                            continue;
+                        if (!m_Locked[a])
+                            collapses.push_back({a, b, m_Quadrics[a].Error(Position(b))});
+                        if (!m_Locked[b])
+                            collapses.push_back({b, a, m_Quadrics[b].Error(Position(a))});
+                    }
+                }
+                if (collapses.empty())
+                    break;
+                std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+                    return a.Cost < b.Cost || (a.Cost == b.Cost && a.From < b.From);
+                });
+                double costLimit = collapses[collapses.size() / 4].Cost * PASS_COST_FACTOR;
+
+                // Collapses in one pass must not share triangles, so the flip test stays valid
+                touched.assign(m_Quadrics.size(), false);
+                remap.resize(m_Quadrics.size());
+                std::iota(remap.begin(), remap.end(), 0);
+
+                size_t triangleCount = m_Indices.size() / 3;
+                size_t collapsed     = 0;
+                for (auto &&collapse : collapses)
+                {
+                    if (triangleCount <= targetTriangles || (collapsed != 0 && collapse.Cost > costLimit))
+                        break;
+                    if (touched[collapse.From] || touched[collapse.To] || Flips(collapse.From, collapse.To))
+                        continue;
+
+                    for (uint32_t i = m_Offsets[collapse.From]; i < m_Offsets[collapse.From + 1]; ++i)
+                    {
+                        const uint32_t *triangle = &m_Indices[m_Adjacency[i] * 3];
+                        for (size_t k = 0; k < 3; ++k)
+                            touched[triangle[k]] = true;
+                        if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To)
+                            --triangleCount;
+                    }
+                    m_Quadrics[collapse.To] += m_Quadrics[collapse.From];
+                    ++collapsed;
+
+                    remap[collapse.From] = collapse.To;
+                    m_MaxError           = (std::max)(m_MaxError, collapse.Cost);
+                }
+                if (collapsed == 0)
+                    break;
+
+                size_t count = 0;
+                for (size_t t = 0; t < m_Indices.size(); t += 3)
+                {
+                    uint32_t a = remap[m_Indices[t]];
+                    uint32_t b = remap[m_Indices[t + 1]];
+                    uint32_t c = remap[m_Indices[t + 2]];
+                    if (a == b || b == c || a == c)
+                        continue;
+                    m_Indices[count++] = a;
+                    m_Indices[count++] = b;
+                    m_Indices[count++] = c;
+                }
+                m_Indices.resize(count);
+            }
+        }
+    };
+} // namespace
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const uint32_t *indices,
+                                               size_t          indexCount,
+                                               const void     *positions,
+                                               size_t          positionStride,
+                                               size_t          vertexCount,
+                                               size_t          targetIndexCount,
+                                               float          *error)
+{
+    Simplifier simplifier(indices, indexCount, positions, positionStride, vertexCount);
+    simplifier.Run(targetIndexCount);
+    if (error)
+        *error = simplifier.Error();
+    return simplifier.Indices();
+}
+
+void MeshSimplifier::GenerateLods(MeshData &mesh, size_t levelCount, float ratio)
+{
+    if (mesh.m_VertexFormat != VERTEX_FORMAT_FULL)
+        throw std::exception("LODs can only be generated before the vertices are encoded");
+
+    mesh.m_Lods.clear();
+    std::vector<uint32_t> indices    = mesh.GetIndices();
+    size_t                indexCount = indices.size() - indices.size() % 3;
+    if (indexCount == 0 || levelCount < 2)
+        return;
+
+    Simplifier simplifier(
+        indices.data(), indexCount, mesh.VertexBufferStart(), mesh.SingleVertexSize(), mesh.VertexCount());
+
+    std::vector<MeshLod> lods          = {{0, static_cast<uint32_t>(indices.size()), 0.0f}};
+    size_t               previousCount = indexCount;
+    float                targetRatio   = 1.0f;
+    for (size_t level = 1; level < levelCount; ++level)
+    {
+        targetRatio *= ratio;
+        simplifier.Run(static_cast<size_t>(indexCount * targetRatio));
+
+        auto &&result = simplifier.Indices();
+        if (result.empty() || result.size() > previousCount * MIN_LOD_REDUCTION)
+            break;
+
+        MeshLod lod = {static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(result.size()), simplifier.Error()};
+        indices.insert(indices.end(), result.begin(), result.end());
+        MeshOptimizer::OptimizeVertexCache(indices.data() + lod.IndexOffset, lod.IndexCount, mesh.VertexCount());
+        lods.push_back(lod);
+        previousCount = result.size();
+    }
+    if (lods.size() < 2)
+        return;
+
+    mesh.SetIndices(indices, mesh.SingleIndexSize());
+    mesh.m_Lods = std::move(lods);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "SceneData.hpp"
+
+// Quadric error metric simplification by half edge collapses. Vertices are never moved or created,
+// so every level indexes the original vertex buffer. Vertices sharing their position with another
+// vertex (UV or normal seams) and vertices on open borders are locked, which keeps seams intact.
+class MeshSimplifier
+{
+  public:
+    static constexpr size_t MAX_LODS  = 4;
+    static constexpr float  LOD_RATIO = 0.5f;
+
+    MeshSimplifier() = delete;
+
+    // Reduces a triangle list to at most targetIndexCount indices if the locked vertices allow it.
+    // error receives the largest distance of a collapsed vertex to its accumulated planes.
+    static std::vector<uint32_t> Simplify(const uint32_t *indices,
+                                          size_t          indexCount,
+                                          const void     *positions,
+                                          size_t          positionStride,
+                                          size_t          vertexCount,
+                                          size_t          targetIndexCount,
+                                          float          *error = nullptr);
+
+    // Appends up to levelCount - 1 simplified levels, each with ratio times the triangles of the
+    // previous one, to the index buffer and fills mesh.m_Lods. Level 0 is the original index range.
+    // Levels that hardly remove anything end the chain.
+    static void GenerateLods(MeshData &mesh, size_t levelCount = MAX_LODS, float ratio = LOD_RATIO);
+};
@@ -0,0 +1,178 @@
+#include "MeshletBuilder.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    bool Normalize(XMFLOAT3 &v) noexcept
+    {
+        float length = std::sqrt(Dot(v, v));
+        if (length == 0.0f)
+            return false;
+        v = XMFLOAT3(v.x / length, v.y / length, v.z / length);
+        return true;
+    }
+} // namespace
+
+MeshletView MeshletView::FromMatrices(FXMMATRIX modelView, CXMMATRIX projection)
+{
+    MeshletView view;
+    view.ObjectFrustum = Frustum::FromMatrix(XMMatrixMultiply(modelView, projection));
+
+    XMFLOAT4X4 inverse;
+    XMStoreFloat4x4(&inverse, XMMatrixInverse(nullptr, modelView));
+    view.CameraPos = XMFLOAT3(inverse(3, 0), inverse(3, 1), inverse(3, 2));
+    return view;
+}
+
+void MeshletBuilder::Build(MeshData &mesh, size_t maxVertices, size_t maxTriangles)
+{
+    if (maxVertices > 256 || maxVertices < 3 || maxTriangles == 0)
+        throw std::exception("Meshlet limits don't fit 8-bit local indices");
+    if (mesh.m_VertexFormat != VERTEX_FORMAT_FULL || mesh.SingleVertexSize() != sizeof(VertexData))
+        throw std::exception("Meshlets can only be built from VertexData");
+
+    std::vector<uint32_t> indices  = mesh.GetIndices();
+    auto                  vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+    if (!mesh.m_Lods.empty())
+        indices.resize(mesh.m_Lods[0].IndexCount);
+
+    mesh.m_Meshlets.clear();
+    mesh.m_MeshletVertices.clear();
+    mesh.m_MeshletTriangles.clear();
+
+    // Meshlet local index of every vertex, only valid for the vertices of the current meshlet
+    std::vector<uint8_t>    localIndex(mesh.VertexCount(), 0);
+    std::vector<bool>       inMeshlet(mesh.VertexCount(), false);
+    std::vector<VertexData> triangles;
+
+    Meshlet current = {};
+
+    auto finishMeshlet = [&]() {
+        if (current.TriangleCount == 0)
+            return;
+        triangles.clear();
+        for (size_t i = 0; i < current.TriangleCount * 3; ++i)
+            triangles.push_back(vertices[indices[current.IndexOffset + i]]);
+        ComputeBounds(current, triangles.data(), current.TriangleCount);
+        mesh.m_Meshlets.push_back(current);
+
+        for (size_t v = current.VertexOffset; v < mesh.m_MeshletVertices.size(); ++v)
+            inMeshlet[mesh.m_MeshletVertices[v]] = false;
+
+        uint32_t nextIndex     = current.IndexOffset + current.TriangleCount * 3;
+        current                = {};
+        current.VertexOffset   = static_cast<uint32_t>(mesh.m_MeshletVertices.size());
+        current.TriangleOffset = static_cast<uint32_t>(mesh.m_MeshletTriangles.size() / 3);
+        current.IndexOffset    = nextIndex;
+    };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        uint32_t a           = indices[t];
+        uint32_t b           = indices[t + 1];
+        uint32_t c           = indices[t + 2];
+        size_t   newVertices = size_t(!inMeshlet[a]) + (!inMeshlet[b] && b != a) + (!inMeshlet[c] && c != a && c != b);
+        if (current.VertexCount + newVertices > maxVertices || current.TriangleCount + 1 > maxTriangles)
+            finishMeshlet();
+
+        for (uint32_t v : {a, b, c})
+        {
+            if (!inMeshlet[v])
+            {
+                inMeshlet[v]  = true;
+                localIndex[v] = static_cast<uint8_t>(current.VertexCount++);
+                mesh.m_MeshletVertices.push_back(v);
+            }
+            mesh.m_MeshletTriangles.push_back(localIndex[v]);
+        }
+        ++current.TriangleCount;
+    }
+    finishMeshlet();
+}
+
+void MeshletBuilder::ComputeBounds(Meshlet &meshlet, const VertexData *triangles, size_t triangleCount)
+{
+    // Sphere around the box center, good enough for clusters this small
+    XMFLOAT3 lo = triangles[0].pos;
+    XMFLOAT3 hi = triangles[0].pos;
+    for (size_t i = 1; i < triangleCount * 3; ++i)
+    {
+        const XMFLOAT3 &p = triangles[i].pos;
+        lo                = XMFLOAT3((std::min)(lo.x, p.x), (std::min)(lo.y, p.y), (std::min)(lo.z, p.z));
+        hi                = XMFLOAT3((std::max)(hi.x, p.x), (std::max)(hi.y, p.y), (std::max)(hi.z, p.z));
+    }
+    XMFLOAT3 center((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+    float    radius2 = 0.0f;
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        XMFLOAT3 d = Sub(triangles[i].pos, center);
+        radius2    = (std::max)(radius2, Dot(d, d));
+    }
+    meshlet.Sphere = XMFLOAT4(center.x, center.y, center.z, std::sqrt(radius2));
+
+    // A cone with cutoff 1 never culls
+    meshlet.ConeApex = center;
+    meshlet.Cone     = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    std::vector<std::pair<const VertexData *, XMFLOAT3>> faces;
+    XMFLOAT3                                             axis(0.0f, 0.0f, 0.0f);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const VertexData *v = triangles + 3 * t;
+        XMFLOAT3          n = Cross(Sub(v[1].pos, v[0].pos), Sub(v[2].pos, v[0].pos));
+        if (!Normalize(n))
+            continue;
+        if (Dot(n, v[0].normal) + Dot(n, v[1].normal) + Dot(n, v[2].normal) < 0.0f)
+            n = XMFLOAT3(-n.x, -n.y, -n.z);
+        faces.emplace_back(v, n);
+        axis = XMFLOAT3(axis.x + n.x, axis.y + n.y, axis.z + n.z);
+    }
+    if (faces.empty() || !Normalize(axis))
+        return;
+
+    // Too wide cones are rejected, they would hardly ever cull
+    float minDot = 1.0f;
+    for (auto &&[v, n] : faces)
+        minDot = (std::min)(minDot, Dot(axis, n));
+    if (minDot <= 0.1f)
+        return;
+
+    // Moves the apex back along the axis until it is behind every triangle plane
+    float maxT = 0.0f;
+    for (auto &&[v, n] : faces)
+        maxT = (std::max)(maxT, Dot(Sub(center, v[0].pos), n) / Dot(axis, n));
+
+    meshlet.ConeApex = XMFLOAT3(center.x - axis.x * maxT, center.y - axis.y * maxT, center.z - axis.z * maxT);
+    meshlet.Cone     = XMFLOAT4(axis.x, axis.y, axis.z, std::sqrt(1.0f - minDot * minDot));
+}
+
+bool MeshletBuilder::IsInFrustum(const Meshlet &meshlet, const MeshletView &view) noexcept
+{
+    for (auto &&plane : view.ObjectFrustum.Planes)
+    {
+        float distance = plane.x * meshlet.Sphere.x + plane.y * meshlet.Sphere.y + plane.z * meshlet.Sphere.z + plane.w;
+        if (distance < -meshlet.Sphere.w)
+            return false;
+    }
+    return true;
+}
+
+bool MeshletBuilder::IsBackFacing(const Meshlet &meshlet, const MeshletView &view) noexcept
+{
+    if (meshlet.Cone.w >= 1.0f)
+        return false;
+    XMFLOAT3 toApex = Sub(meshlet.ConeApex, view.CameraPos);
+    if (!Normalize(toApex))
+        return false;
+    return Dot(toApex, XMFLOAT3(meshlet.Cone.x, meshlet.Cone.y, meshlet.Cone.z)) >= meshlet.Cone.w;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "FrustumCuller.hpp"
+#include "SceneData.hpp"
+
+// Frustum planes and camera position in the object space of a mesh
+struct MeshletView
+{
+    Frustum           ObjectFrustum;
+    DirectX::XMFLOAT3 CameraPos;
+
+    static MeshletView FromMatrices(DirectX::FXMMATRIX modelView, DirectX::CXMMATRIX projection);
+};
+
+// Splits a mesh into meshlets and computes their culling bounds. This is CPU only,
+// the meshlets are currently consumed by Mesh::Draw to skip invisible index ranges.
+class MeshletBuilder
+{
+  public:
+    static constexpr size_t MAX_VERTICES  = 64;
+    static constexpr size_t MAX_TRIANGLES = 124;
+
+    MeshletBuilder() = delete;
+
+    // Walks the triangles in index buffer order, so the mesh should be cache optimized first.
+    // Only works on VertexData, i.e. before the vertices get encoded. Only LOD 0 is covered.
+    static void Build(MeshData &mesh, size_t maxVertices = MAX_VERTICES, size_t maxTriangles = MAX_TRIANGLES);
+
+    // Bounding sphere and normal cone of triangleCount triangles given as three vertices each.
+    // Face normals are flipped to agree with the vertex normals, so the cone doesn't depend
+    // on the winding convention.
+    static void ComputeBounds(Meshlet &meshlet, const VertexData *triangles, size_t triangleCount);
+
+    static bool IsInFrustum(const Meshlet &meshlet, const MeshletView &view) noexcept;
+    static bool IsBackFacing(const Meshlet &meshlet, const MeshletView &view) noexcept;
+    static bool IsVisible(const Meshlet &meshlet, const MeshletView &view) noexcept
+    {
+        return IsInFrustum(meshlet, view) && !IsBackFacing(meshlet, view);
+    }
+};
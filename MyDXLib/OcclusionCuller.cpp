@@ -0,0 +1,306 @@
+#include "OcclusionCuller.hpp"
+#include "ThreadPool.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    // The near plane and the four sides of the guard band
+    constexpr size_t CLIP_PLANES = 5;
+    // Clipping a triangle against a plane adds at most one vertex
+    constexpr size_t MAX_CLIPPED_VERTICES = 3 + CLIP_PLANES;
+
+    // Positive on the inner side of the plane
+    float ClipDistance(const XMFLOAT4 &v, size_t plane, float nearDepth) noexcept
+    {
+        switch (plane)
+        {
+        case 0: return v.w - nearDepth;
+        case 1: return OcclusionCuller::GUARD_BAND * v.w - v.x;
+        case 2: return OcclusionCuller::GUARD_BAND * v.w + v.x;
+        case 3: return OcclusionCuller::GUARD_BAND * v.w - v.y;
+        default: return OcclusionCuller::GUARD_BAND * v.w + v.y;
+        }
+    }
+} // namespace
+
+OcclusionCuller::OcclusionCuller(size_t width, size_t height)
+    : m_TilesX((width + TILE_WIDTH - 1) / TILE_WIDTH),
+      m_TilesY((height + TILE_HEIGHT - 1) / TILE_HEIGHT)
+{
+    if (m_TilesX == 0 || m_TilesY == 0)
+        throw std::exception("Occlusion buffer needs at least one tile");
+
+    m_Width  = m_TilesX * TILE_WIDTH;
+    m_Height = m_TilesY * TILE_HEIGHT;
+    m_Depth.resize(m_Width * m_Height, 0.0f);
+    m_Bins.resize(m_TilesX * m_TilesY);
+}
+
+float OcclusionCuller::NearDepth(FXMMATRIX projection) noexcept
+{
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, projection);
+
+    // z = a * depth + b, the near plane is where z = 0 or where z = w, the other one is the far plane
+    float a      = m(2, 2);
+    float b      = m(3, 2);
+    float atZero = a != 0.0f ? -b / a : INFINITY;
+    float atW    = a != 1.0f ? b / (1.0f - a) : INFINITY;
+    if (atZero <= 0.0f)
+        return atW;
+    if (atW <= 0.0f)
+        return atZero;
+    return (std::min)(atZero, atW);
+}
+
+void OcclusionCuller::Render(const std::vector<Occluder> &occluders, float nearDepth)
+{
+    m_NearDepth = nearDepth;
+
+    m_Triangles.resize(occluders.size());
+    ThreadPool::Shared().ParallelFor(occluders.size(), [&](size_t i) { SetupTriangles(occluders[i], m_Triangles[i]); });
+
+    for (auto &bin : m_Bins)
+        bin.clear();
+    for (auto &&triangles : m_Triangles)
+    {
+        for (auto &&triangle : triangles)
+        {
+            for (size_t y = triangle.MinY / TILE_HEIGHT; y <= triangle.MaxY / TILE_HEIGHT; ++y)
+                for (size_t x = triangle.MinX / TILE_WIDTH; x <= triangle.MaxX / TILE_WIDTH; ++x)
+                    m_Bins[y * m_TilesX + x].push_back(&triangle);
+        }
+    }
+
+    ThreadPool::Shared().ParallelFor(m_Bins.size(), [&](size_t tile) { RasterizeTile(tile); });
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder &occluder, std::vector<Triangle> &triangles) const
+{
+    triangles.clear();
+
+    XMFLOAT4 polygon[MAX_CLIPPED_VERTICES];
+    XMFLOAT4 clipped[MAX_CLIPPED_VERTICES];
+    XMFLOAT3 screen[MAX_CLIPPED_VERTICES];
+    for (size_t t = 0; t + 2 < occluder.IndexCount; t += 3)
+    {
+        uint32_t outsideAll = ~0u;
+        uint32_t outsideAny = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            XMVECTOR position = XMLoadFloat3(&occluder.Positions[occluder.Indices[t + k]]);
+            XMStoreFloat4(&polygon[k], XMVector3Transform(position, occluder.WorldViewProjection));
+
+            uint32_t outside = 0;
+            for (size_t p = 0; p < CLIP_PLANES; ++p)
+                if (ClipDistance(polygon[k], p, m_NearDepth) < 0.0f)
+                    outside |= 1u << p;
+            outsideAll &= outside;
+            outsideAny |= outside;
+        }
+        if (outsideAll != 0)
+            continue;
+
+        size_t count = 3;
+        for (size_t p = 0; p < CLIP_PLANES && count >= 3; ++p)
+        {
+            if ((outsideAny & (1u << p)) == 0)
+                continue;
+
+            size_t clippedCount = 0;
+            for (size_t k = 0; k < count; ++k)
+            {
+                const XMFLOAT4 &from   = polygon[k];
+                const XMFLOAT4 &to     = polygon[(k + 1) % count];
+                float           dFrom  = ClipDistance(from, p, m_NearDepth);
+                float           dTo    = ClipDistance(to, p, m_NearDepth);
+                bool            inFrom = dFrom >= 0.0f;
+                if (inFrom)
+                    clipped[clippedCount++] = from;
+                if (inFrom != (dTo >= 0.0f))
+                {
+                    XMVECTOR crossing = XMVectorLerp(XMLoadFloat4(&from), XMLoadFloat4(&to), dFrom / (dFrom - dTo));
+                    XMStoreFloat4(&clipped[clippedCount++], crossing);
+                }
+            }
+            std::copy(clipped, clipped + clippedCount, polygon);
+            count = clippedCount;
+        }
+        if (count < 3)
+            continue;
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            float invW = 1.0f / polygon[k].w;
+            screen[k]  = XMFLOAT3((polygon[k].x * invW * 0.5f + 0.5f) * m_Width,
+                                 (0.5f - polygon[k].y * invW * 0.5f) * m_Height,
+                                 invW);
+        }
+        for (size_t k = 1; k + 1 < count; ++k)
+            AddTriangle(screen[0], screen[k], screen[k + 1], triangles);
+    }
+}
+
+void OcclusionCuller::AddTriangle(const XMFLOAT3       &a,
+                                  const XMFLOAT3       &b,
+                                  const XMFLOAT3       &c,
+                                  std::vector<Triangle> &triangles) const
+{
+    // Clockwise on screen is front facing, as in the default rasterizer state
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area <= 0.0f)
+        return;
+
+    float   minX  = (std::min)({a.x, b.x, c.x});
+    float   minY  = (std::min)({a.y, b.y, c.y});
+    float   maxX  = (std::max)({a.x, b.x, c.x});
+    float   maxY  = (std::max)({a.y, b.y, c.y});
+    int32_t lastX = static_cast<int32_t>(m_Width) - 1;
+    int32_t lastY = static_cast<int32_t>(m_Height) - 1;
+
+    Triangle triangle;
+    triangle.MinX = (std::max)(static_cast<int32_t>(std::ceil(minX - 0.5f)), 0);
+    triangle.MinY = (std::max)(static_cast<int32_t>(std::ceil(minY - 0.5f)), 0);
+    triangle.MaxX = (std::min)(static_cast<int32_t>(std::floor(maxX - 0.5f)), lastX);
+    triangle.MaxY = (std::min)(static_cast<int32_t>(std::floor(maxY - 0.5f)), lastY);
+    if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+        return;
+
+    // Triangles sharing an edge set it up from the same vertex, their tests are then exact negations
+    // of each other and a pixel center on the edge can't fall through between them
+    const XMFLOAT3 *vertices[3] = {&a, &b, &c};
+    for (size_t k = 0; k < 3; ++k)
+    {
+        const XMFLOAT3 *from    = vertices[k];
+        const XMFLOAT3 *to      = vertices[(k + 1) % 3];
+        bool            swapped = to->y < from->y || (to->y == from->y && to->x < from->x);
+        if (swapped)
+            std::swap(from, to);
+
+        float ea          = from->y - to->y;
+        float eb          = to->x - from->x;
+        float ec          = -(ea * from->x + eb * from->y);
+        triangle.Edges[k] = swapped ? XMFLOAT3(-ea, -eb, -ec) : XMFLOAT3(ea, eb, ec);
+    }
+
+    // Moving half a pixel against the gradient gives the farthest depth within the pixel
+    float za       = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+    float zb       = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+    float zc       = a.z - za * a.x - zb * a.y - 0.5f * (std::abs(za) + std::abs(zb));
+    triangle.Depth = XMFLOAT3(za, zb, zc);
+    triangles.push_back(triangle);
+}
+
+void OcclusionCuller::RasterizeTile(size_t tile)
+{
+    int32_t tileMinX = static_cast<int32_t>(tile % m_TilesX * TILE_WIDTH);
+    int32_t tileMinY = static_cast<int32_t>(tile / m_TilesX * TILE_HEIGHT);
+    int32_t tileMaxX = tileMinX + static_cast<int32_t>(TILE_WIDTH) - 1;
+    int32_t tileMaxY = tileMinY + static_cast<int32_t>(TILE_HEIGHT) - 1;
+
+    for (int32_t y = tileMinY; y <= tileMaxY; ++y)
+        std::fill_n(&m_Depth[y * m_Width + tileMinX], TILE_WIDTH, 0.0f);
+
+    // Four pixels of a row at once, pixels outside of the triangle fail the edge tests
+    XMVECTOR laneCenters = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+    XMVECTOR zero        = XMVectorZero();
+    for (const Triangle *triangle : m_Bins[tile])
+    {
+        int32_t minX = (std::max)(triangle->MinX, tileMinX) & ~3;
+        int32_t maxX = (std::min)(triangle->MaxX, tileMaxX);
+        int32_t minY = (std::max)(triangle->MinY, tileMinY);
+        int32_t maxY = (std::min)(triangle->MaxY, tileMaxY);
+
+        XMVECTOR edgeA[3];
+        XMVECTOR edgeB[3];
+        XMVECTOR edgeC[3];
+        for (size_t k = 0; k < 3; ++k)
+        {
+            edgeA[k] = XMVectorReplicate(triangle->Edges[k].x);
+            edgeB[k] = XMVectorReplicate(triangle->Edges[k].y);
+            edgeC[k] = XMVectorReplicate(triangle->Edges[k].z);
+        }
+        XMVECTOR depthA = XMVectorReplicate(triangle->Depth.x);
+        XMVECTOR depthB = XMVectorReplicate(triangle->Depth.y);
+        XMVECTOR depthC = XMVectorReplicate(triangle->Depth.z);
+
+        for (int32_t y = minY; y <= maxY; ++y)
+        {
+            XMVECTOR centerY = XMVectorReplicate(y + 0.5f);
+            XMVECTOR rowEdges[3];
+            for (size_t k = 0; k < 3; ++k)
+                rowEdges[k] = XMVectorMultiplyAdd(edgeB[k], centerY, edgeC[k]);
+            XMVECTOR rowDepth = XMVectorMultiplyAdd(depthB, centerY, depthC);
+
+            float *row = &m_Depth[y * m_Width];
+            for (int32_t x = minX; x <= maxX; x += 4)
+            {
+                XMVECTOR centerX = XMVectorReplicate(static_cast<float>(x)) + laneCenters;
+                XMVECTOR edge0   = XMVectorMultiplyAdd(edgeA[0], centerX, rowEdges[0]);
+                XMVECTOR edge1   = XMVectorMultiplyAdd(edgeA[1], centerX, rowEdges[1]);
+                XMVECTOR edge2   = XMVectorMultiplyAdd(edgeA[2], centerX, rowEdges[2]);
+                XMVECTOR inside  = XMVectorAndInt(XMVectorGreaterOrEqual(edge0, zero),
+                                                 XMVectorAndInt(XMVectorGreaterOrEqual(edge1, zero),
+                                                                XMVectorGreaterOrEqual(edge2, zero)));
+
+                XMVECTOR depth    = XMVectorMultiplyAdd(depthA, centerX, rowDepth);
+                XMVECTOR previous = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(row + x));
+                XMVECTOR nearest  = XMVectorSelect(previous, XMVectorMax(previous, depth), inside);
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(row + x), nearest);
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsOccluded(const XMFLOAT3 &boundsMin,
+                                 const XMFLOAT3 &boundsMax,
+                                 FXMMATRIX       worldViewProjection) const
+{
+    float minX    = INFINITY;
+    float minY    = INFINITY;
+    float maxX    = -INFINITY;
+    float maxY    = -INFINITY;
+    float nearest = 0.0f;
+    for (size_t k = 0; k < 8; ++k)
+    {
+        XMFLOAT3 corner((k & 1) ? boundsMax.x : boundsMin.x,
+                        (k & 2) ? boundsMax.y : boundsMin.y,
+                        (k & 4) ? boundsMax.z : boundsMin.z);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corner), worldViewProjection));
+
+        // Boxes reaching past the near plane are never occluded
+        if (clip.w < m_NearDepth)
+            return false;
+
+        float invW = 1.0f / clip.w;
+        float x    = (clip.x * invW * 0.5f + 0.5f) * m_Width;
+        float y    = (0.5f - clip.y * invW * 0.5f) * m_Height;
+        minX       = (std::min)(minX, x);
+        minY       = (std::min)(minY, y);
+        maxX       = (std::max)(maxX, x);
+        maxY       = (std::max)(maxY, y);
+        nearest    = (std::max)(nearest, invW);
+    }
+
+    // Every pixel the rectangle touches, widened to groups of four
+    int32_t pixelMinX = (std::max)(static_cast<int32_t>(std::floor(minX)), 0) & ~3;
+    int32_t pixelMinY = (std::max)(static_cast<int32_t>(std::floor(minY)), 0);
+    int32_t pixelMaxX = (std::min)(static_cast<int32_t>(std::ceil(maxX)), int32_t(m_Width)) - 1;
+    int32_t pixelMaxY = (std::min)(static_cast<int32_t>(std::ceil(maxY)), int32_t(m_Height)) - 1;
+    if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+        return false;
+
+    XMVECTOR boxDepth = XMVectorReplicate(nearest);
+    for (int32_t y = pixelMinY; y <= pixelMaxY; ++y)
+    {
+        const float *row = &m_Depth[y * m_Width];
+        for (int32_t x = pixelMinX; x <= pixelMaxX; x += 4)
+        {
+            if (!XMVector4Greater(XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(row + x)), boxDepth))
+                return false;
+        }
+    }
+    return true;
+}
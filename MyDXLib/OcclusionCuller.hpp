@@ -0,0 +1,75 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Low resolution software depth buffer for occlusion culling. It stores 1 / view depth, 0 being empty,
+// so it works the same with either depth direction. Front facing occluder triangles write every pixel
+// whose center they cover, with the farthest depth their plane has within that pixel. A box is occluded
+// when its nearest point is behind every pixel it touches. Like any coverage by pixel centers this can
+// be off by half a pixel at the silhouettes of the occluders.
+class OcclusionCuller
+{
+  public:
+    static constexpr size_t TILE_WIDTH     = 32;
+    static constexpr size_t TILE_HEIGHT    = 16;
+    static constexpr size_t DEFAULT_WIDTH  = 256;
+    static constexpr size_t DEFAULT_HEIGHT = 144;
+
+    // Triangles are clipped to this multiple of the viewport to keep the edge functions precise
+    static constexpr float GUARD_BAND = 2.0f;
+
+    struct Occluder
+    {
+        DirectX::XMMATRIX        WorldViewProjection;
+        const DirectX::XMFLOAT3 *Positions;
+        const uint32_t          *Indices;
+        size_t                   IndexCount;
+    };
+
+  private:
+    struct Triangle
+    {
+        DirectX::XMFLOAT3 Edges[3]; // a * x + b * y + c >= 0 for pixel centers inside the triangle
+        DirectX::XMFLOAT3 Depth;    // a * x + b * y + c at a pixel center is the farthest depth within it
+        int32_t           MinX;     // Inclusive bounds of the pixel centers
+        int32_t           MinY;
+        int32_t           MaxX;
+        int32_t           MaxY;
+    };
+
+    size_t             m_Width;
+    size_t             m_Height;
+    size_t             m_TilesX;
+    size_t             m_TilesY;
+    float              m_NearDepth = 0.0f;
+    std::vector<float> m_Depth;
+
+    std::vector<std::vector<Triangle>>         m_Triangles; // For every occluder
+    std::vector<std::vector<const Triangle *>> m_Bins;      // For every tile
+
+    void SetupTriangles(const Occluder &occluder, std::vector<Triangle> &triangles) const;
+    void AddTriangle(const DirectX::XMFLOAT3 &a,
+                     const DirectX::XMFLOAT3 &b,
+                     const DirectX::XMFLOAT3 &c,
+                     std::vector<Triangle>   &triangles) const;
+    void RasterizeTile(size_t tile);
+
+  public:
+    // The size is rounded up to whole tiles
+    explicit OcclusionCuller(size_t width = DEFAULT_WIDTH, size_t height = DEFAULT_HEIGHT);
+
+    // View depth of the near plane of a projection with w = view depth, for either depth direction
+    static float NearDepth(DirectX::FXMMATRIX projection) noexcept;
+
+    // Clears the buffer and rasterizes the occluders, clipped at nearDepth. Triangles are set up
+    // in parallel per occluder, then binned and rasterized in parallel per tile.
+    void Render(const std::vector<Occluder> &occluders, float nearDepth);
+
+    bool IsOccluded(const DirectX::XMFLOAT3 &boundsMin,
+                    const DirectX::XMFLOAT3 &boundsMax,
+                    DirectX::FXMMATRIX       worldViewProjection) const;
+
+    size_t       GetWidth() const noexcept { return m_Width; }
+    size_t       GetHeight() const noexcept { return m_Height; }
+    const float *GetDepth() const noexcept { return m_Depth.data(); }
+};
@@ -0,0 +1,28 @@
+#include "ParallelRecorder.hpp"
+
+size_t ParallelRecorder::ChunkCount(size_t drawCount) const noexcept
+{
+    return std::clamp(drawCount / MIN_CHUNK_DRAWS, size_t(1), m_ThreadPool.ThreadCount());
+}
+
+void ParallelRecorder::Record(size_t                              drawCount,
+                              const std::vector<RenderBackend *> &backends,
+                              const RecordFunction               &record)
+{
+    size_t chunkCount = backends.size();
+    m_Chunks.resize(chunkCount);
+    m_ThreadPool.ParallelFor(chunkCount, [&](size_t chunk) {
+        RenderCommands &commands = m_Chunks[chunk];
+        commands.Clear();
+        record(commands, drawCount * chunk / chunkCount, drawCount * (chunk + 1) / chunkCount);
+        commands.Replay(*backends[chunk]);
+    });
+}
+
+size_t ParallelRecorder::GetCommandCount() const noexcept
+{
+    size_t count = 0;
+    for (auto &&commands : m_Chunks)
+        count += commands.GetCommandCount();
+    return count;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "RenderCommands.hpp"
+#include "ThreadPool.hpp"
+
+// Splits a range of draws into consecutive chunks, records every chunk into a command stream of its own on
+// a thread of the pool and replays it into the chunk's backend on the same thread. Submitting the command
+// lists behind the backends in chunk order keeps the draw order of the range.
+class ParallelRecorder
+{
+    ThreadPool                 &m_ThreadPool;
+    std::vector<RenderCommands> m_Chunks;
+
+  public:
+    // Smaller chunks would spend more on the command list setup than they save
+    static constexpr size_t MIN_CHUNK_DRAWS = 256;
+
+    using RecordFunction = std::function<void(RenderCommands &commands, size_t begin, size_t end)>;
+
+    explicit ParallelRecorder(ThreadPool &threadPool = ThreadPool::Shared()) : m_ThreadPool(threadPool) {}
+
+    // At least one chunk, at most one per thread of the pool
+    size_t ChunkCount(size_t drawCount) const noexcept;
+
+    // Calls record for the draws of every chunk, there are as many chunks as backends
+    void Record(size_t drawCount, const std::vector<RenderBackend *> &backends, const RecordFunction &record);
+
+    // Commands recorded into all chunks by the last Record
+    size_t GetCommandCount() const noexcept;
+};
@@ -0,0 +1,271 @@
+#include "RenderCommands.hpp"
+
+namespace
+{
+    struct RootConstantsArguments
+    {
+        UINT RootIndex;
+        UINT Count;
+    };
+
+    struct RootDescriptorTableArguments
+    {
+        UINT                        RootIndex;
+        D3D12_GPU_DESCRIPTOR_HANDLE Table;
+    };
+
+    // Root constant buffer and shader resource views
+    struct RootViewArguments
+    {
+        UINT                      RootIndex;
+        D3D12_GPU_VIRTUAL_ADDRESS Address;
+    };
+
+    struct DrawIndexedArguments
+    {
+        UINT IndexCount;
+        UINT InstanceCount;
+        UINT StartIndex;
+        INT  BaseVertex;
+    };
+
+    struct DrawArguments
+    {
+        UINT VertexCount;
+        UINT InstanceCount;
+        UINT StartVertex;
+    };
+
+    // Arguments are unaligned in the stream
+    template <class T> T Read(const uint8_t *&data) noexcept
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return value;
+    }
+} // namespace
+
+void D3D12RenderBackend::SetPipelineState(ID3D12PipelineState *pipelineState)
+{
+    m_CommandList->SetPipelineState(pipelineState);
+}
+
+void D3D12RenderBackend::SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view)
+{
+    m_CommandList->IASetVertexBuffers(0, 1, &view);
+}
+
+void D3D12RenderBackend::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view)
+{
+    m_CommandList->IASetIndexBuffer(&view);
+}
+
+void D3D12RenderBackend::SetRootConstants(UINT rootIndex, UINT count, const void *values)
+{
+    m_CommandList->SetGraphicsRoot32BitConstants(rootIndex, count, values, 0);
+}
+
+void D3D12RenderBackend::SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+    m_CommandList->SetGraphicsRootDescriptorTable(rootIndex, table);
+}
+
+void D3D12RenderBackend::SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    m_CommandList->SetGraphicsRootConstantBufferView(rootIndex, address);
+}
+
+void D3D12RenderBackend::SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    m_CommandList->SetGraphicsRootShaderResourceView(rootIndex, address);
+}
+
+void D3D12RenderBackend::DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex)
+{
+    m_CommandList->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, 0);
+}
+
+void D3D12RenderBackend::Draw(UINT vertexCount, UINT instanceCount, UINT startVertex)
+{
+    m_CommandList->DrawInstanced(vertexCount, instanceCount, startVertex, 0);
+}
+
+void D3D12RenderBackend::ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *barriers)
+{
+    m_CommandList->ResourceBarrier(count, barriers);
+}
+
+void NullRenderBackend::SetPipelineState(ID3D12PipelineState *)
+{
+    ++m_Counts.PipelineStates;
+}
+
+void NullRenderBackend::SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &)
+{
+    ++m_Counts.VertexBuffers;
+}
+
+void NullRenderBackend::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &)
+{
+    ++m_Counts.IndexBuffers;
+}
+
+void NullRenderBackend::SetRootConstants(UINT, UINT, const void *)
+{
+    ++m_Counts.RootConstants;
+}
+
+void NullRenderBackend::SetRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)
+{
+    ++m_Counts.DescriptorTables;
+}
+
+void NullRenderBackend::SetRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS)
+{
+    ++m_Counts.ConstantBufferViews;
+}
+
+void NullRenderBackend::SetRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS)
+{
+    ++m_Counts.ShaderResourceViews;
+}
+
+void NullRenderBackend::DrawIndexed(UINT indexCount, UINT instanceCount, UINT, INT)
+{
+    ++m_Counts.Draws;
+    m_Counts.Instances += instanceCount;
+    m_Counts.Triangles += size_t(indexCount / 3) * instanceCount;
+}
+
+void NullRenderBackend::Draw(UINT vertexCount, UINT instanceCount, UINT)
+{
+    ++m_Counts.Draws;
+    m_Counts.Instances += instanceCount;
+    m_Counts.Triangles += size_t(vertexCount / 3) * instanceCount;
+}
+
+void NullRenderBackend::ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *)
+{
+    ++m_Counts.BarrierCalls;
+    m_Counts.Barriers += count;
+}
+
+void RenderCommands::Push(Type type, const void *arguments, size_t size)
+{
+    size_t offset = m_Data.size();
+    m_Data.resize(offset + 1 + size);
+    m_Data[offset] = static_cast<uint8_t>(type);
+    std::memcpy(m_Data.data() + offset + 1, arguments, size);
+    ++m_CommandCount;
+}
+
+void RenderCommands::SetPipelineState(ID3D12PipelineState *pipelineState)
+{
+    Push(Type::SetPipelineState, &pipelineState, sizeof(pipelineState));
+}
+
+void RenderCommands::SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view)
+{
+    Push(Type::SetVertexBuffer, &view, sizeof(view));
+}
+
+void RenderCommands::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view)
+{
+    Push(Type::SetIndexBuffer, &view, sizeof(view));
+}
+
+void RenderCommands::SetRootConstants(UINT rootIndex, UINT count, const void *values)
+{
+    RootConstantsArguments arguments = {rootIndex, count};
+    Push(Type::SetRootConstants, &arguments, sizeof(arguments));
+
+    auto bytes = static_cast<const uint8_t *>(values);
+    m_Data.insert(m_Data.end(), bytes, bytes + count * sizeof(UINT));
+}
+
+void RenderCommands::SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+    RootDescriptorTableArguments arguments = {rootIndex, table};
+    Push(Type::SetRootDescriptorTable, &arguments, sizeof(arguments));
+}
+
+void RenderCommands::SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    RootViewArguments arguments = {rootIndex, address};
+    Push(Type::SetRootConstantBufferView, &arguments, sizeof(arguments));
+}
+
+void RenderCommands::SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    RootViewArguments arguments = {rootIndex, address};
+    Push(Type::SetRootShaderResourceView, &arguments, sizeof(arguments));
+}
+
+void RenderCommands::DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex)
+{
+    DrawIndexedArguments arguments = {indexCount, instanceCount, startIndex, baseVertex};
+    Push(Type::DrawIndexed, &arguments, sizeof(arguments));
+}
+
+void RenderCommands::Draw(UINT vertexCount, UINT instanceCount, UINT startVertex)
+{
+    DrawArguments arguments = {vertexCount, instanceCount, startVertex};
+    Push(Type::Draw, &arguments, sizeof(arguments));
+}
+
+void RenderCommands::Replay(RenderBackend &backend) const
+{
+    const uint8_t *data = m_Data.data();
+    const uint8_t *end  = data + m_Data.size();
+    while (data != end)
+    {
+        switch (static_cast<Type>(*data++))
+        {
+        case Type::SetPipelineState: backend.SetPipelineState(Read<ID3D12PipelineState *>(data)); break;
+        case Type::SetVertexBuffer: backend.SetVertexBuffer(Read<D3D12_VERTEX_BUFFER_VIEW>(data)); break;
+        case Type::SetIndexBuffer: backend.SetIndexBuffer(Read<D3D12_INDEX_BUFFER_VIEW>(data)); break;
+        case Type::SetRootConstants:
+        {
+            auto arguments = Read<RootConstantsArguments>(data);
+            backend.SetRootConstants(arguments.RootIndex, arguments.Count, data);
+            data += arguments.Count * sizeof(UINT);
+            break;
+        }
+        case Type::SetRootDescriptorTable:
+        {
+            auto arguments = Read<RootDescriptorTableArguments>(data);
+            backend.SetRootDescriptorTable(arguments.RootIndex, arguments.Table);
+            break;
+        }
+        case Type::SetRootConstantBufferView:
+        {
+            auto arguments = Read<RootViewArguments>(data);
+            backend.SetRootConstantBufferView(arguments.RootIndex, arguments.Address);
+            break;
+        }
+        case Type::SetRootShaderResourceView:
+        {
+            auto arguments = Read<RootViewArguments>(data);
+            backend.SetRootShaderResourceView(arguments.RootIndex, arguments.Address);
+            break;
+        }
+        case Type::DrawIndexed:
+        {
+            auto arguments = Read<DrawIndexedArguments>(data);
+            backend.DrawIndexed(arguments.IndexCount,
+                                arguments.InstanceCount,
+                                arguments.StartIndex,
+                                arguments.BaseVertex);
+            break;
+        }
+        case Type::Draw:
+        {
+            auto arguments = Read<DrawArguments>(data);
+            backend.Draw(arguments.VertexCount, arguments.InstanceCount, arguments.StartVertex);
+            break;
+        }
+        default: throw std::exception("Unknown render command");
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Receives the commands of a RenderCommands stream when it is replayed
+class RenderBackend
+{
+  public:
+    virtual ~RenderBackend() = default;
+
+    virtual void SetPipelineState(ID3D12PipelineState *pipelineState) = 0;
+    virtual void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view) = 0;
+    virtual void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view) = 0;
+    virtual void SetRootConstants(UINT rootIndex, UINT count, const void *values) = 0;
+    virtual void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) = 0;
+    virtual void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) = 0;
+    virtual void SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) = 0;
+    virtual void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex) = 0;
+    virtual void Draw(UINT vertexCount, UINT instanceCount, UINT startVertex) = 0;
+    // Not part of the command stream, issued directly by ResourceStateTracker::Flush
+    virtual void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *barriers) = 0;
+};
+
+// Translates the commands into calls on a graphics command list
+class D3D12RenderBackend : public RenderBackend
+{
+    PGraphicsCommandList m_CommandList;
+
+  public:
+    explicit D3D12RenderBackend(PGraphicsCommandList commandList) : m_CommandList(std::move(commandList)) {}
+
+    void SetPipelineState(ID3D12PipelineState *pipelineState) override;
+    void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view) override;
+    void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view) override;
+    void SetRootConstants(UINT rootIndex, UINT count, const void *values) override;
+    void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) override;
+    void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+    void SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+    void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex) override;
+    void Draw(UINT vertexCount, UINT instanceCount, UINT startVertex) override;
+    void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *barriers) override;
+};
+
+// Only counts the commands, for measuring and testing the draw path without a device
+class NullRenderBackend : public RenderBackend
+{
+  public:
+    struct Counts
+    {
+        size_t PipelineStates      = 0;
+        size_t VertexBuffers       = 0;
+        size_t IndexBuffers        = 0;
+        size_t RootConstants       = 0;
+        size_t DescriptorTables    = 0;
+        size_t ConstantBufferViews = 0;
+        size_t ShaderResourceViews = 0;
+        size_t Draws               = 0;
+        size_t Instances           = 0;
+        size_t Triangles           = 0; // Of all instances
+        size_t BarrierCalls        = 0;
+        size_t Barriers            = 0;
+    };
+
+  private:
+    Counts m_Counts;
+
+  public:
+    void SetPipelineState(ID3D12PipelineState *pipelineState) override;
+    void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view) override;
+    void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view) override;
+    void SetRootConstants(UINT rootIndex, UINT count, const void *values) override;
+    void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) override;
+    void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+    void SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+    void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex) override;
+    void Draw(UINT vertexCount, UINT instanceCount, UINT startVertex) override;
+    void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *barriers) override;
+
+    const Counts &GetCounts() const noexcept { return m_Counts; }
+    void          Reset() noexcept { m_Counts = {}; }
+};
+
+// Compact stream of render commands, recorded by the scene and replayed into a backend. Every
+// command is a type byte followed by its arguments, root constants carry their values inline.
+class RenderCommands
+{
+  public:
+    enum class Type : uint8_t
+    {
+        SetPipelineState,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        SetRootConstants,
+        SetRootDescriptorTable,
+        SetRootConstantBufferView,
+        SetRootShaderResourceView,
+        DrawIndexed,
+        Draw,
+    };
+
+  private:
+    std::vector<uint8_t> m_Data;
+    size_t               m_CommandCount = 0;
+
+    void Push(Type type, const void *arguments, size_t size);
+
+  public:
+    void Clear() noexcept
+    {
+        m_Data.clear();
+        m_CommandCount = 0;
+    }
+
+    void SetPipelineState(ID3D12PipelineState *pipelineState);
+    void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view);
+    void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view);
+    void SetRootConstants(UINT rootIndex, UINT count, const void *values);
+    void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table);
+    void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex);
+    void Draw(UINT vertexCount, UINT instanceCount, UINT startVertex);
+
+    void Replay(RenderBackend &backend) const;
+
+    size_t GetCommandCount() const noexcept { return m_CommandCount; }
+    size_t GetSize() const noexcept { return m_Data.size(); }
+};
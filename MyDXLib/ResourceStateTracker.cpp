@@ -0,0 +1,127 @@
+#include "ResourceStateTracker.hpp"
+
+void ResourceStateTracker::SetState(ID3D12Resource *resource, D3D12_RESOURCE_STATES state, UINT subresourceCount)
+{
+    m_States[resource] = {state, {}, subresourceCount};
+}
+
+void ResourceStateTracker::Push(ID3D12Resource       *resource,
+                                ResourceState        &state,
+                                UINT                  subresource,
+                                D3D12_RESOURCE_STATES before,
+                                D3D12_RESOURCE_STATES after)
+{
+    // Only the latest pending barrier of the resource can be merged, an earlier one may be ordered against it
+    if (state.LastBarrier != NO_BARRIER && m_Pending[state.LastBarrier].Transition.Subresource == subresource)
+    {
+        D3D12_RESOURCE_TRANSITION_BARRIER &pending = m_Pending[state.LastBarrier].Transition;
+        pending.StateAfter                         = after;
+        ++m_Stats.RedundantTransitions;
+        // A cancelled barrier is left as a no-op, the one before it isn't known anymore
+        if (pending.StateBefore == after)
+            state.LastBarrier = NO_BARRIER;
+        return;
+    }
+    state.LastBarrier = m_Pending.size();
+    m_Pending.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, before, after, subresource));
+}
+
+void ResourceStateTracker::Transition(ID3D12Resource *resource, D3D12_RESOURCE_STATES after, UINT subresource)
+{
+    auto found = m_States.find(resource);
+    if (found == m_States.end())
+        throw std::exception("Resource state is not tracked");
+
+    ResourceState &state = found->second;
+    ++m_Stats.Transitions;
+
+    if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        bool changed = false;
+        if (state.Subresources.empty())
+        {
+            if (state.State != after)
+            {
+                Push(resource, state, subresource, state.State, after);
+                changed = true;
+            }
+        }
+        else
+        {
+            // Diverged subresources are moved one by one and merged into a single state again
+            for (UINT i = 0; i < state.SubresourceCount; ++i)
+            {
+                if (state.Subresources[i] == after)
+                    continue;
+                Push(resource, state, i, state.Subresources[i], after);
+                changed = true;
+            }
+            state.Subresources.clear();
+        }
+        state.State = after;
+        if (!changed)
+            ++m_Stats.RedundantTransitions;
+        return;
+    }
+
+    if (subresource >= state.SubresourceCount)
+        throw std::exception("Subresource out of range");
+
+    D3D12_RESOURCE_STATES before = state.Subresources.empty() ? state.State : state.Subresources[subresource];
+    if (before == after)
+    {
+        ++m_Stats.RedundantTransitions;
+        return;
+    }
+    Push(resource, state, subresource, before, after);
+
+    if (state.Subresources.empty())
+        state.Subresources.assign(state.SubresourceCount, state.State);
+    state.Subresources[subresource] = after;
+    if (std::all_of(state.Subresources.begin(), state.Subresources.end(), [&](auto s) { return s == after; }))
+    {
+        state.State = after;
+        state.Subresources.clear();
+    }
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::GetState(ID3D12Resource *resource, UINT subresource) const
+{
+    auto found = m_States.find(resource);
+    if (found == m_States.end())
+        throw std::exception("Resource state is not tracked");
+    const ResourceState &state = found->second;
+    if (subresource >= state.SubresourceCount)
+        throw std::exception("Subresource out of range");
+    return state.Subresources.empty() ? state.State : state.Subresources[subresource];
+}
+
+size_t ResourceStateTracker::GetPendingCount() const noexcept
+{
+    return std::count_if(m_Pending.begin(), m_Pending.end(), [](const D3D12_RESOURCE_BARRIER &barrier) {
+        return barrier.Transition.StateBefore != barrier.Transition.StateAfter;
+    });
+}
+
+void ResourceStateTracker::Flush(RenderBackend &backend)
+{
+    for (auto &&barrier : m_Pending)
+    {
+        auto found = m_States.find(barrier.Transition.pResource);
+        if (found != m_States.end())
+            found->second.LastBarrier = NO_BARRIER;
+    }
+    m_Pending.erase(std::remove_if(m_Pending.begin(),
+                                   m_Pending.end(),
+                                   [](const D3D12_RESOURCE_BARRIER &barrier) {
+                                       return barrier.Transition.StateBefore == barrier.Transition.StateAfter;
+                                   }),
+                    m_Pending.end());
+    if (m_Pending.empty())
+        return;
+
+    backend.ResourceBarrier(static_cast<UINT>(m_Pending.size()), m_Pending.data());
+    m_Stats.Barriers += m_Pending.size();
+    ++m_Stats.BarrierCalls;
+    m_Pending.clear();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "RenderCommands.hpp"
+
+struct BarrierStats
+{
+    size_t Transitions          = 0; // Requested through Transition
+    size_t RedundantTransitions = 0; // Already in the state, or cancelled by a later transition before the flush
+    size_t Barriers             = 0; // Issued by Flush
+    size_t BarrierCalls         = 0; // ResourceBarrier calls issued by Flush
+
+    BarrierStats &operator+=(const BarrierStats &other) noexcept
+    {
+        Transitions          += other.Transitions;
+        RedundantTransitions += other.RedundantTransitions;
+        Barriers             += other.Barriers;
+        BarrierCalls         += other.BarrierCalls;
+        return *this;
+    }
+};
+
+// Knows the state of every registered resource, per subresource once they diverge, and turns a transition into a
+// barrier from that state. Barriers are collected until Flush issues all of them in one ResourceBarrier call, a
+// transition back and forth before that cancels out. The states are those at the end of everything recorded so far,
+// so the command lists have to be submitted in recording order. Implicit promotion and decay are not modelled.
+class ResourceStateTracker
+{
+    static constexpr size_t NO_BARRIER = SIZE_MAX;
+
+    struct ResourceState
+    {
+        D3D12_RESOURCE_STATES              State; // Of every subresource while Subresources is empty
+        std::vector<D3D12_RESOURCE_STATES> Subresources;
+        UINT                               SubresourceCount;
+        size_t                             LastBarrier = NO_BARRIER; // Into m_Pending
+    };
+
+    std::unordered_map<ID3D12Resource *, ResourceState> m_States;
+    std::vector<D3D12_RESOURCE_BARRIER>                 m_Pending; // Cancelled ones stay until Flush as no-ops
+    BarrierStats                                        m_Stats;
+
+    void Push(ID3D12Resource       *resource,
+              ResourceState        &state,
+              UINT                  subresource,
+              D3D12_RESOURCE_STATES before,
+              D3D12_RESOURCE_STATES after);
+
+  public:
+    // Registers a resource in its current state, replacing whatever was known about a resource at the same address.
+    // The subresource count is only needed for transitions of single subresources.
+    void SetState(ID3D12Resource *resource, D3D12_RESOURCE_STATES state, UINT subresourceCount = 1);
+    bool IsTracked(ID3D12Resource *resource) const { return m_States.count(resource) != 0; }
+    // Pending barriers of the forgotten resources are still issued
+    void Forget(ID3D12Resource *resource) { m_States.erase(resource); }
+    void Clear() { m_States.clear(); }
+
+    // Throw for resources that aren't registered
+    void Transition(ID3D12Resource       *resource,
+                    D3D12_RESOURCE_STATES after,
+                    UINT                  subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+    D3D12_RESOURCE_STATES GetState(ID3D12Resource *resource, UINT subresource = 0) const;
+
+    // Has to be called before the next command that depends on the transitions, e.g. a clear, draw or dispatch
+    void   Flush(RenderBackend &backend);
+    size_t GetPendingCount() const noexcept;
+
+    const BarrierStats &GetStats() const noexcept { return m_Stats; }
+    void                ResetStats() noexcept { m_Stats = {}; }
+};
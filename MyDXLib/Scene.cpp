@@ -1,16 +1,48 @@
 #include "Scene.hpp"
 #include "SceneData.hpp"
 #include "Utils.hpp"
+#include "VertexCodec.hpp"
 
 using namespace DirectX;
 
-Texture::Texture(
-    PDevice device, ResourceUploadBatch &rub, DescriptorHeap &heap, const wchar_t *path, size_t descriptorId)
-    : m_DescriptorHeap(heap),
-      m_DescriptorId(descriptorId)
+Texture::Texture(PDevice device, StagingUploader &uploader, DescriptorAllocator &descriptors, const wchar_t *path)
+    : m_Descriptors(&descriptors),
+      m_DescriptorId(descriptors.AllocatePersistent())
 {
-    Assert(CreateWICTextureFromFile(device.Get(), rub, path, m_Data.ReleaseAndGetAddressOf()));
+    // The texture is created in the copy destination state, it decays to common after the copy queue used it
+    std::unique_ptr<uint8_t[]> decodedData;
+    D3D12_SUBRESOURCE_DATA     subresource;
+    Assert(LoadWICTextureFromFile(device.Get(), path, m_Data.ReleaseAndGetAddressOf(), decodedData, subresource));
+    uploader.UploadTexture(m_Data.Get(), &subresource, 0, 1);
+    CreateView(device);
+}
+
+Texture::Texture(PDevice device, StagingUploader &uploader, DescriptorAllocator &descriptors, uint32_t color)
+    : m_Descriptors(&descriptors),
+      m_DescriptorId(descriptors.AllocatePersistent())
+{
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC   desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1);
+    Assert(device->CreateCommittedResource(&heapProperties,
+                                           D3D12_HEAP_FLAG_NONE,
+                                           &desc,
+                                           D3D12_RESOURCE_STATE_COPY_DEST,
+                                           nullptr,
+                                           IID_PPV_ARGS(&m_Data)));
 
+    D3D12_SUBRESOURCE_DATA subresource = {&color, sizeof(color), sizeof(color)};
+    uploader.UploadTexture(m_Data.Get(), &subresource, 0, 1);
+    CreateView(device);
+}
+
+Texture::Texture(DescriptorAllocator &descriptors)
+    : m_Descriptors(&descriptors),
+      m_DescriptorId(descriptors.AllocatePersistent())
+{
+}
+
+void Texture::CreateView(PDevice device)
+{
     D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
     desc.Format                          = DXGI_FORMAT_UNKNOWN;
     desc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
@@ -19,134 +51,308 @@ Texture::Texture(
     desc.Texture2D.MipLevels             = -1;
     desc.Texture2D.PlaneSlice            = 0;
     desc.Texture2D.ResourceMinLODClamp   = 0.0f;
-    device->CreateShaderResourceView(m_Data.Get(), &desc, m_DescriptorHeap.GetCpuHandle(m_DescriptorId));
+    device->CreateShaderResourceView(m_Data.Get(), &desc, m_Descriptors->GetCpuHandle(m_DescriptorId));
 }
 
-void Texture::Draw(PGraphicsCommandList commandList) const
+Texture::~Texture()
 {
-    commandList->SetGraphicsRootDescriptorTable(1, m_DescriptorHeap.GetGpuHandle(m_DescriptorId));
+    if (m_Descriptors)
+        m_Descriptors->Free(m_DescriptorId);
 }
 
-Material::Material(std::unordered_map<std::wstring_view, Texture *> textures, const MaterialData &data)
+Texture::Texture(Texture &&other) noexcept
+    : m_Descriptors(std::exchange(other.m_Descriptors, nullptr)),
+      m_Data(std::move(other.m_Data)),
+      m_DescriptorId(other.m_DescriptorId)
+{
+}
+
+void Texture::Draw(RenderCommands &commands) const
+{
+    commands.SetRootDescriptorTable(1, m_Descriptors->GetGpuHandle(m_DescriptorId));
+}
+
+Material::Material(Texture *defaultTexture)
+{
+    std::fill(std::begin(m_Textures), std::end(m_Textures), defaultTexture);
+}
+
+Material::Material(std::unordered_map<std::wstring_view, Texture *> textures,
+                   const MaterialData                              &data,
+                   Texture                                         *defaultTexture)
 {
     for (size_t i = 0; i < TEXTURE_TYPE_COUNT; ++i)
+    {
         m_Textures[i] = textures[data.TexturePaths[i]];
+        if (!m_Textures[i])
+            m_Textures[i] = defaultTexture;
+    }
 }
 
-void Material::Draw(PGraphicsCommandList commandList) const
+void Material::Draw(RenderCommands &commands) const
 {
-    if (!m_Textures[0])
-        return;
-    m_Textures[0]->Draw(commandList);
+    m_Textures[0]->Draw(commands);
 }
 
-void Mesh::QueryInit(PDevice device, ResourceUploadBatch &rub, const MeshData &data, const Material *material)
+void Material::DrawBindless(RenderCommands &commands) const
 {
-    DXGI_FORMAT indexFormat = DXGI_FORMAT_UNKNOWN;
-    switch (data.SingleIndexSize())
+    UINT baseColor = static_cast<UINT>(m_Textures[0]->GetDescriptorId());
+    commands.SetRootConstants(4, 1, &baseColor);
+}
+
+DXGI_FORMAT GeometryBuffer::IndexFormat(size_t indexSize) noexcept
+{
+    switch (indexSize)
     {
-    case sizeof(uint16_t): indexFormat = DXGI_FORMAT_R16_UINT; break;
-    case sizeof(uint32_t): indexFormat = DXGI_FORMAT_R32_UINT; break;
-    default: indexFormat = DXGI_FORMAT_UNKNOWN; break;
+    case sizeof(uint16_t): return DXGI_FORMAT_R16_UINT;
+    case sizeof(uint32_t): return DXGI_FORMAT_R32_UINT;
+    default: return DXGI_FORMAT_UNKNOWN;
     }
+}
 
-    m_UseIndex = data.IndexCount() != 0;
-    if (m_UseIndex && indexFormat == DXGI_FORMAT_UNKNOWN)
+void GeometryBuffer::QueryInit(HeapAllocator   &heap,
+                               StagingUploader &uploader,
+                               const void      *vertices,
+                               size_t           vertexBytes,
+                               size_t           vertexStride,
+                               const void      *indices,
+                               size_t           indexBytes,
+                               size_t           indexSize)
+{
+    Allocate(heap, vertexBytes, vertexStride, indexBytes, indexSize);
+    UploadVertices(uploader, vertices, vertexBytes, 0);
+    UploadIndices(uploader, indices, indexBytes, 0);
+}
+
+void GeometryBuffer::Allocate(
+    HeapAllocator &heap, size_t vertexBytes, size_t vertexStride, size_t indexBytes, size_t indexSize)
+{
+    Describe(vertexBytes, vertexStride, indexBytes, indexSize);
+    if (vertexBytes != 0)
+    {
+        m_VertexBuffer                    = heap.CreateBuffer(vertexBytes);
+        m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
+    }
+    if (indexBytes != 0)
+    {
+        m_IndexBuffer                    = heap.CreateBuffer(indexBytes);
+        m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
+    }
+}
+
+void GeometryBuffer::Describe(size_t vertexBytes, size_t vertexStride, size_t indexBytes, size_t indexSize)
+{
+    DXGI_FORMAT indexFormat = IndexFormat(indexSize);
+    if (indexBytes != 0 && indexFormat == DXGI_FORMAT_UNKNOWN)
         throw std::exception("Unknown index format");
 
-    m_VertexCount = data.VertexCount();
-    m_IndexCount  = data.IndexCount();
+    m_VertexBufferView = {0, static_cast<UINT>(vertexBytes), static_cast<UINT>(vertexStride)};
+    m_IndexBufferView  = {0, static_cast<UINT>(indexBytes), indexFormat};
+}
 
-    m_VertexBuffer = QueryUploadBuffer(device, rub, data.VertexBufferStart(), data.VertexBufferSize());
-    if (m_UseIndex)
-        m_IndexBuffer = QueryUploadBuffer(device, rub, data.IndexBufferStart(), data.IndexBufferSize());
+void GeometryBuffer::UploadVertices(StagingUploader &uploader, const void *vertices, size_t bytes, size_t offset) const
+{
+    if (offset + bytes > m_VertexBufferView.SizeInBytes)
+        throw std::exception("Vertices don't fit into the vertex buffer");
+    uploader.UploadBuffer(m_VertexBuffer.Get(), vertices, bytes, offset);
+}
 
-    m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
-    m_VertexBufferView.SizeInBytes    = static_cast<UINT>(data.VertexBufferSize());
-    m_VertexBufferView.StrideInBytes  = data.SingleVertexSize();
+void GeometryBuffer::UploadIndices(StagingUploader &uploader, const void *indices, size_t bytes, size_t offset) const
+{
+    if (offset + bytes > m_IndexBufferView.SizeInBytes)
+        throw std::exception("Indices don't fit into the index buffer");
+    uploader.UploadBuffer(m_IndexBuffer.Get(), indices, bytes, offset);
+}
 
-    if (m_UseIndex)
-        m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
-    m_IndexBufferView.SizeInBytes = static_cast<UINT>(data.IndexBufferSize());
-    m_IndexBufferView.Format      = indexFormat;
+void GeometryBuffer::Bind(RenderCommands &commands) const
+{
+    commands.SetVertexBuffer(m_VertexBufferView);
+    if (m_IndexBufferView.SizeInBytes != 0)
+        commands.SetIndexBuffer(m_IndexBufferView);
+}
+
+void Mesh::QueryInit(HeapAllocator &heap, StagingUploader &uploader, const MeshData &data, const Material *material)
+{
+    auto geometry = std::make_shared<GeometryBuffer>();
+    geometry->QueryInit(heap,
+                        uploader,
+                        data.VertexBufferStart(),
+                        data.VertexBufferSize(),
+                        data.SingleVertexSize(),
+                        data.IndexBufferStart(),
+                        data.IndexBufferSize(),
+                        data.SingleIndexSize());
+    Init(data, std::move(geometry), 0, 0, material);
+}
+
+void Mesh::Init(const MeshData                       &data,
+                std::shared_ptr<const GeometryBuffer> geometry,
+                INT                                   baseVertex,
+                UINT                                  startIndex,
+                const Material                       *material)
+{
+    m_UseIndex = data.IndexCount() != 0;
+    if (m_UseIndex && GeometryBuffer::IndexFormat(data.SingleIndexSize()) != geometry->GetIndexView().Format)
+        throw std::exception("Mesh index size doesn't match the geometry buffer");
+    if (data.SingleVertexSize() != geometry->GetVertexView().StrideInBytes)
+        throw std::exception("Mesh vertex size doesn't match the geometry buffer");
+
+    m_Geometry    = std::move(geometry);
+    m_BaseVertex  = baseVertex;
+    m_StartIndex  = startIndex;
+    m_VertexCount = data.VertexCount();
+    m_IndexCount  = data.IndexCount();
 
     m_Material      = material;
     m_MaterialIndex = data.m_MaterialIndex;
+
+    m_QuantizedPositions = data.m_VertexFormat == VERTEX_FORMAT_QUANTIZED;
+    m_PositionDecode[0]  = XMFLOAT4(data.m_BoundsMin.x, data.m_BoundsMin.y, data.m_BoundsMin.z, 0.0f);
+    m_PositionDecode[1]  = XMFLOAT4(data.m_BoundsMax.x - data.m_BoundsMin.x,
+                                   data.m_BoundsMax.y - data.m_BoundsMin.y,
+                                   data.m_BoundsMax.z - data.m_BoundsMin.z,
+                                   0.0f);
+
+    m_Meshlets  = data.m_Meshlets;
+    m_Lods      = data.m_Lods;
+    m_BoundsMin = data.m_BoundsMin;
+    m_BoundsMax = data.m_BoundsMax;
+
+    XMVECTOR boundsMin = XMLoadFloat3(&data.m_BoundsMin);
+    XMVECTOR boundsMax = XMLoadFloat3(&data.m_BoundsMax);
+    float    radius    = XMVectorGetX(XMVector3Length(boundsMax - boundsMin)) * 0.5f;
+    XMStoreFloat4(&m_BoundingSphere, XMVectorSetW((boundsMin + boundsMax) * 0.5f, radius));
 }
 
-void Mesh::Draw(PGraphicsCommandList commandList) const
+size_t Mesh::SelectLod(FXMMATRIX modelView, float pixelsPerUnit) const
 {
-    commandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
+    if (m_Lods.size() < 2 || pixelsPerUnit <= 0.0f)
+        return 0;
 
+    // Errors are stored in object space, the largest axis scale brings them to view space
+    float scale = std::sqrt((std::max)({XMVectorGetX(XMVector3LengthSq(modelView.r[0])),
+                                        XMVectorGetX(XMVector3LengthSq(modelView.r[1])),
+                                        XMVectorGetX(XMVector3LengthSq(modelView.r[2]))}));
+
+    // The camera projection has w = view z, the nearest point of the bounding sphere decides
+    XMVECTOR center   = XMVector3TransformCoord(XMLoadFloat4(&m_BoundingSphere), modelView);
+    float    distance = XMVectorGetZ(center) - m_BoundingSphere.w * scale;
+    if (distance <= 0.0f)
+        return 0;
+
+    size_t lod = 0;
+    while (lod + 1 < m_Lods.size() && m_Lods[lod + 1].Error * scale * pixelsPerUnit <= distance)
+        ++lod;
+    return lod;
+}
+
+float Mesh::ViewDepth(FXMMATRIX modelView) const
+{
+    return XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat4(&m_BoundingSphere), modelView));
+}
+
+void Mesh::Draw(RenderCommands &commands, const MeshletView *view, size_t lod, UINT instanceCount) const
+{
+    m_Geometry->Bind(commands);
     if (m_Material)
-        m_Material->Draw(commandList);
+        m_Material->Draw(commands);
+    DrawBound(commands, view, lod, instanceCount);
+}
+
+void Mesh::DrawBound(RenderCommands &commands, const MeshletView *view, size_t lod, UINT instanceCount) const
+{
+    if (m_QuantizedPositions)
+        commands.SetRootConstants(2, 8, m_PositionDecode);
 
     if (m_UseIndex)
     {
-        commandList->IASetIndexBuffer(&m_IndexBufferView);
-        commandList->DrawIndexedInstanced(static_cast<UINT>(m_IndexCount), 1, 0, 0, 0);
+        if (lod != 0 || !view || m_Meshlets.empty())
+        {
+            UINT start = 0;
+            UINT count = static_cast<UINT>(m_IndexCount);
+            if (!m_Lods.empty())
+            {
+                const MeshLod &level = m_Lods[(std::min)(lod, m_Lods.size() - 1)];
+                start                = level.IndexOffset;
+                count                = level.IndexCount;
+            }
+            commands.DrawIndexed(count, instanceCount, m_StartIndex + start, m_BaseVertex);
+            return;
+        }
+
+        // Meshlets are consecutive in the index buffer, so neighbouring visible ones share a draw
+        UINT start = 0;
+        UINT count = 0;
+        for (auto &&meshlet : m_Meshlets)
+        {
+            if (!MeshletBuilder::IsVisible(meshlet, *view))
+                continue;
+            if (count != 0 && start + count != meshlet.IndexOffset)
+            {
+                commands.DrawIndexed(count, instanceCount, m_StartIndex + start, m_BaseVertex);
+                count = 0;
+            }
+            if (count == 0)
+                start = meshlet.IndexOffset;
+            count += meshlet.TriangleCount * 3;
+        }
+        if (count != 0)
+            commands.DrawIndexed(count, instanceCount, m_StartIndex + start, m_BaseVertex);
     }
     else
     {
-        commandList->DrawInstanced(m_VertexCount, 1, 0, 0);
+        commands.Draw(static_cast<UINT>(m_VertexCount), instanceCount, static_cast<UINT>(m_BaseVertex));
     }
 }
 
-void SceneObject::QueryInit(const ObjectData &data, const std::vector<Mesh> &meshes)
+void Scene::QueryInit(PDevice              device,
+                      StagingUploader     &uploader,
+                      HeapAllocator       &geometryHeap,
+                      DescriptorAllocator &descriptors,
+                      const SceneData     &data)
 {
-    m_Transform = XMLoadFloat4x4(&data.m_Transform);
-
-    m_Meshes.resize(data.GetMeshIdx().size());
-    for (size_t i = 0; i < m_Meshes.size(); ++i)
-        m_Meshes[i] = &meshes[data.GetMeshIdx()[i]];
-
-    m_Children.resize(data.GetChildren().size());
-    for (size_t i = 0; i < m_Children.size(); ++i)
-    {
-        m_Children[i] = std::make_unique<SceneObject>();
-        m_Children[i]->QueryInit(*(data.GetChildren()[i]), meshes);
-    }
+    Init(std::move(device), &uploader, &geometryHeap, descriptors, data);
 }
 
-void SceneObject::Draw(PGraphicsCommandList     commandList,
-                       const DirectX::XMMATRIX &model,
-                       const DirectX::XMMATRIX &view,
-                       const DirectX::XMMATRIX &projection) const
+void Scene::Describe(DescriptorAllocator &descriptors, const SceneData &data)
 {
-    XMMATRIX constants[3];
-    constants[0] = m_Transform * model;
-    constants[1] = view;
-    constants[2] = projection;
-    commandList->SetGraphicsRoot32BitConstants(0, 48, &constants, 0);
-
-    for (const Mesh *mesh : m_Meshes)
-        mesh->Draw(commandList);
-
-    for (auto &child : m_Children)
-        child->Draw(commandList, constants[0], view, projection);
+    Init(PDevice(), nullptr, nullptr, descriptors, data);
 }
 
-void Scene::QueryInit(PDevice device, ResourceUploadBatch &rub, DescriptorHeap &descriptorHeap, const SceneData &data)
+void Scene::Init(PDevice              device,
+                 StagingUploader     *uploader,
+                 HeapAllocator       *geometryHeap,
+                 DescriptorAllocator &descriptors,
+                 const SceneData     &data)
 {
     auto &&texturePaths = data.GetTexturePaths();
     auto &&materialData = data.GetMaterials();
     auto &&meshData     = data.GetMeshes();
 
     std::unordered_map<std::wstring_view, Texture *> textureMapping;
-    textureMapping[L""] = nullptr;
+
+    m_Materials.clear();
+    m_DefaultMaterial.reset();
+    if (uploader)
+        m_DefaultTexture.emplace(device, *uploader, descriptors, 0xFFFFFFFF);
+    else
+        m_DefaultTexture.emplace(descriptors);
+    m_DefaultMaterial.emplace(&*m_DefaultTexture);
 
     m_Textures.clear();
     m_Textures.reserve(texturePaths.size());
-    m_Materials.clear();
     m_Materials.reserve(materialData.size());
     m_Meshes.resize(meshData.size());
 
-    size_t takenId = 1;
+    m_Descriptors = &descriptors;
     for (auto &&path : texturePaths)
     {
         // if (m_Textures.empty())
         // {
-        m_Textures.emplace_back(device, rub, descriptorHeap, path.c_str(), takenId++);
+        if (uploader)
+            m_Textures.emplace_back(device, *uploader, descriptors, path.c_str());
+        else
+            m_Textures.emplace_back(descriptors);
         textureMapping[path] = &m_Textures[m_Textures.size() - 1];
         // }
         // else
@@ -156,25 +362,404 @@ void Scene::QueryInit(PDevice device, ResourceUploadBatch &rub, DescriptorHeap &
     }
 
     for (size_t i = 0; i < materialData.size(); ++i)
-        m_Materials.emplace_back(textureMapping, materialData[i]);
+        m_Materials.emplace_back(textureMapping, materialData[i], &*m_DefaultTexture);
 
+    // Meshes with the same vertex stride and index size share one vertex and one index buffer
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> layouts;
     for (size_t i = 0; i < meshData.size(); ++i)
+        layouts[{meshData[i].SingleVertexSize(), meshData[i].SingleIndexSize()}].push_back(i);
+
+    for (auto &&[layout, meshes] : layouts)
     {
-        Material *material = nullptr;
-        if (meshData[i].m_MaterialIndex < m_Materials.size())
-            material = &m_Materials[meshData[i].m_MaterialIndex];
-        m_Meshes[i].QueryInit(device, rub, meshData[i], material);
+        auto [vertexSize, indexSize] = layout;
+
+        size_t vertexBytes = 0;
+        size_t indexBytes  = 0;
+        for (size_t i : meshes)
+        {
+            vertexBytes += meshData[i].VertexBufferSize();
+            indexBytes  += meshData[i].IndexBufferSize();
+        }
+
+        // Every mesh is copied from its MeshData into the staging memory right away
+        auto geometry = std::make_shared<GeometryBuffer>();
+        if (uploader)
+            geometry->Allocate(*geometryHeap, vertexBytes, vertexSize, indexBytes, indexSize);
+        else
+            geometry->Describe(vertexBytes, vertexSize, indexBytes, indexSize);
+
+        INT  baseVertex = 0;
+        UINT startIndex = 0;
+        for (size_t i : meshes)
+        {
+            if (uploader)
+            {
+                geometry->UploadVertices(*uploader,
+                                         meshData[i].VertexBufferStart(),
+                                         meshData[i].VertexBufferSize(),
+                                         baseVertex * vertexSize);
+                geometry->UploadIndices(*uploader,
+                                        meshData[i].IndexBufferStart(),
+                                        meshData[i].IndexBufferSize(),
+                                        startIndex * indexSize);
+            }
+
+            Material *material = nullptr;
+            if (meshData[i].m_MaterialIndex < m_Materials.size())
+                material = &m_Materials[meshData[i].m_MaterialIndex];
+            m_Meshes[i].Init(meshData[i], geometry, baseVertex, startIndex, material);
+            baseVertex += static_cast<INT>(meshData[i].VertexCount());
+            startIndex += static_cast<UINT>(meshData[i].IndexCount());
+        }
     }
 
-    m_Root.QueryInit(data.GetRoot(), m_Meshes);
+    std::wstringstream ss;
+    ss << meshData.size() << L" meshes in " << layouts.size() << L" geometry buffers\n";
+    OutputDebugStringW(ss.str().c_str());
+
+    auto &&objects      = data.GetObjects();
+    auto &&objectMeshes = data.GetObjectMeshes();
+
+    m_Parents.resize(objects.size());
+    m_LocalTransforms.resize(objects.size());
+    m_WorldTransforms.resize(objects.size());
+    m_MeshOffsets.resize(objects.size() + 1);
+    m_BoundsMin.resize(objects.size());
+    m_BoundsMax.resize(objects.size());
+    m_ObjectMeshes.clear();
+    m_ObjectMeshes.reserve(objectMeshes.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        m_Parents[i]         = objects[i].Parent;
+        m_LocalTransforms[i] = XMLoadFloat4x4(&objects[i].Transform);
+        m_MeshOffsets[i]     = static_cast<uint32_t>(m_ObjectMeshes.size());
+        m_BoundsMin[i]       = objects[i].BoundsMin;
+        m_BoundsMax[i]       = objects[i].BoundsMax;
+        for (uint32_t j = 0; j < objects[i].MeshCount; ++j)
+            m_ObjectMeshes.push_back(&m_Meshes[objectMeshes[objects[i].MeshOffset + j]]);
+    }
+    m_MeshOffsets[objects.size()] = static_cast<uint32_t>(m_ObjectMeshes.size());
+    m_MeshVisible.assign(m_ObjectMeshes.size(), 1);
+    m_MeshBatches.assign(m_Meshes.size(), NO_BATCH);
+    m_TransformDirty.assign(objects.size(), 1);
+    m_WorldChanged.assign(objects.size(), 1);
+    m_ObjectBoxes.Clear();
+
+    // The meshes with the largest boxes are the most likely to hide something
+    auto boxArea = [&](size_t i) {
+        XMFLOAT3 size(meshData[i].m_BoundsMax.x - meshData[i].m_BoundsMin.x,
+                      meshData[i].m_BoundsMax.y - meshData[i].m_BoundsMin.y,
+                      meshData[i].m_BoundsMax.z - meshData[i].m_BoundsMin.z);
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    };
+    std::vector<size_t> order(meshData.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return boxArea(a) > boxArea(b); });
+
+    m_OccluderGeometry.clear();
+    m_OccluderGeometry.resize(meshData.size());
+    size_t occluderCount     = 0;
+    size_t occluderTriangles = 0;
+    for (size_t i : order)
+    {
+        size_t indexCount = meshData[i].m_Lods.empty() ? meshData[i].IndexCount() : meshData[i].m_Lods[0].IndexCount;
+        if (indexCount == 0 || occluderTriangles + indexCount / 3 > OCCLUDER_TRIANGLE_BUDGET)
+            continue;
+
+        m_OccluderGeometry[i].Positions = VertexCodec::DecodePositions(meshData[i]);
+        m_OccluderGeometry[i].Indices   = meshData[i].GetIndices();
+        m_OccluderGeometry[i].Indices.resize(indexCount);
+        occluderTriangles += indexCount / 3;
+        ++occluderCount;
+    }
+
+    ss.str(L"");
+    ss << occluderCount << L" occluder meshes with " << occluderTriangles << L" triangles\n";
+    OutputDebugStringW(ss.str().c_str());
 }
 
-void Scene::Draw(PGraphicsCommandList     commandList,
-                 const DirectX::XMMATRIX &model,
-                 const DirectX::XMMATRIX &view,
-                 const DirectX::XMMATRIX &projection) const
+void Scene::SetLocalTransform(size_t object, FXMMATRIX transform)
 {
-    m_Root.Draw(commandList, model, view, projection);
-    // for (auto &&mesh : m_Meshes)
-    //     mesh.Draw(commandList);
+    m_LocalTransforms[object] = transform;
+    m_TransformDirty[object]  = 1;
+}
+
+void Scene::UpdateTransforms(const DirectX::XMMATRIX &model)
+{
+    bool modelChanged = std::memcmp(&model, &m_Model, sizeof(XMMATRIX)) != 0;
+    m_Model           = model;
+
+    // Parents come first, so their flag already includes whether any of their ancestors moved
+    size_t updated = 0;
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        uint32_t parent = m_Parents[i];
+        if (parent == ObjectData::NO_PARENT ? modelChanged : m_TransformDirty[parent])
+            m_TransformDirty[i] = 1;
+        if (!m_TransformDirty[i])
+            continue;
+
+        const XMMATRIX &parentWorld = parent == ObjectData::NO_PARENT ? model : m_WorldTransforms[parent];
+        m_WorldTransforms[i]        = m_LocalTransforms[i] * parentWorld;
+        m_WorldChanged[i]           = 1;
+        ++updated;
+    }
+    if (updated != 0)
+        std::fill(m_TransformDirty.begin(), m_TransformDirty.end(), uint8_t(0));
+    m_Stats.UpdatedTransforms = updated;
+}
+
+void Scene::Cull(const DirectX::XMMATRIX &viewProjection)
+{
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+    if (m_ObjectBoxes.Size() != m_Parents.size())
+    {
+        m_ObjectBoxes.Clear();
+        for (size_t i = 0; i < m_Parents.size(); ++i)
+            m_ObjectBoxes.Add(m_BoundsMin[i], m_BoundsMax[i], m_WorldTransforms[i]);
+        std::fill(m_WorldChanged.begin(), m_WorldChanged.end(), uint8_t(0));
+    }
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        if (!m_WorldChanged[i])
+            continue;
+        m_ObjectBoxes.Set(i, m_BoundsMin[i], m_BoundsMax[i], m_WorldTransforms[i]);
+        m_WorldChanged[i] = 0;
+    }
+    FrustumCuller::Test(frustum, m_ObjectBoxes, m_ObjectVisible);
+
+    m_MeshBoxes.Clear();
+    m_MeshBoxEntries.clear();
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        uint32_t first = m_MeshOffsets[i];
+        uint32_t last  = m_MeshOffsets[i + 1];
+        if (!m_ObjectVisible[i] || last - first < 2)
+        {
+            std::fill(m_MeshVisible.begin() + first, m_MeshVisible.begin() + last, m_ObjectVisible[i]);
+            continue;
+        }
+        for (uint32_t j = first; j < last; ++j)
+        {
+            m_MeshBoxes.Add(m_ObjectMeshes[j]->GetBoundsMin(), m_ObjectMeshes[j]->GetBoundsMax(), m_WorldTransforms[i]);
+            m_MeshBoxEntries.push_back(j);
+        }
+    }
+    FrustumCuller::Test(frustum, m_MeshBoxes, m_MeshBoxVisible);
+    for (size_t k = 0; k < m_MeshBoxEntries.size(); ++k)
+        m_MeshVisible[m_MeshBoxEntries[k]] = m_MeshBoxVisible[k];
+
+    m_Stats.CulledDraws = static_cast<size_t>(std::count(m_MeshVisible.begin(), m_MeshVisible.end(), uint8_t(0)));
+}
+
+void Scene::Occlude(const DirectX::XMMATRIX &viewProjection, float nearDepth)
+{
+    m_Occluders.clear();
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        if (!m_ObjectVisible[i])
+            continue;
+        XMMATRIX worldViewProjection = m_WorldTransforms[i] * viewProjection;
+        for (uint32_t j = m_MeshOffsets[i]; j < m_MeshOffsets[i + 1]; ++j)
+        {
+            const OccluderGeometry &geometry = m_OccluderGeometry[m_ObjectMeshes[j] - m_Meshes.data()];
+            if (m_MeshVisible[j] && !geometry.Indices.empty())
+            {
+                m_Occluders.push_back({worldViewProjection,
+                                       geometry.Positions.data(),
+                                       geometry.Indices.data(),
+                                       geometry.Indices.size()});
+            }
+        }
+    }
+    if (m_Occluders.empty())
+        return;
+    m_OcclusionCuller.Render(m_Occluders, nearDepth);
+
+    // The occluders are tested as well, their boxes are never behind their own surface
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        if (!m_ObjectVisible[i])
+            continue;
+        XMMATRIX worldViewProjection = m_WorldTransforms[i] * viewProjection;
+        for (uint32_t j = m_MeshOffsets[i]; j < m_MeshOffsets[i + 1]; ++j)
+        {
+            const Mesh *mesh = m_ObjectMeshes[j];
+            if (m_MeshVisible[j]
+                && m_OcclusionCuller.IsOccluded(mesh->GetBoundsMin(), mesh->GetBoundsMax(), worldViewProjection))
+            {
+                m_MeshVisible[j] = 0;
+                ++m_Stats.OccludedDraws;
+            }
+        }
+    }
+}
+
+void Scene::Prepare(UploadRing              &uploadRing,
+                    ID3D12PipelineState     *pipelineState,
+                    const DirectX::XMMATRIX &model,
+                    const DirectX::XMMATRIX &view,
+                    const DirectX::XMMATRIX &projection)
+{
+    m_Stats      = {};
+    m_View       = view;
+    m_Projection = projection;
+
+    UpdateTransforms(model);
+
+    XMMATRIX viewProjection = view * projection;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Cull(viewProjection);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    Occlude(viewProjection, OcclusionCuller::NearDepth(projection));
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    // Row 1 column 1 of the projection maps view y at depth one to normalized device y
+    float    pixelsPerUnit = m_LodScale * XMVectorGetY(projection.r[1]);
+    uint32_t pipeline      = m_DrawList.PipelineId(pipelineState);
+
+    // Layouts of the constant buffers in VertexSponza.hlsl
+    struct FrameConstants
+    {
+        XMMATRIX View;
+        XMMATRIX Projection;
+    };
+    m_FrameConstants = uploadRing.PushConstants(FrameConstants{view, projection});
+
+    // Every mesh and LOD gets one batch, the few LODs of a mesh are found by following NextBatch
+    m_Batches.clear();
+    m_Instances.clear();
+    for (size_t i = 0; i < m_Parents.size(); ++i)
+    {
+        if (!m_ObjectVisible[i])
+            continue;
+
+        XMMATRIX modelView = m_WorldTransforms[i] * view;
+        for (uint32_t j = m_MeshOffsets[i]; j < m_MeshOffsets[i + 1]; ++j)
+        {
+            if (!m_MeshVisible[j])
+                continue;
+
+            const Mesh *mesh      = m_ObjectMeshes[j];
+            uint32_t    lod       = static_cast<uint32_t>(mesh->SelectLod(modelView, pixelsPerUnit));
+            float       viewDepth = mesh->ViewDepth(modelView);
+            uint32_t   &first     = m_MeshBatches[mesh - m_Meshes.data()];
+
+            uint32_t batch = first;
+            while (batch != NO_BATCH && m_Batches[batch].Lod != lod)
+                batch = m_Batches[batch].NextBatch;
+            if (batch == NO_BATCH)
+            {
+                batch = static_cast<uint32_t>(m_Batches.size());
+                m_Batches.push_back({mesh, lod, static_cast<uint32_t>(i), 0, 0, first, viewDepth});
+                first = batch;
+            }
+
+            InstanceBatch &entry = m_Batches[batch];
+            entry.ViewDepth      = (std::min)(entry.ViewDepth, viewDepth);
+            m_Instances.push_back({batch, static_cast<uint32_t>(i), entry.InstanceCount++});
+        }
+    }
+
+    // The transforms of a batch are consecutive, so a draw only needs the address of its first one
+    uint32_t instanceCount = 0;
+    for (auto &&batch : m_Batches)
+    {
+        batch.FirstInstance = instanceCount;
+        instanceCount       = batch.FirstInstance + batch.InstanceCount;
+
+        m_MeshBatches[batch.DrawnMesh - m_Meshes.data()] = NO_BATCH;
+    }
+    m_InstanceTransforms = 0;
+    if (instanceCount != 0)
+    {
+        UploadAllocation allocation = uploadRing.Allocate(instanceCount * sizeof(XMMATRIX));
+        auto             transforms = static_cast<XMMATRIX *>(allocation.CpuAddress);
+        for (auto &&instance : m_Instances)
+            transforms[m_Batches[instance.Batch].FirstInstance + instance.Index] = m_WorldTransforms[instance.Object];
+        m_InstanceTransforms = allocation.GpuAddress;
+    }
+
+    // Replayed grouped by pipeline and material and front to back within them
+    m_DrawList.Clear();
+    for (auto &&batch : m_Batches)
+    {
+        uint32_t material = static_cast<uint32_t>(batch.DrawnMesh->GetMaterialIndex());
+        uint64_t key      = DrawList::MakeKey(pipeline, material, batch.ViewDepth);
+        m_DrawList.Add({key, batch.DrawnMesh, batch.Object, batch.Lod, batch.FirstInstance, batch.InstanceCount});
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    m_DrawList.Sort();
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    m_Stats.Draws                 = m_Instances.size();
+    m_Stats.InstancedDraws        = m_Batches.size();
+    m_Stats.CullingMilliseconds   = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    m_Stats.OcclusionMilliseconds = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    m_Stats.SortMilliseconds      = std::chrono::duration<double, std::milli>(t4 - t3).count();
+}
+
+void Scene::Record(RenderCommands &commands, size_t begin, size_t end) const
+{
+    // State is only set when it differs from the previous packet, every range starts without state
+    ID3D12PipelineState  *boundPipeline = nullptr;
+    const GeometryBuffer *boundGeometry = nullptr;
+    const Material       *boundMaterial = nullptr;
+
+    // Root parameters of RootSignatureSponza.inc: 0 is the instance transforms, 1 the texture table,
+    // 3 the frame constant buffer and 4 the index of the base color texture in the table. Both texture
+    // parameters are set before the first draw, the default material fills the one materials change.
+    if (begin != end)
+    {
+        commands.SetRootConstantBufferView(3, m_FrameConstants);
+        UINT firstTexture = 0;
+        if (m_Bindless)
+            commands.SetRootDescriptorTable(1, m_Descriptors->GetGpuHandle(0));
+        else
+            commands.SetRootConstants(4, 1, &firstTexture);
+
+        boundMaterial = &*m_DefaultMaterial;
+        if (m_Bindless)
+            boundMaterial->DrawBindless(commands);
+        else
+            boundMaterial->Draw(commands);
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        const DrawPacket    &packet         = m_DrawList.GetPackets()[i];
+        ID3D12PipelineState *packetPipeline = m_DrawList.GetPipeline(packet.SortKey);
+        if (packetPipeline != boundPipeline)
+        {
+            boundPipeline = packetPipeline;
+            commands.SetPipelineState(boundPipeline);
+        }
+        commands.SetRootShaderResourceView(0, m_InstanceTransforms + packet.FirstInstance * sizeof(XMMATRIX));
+
+        const Mesh *mesh = packet.DrawnMesh;
+        if (mesh->GetGeometry() != boundGeometry)
+        {
+            boundGeometry = mesh->GetGeometry();
+            boundGeometry->Bind(commands);
+        }
+        const Material *material = mesh->GetMaterial() ? mesh->GetMaterial() : &*m_DefaultMaterial;
+        if (material != boundMaterial)
+        {
+            boundMaterial = material;
+            if (m_Bindless)
+                boundMaterial->DrawBindless(commands);
+            else
+                boundMaterial->Draw(commands);
+        }
+        if (mesh->HasMeshlets() && packet.InstanceCount == 1)
+        {
+            MeshletView view = MeshletView::FromMatrices(m_WorldTransforms[packet.Object] * m_View, m_Projection);
+            mesh->DrawBound(commands, &view, packet.Lod);
+        }
+        else
+        {
+            mesh->DrawBound(commands, nullptr, packet.Lod, packet.InstanceCount);
+        }
+    }
 }
@@ -2,40 +2,99 @@
 
 #include "pch.hpp"
 
+#include "DescriptorAllocator.hpp"
+#include "DrawList.hpp"
+#include "FrustumCuller.hpp"
+#include "HeapAllocator.hpp"
+#include "MeshletBuilder.hpp"
+#include "OcclusionCuller.hpp"
+#include "RenderCommands.hpp"
 #include "SceneData.hpp"
+#include "StagingUploader.hpp"
+#include "UploadRing.hpp"
 
+// Owns a persistent descriptor of the allocator, freed with the texture once the frames in flight are retired
 class Texture
 {
-    DescriptorHeap &m_DescriptorHeap;
-    PResource       m_Data;
-    size_t          m_DescriptorId;
+    DescriptorAllocator *m_Descriptors;
+    PResource            m_Data;
+    size_t               m_DescriptorId;
+
+    void CreateView(PDevice device);
 
   public:
-    Texture(PDevice                  device,
-            ResourceUploadBatch     &rub,
-            DirectX::DescriptorHeap &heap,
-            const wchar_t           *path,
-            size_t                   descriptorId);
+    Texture(PDevice device, StagingUploader &uploader, DescriptorAllocator &descriptors, const wchar_t *path);
+    // 1x1 texture of a single RGBA8 color, for materials without a texture
+    Texture(PDevice device, StagingUploader &uploader, DescriptorAllocator &descriptors, uint32_t color);
+    // Only reserves the descriptor, for scenes built without a device
+    explicit Texture(DescriptorAllocator &descriptors);
+    ~Texture();
+
+    Texture(Texture &&other) noexcept;
+    Texture(const Texture &)            = delete;
+    Texture &operator=(const Texture &) = delete;
+
+    size_t GetDescriptorId() const noexcept { return m_DescriptorId; }
 
-    void Draw(PGraphicsCommandList commandList) const;
+    void Draw(RenderCommands &commands) const;
 };
 
+// Every texture slot is bound, the ones the material data leaves empty use the default texture
 class Material
 {
     Texture *m_Textures[TEXTURE_TYPE_COUNT] = {};
 
   public:
-    Material(std::unordered_map<std::wstring_view, Texture *> textures, const MaterialData &data);
-    void Draw(PGraphicsCommandList commandList) const;
+    explicit Material(Texture *defaultTexture);
+    Material(std::unordered_map<std::wstring_view, Texture *> textures,
+             const MaterialData                              &data,
+             Texture                                         *defaultTexture);
+    void Draw(RenderCommands &commands) const;
+    // Passes the heap index of the base color texture instead of binding a descriptor table
+    void DrawBindless(RenderCommands &commands) const;
 };
 
-class Mesh
+// Vertex and index buffer holding the geometry of any number of meshes with the same
+// vertex stride and index size, the meshes address it by base vertex and start index
+class GeometryBuffer
 {
-    PResource                m_VertexBuffer;
+    PlacedResource           m_VertexBuffer;
     D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView = {};
-    PResource                m_IndexBuffer;
+    PlacedResource           m_IndexBuffer;
     D3D12_INDEX_BUFFER_VIEW  m_IndexBufferView = {};
 
+  public:
+    // DXGI_FORMAT_UNKNOWN for sizes that can't be used as an index buffer
+    static DXGI_FORMAT IndexFormat(size_t indexSize) noexcept;
+
+    void QueryInit(HeapAllocator   &heap,
+                   StagingUploader &uploader,
+                   const void      *vertices,
+                   size_t           vertexBytes,
+                   size_t           vertexStride,
+                   const void      *indices,
+                   size_t           indexBytes,
+                   size_t           indexSize);
+    // Places buffers of the given sizes without filling them, the meshes are uploaded one by one with
+    // UploadVertices and UploadIndices instead of being gathered into one block first
+    void Allocate(HeapAllocator &heap, size_t vertexBytes, size_t vertexStride, size_t indexBytes, size_t indexSize);
+    // Sets up the views without placing any buffer, their addresses stay null
+    void Describe(size_t vertexBytes, size_t vertexStride, size_t indexBytes, size_t indexSize);
+    void UploadVertices(StagingUploader &uploader, const void *vertices, size_t bytes, size_t offset) const;
+    void UploadIndices(StagingUploader &uploader, const void *indices, size_t bytes, size_t offset) const;
+
+    const D3D12_VERTEX_BUFFER_VIEW &GetVertexView() const noexcept { return m_VertexBufferView; }
+    const D3D12_INDEX_BUFFER_VIEW  &GetIndexView() const noexcept { return m_IndexBufferView; }
+
+    void Bind(RenderCommands &commands) const;
+};
+
+class Mesh
+{
+    std::shared_ptr<const GeometryBuffer> m_Geometry;
+    INT                                   m_BaseVertex = 0;
+    UINT                                  m_StartIndex = 0;
+
     const Material *m_Material      = nullptr;
     size_t          m_MaterialIndex = 0;
 
@@ -43,41 +102,227 @@ class Mesh
     size_t m_IndexCount  = 0;
     bool   m_UseIndex    = false;
 
+    // Bounds offset and extent for VERTEX_FORMAT_QUANTIZED, w components are padding
+    DirectX::XMFLOAT4 m_PositionDecode[2]  = {};
+    bool              m_QuantizedPositions = false;
+
+    std::vector<Meshlet> m_Meshlets;
+    std::vector<MeshLod> m_Lods;
+    DirectX::XMFLOAT4    m_BoundingSphere = {};
+    DirectX::XMFLOAT3    m_BoundsMin      = {};
+    DirectX::XMFLOAT3    m_BoundsMax      = {};
+
   public:
-    const D3D12_VERTEX_BUFFER_VIEW &GetVertexView() const noexcept { return m_VertexBufferView; }
-    const D3D12_INDEX_BUFFER_VIEW  &GetIndexView() const noexcept { return m_IndexBufferView; }
+    const D3D12_VERTEX_BUFFER_VIEW &GetVertexView() const noexcept { return m_Geometry->GetVertexView(); }
+    const D3D12_INDEX_BUFFER_VIEW  &GetIndexView() const noexcept { return m_Geometry->GetIndexView(); }
+    const GeometryBuffer           *GetGeometry() const noexcept { return m_Geometry.get(); }
+
+    const Material          *GetMaterial() const noexcept { return m_Material; }
+    size_t                   GetMaterialIndex() const noexcept { return m_MaterialIndex; }
+    const DirectX::XMFLOAT3 &GetBoundsMin() const noexcept { return m_BoundsMin; }
+    const DirectX::XMFLOAT3 &GetBoundsMax() const noexcept { return m_BoundsMax; }
+
+    bool HasMeshlets() const noexcept { return !m_Meshlets.empty(); }
+
+    // Uploads the mesh into a geometry buffer of its own
+    void QueryInit(HeapAllocator   &heap,
+                   StagingUploader &uploader,
+                   const MeshData  &data,
+                   const Material  *material = nullptr);
+    // Uses the range of a shared geometry buffer the mesh data was already uploaded to
+    void Init(const MeshData                       &data,
+              std::shared_ptr<const GeometryBuffer> geometry,
+              INT                                   baseVertex,
+              UINT                                  startIndex,
+              const Material                       *material = nullptr);
 
-    void QueryInit(PDevice device, ResourceUploadBatch &rub, const MeshData &data, const Material *material = nullptr);
-    void Draw(PGraphicsCommandList commandList) const;
+    // Coarsest level whose error stays below one unit after multiplying with pixelsPerUnit and dividing by
+    // the view depth, pixelsPerUnit being the screen size in pixels of one unit at depth one
+    size_t SelectLod(DirectX::FXMMATRIX modelView, float pixelsPerUnit) const;
+    // View depth of the bounding sphere center
+    float ViewDepth(DirectX::FXMMATRIX modelView) const;
+
+    // With a view given, only the index ranges of visible meshlets are drawn. Meshlets only cover LOD 0
+    // and are culled for a single transform, instanced draws pass no view.
+    void Draw(RenderCommands    &commands,
+              const MeshletView *view          = nullptr,
+              size_t             lod           = 0,
+              UINT               instanceCount = 1) const;
+    // Draw without binding the geometry buffer and the material, for callers that keep track of them themselves
+    void DrawBound(RenderCommands    &commands,
+                   const MeshletView *view          = nullptr,
+                   size_t             lod           = 0,
+                   UINT               instanceCount = 1) const;
 };
 
-class SceneObject
+struct SceneDrawStats
 {
-    std::vector<std::unique_ptr<SceneObject>> m_Children;
-    std::vector<const Mesh *>                 m_Meshes;
-    DirectX::XMMATRIX                         m_Transform;
+    size_t UpdatedTransforms     = 0; // World transforms recomputed
+    size_t Draws                 = 0; // Meshes that reached the command list
+    size_t InstancedDraws        = 0; // Draws the meshes were grouped into, by mesh and LOD
+    size_t CulledDraws           = 0; // Meshes outside the view frustum
+    size_t OccludedDraws         = 0; // Meshes inside the frustum but behind the occluders
+    double CullingMilliseconds   = 0.0;
+    double OcclusionMilliseconds = 0.0;
+    double SortMilliseconds      = 0.0; // Recording the draw list is not included
 
-  public:
-    void QueryInit(const ObjectData &data, const std::vector<Mesh> &meshes);
-    void Draw(PGraphicsCommandList     commandList,
-              const DirectX::XMMATRIX &model,
-              const DirectX::XMMATRIX &view,
-              const DirectX::XMMATRIX &projection) const;
+    size_t TotalDraws() const noexcept { return Draws + CulledDraws + OccludedDraws; }
+
+    SceneDrawStats &operator+=(const SceneDrawStats &other) noexcept
+    {
+        UpdatedTransforms     += other.UpdatedTransforms;
+        Draws                 += other.Draws;
+        InstancedDraws        += other.InstancedDraws;
+        CulledDraws           += other.CulledDraws;
+        OccludedDraws         += other.OccludedDraws;
+        CullingMilliseconds   += other.CullingMilliseconds;
+        OcclusionMilliseconds += other.OcclusionMilliseconds;
+        SortMilliseconds      += other.SortMilliseconds;
+        return *this;
+    }
 };
 
 class Scene
 {
-    std::vector<Texture>  m_Textures;
-    std::vector<Material> m_Materials;
-    std::vector<Mesh>     m_Meshes;
-    SceneObject           m_Root;
+    std::vector<Texture>    m_Textures;
+    std::vector<Material>   m_Materials;
+    std::vector<Mesh>       m_Meshes;
+    std::optional<Texture>  m_DefaultTexture;  // White, in the texture slots the materials leave empty
+    std::optional<Material> m_DefaultMaterial; // Of meshes without a material, bound at the start of every range
+
+    // Object hierarchy flattened in parent order, see ObjectData. Object i draws
+    // m_ObjectMeshes[m_MeshOffsets[i]] up to m_ObjectMeshes[m_MeshOffsets[i + 1]].
+    std::vector<uint32_t>          m_Parents;
+    std::vector<DirectX::XMMATRIX> m_LocalTransforms;
+    std::vector<DirectX::XMMATRIX> m_WorldTransforms;
+    std::vector<uint32_t>          m_MeshOffsets;
+    std::vector<const Mesh *>      m_ObjectMeshes;
+    std::vector<DirectX::XMFLOAT3> m_BoundsMin;
+    std::vector<DirectX::XMFLOAT3> m_BoundsMax;
+
+    // Objects whose local transform changed since the last UpdateTransforms, which recomputes the world
+    // transforms of their subtrees only. m_WorldChanged keeps the moved objects until Cull updated their box.
+    std::vector<uint8_t> m_TransformDirty;
+    std::vector<uint8_t> m_WorldChanged;
+    DirectX::XMMATRIX    m_Model = DirectX::XMMatrixIdentity();
+
+    // World space boxes of the last Cull. Objects with a single mesh share their box with it,
+    // the others get a box per mesh once the object box is visible. Object boxes are kept between
+    // frames and only follow the objects that moved.
+    BoundingBoxes         m_ObjectBoxes;
+    BoundingBoxes         m_MeshBoxes;
+    std::vector<uint8_t>  m_ObjectVisible;
+    std::vector<uint8_t>  m_MeshBoxVisible;
+    std::vector<uint32_t> m_MeshBoxEntries; // Index into m_ObjectMeshes of every mesh box
+    std::vector<uint8_t>  m_MeshVisible;    // For every entry of m_ObjectMeshes
+
+    // Positions and LOD 0 indices of the meshes chosen as occluders, empty for the others
+    struct OccluderGeometry
+    {
+        std::vector<DirectX::XMFLOAT3> Positions;
+        std::vector<uint32_t>          Indices;
+    };
+    std::vector<OccluderGeometry>          m_OccluderGeometry; // For every mesh
+    std::vector<OcclusionCuller::Occluder> m_Occluders;
+    OcclusionCuller                        m_OcclusionCuller;
+
+    DrawList          m_DrawList;
+    SceneDrawStats    m_Stats;
+    DirectX::XMMATRIX m_View;
+    DirectX::XMMATRIX m_Projection;
+
+    // Visible meshes of the last Prepare grouped by mesh and LOD, every batch becomes one instanced draw
+    struct InstanceBatch
+    {
+        const Mesh *DrawnMesh;
+        uint32_t    Lod;
+        uint32_t    Object; // Of the first instance
+        uint32_t    FirstInstance;
+        uint32_t    InstanceCount;
+        uint32_t    NextBatch; // Batch of the same mesh with another LOD
+        float       ViewDepth; // Of the nearest instance
+    };
+    struct BatchInstance
+    {
+        uint32_t Batch;
+        uint32_t Object;
+        uint32_t Index; // Within the batch
+    };
+    static constexpr uint32_t NO_BATCH = UINT32_MAX;
+
+    std::vector<InstanceBatch> m_Batches;
+    std::vector<uint32_t>      m_MeshBatches; // First batch of every mesh, NO_BATCH outside of Prepare
+    std::vector<BatchInstance> m_Instances;   // For every visible mesh
+
+    // Written by the last Prepare, the instance transforms of a batch are consecutive
+    D3D12_GPU_VIRTUAL_ADDRESS m_FrameConstants     = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS m_InstanceTransforms = 0;
 
-    DescriptorHeap *m_DescriptorHeap;
+    DescriptorAllocator *m_Descriptors = nullptr;
+    // Materials pass their texture indices into the whole heap, bound once per range, instead of a table each
+    bool m_Bindless = true;
+
+    // Viewport pixels per unit of normalized device y divided by the allowed error, 0 keeps every mesh at LOD 0
+    float m_LodScale = 0.0f;
+
+    // Without an uploader nothing is created on the device, see Describe
+    void Init(PDevice              device,
+              StagingUploader     *uploader,
+              HeapAllocator       *geometryHeap,
+              DescriptorAllocator &descriptors,
+              const SceneData     &data);
 
   public:
-    void QueryInit(PDevice device, ResourceUploadBatch &rub, DescriptorHeap &descriptorHeap, const SceneData &data);
-    void Draw(PGraphicsCommandList     commandList,
-              const DirectX::XMMATRIX &model,
-              const DirectX::XMMATRIX &view,
-              const DirectX::XMMATRIX &projection) const;
+    static constexpr float LOD_PIXEL_ERROR = 1.0f;
+
+    // Triangles of the largest meshes, by bounding box area, that get rasterized as occluders
+    static constexpr size_t OCCLUDER_TRIANGLE_BUDGET = 1 << 15;
+
+    void SetLodTarget(float viewportHeight, float pixelError = LOD_PIXEL_ERROR) noexcept
+    {
+        m_LodScale = viewportHeight * 0.5f / pixelError;
+    }
+
+    // The textures take their descriptors from the persistent range of descriptors, the geometry buffers are
+    // placed in geometryHeap
+    void QueryInit(PDevice              device,
+                   StagingUploader     &uploader,
+                   HeapAllocator       &geometryHeap,
+                   DescriptorAllocator &descriptors,
+                   const SceneData     &data);
+    // Same meshes, materials and objects as QueryInit without creating any resource, for measuring and testing
+    // the CPU side of a frame without a device. The textures still take their descriptors.
+    void Describe(DescriptorAllocator &descriptors, const SceneData &data);
+
+    void SetBindless(bool bindless) noexcept { m_Bindless = bindless; }
+    bool IsBindless() const noexcept { return m_Bindless; }
+
+    size_t                   GetObjectCount() const noexcept { return m_Parents.size(); }
+    const DirectX::XMMATRIX &GetLocalTransform(size_t object) const noexcept { return m_LocalTransforms[object]; }
+    void                     SetLocalTransform(size_t object, DirectX::FXMMATRIX transform);
+
+    // One pass over the objects, parents are always updated before their children. Only the objects with
+    // a changed local transform and their descendants are multiplied, or all of them when the model changes.
+    void UpdateTransforms(const DirectX::XMMATRIX &model);
+    // Tests the world bounds of the objects, then of their meshes against the frustum of viewProjection
+    void Cull(const DirectX::XMMATRIX &viewProjection);
+    // Renders the occluders that passed Cull and drops the meshes they hide
+    void Occlude(const DirectX::XMMATRIX &viewProjection, float nearDepth);
+
+    // Counters of the last Prepare
+    const SceneDrawStats &GetStats() const noexcept { return m_Stats; }
+
+    // Culls, groups the visible meshes into instanced draws by mesh and LOD, fills the draw list with them
+    // and sorts it. The view and projection are written to a constant buffer in uploadRing, the world
+    // transforms of the instances to a structured buffer ordered by draw.
+    void Prepare(UploadRing              &uploadRing,
+                 ID3D12PipelineState     *pipelineState,
+                 const DirectX::XMMATRIX &model,
+                 const DirectX::XMMATRIX &view,
+                 const DirectX::XMMATRIX &projection);
+    // Packets of the draw list the last Prepare filled
+    size_t GetDrawCount() const noexcept { return m_DrawList.GetPackets().size(); }
+    // Replays the packets [begin, end) of the draw list. Ranges don't depend on each other's state,
+    // so they can be recorded on different threads into command lists of their own.
+    void Record(RenderCommands &commands, size_t begin, size_t end) const;
 };
@@ -0,0 +1,340 @@
+#include "SceneCache.hpp"
+#include "GltfLoader.hpp"
+#include "MappedFile.hpp"
+#include "Utils.hpp"
+
+namespace
+{
+    constexpr uint32_t NO_TEXTURE = UINT32_MAX;
+
+    struct CacheHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t SourceHash;
+        uint64_t ImportFlags;
+        uint64_t FileSize;
+        uint64_t TextureCount;
+        uint64_t MaterialCount;
+        uint64_t MeshCount;
+        uint64_t ObjectCount;
+        uint64_t ObjectMeshCount;
+    };
+
+    struct CacheMesh
+    {
+        uint64_t          VertexCount;
+        uint64_t          VertexSize;
+        uint64_t          IndexCount;
+        uint64_t          IndexSize;
+        uint64_t          MaterialIndex;
+        uint64_t          Format;
+        DirectX::XMFLOAT3 BoundsMin;
+        DirectX::XMFLOAT3 BoundsMax;
+        uint32_t          Padding;
+        uint64_t          MeshletCount;
+        uint64_t          MeshletVertexCount;
+        uint64_t          MeshletTriangleCount;
+        uint64_t          LodCount;
+    };
+
+    // Path, size and modification time of a file the scene depends on, missing files hash differently from
+    // every existing one
+    uint64_t HashFileStamp(const std::filesystem::path &path, uint64_t seed)
+    {
+        std::error_code ec;
+        uint64_t        size = std::filesystem::file_size(path, ec);
+        if (ec)
+            size = UINT64_MAX;
+        int64_t time = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        if (ec)
+            time = 0;
+
+        std::string name = path.generic_u8string();
+        uint64_t    hash = HashBytes(name.data(), name.size(), seed);
+        hash             = HashBytes(&size, sizeof(size), hash);
+        return HashBytes(&time, sizeof(time), hash);
+    }
+
+    class BinaryWriter
+    {
+        std::vector<char> m_Bytes;
+
+      public:
+        template <typename T> void Write(const T &value) { WriteBytes(&value, sizeof(T)); }
+
+        void WriteBytes(const void *data, size_t size)
+        {
+            const char *bytes = static_cast<const char *>(data);
+            m_Bytes.insert(m_Bytes.end(), bytes, bytes + size);
+        }
+
+        void Align(size_t alignment) { m_Bytes.resize(Math::AlignUp(m_Bytes.size(), alignment), 0); }
+
+        std::vector<char> &Bytes() noexcept { return m_Bytes; }
+    };
+
+    class BinaryReader
+    {
+        const char *m_Data;
+        size_t      m_Size;
+        size_t      m_Offset = 0;
+
+      public:
+        BinaryReader(const char *data, size_t size)
+            : m_Data(data),
+              m_Size(size)
+        {
+        }
+
+        const char *ReadBytes(size_t size)
+        {
+            if (size > m_Size - m_Offset)
+                throw std::runtime_error("Scene cache is truncated");
+            const char *result = m_Data + m_Offset;
+            m_Offset += size;
+            return result;
+        }
+
+        template <typename T> T Read()
+        {
+            T result;
+            std::memcpy(&result, ReadBytes(sizeof(T)), sizeof(T));
+            return result;
+        }
+
+        void Align(size_t alignment) { ReadBytes(Math::AlignUp(m_Offset, alignment) - m_Offset); }
+    };
+} // namespace
+
+std::filesystem::path SceneCache::CachePathFor(const std::filesystem::path &scenePath)
+{
+    std::filesystem::path result = scenePath;
+    result += L".scenecache";
+    return result;
+}
+
+SceneCache::Key SceneCache::MakeKey(const std::filesystem::path &scenePath, uint64_t importFlags)
+{
+    MappedFile source(scenePath);
+
+    Key key;
+    key.SourceHash  = HashBytes(source.Data(), source.Size());
+    key.ImportFlags = importFlags;
+
+    // The buffers of a glTF scene are much larger than the scene file. Their size and modification time tell
+    // when they were replaced without reading them.
+    std::filesystem::path extension = scenePath.extension();
+    if (extension == ".gltf" || extension == ".glb")
+    {
+        for (auto &&path : GltfLoader::BufferPaths(scenePath))
+            key.SourceHash = HashFileStamp(path, key.SourceHash);
+    }
+    return key;
+}
+
+bool SceneCache::Load(const std::filesystem::path &cachePath, const Key &key, SceneData &sceneData)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec))
+        return false;
+
+    try
+    {
+        MappedFile   file(cachePath);
+        BinaryReader reader(file.Data(), file.Size());
+
+        auto header = reader.Read<CacheHeader>();
+        if (header.Magic != CACHE_MAGIC || header.Version != CACHE_VERSION || header.SourceHash != key.SourceHash
+            || header.ImportFlags != key.ImportFlags || header.FileSize != file.Size())
+            return false;
+
+        std::filesystem::path sceneDir  = cachePath;
+        std::wstring          sceneDirW = sceneDir.remove_filename().generic_wstring();
+
+        SceneData result;
+
+        std::vector<std::wstring> texturePaths(header.TextureCount);
+        for (auto &path : texturePaths)
+        {
+            auto length = reader.Read<uint64_t>();
+            auto chars  = reinterpret_cast<const wchar_t *>(reader.ReadBytes(length * sizeof(wchar_t)));
+            path        = sceneDirW + std::wstring(chars, chars + length);
+            result.m_TexturePaths.insert(path);
+        }
+
+        result.m_Materials.resize(header.MaterialCount);
+        for (auto &material : result.m_Materials)
+        {
+            for (size_t i = 0; i < TEXTURE_TYPE_COUNT; ++i)
+            {
+                auto idx = reader.Read<uint32_t>();
+                if (idx == NO_TEXTURE)
+                    continue;
+                if (idx >= texturePaths.size())
+                    return false;
+                material.TexturePaths[i] = texturePaths[idx];
+            }
+        }
+
+        result.m_Meshes.resize(header.MeshCount);
+        for (auto &mesh : result.m_Meshes)
+        {
+            auto desc = reader.Read<CacheMesh>();
+            if (desc.Format > VERTEX_FORMAT_QUANTIZED)
+                return false;
+            reader.Align(CACHE_ALIGNMENT);
+            const char *vertices = reader.ReadBytes(desc.VertexCount * desc.VertexSize);
+            reader.Align(CACHE_ALIGNMENT);
+            const char *indices = reader.ReadBytes(desc.IndexCount * desc.IndexSize);
+            reader.Align(CACHE_ALIGNMENT);
+            auto meshlets = reinterpret_cast<const Meshlet *>(reader.ReadBytes(desc.MeshletCount * sizeof(Meshlet)));
+            reader.Align(CACHE_ALIGNMENT);
+            auto meshletVertices
+                = reinterpret_cast<const uint32_t *>(reader.ReadBytes(desc.MeshletVertexCount * sizeof(uint32_t)));
+            reader.Align(CACHE_ALIGNMENT);
+            auto meshletTriangles = reinterpret_cast<const uint8_t *>(reader.ReadBytes(desc.MeshletTriangleCount * 3));
+            reader.Align(CACHE_ALIGNMENT);
+            auto lods = reinterpret_cast<const MeshLod *>(reader.ReadBytes(desc.LodCount * sizeof(MeshLod)));
+            reader.Align(CACHE_ALIGNMENT);
+
+            mesh.InitBytes(vertices, desc.VertexCount, desc.VertexSize, indices, desc.IndexCount, desc.IndexSize);
+            mesh.m_MaterialIndex = desc.MaterialIndex;
+            mesh.m_VertexFormat  = static_cast<VertexFormat>(desc.Format);
+            mesh.m_BoundsMin     = desc.BoundsMin;
+            mesh.m_BoundsMax     = desc.BoundsMax;
+            mesh.m_Meshlets.assign(meshlets, meshlets + desc.MeshletCount);
+            mesh.m_MeshletVertices.assign(meshletVertices, meshletVertices + desc.MeshletVertexCount);
+            mesh.m_MeshletTriangles.assign(meshletTriangles, meshletTriangles + desc.MeshletTriangleCount * 3);
+            mesh.m_Lods.assign(lods, lods + desc.LodCount);
+
+            for (auto &&meshlet : mesh.m_Meshlets)
+                if (meshlet.IndexOffset + meshlet.TriangleCount * 3ull > desc.IndexCount)
+                    return false;
+            for (auto &&lod : mesh.m_Lods)
+                if (lod.IndexOffset + static_cast<uint64_t>(lod.IndexCount) > desc.IndexCount)
+                    return false;
+        }
+
+        reader.Align(CACHE_ALIGNMENT);
+        auto objects = reinterpret_cast<const ObjectData *>(reader.ReadBytes(header.ObjectCount * sizeof(ObjectData)));
+        reader.Align(CACHE_ALIGNMENT);
+        auto objectMeshes
+            = reinterpret_cast<const uint32_t *>(reader.ReadBytes(header.ObjectMeshCount * sizeof(uint32_t)));
+        result.m_Objects.assign(objects, objects + header.ObjectCount);
+        result.m_ObjectMeshes.assign(objectMeshes, objectMeshes + header.ObjectMeshCount);
+
+        // Parents have to precede their children, that is what the linear transform pass relies on
+        for (size_t i = 0; i < result.m_Objects.size(); ++i)
+        {
+            auto &&object = result.m_Objects[i];
+            if (i == 0 ? object.Parent != ObjectData::NO_PARENT : object.Parent >= i)
+                return false;
+            if (object.MeshOffset + static_cast<uint64_t>(object.MeshCount) > header.ObjectMeshCount)
+                return false;
+        }
+        for (uint32_t idx : result.m_ObjectMeshes)
+            if (idx >= result.m_Meshes.size())
+                return false;
+
+        sceneData = std::move(result);
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        OutputDebugStringA(e.what());
+        OutputDebugStringA("\n");
+        return false;
+    }
+}
+
+void SceneCache::Save(const std::filesystem::path &cachePath, const Key &key, const SceneData &sceneData)
+{
+    std::filesystem::path sceneDir  = cachePath;
+    std::wstring          sceneDirW = sceneDir.remove_filename().generic_wstring();
+
+    BinaryWriter writer;
+
+    CacheHeader header     = {};
+    header.Magic           = CACHE_MAGIC;
+    header.Version         = CACHE_VERSION;
+    header.SourceHash      = key.SourceHash;
+    header.ImportFlags     = key.ImportFlags;
+    header.TextureCount    = sceneData.m_TexturePaths.size();
+    header.MaterialCount   = sceneData.m_Materials.size();
+    header.MeshCount       = sceneData.m_Meshes.size();
+    header.ObjectCount     = sceneData.m_Objects.size();
+    header.ObjectMeshCount = sceneData.m_ObjectMeshes.size();
+    writer.Write(header);
+
+    std::unordered_map<std::wstring_view, uint32_t> textureIndices;
+    for (auto &&path : sceneData.m_TexturePaths)
+    {
+        std::wstring_view relative = path;
+        if (relative.substr(0, sceneDirW.size()) == sceneDirW)
+            relative.remove_prefix(sceneDirW.size());
+        textureIndices[path] = static_cast<uint32_t>(textureIndices.size());
+        writer.Write(static_cast<uint64_t>(relative.size()));
+        writer.WriteBytes(relative.data(), relative.size() * sizeof(wchar_t));
+    }
+
+    for (auto &&material : sceneData.m_Materials)
+    {
+        for (size_t i = 0; i < TEXTURE_TYPE_COUNT; ++i)
+        {
+            auto it = textureIndices.find(material.TexturePaths[i]);
+            writer.Write(it == textureIndices.end() ? NO_TEXTURE : it->second);
+        }
+    }
+
+    for (auto &&mesh : sceneData.m_Meshes)
+    {
+        CacheMesh desc            = {};
+        desc.VertexCount          = mesh.VertexCount();
+        desc.VertexSize           = mesh.SingleVertexSize();
+        desc.IndexCount           = mesh.IndexCount();
+        desc.IndexSize            = mesh.SingleIndexSize();
+        desc.MaterialIndex        = mesh.m_MaterialIndex;
+        desc.Format               = mesh.m_VertexFormat;
+        desc.BoundsMin            = mesh.m_BoundsMin;
+        desc.BoundsMax            = mesh.m_BoundsMax;
+        desc.MeshletCount         = mesh.m_Meshlets.size();
+        desc.MeshletVertexCount   = mesh.m_MeshletVertices.size();
+        desc.MeshletTriangleCount = mesh.m_MeshletTriangles.size() / 3;
+        desc.LodCount             = mesh.m_Lods.size();
+        writer.Write(desc);
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.VertexBufferStart(), mesh.VertexBufferSize());
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.IndexBufferStart(), mesh.IndexBufferSize());
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.m_Meshlets.data(), mesh.m_Meshlets.size() * sizeof(Meshlet));
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.m_MeshletVertices.data(), mesh.m_MeshletVertices.size() * sizeof(uint32_t));
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.m_MeshletTriangles.data(), mesh.m_MeshletTriangles.size());
+        writer.Align(CACHE_ALIGNMENT);
+        writer.WriteBytes(mesh.m_Lods.data(), mesh.m_Lods.size() * sizeof(MeshLod));
+        writer.Align(CACHE_ALIGNMENT);
+    }
+
+    writer.Align(CACHE_ALIGNMENT);
+    writer.WriteBytes(sceneData.m_Objects.data(), sceneData.m_Objects.size() * sizeof(ObjectData));
+    writer.Align(CACHE_ALIGNMENT);
+    writer.WriteBytes(sceneData.m_ObjectMeshes.data(), sceneData.m_ObjectMeshes.size() * sizeof(uint32_t));
+
+    auto &bytes     = writer.Bytes();
+    header.FileSize = bytes.size();
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    // Write next to the target and swap in, so a crash never leaves a half-written cache behind
+    std::filesystem::path tempPath = cachePath;
+    tempPath += L".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        fout.write(bytes.data(), bytes.size());
+        if (!fout)
+            throw std::runtime_error("Couldn't write scene cache " + tempPath.string());
+    }
+    std::filesystem::rename(tempPath, cachePath);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "SceneData.hpp"
+
+// Binary snapshot of an imported SceneData.
+// Layout (all values little endian, blobs aligned to CACHE_ALIGNMENT):
+//   header, texture path table, materials, meshes, objects in parent order, object mesh indices.
+// Every mesh is a descriptor followed by vertex, index, meshlet and LOD blobs.
+// Texture paths are stored relative to the scene directory.
+class SceneCache
+{
+  public:
+    static constexpr uint32_t CACHE_MAGIC     = 0x48434453; // "SDCH"
+    static constexpr uint32_t CACHE_VERSION   = 6;
+    static constexpr size_t   CACHE_ALIGNMENT = 16;
+
+    struct Key
+    {
+        uint64_t SourceHash  = 0; // Scene file contents, and path, size and write time of the glTF buffers
+        uint64_t ImportFlags = 0;
+    };
+
+    SceneCache() = delete;
+
+    static std::filesystem::path CachePathFor(const std::filesystem::path &scenePath);
+    static Key                   MakeKey(const std::filesystem::path &scenePath, uint64_t importFlags);
+
+    // Returns false if the cache is missing, stale or corrupted. The blobs are copied out of the mapping, so the
+    // file isn't held open and a later import can replace it while the scene is alive.
+    static bool Load(const std::filesystem::path &cachePath, const Key &key, SceneData &sceneData);
+    static void Save(const std::filesystem::path &cachePath, const Key &key, const SceneData &sceneData);
+};
@@ -1,66 +1,358 @@
 #include "SceneData.hpp"
+#include "GltfLoader.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "SceneCache.hpp"
+#include "ThreadPool.hpp"
+#include "VertexCodec.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/material.h>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
-struct VertexData
+static constexpr unsigned int IMPORT_FLAGS = aiProcessPreset_TargetRealtime_Quality | aiProcess_TransformUVCoords
+                                           | aiProcess_FlipUVs | aiProcess_ValidateDataStructure;
+
+static const wchar_t *const IMPORTER_NAMES[] = {L"assimp", L"gltf"};
+
+// Everything that changes the produced data has to end up in the cache key
+static uint64_t ImportKey(const SceneImportOptions &options)
+{
+    return IMPORT_FLAGS | static_cast<uint64_t>(options.Importer) << 32 | static_cast<uint64_t>(options.Format) << 36
+         | static_cast<uint64_t>(options.OptimizeMeshes) << 40 | static_cast<uint64_t>(options.NarrowIndices) << 41
+         | static_cast<uint64_t>(options.SplitMeshes) << 42 | static_cast<uint64_t>(options.BuildMeshlets) << 43
+         | static_cast<uint64_t>(options.GenerateLods) << 44;
+}
+
+// Assimp's strings are UTF-8
+static std::wstring FromUtf8(const char *text) { return std::filesystem::u8path(text).wstring(); }
+
+static DirectX::XMFLOAT3 ToFloat3(const aiVector3D &v) { return DirectX::XMFLOAT3(v.x, v.y, v.z); }
+
+static void ConvertMesh(const aiMesh *mesh, MeshData &meshData)
+{
+    if (mesh->mNumUVComponents[0] < 2)
+        throw std::exception("Mesh doesn't contain UV coordinates");
+
+    size_t triangleCount = std::count_if(
+        mesh->mFaces, mesh->mFaces + mesh->mNumFaces, [](const aiFace &face) { return face.mNumIndices == 3; });
+
+    meshData.Allocate(mesh->mNumVertices, sizeof(VertexData), 3 * triangleCount, sizeof(uint32_t));
+    meshData.m_MaterialIndex = mesh->mMaterialIndex;
+
+    auto vertices = static_cast<VertexData *>(meshData.VertexBufferData());
+    for (size_t j = 0; j < mesh->mNumVertices; ++j)
+    {
+        aiVector3D uvw        = mesh->mTextureCoords[0][j];
+        vertices[j].pos       = ToFloat3(mesh->mVertices[j]);
+        vertices[j].normal    = ToFloat3(mesh->mNormals[j]);
+        vertices[j].tangent   = ToFloat3(mesh->mTangents[j]);
+        vertices[j].bitangent = ToFloat3(mesh->mBitangents[j]);
+        vertices[j].uv        = DirectX::XMFLOAT2(uvw.x, uvw.y);
+    }
+
+    auto indices = static_cast<uint32_t *>(meshData.IndexBufferData());
+    for (size_t j = 0; j < mesh->mNumFaces; ++j)
+    {
+        auto &&face = mesh->mFaces[j];
+        if (face.mNumIndices != 3)
+            // throw std::exception("Weird face");
+            continue;
+        for (size_t k = 0; k < face.mNumIndices; ++k)
+            *indices++ = face.mIndices[k];
+    }
+}
+
+uint32_t SceneData::AddObject(uint32_t parent, const DirectX::XMFLOAT4X4 &transform, const std::vector<size_t> &meshes)
 {
-    aiVector3D pos;
-    aiVector3D normal;
-    aiVector3D tangent;
-    aiVector3D bitangent;
-    aiVector2D uv;
-};
-
-void ObjectData::ParseNode(const aiNode *node)
+    if (parent != ObjectData::NO_PARENT && parent >= m_Objects.size())
+        throw std::exception("Parent object has to be added first");
+
+    ObjectData object = {};
+    object.Parent     = parent;
+    object.MeshOffset = static_cast<uint32_t>(m_ObjectMeshes.size());
+    object.MeshCount  = static_cast<uint32_t>(meshes.size());
+    object.Transform  = transform;
+    for (size_t idx : meshes)
+        m_ObjectMeshes.push_back(static_cast<uint32_t>(idx));
+
+    m_Objects.push_back(object);
+    return static_cast<uint32_t>(m_Objects.size() - 1);
+}
+
+void SceneData::ParseNode(const aiNode *node, uint32_t parent)
 {
-    m_Transform(0, 0) = node->mTransformation.a1;
-    m_Transform(0, 1) = node->mTransformation.a2;
-    m_Transform(0, 2) = node->mTransformation.a3;
-    m_Transform(0, 3) = node->mTransformation.a4;
-    m_Transform(1, 0) = node->mTransformation.b1;
-    m_Transform(1, 1) = node->mTransformation.b2;
-    m_Transform(1, 2) = node->mTransformation.b3;
-    m_Transform(1, 3) = node->mTransformation.b4;
-    m_Transform(2, 0) = node->mTransformation.c1;
-    m_Transform(2, 1) = node->mTransformation.c2;
-    m_Transform(2, 2) = node->mTransformation.c3;
-    m_Transform(2, 3) = node->mTransformation.c4;
-    m_Transform(3, 0) = node->mTransformation.d1;
-    m_Transform(3, 1) = node->mTransformation.d2;
-    m_Transform(3, 2) = node->mTransformation.d3;
-    m_Transform(3, 3) = node->mTransformation.d4;
-
-    m_MeshIdx.resize(node->mNumMeshes);
-    for (size_t i = 0; i < node->mNumMeshes; ++i)
-        m_MeshIdx[i] = node->mMeshes[i];
-
-    m_Children.resize(node->mNumChildren);
+    DirectX::XMFLOAT4X4 transform;
+    transform(0, 0) = node->mTransformation.a1;
+    transform(0, 1) = node->mTransformation.a2;
+    transform(0, 2) = node->mTransformation.a3;
+    transform(0, 3) = node->mTransformation.a4;
+    transform(1, 0) = node->mTransformation.b1;
+    transform(1, 1) = node->mTransformation.b2;
+    transform(1, 2) = node->mTransformation.b3;
+    transform(1, 3) = node->mTransformation.b4;
+    transform(2, 0) = node->mTransformation.c1;
+    transform(2, 1) = node->mTransformation.c2;
+    transform(2, 2) = node->mTransformation.c3;
+    transform(2, 3) = node->mTransformation.c4;
+    transform(3, 0) = node->mTransformation.d1;
+    transform(3, 1) = node->mTransformation.d2;
+    transform(3, 2) = node->mTransformation.d3;
+    transform(3, 3) = node->mTransformation.d4;
+
+    std::vector<size_t> meshes(node->mMeshes, node->mMeshes + node->mNumMeshes);
+    uint32_t            object = AddObject(parent, transform, meshes);
     for (size_t i = 0; i < node->mNumChildren; ++i)
+        ParseNode(node->mChildren[i], object);
+}
+
+void SceneData::RemapMeshes(const std::vector<size_t> &firstMesh)
+{
+    std::vector<uint32_t> objectMeshes;
+    for (auto &object : m_Objects)
+    {
+        uint32_t offset = static_cast<uint32_t>(objectMeshes.size());
+        for (uint32_t i = object.MeshOffset; i < object.MeshOffset + object.MeshCount; ++i)
+            for (size_t part = firstMesh[m_ObjectMeshes[i]]; part < firstMesh[m_ObjectMeshes[i] + 1]; ++part)
+                objectMeshes.push_back(static_cast<uint32_t>(part));
+        object.MeshOffset = offset;
+        object.MeshCount  = static_cast<uint32_t>(objectMeshes.size()) - offset;
+    }
+    m_ObjectMeshes = std::move(objectMeshes);
+}
+
+void SceneData::ComputeObjectBounds()
+{
+    for (auto &object : m_Objects)
+    {
+        object.BoundsMin = object.BoundsMax = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        if (object.MeshCount == 0)
+            continue;
+
+        DirectX::XMVECTOR lo = DirectX::XMLoadFloat3(&m_Meshes[m_ObjectMeshes[object.MeshOffset]].m_BoundsMin);
+        DirectX::XMVECTOR hi = DirectX::XMLoadFloat3(&m_Meshes[m_ObjectMeshes[object.MeshOffset]].m_BoundsMax);
+        for (uint32_t i = object.MeshOffset + 1; i < object.MeshOffset + object.MeshCount; ++i)
+        {
+            lo = DirectX::XMVectorMin(lo, DirectX::XMLoadFloat3(&m_Meshes[m_ObjectMeshes[i]].m_BoundsMin));
+            hi = DirectX::XMVectorMax(hi, DirectX::XMLoadFloat3(&m_Meshes[m_ObjectMeshes[i]].m_BoundsMax));
+        }
+        DirectX::XMStoreFloat3(&object.BoundsMin, lo);
+        DirectX::XMStoreFloat3(&object.BoundsMax, hi);
+    }
+}
+
+void MeshData::ComputeBounds()
+{
+    m_BoundsMin = m_BoundsMax = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    if (m_VertexCount == 0)
+        return;
+
+    DirectX::XMFLOAT3 pos;
+    std::memcpy(&pos, m_VertexBuffer.data(), sizeof(pos));
+    m_BoundsMin = m_BoundsMax = pos;
+    for (size_t i = 1; i < m_VertexCount; ++i)
+    {
+        std::memcpy(&pos, m_VertexBuffer.data() + i * m_VertexSize, sizeof(pos));
+        m_BoundsMin.x = (std::min)(m_BoundsMin.x, pos.x);
+        m_BoundsMin.y = (std::min)(m_BoundsMin.y, pos.y);
+        m_BoundsMin.z = (std::min)(m_BoundsMin.z, pos.z);
+        m_BoundsMax.x = (std::max)(m_BoundsMax.x, pos.x);
+        m_BoundsMax.y = (std::max)(m_BoundsMax.y, pos.y);
+        m_BoundsMax.z = (std::max)(m_BoundsMax.z, pos.z);
+    }
+}
+
+std::vector<uint32_t> MeshData::GetIndices() const
+{
+    std::vector<uint32_t> result(m_IndexCount);
+    if (m_IndexSize == sizeof(uint32_t))
+        std::memcpy(result.data(), m_IndexBuffer.data(), m_IndexBuffer.size());
+    else if (m_IndexSize == sizeof(uint16_t))
+        for (size_t i = 0; i < m_IndexCount; ++i)
+            result[i] = reinterpret_cast<const uint16_t *>(m_IndexBuffer.data())[i];
+    else if (m_IndexCount != 0)
+        throw std::exception("Unknown index format");
+    return result;
+}
+
+void MeshData::SetIndices(const std::vector<uint32_t> &indices, size_t indexSize)
+{
+    m_IndexCount = indices.size();
+    m_IndexSize  = indexSize;
+    m_IndexBuffer.resize(indices.size() * indexSize);
+    if (indexSize == sizeof(uint32_t))
+        std::memcpy(m_IndexBuffer.data(), indices.data(), m_IndexBuffer.size());
+    else if (indexSize == sizeof(uint16_t))
+        for (size_t i = 0; i < indices.size(); ++i)
+            reinterpret_cast<uint16_t *>(m_IndexBuffer.data())[i] = static_cast<uint16_t>(indices[i]);
+    else
+        throw std::exception("Unknown index format");
+}
+
+void SceneData::ProcessMeshes(const std::filesystem::path &scenePath, const SceneImportOptions &options)
+{
+    std::vector<VertexCacheStats> before(m_Meshes.size());
+    std::vector<VertexCacheStats> after(m_Meshes.size());
+
+    size_t sourceVertexBytes = 0;
+    size_t sourceIndexBytes  = 0;
+    for (auto &&mesh : m_Meshes)
+    {
+        sourceVertexBytes += mesh.VertexBufferSize();
+        sourceIndexBytes  += mesh.IndexBufferSize();
+    }
+
+    if (options.OptimizeMeshes)
+    {
+        ThreadPool::Shared().ParallelFor(
+            m_Meshes.size(), [&](size_t i) { MeshOptimizer::Optimize(m_Meshes[i], before[i], after[i]); });
+    }
+
+    size_t meshCount = m_Meshes.size();
+    if (options.SplitMeshes)
+    {
+        std::vector<MeshData> meshes;
+        std::vector<size_t>   firstMesh(m_Meshes.size() + 1, 0);
+        for (size_t i = 0; i < m_Meshes.size(); ++i)
+        {
+            if (m_Meshes[i].VertexCount() <= MeshOptimizer::MAX_16BIT_VERTICES)
+            {
+                meshes.push_back(std::move(m_Meshes[i]));
+            }
+            else
+            {
+                for (auto &part : MeshOptimizer::Split(m_Meshes[i]))
+                    meshes.push_back(std::move(part));
+            }
+            firstMesh[i + 1] = meshes.size();
+        }
+        m_Meshes = std::move(meshes);
+        RemapMeshes(firstMesh);
+    }
+
+    // Passes that need float positions have to run before the vertices get encoded
+    ThreadPool::Shared().ParallelFor(m_Meshes.size(), [&](size_t i) {
+        if (options.GenerateLods)
+            MeshSimplifier::GenerateLods(m_Meshes[i]);
+        if (options.NarrowIndices)
+            MeshOptimizer::NarrowIndices(m_Meshes[i]);
+        if (options.BuildMeshlets)
+            MeshletBuilder::Build(m_Meshes[i]);
+        m_Meshes[i].ComputeBounds();
+        VertexCodec::Encode(m_Meshes[i], options.Format);
+    });
+    ComputeObjectBounds();
+
+    size_t targetVertexBytes = 0;
+    size_t targetIndexBytes  = 0;
+    for (auto &&mesh : m_Meshes)
     {
-        m_Children[i] = std::make_unique<ObjectData>();
-        m_Children[i]->ParseNode(node->mChildren[i]);
+        targetVertexBytes += mesh.VertexBufferSize();
+        targetIndexBytes  += mesh.IndexBufferSize();
     }
+
+    std::wstring       name = scenePath.filename().wstring();
+    std::wstringstream ss;
+    if (options.OptimizeMeshes)
+    {
+        VertexCacheStats totalBefore;
+        VertexCacheStats totalAfter;
+        for (size_t i = 0; i < before.size(); ++i)
+        {
+            totalBefore += before[i];
+            totalAfter  += after[i];
+        }
+        ss << name << L": ACMR " << totalBefore.ACMR() << L" -> " << totalAfter.ACMR() << L", ATVR "
+           << totalBefore.ATVR() << L" -> " << totalAfter.ATVR() << L"\n";
+    }
+    if (m_Meshes.size() != meshCount)
+        ss << name << L": meshes " << meshCount << L" -> " << m_Meshes.size() << L" after splitting\n";
+    if (options.BuildMeshlets)
+    {
+        size_t meshletCount = 0;
+        for (auto &&mesh : m_Meshes)
+            meshletCount += mesh.m_Meshlets.size();
+        ss << name << L": " << meshletCount << L" meshlets\n";
+    }
+    if (options.GenerateLods)
+    {
+        std::vector<size_t> lodTriangles(MeshSimplifier::MAX_LODS, 0);
+        for (auto &&mesh : m_Meshes)
+        {
+            // Meshes that couldn't be simplified keep showing their full triangle count at every level
+            for (size_t level = 0; level < lodTriangles.size(); ++level)
+            {
+                if (mesh.m_Lods.empty())
+                    lodTriangles[level] += mesh.IndexCount() / 3;
+                else
+                    lodTriangles[level] += mesh.m_Lods[(std::min)(level, mesh.m_Lods.size() - 1)].IndexCount / 3;
+            }
+        }
+        ss << name << L": LOD triangles";
+        for (size_t count : lodTriangles)
+            ss << L" " << count;
+        ss << L"\n";
+    }
+    if (targetVertexBytes != sourceVertexBytes)
+        ss << name << L": vertices " << sourceVertexBytes << L" -> " << targetVertexBytes << L" bytes\n";
+    if (targetIndexBytes != sourceIndexBytes)
+        ss << name << L": indices " << sourceIndexBytes << L" -> " << targetIndexBytes << L" bytes\n";
+    OutputDebugStringW(ss.str().c_str());
 }
 
-void SceneData::LoadFromFile(const std::filesystem::path &scenePath)
+void SceneData::LoadFromFile(const std::filesystem::path &scenePath, const SceneImportOptions &options)
 {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    // Importers don't produce byte-identical data, so the importer is a part of the key
+    std::filesystem::path cachePath = SceneCache::CachePathFor(scenePath);
+    SceneCache::Key       cacheKey  = SceneCache::MakeKey(scenePath, ImportKey(options));
+    bool                  cached    = SceneCache::Load(cachePath, cacheKey, *this);
+
+    if (!cached)
+    {
+        ImportFromFile(scenePath, options.Importer);
+        ProcessMeshes(scenePath, options);
+        try
+        {
+            SceneCache::Save(cachePath, cacheKey, *this);
+        }
+        catch (const std::exception &e)
+        {
+            // Not being able to cache is not a reason to fail loading
+            OutputDebugStringA(e.what());
+            OutputDebugStringA("\n");
+        }
+    }
+
+    auto               t1 = std::chrono::high_resolution_clock::now();
+    std::wstringstream ss;
+    ss << scenePath.filename().wstring() << L": " << (cached ? L"cache" : IMPORTER_NAMES[options.Importer]) << L" "
+       << std::chrono::duration<double, std::milli>(t1 - t0).count() << L" ms\n";
+    OutputDebugStringW(ss.str().c_str());
+}
+
+void SceneData::ImportFromFile(const std::filesystem::path &scenePath, SceneImporter sceneImporter)
+{
+    if (sceneImporter == SCENE_IMPORTER_GLTF)
+    {
+        GltfLoader::Load(scenePath, *this);
+        return;
+    }
+
     // Had troubles with enabling <filesystem> include in MSVC,
     // this is a workaround
     Assimp::Importer      importer;
     std::filesystem::path pathComponents = scenePath;
     auto                  sceneDirW      = pathComponents.remove_filename().generic_wstring();
 
-    const aiScene *scene = importer.ReadFile(scenePath.generic_string(),
-                                             aiProcessPreset_TargetRealtime_Quality | aiProcess_TransformUVCoords
-                                                 | aiProcess_FlipUVs | aiProcess_ValidateDataStructure);
+    const aiScene *scene = importer.ReadFile(scenePath.generic_string(), IMPORT_FLAGS);
 
     if (!scene)
         throw std::exception("Couldn't read scene from file");
 
-    std::wstring_convert<std::codecvt<wchar_t, char, std::mbstate_t>> converter;
-    aiString                                                          texturePath;
+    aiString texturePath;
 
     m_Materials.resize(scene->mNumMaterials);
     for (size_t i = 0; i < scene->mNumMaterials; ++i)
@@ -71,7 +363,7 @@ void SceneData::LoadFromFile(const std::filesystem::path &scenePath)
     {                                                                                                                  \
         if (material->GetTexture(aiTextureType_##x, 0, &texturePath) == aiReturn_SUCCESS)                              \
         {                                                                                                              \
-            std::wstring thisPath                         = sceneDirW + converter.from_bytes(texturePath.C_Str());     \
+            std::wstring thisPath                         = sceneDirW + FromUtf8(texturePath.C_Str());                 \
             m_Materials[i].TexturePaths[TEXTURE_TYPE_##x] = thisPath;                                                  \
             m_TexturePaths.insert(thisPath);                                                                           \
         }                                                                                                              \
@@ -80,45 +372,11 @@ void SceneData::LoadFromFile(const std::filesystem::path &scenePath)
 #undef E
     }
 
+    // Every task writes only to its own presized MeshData, so the result doesn't depend on scheduling
     m_Meshes.resize(scene->mNumMeshes);
-    for (size_t i = 0; i < scene->mNumMeshes; ++i)
-    {
-        auto mesh = scene->mMeshes[i];
-
-        if (mesh->mNumUVComponents[0] < 2)
-            throw std::exception("Mesh doesn't contain UV coordinates");
-
-        std::vector<VertexData> vertices;
-        std::vector<uint32_t>   indices;
-
-        vertices.reserve(mesh->mNumVertices);
-        indices.reserve(size_t(3) * mesh->mNumFaces);
-
-        for (size_t j = 0; j < mesh->mNumVertices; ++j)
-        {
-            auto       vert      = mesh->mVertices[j];
-            auto       normal    = mesh->mNormals[j];
-            auto       tangent   = mesh->mTangents[j];
-            auto       bitangent = mesh->mBitangents[j];
-            aiVector3D uvw       = mesh->mTextureCoords[0][j];
-            vertices.push_back(VertexData{
-                vert, normal, tangent, bitangent, {uvw.x, uvw.y}
-            });
-        }
-
-        for (size_t j = 0; j < mesh->mNumFaces; ++j)
-        {
-            auto &&face = mesh->mFaces[j];
-            if (face.mNumIndices != 3)
-                // throw std::exception("Weird face");
-                continue;
-            for (size_t k = 0; k < face.mNumIndices; ++k)
-                indices.push_back(face.mIndices[k]);
-        }
-
-        m_Meshes[i].InitData(vertices.data(), vertices.size(), indices.data(), indices.size());
-        m_Meshes[i].m_MaterialIndex = mesh->mMaterialIndex;
-    }
+    ThreadPool::Shared().ParallelFor(scene->mNumMeshes, [&](size_t i) { ConvertMesh(scene->mMeshes[i], m_Meshes[i]); });
 
-    m_RootObject.ParseNode(scene->mRootNode);
+    m_Objects.clear();
+    m_ObjectMeshes.clear();
+    ParseNode(scene->mRootNode, ObjectData::NO_PARENT);
 }
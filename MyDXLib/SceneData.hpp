@@ -13,6 +13,63 @@ enum TextureType
         TEXTURE_TYPE_COUNT
 };
 
+enum SceneImporter
+{
+    SCENE_IMPORTER_ASSIMP,
+    SCENE_IMPORTER_GLTF,
+};
+
+// How vertices are laid out in the vertex buffer, see VertexCodec.hpp
+enum VertexFormat
+{
+    VERTEX_FORMAT_FULL,      // VertexData as produced by the importers
+    VERTEX_FORMAT_COMPACT,   // CompactVertexData
+    VERTEX_FORMAT_QUANTIZED, // QuantizedVertexData, positions relative to the mesh bounds
+};
+
+struct SceneImportOptions
+{
+    SceneImporter Importer       = SCENE_IMPORTER_ASSIMP;
+    VertexFormat  Format         = VERTEX_FORMAT_FULL;
+    bool          OptimizeMeshes = false; // Vertex cache, overdraw and vertex fetch ordering
+    bool          NarrowIndices  = false; // 16-bit indices for meshes with at most 65536 vertices
+    bool          SplitMeshes    = false; // Splits bigger meshes so that NarrowIndices applies to every part
+    bool          BuildMeshlets  = false; // Meshlets with culling bounds, see MeshletBuilder
+    bool          GenerateLods   = false; // Simplified index ranges, see MeshSimplifier
+};
+
+// Vertex layout produced by both importers and expected by VertexSponza.hlsl
+struct VertexData
+{
+    DirectX::XMFLOAT3 pos;
+    DirectX::XMFLOAT3 normal;
+    DirectX::XMFLOAT3 tangent;
+    DirectX::XMFLOAT3 bitangent;
+    DirectX::XMFLOAT2 uv;
+};
+
+// Cluster of at most MeshletBuilder::MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+// Meshlets cover consecutive triangles, so they are also ranges of the regular index buffer.
+struct Meshlet
+{
+    uint32_t          VertexOffset;   // Into MeshData::m_MeshletVertices
+    uint32_t          TriangleOffset; // Into MeshData::m_MeshletTriangles, in triangles
+    uint32_t          VertexCount;
+    uint32_t          TriangleCount;
+    uint32_t          IndexOffset;    // First index of the same triangles in the index buffer
+    DirectX::XMFLOAT4 Sphere;         // Center and radius
+    DirectX::XMFLOAT3 ConeApex;
+    DirectX::XMFLOAT4 Cone;           // Axis and cutoff, cutoff = 1 means the cone can't cull
+};
+
+// Index range of one level of detail. Every level uses the vertices of the full mesh.
+struct MeshLod
+{
+    uint32_t IndexOffset;
+    uint32_t IndexCount;
+    float    Error; // Object space distance the level may deviate from the full mesh
+};
+
 class MaterialData
 {
   public:
@@ -29,7 +86,18 @@ class MeshData
     size_t            m_IndexSize   = 0;
 
   public:
-    size_t m_MaterialIndex = 0;
+    size_t            m_MaterialIndex = 0;
+    VertexFormat      m_VertexFormat  = VERTEX_FORMAT_FULL;
+    DirectX::XMFLOAT3 m_BoundsMin     = {};
+    DirectX::XMFLOAT3 m_BoundsMax     = {};
+
+    // Optional, filled by MeshletBuilder
+    std::vector<Meshlet>  m_Meshlets;
+    std::vector<uint32_t> m_MeshletVertices;  // Vertex buffer indices
+    std::vector<uint8_t>  m_MeshletTriangles; // Three meshlet local vertex indices per triangle
+
+    // Optional, filled by MeshSimplifier. Level 0 is the full mesh and the only one covered by meshlets.
+    std::vector<MeshLod> m_Lods;
 
     MeshData()                            = default;
     MeshData(MeshData const &)            = default;
@@ -62,6 +130,58 @@ class MeshData
         m_IndexBuffer.clear();
     }
 
+    void InitBytes(const void *vertexData,
+                   size_t      nVertices,
+                   size_t      vertexSize,
+                   const void *indexData,
+                   size_t      nIndices,
+                   size_t      indexSize)
+    {
+        char const *pVertices = static_cast<char const *>(vertexData);
+        char const *pIndices  = static_cast<char const *>(indexData);
+        m_VertexCount         = nVertices;
+        m_VertexSize          = vertexSize;
+        m_IndexCount          = nIndices;
+        m_IndexSize           = indexSize;
+        m_VertexBuffer        = std::vector(pVertices, pVertices + vertexSize * nVertices);
+        m_IndexBuffer         = std::vector(pIndices, pIndices + indexSize * nIndices);
+    }
+
+    // Presizes the storage so that it can be filled in place through the mutable accessors below
+    void Allocate(size_t nVertices, size_t vertexSize, size_t nIndices, size_t indexSize)
+    {
+        m_VertexCount = nVertices;
+        m_VertexSize  = vertexSize;
+        m_IndexCount  = nIndices;
+        m_IndexSize   = indexSize;
+        m_VertexBuffer.resize(vertexSize * nVertices);
+        m_IndexBuffer.resize(indexSize * nIndices);
+    }
+
+    // Swaps in re-encoded vertices, the index buffer is kept as is
+    void ReplaceVertices(std::vector<char> vertexBuffer, size_t nVertices, size_t vertexSize)
+    {
+        m_VertexCount  = nVertices;
+        m_VertexSize   = vertexSize;
+        m_VertexBuffer = std::move(vertexBuffer);
+    }
+
+    // Frees the vertex and index bytes once they were uploaded. The counts, bounds, meshlets and LODs stay.
+    void ReleaseGeometry() noexcept
+    {
+        m_VertexBuffer = {};
+        m_IndexBuffer  = {};
+    }
+
+    // Indices widened to 32 bits and written back with the given index size
+    std::vector<uint32_t> GetIndices() const;
+    void                  SetIndices(const std::vector<uint32_t> &indices, size_t indexSize);
+
+    // Expects the position to be the leading XMFLOAT3 of every vertex
+    void ComputeBounds();
+
+    void            *VertexBufferData() noexcept { return m_VertexBuffer.data(); }
+    void            *IndexBufferData() noexcept { return m_IndexBuffer.data(); }
     const void      *VertexBufferStart() const noexcept { return m_VertexBuffer.data(); }
     const void      *IndexBufferStart() const noexcept { return m_IndexBuffer.data(); }
     size_t           VertexBufferSize() const noexcept { return m_VertexBuffer.size(); }
@@ -74,34 +194,60 @@ class MeshData
 
 struct aiNode;
 
-class ObjectData
+// Node of the flattened object hierarchy. SceneData keeps the nodes in parent order,
+// so a parent always precedes its children and node 0 is the root.
+struct ObjectData
 {
-    std::vector<std::unique_ptr<ObjectData>> m_Children;
-    std::vector<size_t>                      m_MeshIdx;
-
-  public:
-    DirectX::XMFLOAT4X4 m_Transform;
-
-    const std::vector<std::unique_ptr<ObjectData>> &GetChildren() const noexcept { return m_Children; }
-    const std::vector<size_t>                      &GetMeshIdx() const noexcept { return m_MeshIdx; }
-
-    void ParseNode(const aiNode *node);
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    uint32_t            Parent;
+    uint32_t            MeshOffset; // Into SceneData::GetObjectMeshes()
+    uint32_t            MeshCount;
+    DirectX::XMFLOAT4X4 Transform;  // Relative to the parent
+    DirectX::XMFLOAT3   BoundsMin;  // Union of the mesh bounds in object space, a point for objects without meshes
+    DirectX::XMFLOAT3   BoundsMax;
 };
 
 class SceneData
 {
+    friend class GltfLoader;
+    friend class SceneCache;
+
     std::unordered_set<std::wstring> m_TexturePaths;
     std::vector<MaterialData>        m_Materials;
     std::vector<MeshData>            m_Meshes;
-    ObjectData                       m_RootObject;
+    std::vector<ObjectData>          m_Objects;
+    std::vector<uint32_t>            m_ObjectMeshes;
+
+    void ProcessMeshes(const std::filesystem::path &scenePath, const SceneImportOptions &options);
+
+    // Appends a node after its parent, returns its index
+    uint32_t AddObject(uint32_t parent, const DirectX::XMFLOAT4X4 &transform, const std::vector<size_t> &meshes);
+    void     ParseNode(const aiNode *node, uint32_t parent);
+
+    // Mesh i got replaced by meshes [firstMesh[i], firstMesh[i + 1])
+    void RemapMeshes(const std::vector<size_t> &firstMesh);
+    // Needs the mesh bounds, see MeshData::ComputeBounds
+    void ComputeObjectBounds();
 
   public:
     const std::unordered_set<std::wstring> &GetTexturePaths() const noexcept { return m_TexturePaths; }
     const std::vector<MaterialData>        &GetMaterials() const noexcept { return m_Materials; }
     const std::vector<MeshData>            &GetMeshes() const noexcept { return m_Meshes; }
-    const ObjectData                       &GetRoot() const noexcept { return m_RootObject; }
+    const std::vector<ObjectData>          &GetObjects() const noexcept { return m_Objects; }
+    const std::vector<uint32_t>            &GetObjectMeshes() const noexcept { return m_ObjectMeshes; }
 
-    void LoadFromFile(const std::filesystem::path &scenePath);
+    // Goes through the scene cache next to the source file and only
+    // falls back to the importer when the cache is missing or stale
+    void LoadFromFile(const std::filesystem::path &scenePath, const SceneImportOptions &options = {});
+    void ImportFromFile(const std::filesystem::path &scenePath, SceneImporter sceneImporter = SCENE_IMPORTER_ASSIMP);
 
     size_t TextureCount() const noexcept { return m_TexturePaths.size(); }
+
+    // See MeshData::ReleaseGeometry
+    void ReleaseGeometry() noexcept
+    {
+        for (auto &&mesh : m_Meshes)
+            mesh.ReleaseGeometry();
+    }
 };
@@ -10,7 +10,7 @@ ShaderCompiler::ShaderCompiler(std::filesystem::path shaderRoot)
     Assert(m_Utils->CreateDefaultIncludeHandler(m_IncludeHandler.ReleaseAndGetAddressOf()));
 }
 
-PBlob ShaderCompiler::Compile(const wchar_t *filename, const wchar_t *target)
+PBlob ShaderCompiler::Compile(const wchar_t *filename, const wchar_t *target, const std::vector<std::wstring> &defines)
 {
     std::vector<char> contents;
     {
@@ -30,6 +30,11 @@ PBlob ShaderCompiler::Compile(const wchar_t *filename, const wchar_t *target)
     args.push_back(target);
     args.push_back(L"-I");
     args.push_back(m_ShaderRootWStr.c_str());
+    for (auto &&define : defines)
+    {
+        args.push_back(L"-D");
+        args.push_back(define.c_str());
+    }
 
 #ifdef _DEBUG
     args.push_back(DXC_ARG_DEBUG);
@@ -10,10 +10,16 @@ class ShaderCompiler
     PDxcUtils             m_Utils;
     PDxcIncludeHandler    m_IncludeHandler;
 
-    PBlob Compile(const wchar_t *filename, const wchar_t *target);
+    PBlob Compile(const wchar_t *filename, const wchar_t *target, const std::vector<std::wstring> &defines);
 
   public:
     explicit ShaderCompiler(std::filesystem::path shaderRoot);
-    PBlob CompileVS(const wchar_t *filename) { return Compile(filename, L"vs_6_0"); }
-    PBlob CompilePS(const wchar_t *filename) { return Compile(filename, L"ps_6_0"); }
+    PBlob CompileVS(const wchar_t *filename, const std::vector<std::wstring> &defines = {})
+    {
+        return Compile(filename, L"vs_6_0", defines);
+    }
+    PBlob CompilePS(const wchar_t *filename, const std::vector<std::wstring> &defines = {})
+    {
+        return Compile(filename, L"ps_6_0", defines);
+    }
 };
@@ -0,0 +1,168 @@
+#include "StagingUploader.hpp"
+
+namespace
+{
+    // Copies between buffers don't need any, this only keeps the staged data aligned for memcpy
+    constexpr size_t BUFFER_ALIGNMENT = 16;
+} // namespace
+
+StagingUploader::StagingUploader(PDevice device, CommandQueue &copyQueue, size_t chunkSize)
+    : m_Device(std::move(device)),
+      m_Queue(copyQueue),
+      m_ChunkSize(chunkSize)
+{
+}
+
+StagingUploader::~StagingUploader()
+{
+    // The chunks may still be read by submitted copies
+    m_Queue.WaitForFenceValue(m_LastFenceValue);
+}
+
+StagingUploader::Chunk StagingUploader::CreateChunk(size_t size)
+{
+    Chunk chunk;
+    chunk.Size = size;
+
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC   desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    Assert(m_Device->CreateCommittedResource(&heapProperties,
+                                             D3D12_HEAP_FLAG_NONE,
+                                             &desc,
+                                             D3D12_RESOURCE_STATE_GENERIC_READ,
+                                             nullptr,
+                                             IID_PPV_ARGS(&chunk.Buffer)));
+
+    CD3DX12_RANGE readRange(0, 0);
+    Assert(chunk.Buffer->Map(0, &readRange, reinterpret_cast<void **>(&chunk.CpuAddress)));
+    ++m_Stats.CreatedChunks;
+    return chunk;
+}
+
+StagingUploader::Allocation StagingUploader::Allocate(size_t size, size_t alignment)
+{
+    size_t offset = Math::AlignUp(m_Current.Used, alignment);
+    if (!m_Current.Buffer || offset + size > m_Current.Size)
+    {
+        // The copies out of the full chunk have to be submitted before it can be reused
+        if (m_Current.Buffer)
+            Submit();
+        offset = 0;
+
+        if (size > m_ChunkSize)
+        {
+            m_Current = CreateChunk(Math::AlignUp(size, alignment));
+        }
+        else
+        {
+            // The oldest submission is waited for once the pool is full, chunks of large uploads are dropped
+            while (!m_Submitted.empty() && !m_Current.Buffer)
+            {
+                Chunk &oldest = m_Submitted.front();
+                if (!m_Queue.IsFenceComplete(oldest.FenceValue) && m_ChunkCount < MAX_CHUNK_COUNT)
+                    break;
+                m_Queue.WaitForFenceValue(oldest.FenceValue);
+                if (oldest.Size == m_ChunkSize)
+                    m_Current = std::move(oldest);
+                m_Submitted.pop_front();
+            }
+            if (!m_Current.Buffer)
+            {
+                m_Current = CreateChunk(m_ChunkSize);
+                ++m_ChunkCount;
+            }
+        }
+    }
+
+    m_Current.Used = offset + size;
+    return {m_Current.Buffer.Get(), m_Current.CpuAddress + offset, offset};
+}
+
+void StagingUploader::BeginCopy()
+{
+    if (!m_CommandList)
+        m_CommandList = m_Queue.ResetCommandList();
+    if (!m_Uploading)
+    {
+        m_FirstUpload = std::chrono::high_resolution_clock::now();
+        m_Uploading   = true;
+    }
+}
+
+void StagingUploader::UploadBuffer(ID3D12Resource *destination, const void *data, size_t size, UINT64 destinationOffset)
+{
+    if (size == 0)
+        return;
+
+    Allocation allocation = Allocate(size, BUFFER_ALIGNMENT);
+    BeginCopy();
+    std::memcpy(allocation.CpuAddress, data, size);
+    m_CommandList->CopyBufferRegion(destination, destinationOffset, allocation.Buffer, allocation.Offset, size);
+
+    m_Stats.Bytes += size;
+    ++m_Stats.Copies;
+}
+
+void StagingUploader::UploadTexture(ID3D12Resource               *destination,
+                                    const D3D12_SUBRESOURCE_DATA *subresources,
+                                    UINT                          firstSubresource,
+                                    UINT                          subresourceCount)
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+    std::vector<UINT>                               rowCounts(subresourceCount);
+    std::vector<UINT64>                             rowSizes(subresourceCount);
+    UINT64                                          totalSize = 0;
+
+    D3D12_RESOURCE_DESC desc = destination->GetDesc();
+    m_Device->GetCopyableFootprints(
+        &desc, firstSubresource, subresourceCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(), &totalSize);
+
+    Allocation allocation = Allocate(static_cast<size_t>(totalSize), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    BeginCopy();
+    for (UINT i = 0; i < subresourceCount; ++i)
+    {
+        D3D12_MEMCPY_DEST copyDest = {allocation.CpuAddress + layouts[i].Offset,
+                                      layouts[i].Footprint.RowPitch,
+                                      SIZE_T(layouts[i].Footprint.RowPitch) * rowCounts[i]};
+        MemcpySubresource(
+            &copyDest, &subresources[i], static_cast<SIZE_T>(rowSizes[i]), rowCounts[i], layouts[i].Footprint.Depth);
+
+        layouts[i].Offset += allocation.Offset;
+        CD3DX12_TEXTURE_COPY_LOCATION source(allocation.Buffer, layouts[i]);
+        CD3DX12_TEXTURE_COPY_LOCATION target(destination, firstSubresource + i);
+        m_CommandList->CopyTextureRegion(&target, 0, 0, 0, &source, nullptr);
+    }
+
+    m_Stats.Bytes += static_cast<size_t>(totalSize);
+    m_Stats.Copies += subresourceCount;
+}
+
+UINT64 StagingUploader::Submit()
+{
+    if (m_CommandList)
+    {
+        m_LastFenceValue = m_Queue.ExecuteCommandList(m_CommandList);
+        m_CommandList    = nullptr;
+        ++m_Stats.Submits;
+    }
+
+    // The chunk is handed back even without copies, it is reused without waiting then
+    if (m_Current.Buffer)
+    {
+        m_Current.FenceValue = m_LastFenceValue;
+        m_Submitted.push_back(std::move(m_Current));
+        m_Current = {};
+    }
+    return m_LastFenceValue;
+}
+
+void StagingUploader::Finish()
+{
+    m_Queue.WaitForFenceValue(Submit());
+    if (m_Uploading)
+    {
+        auto now = std::chrono::high_resolution_clock::now();
+        m_Stats.Milliseconds += std::chrono::duration<double, std::milli>(now - m_FirstUpload).count();
+        m_Uploading = false;
+    }
+}
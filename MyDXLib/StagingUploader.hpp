@@ -0,0 +1,84 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "CommandQueue.hpp"
+
+struct UploadStats
+{
+    size_t Bytes         = 0;
+    size_t Copies        = 0;
+    size_t Submits       = 0;
+    size_t CreatedChunks = 0;
+    double Milliseconds  = 0.0; // From the first upload after Finish until the copies completed
+
+    double MegabytesPerSecond() const noexcept
+    {
+        return Milliseconds == 0.0 ? 0.0 : Bytes / (1024.0 * 1024.0) / (Milliseconds / 1000.0);
+    }
+};
+
+// Stages buffer and texture data in a few large, persistently mapped upload buffers and records the copies into one
+// command list of the copy queue. A full chunk submits the copies recorded so far, chunks are reused once the fence
+// value of their submission completed. Uploads larger than a chunk get a chunk of their own, which isn't kept.
+class StagingUploader
+{
+    struct Chunk
+    {
+        PResource Buffer;
+        uint8_t  *CpuAddress = nullptr;
+        size_t    Size       = 0;
+        size_t    Used       = 0;
+        UINT64    FenceValue = 0;
+    };
+
+    struct Allocation
+    {
+        ID3D12Resource *Buffer;
+        uint8_t        *CpuAddress;
+        size_t          Offset;
+    };
+
+    PDevice       m_Device;
+    CommandQueue &m_Queue;
+    size_t        m_ChunkSize;
+
+    Chunk                m_Current;
+    std::deque<Chunk>    m_Submitted; // Oldest first
+    size_t               m_ChunkCount = 0;
+    PGraphicsCommandList m_CommandList;
+    UINT64               m_LastFenceValue = 0;
+
+    UploadStats                                    m_Stats;
+    std::chrono::high_resolution_clock::time_point m_FirstUpload;
+    bool                                           m_Uploading = false;
+
+    Chunk      CreateChunk(size_t size);
+    Allocation Allocate(size_t size, size_t alignment);
+    void       BeginCopy();
+
+  public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 32 << 20;
+    // Beyond this many chunks a new one waits for the oldest submission instead of growing the pool
+    static constexpr size_t MAX_CHUNK_COUNT = 4;
+
+    StagingUploader(PDevice device, CommandQueue &copyQueue, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~StagingUploader();
+
+    StagingUploader(const StagingUploader &)            = delete;
+    StagingUploader &operator=(const StagingUploader &) = delete;
+
+    // The destinations have to be in the common state, or in the copy destination state for textures
+    void UploadBuffer(ID3D12Resource *destination, const void *data, size_t size, UINT64 destinationOffset = 0);
+    void UploadTexture(ID3D12Resource               *destination,
+                       const D3D12_SUBRESOURCE_DATA *subresources,
+                       UINT                          firstSubresource,
+                       UINT                          subresourceCount);
+
+    // Submits the recorded copies and returns the fence value that signals their completion
+    UINT64 Submit();
+    // Submits and waits for all copies, the destinations can be used on any queue afterwards
+    void Finish();
+
+    const UploadStats &GetStats() const noexcept { return m_Stats; }
+};
@@ -0,0 +1,110 @@
+#include "ThreadPool.hpp"
+
+static thread_local bool t_InsideTask = false;
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    size_t workerCount = threadCount > 1 ? threadCount - 1 : 0;
+    m_Workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WakeUp.notify_all();
+    for (auto &worker : m_Workers)
+        worker.join();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock lock(m_Mutex);
+            m_WakeUp.wait(lock, [&] { return m_Stop || m_Generation != seenGeneration; });
+            if (m_Stop)
+                return;
+            seenGeneration = m_Generation;
+        }
+
+        RunTasks();
+
+        {
+            std::lock_guard lock(m_Mutex);
+            --m_ActiveWorkers;
+        }
+        m_Done.notify_one();
+    }
+}
+
+void ThreadPool::RunTasks()
+{
+    t_InsideTask = true;
+    for (size_t i = m_NextIndex++; i < m_TaskCount; i = m_NextIndex++)
+    {
+        try
+        {
+            (*m_Task)(i);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_Mutex);
+            if (!m_Error)
+                m_Error = std::current_exception();
+            // Skip the remaining work, the call is going to fail anyway
+            m_NextIndex = m_TaskCount;
+        }
+    }
+    t_InsideTask = false;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &task)
+{
+    if (count == 0)
+        return;
+
+    if (t_InsideTask || m_Workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    std::lock_guard callLock(m_CallMutex);
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Task          = &task;
+        m_TaskCount     = count;
+        m_NextIndex     = 0;
+        m_ActiveWorkers = m_Workers.size();
+        m_Error         = nullptr;
+        ++m_Generation;
+    }
+    m_WakeUp.notify_all();
+
+    RunTasks();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Done.wait(lock, [&] { return m_ActiveWorkers == 0; });
+        m_Task      = nullptr;
+        m_TaskCount = 0;
+        error       = std::exchange(m_Error, nullptr);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+ThreadPool &ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+class ThreadPool
+{
+    std::vector<std::thread> m_Workers;
+
+    std::mutex              m_CallMutex;
+    std::mutex              m_Mutex;
+    std::condition_variable m_WakeUp;
+    std::condition_variable m_Done;
+
+    const std::function<void(size_t)> *m_Task          = nullptr;
+    size_t                             m_TaskCount     = 0;
+    std::atomic<size_t>                m_NextIndex     = 0;
+    size_t                             m_ActiveWorkers = 0;
+    uint64_t                           m_Generation    = 0;
+    bool                               m_Stop          = false;
+    std::exception_ptr                 m_Error;
+
+    void WorkerLoop();
+    void RunTasks();
+
+  public:
+    // The calling thread takes part in ParallelFor, so threadCount - 1 workers are spawned
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t ThreadCount() const noexcept { return m_Workers.size() + 1; }
+
+    // Calls task(i) for every i in [0, count) and blocks until all calls return.
+    // The first exception thrown by a task is rethrown on the calling thread.
+    // Nested calls from inside a task run serially on that task's thread.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &task);
+
+    static ThreadPool &Shared();
+};
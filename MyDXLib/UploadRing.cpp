@@ -0,0 +1,75 @@
+#include "UploadRing.hpp"
+
+size_t RingAllocator::Allocate(size_t size, size_t alignment)
+{
+    if (size > m_Capacity || m_Capacity % alignment != 0)
+        return INVALID_OFFSET;
+
+    // An empty ring starts over at offset 0, so that everything up to the capacity fits
+    if (m_Head == m_Tail && m_Head % m_Capacity != 0)
+        m_Head = m_Tail = m_Head - m_Head % m_Capacity + m_Capacity;
+
+    uint64_t start  = Math::AlignUp(static_cast<size_t>(m_Head % m_Capacity), alignment);
+    uint64_t offset = m_Head - m_Head % m_Capacity + start;
+    if (start + size > m_Capacity)
+        offset = m_Head - m_Head % m_Capacity + m_Capacity;
+    if (offset + size - m_Tail > m_Capacity)
+        return INVALID_OFFSET;
+
+    m_Head = offset + size;
+    return static_cast<size_t>(offset % m_Capacity);
+}
+
+void RingAllocator::EndFrame(UINT64 fenceValue)
+{
+    m_Frames.push_back({fenceValue, m_Head});
+}
+
+void RingAllocator::Retire(UINT64 completedFenceValue)
+{
+    while (!m_Frames.empty() && m_Frames.front().FenceValue <= completedFenceValue)
+    {
+        // Frames ended before a start over end before the tail
+        m_Tail = std::max(m_Tail, m_Frames.front().Head);
+        m_Frames.pop_front();
+    }
+}
+
+UploadRing::UploadRing(PDevice device, size_t capacity)
+    : m_Allocator(capacity)
+{
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC   desc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+    Assert(device->CreateCommittedResource(&heapProperties,
+                                           D3D12_HEAP_FLAG_NONE,
+                                           &desc,
+                                           D3D12_RESOURCE_STATE_GENERIC_READ,
+                                           nullptr,
+                                           IID_PPV_ARGS(&m_Buffer)));
+
+    // Upload heaps may stay mapped for their whole lifetime, the CPU never reads them
+    CD3DX12_RANGE readRange(0, 0);
+    Assert(m_Buffer->Map(0, &readRange, reinterpret_cast<void **>(&m_CpuAddress)));
+    m_GpuAddress = m_Buffer->GetGPUVirtualAddress();
+}
+
+UploadRing::UploadRing(size_t capacity)
+    : m_Allocator(capacity),
+      m_CpuMemory(std::make_unique<uint8_t[]>(capacity)),
+      m_CpuAddress(m_CpuMemory.get())
+{
+}
+
+UploadRing::~UploadRing()
+{
+    if (m_Buffer)
+        m_Buffer->Unmap(0, nullptr);
+}
+
+UploadAllocation UploadRing::Allocate(size_t size, size_t alignment)
+{
+    size_t offset = m_Allocator.Allocate(size, alignment);
+    if (offset == RingAllocator::INVALID_OFFSET)
+        throw std::exception("Upload ring is full");
+    return {m_CpuAddress + offset, m_GpuAddress + offset};
+}
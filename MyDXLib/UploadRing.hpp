@@ -0,0 +1,82 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "Utils.hpp"
+
+// Offsets of a linear allocator running around a ring of capacity bytes. Allocations are grouped into frames,
+// tagged with a fence value by EndFrame. Retire frees the frames whose fence value completed, oldest first.
+// An allocation never wraps, the rest of the ring is skipped when it doesn't fit before the end.
+class RingAllocator
+{
+    size_t m_Capacity;
+    // Running totals of allocated and freed bytes, the offset into the ring is the total modulo the capacity
+    uint64_t m_Head = 0;
+    uint64_t m_Tail = 0;
+
+    struct FrameEntry
+    {
+        UINT64   FenceValue;
+        uint64_t Head; // m_Head at the end of the frame
+    };
+    std::deque<FrameEntry> m_Frames;
+
+  public:
+    static constexpr size_t INVALID_OFFSET = SIZE_MAX;
+
+    // Alignments passed to Allocate have to divide the capacity
+    explicit RingAllocator(size_t capacity) : m_Capacity(capacity) {}
+
+    // INVALID_OFFSET when the ring doesn't have size bytes free
+    size_t Allocate(size_t size, size_t alignment);
+
+    void EndFrame(UINT64 fenceValue);
+    void Retire(UINT64 completedFenceValue);
+
+    size_t GetCapacity() const noexcept { return m_Capacity; }
+    size_t GetUsedSize() const noexcept { return static_cast<size_t>(m_Head - m_Tail); }
+};
+
+struct UploadAllocation
+{
+    void                     *CpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+};
+
+// Ring allocator over a persistently mapped upload buffer, for data written by the CPU every frame
+class UploadRing
+{
+    RingAllocator              m_Allocator;
+    PResource                  m_Buffer;
+    std::unique_ptr<uint8_t[]> m_CpuMemory; // Instead of m_Buffer without a device
+    uint8_t                   *m_CpuAddress = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS  m_GpuAddress = 0;
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 4 << 20;
+
+    explicit UploadRing(PDevice device, size_t capacity = DEFAULT_CAPACITY);
+    // Backed by CPU memory, the GPU addresses are offsets into the ring. For the tests and benches without a device.
+    explicit UploadRing(size_t capacity);
+    ~UploadRing();
+
+    UploadRing(const UploadRing &)            = delete;
+    UploadRing &operator=(const UploadRing &) = delete;
+
+    // Throws when the frames in flight use up the ring
+    UploadAllocation Allocate(size_t size, size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+    // Copies the value into a constant buffer allocation and returns its GPU address
+    template <class T> D3D12_GPU_VIRTUAL_ADDRESS PushConstants(const T &value)
+    {
+        UploadAllocation allocation = Allocate(sizeof(T));
+        std::memcpy(allocation.CpuAddress, &value, sizeof(T));
+        return allocation.GpuAddress;
+    }
+
+    // The allocations since the last EndFrame may be overwritten once the fence reaches fenceValue
+    void EndFrame(UINT64 fenceValue) { m_Allocator.EndFrame(fenceValue); }
+    void Retire(UINT64 completedFenceValue) { m_Allocator.Retire(completedFenceValue); }
+
+    size_t GetUsedSize() const noexcept { return m_Allocator.GetUsedSize(); }
+};
@@ -31,5 +31,3 @@ inline constexpr size_t INTERMEDIATE_RTV_COUNT = 1;
 inline constexpr size_t BACK_BUFFER_START      = 0;
 inline constexpr size_t INTERMEDIATE_RTV_START = BACK_BUFFER_START + BACK_BUFFER_COUNT;
 inline constexpr size_t RTV_COUNT              = INTERMEDIATE_RTV_START + INTERMEDIATE_RTV_COUNT;
-
-PResource QueryUploadBuffer(PDevice device, ResourceUploadBatch &rub, const void *data, size_t bufSize);
@@ -0,0 +1,249 @@
+#include "VertexCodec.hpp"
+
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+
+namespace
+{
+    float SignNotZero(float v) noexcept { return v >= 0.0f ? 1.0f : -1.0f; }
+
+    float Clamp(float v, float lo, float hi) noexcept { return (std::min)((std::max)(v, lo), hi); }
+
+    XMFLOAT3 Normalize(const XMFLOAT3 &v) noexcept
+    {
+        float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        if (length == 0.0f)
+            return XMFLOAT3(0.0f, 0.0f, 1.0f);
+        return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    uint32_t ToUnorm(float v, uint32_t maxValue) noexcept
+    {
+        return static_cast<uint32_t>(std::lround(Clamp(v, 0.0f, 1.0f) * maxValue));
+    }
+
+    template <typename V> void EncodeVertex(const VertexData &in, const MeshData &mesh, V &out) noexcept
+    {
+        if constexpr (std::is_same_v<V, QuantizedVertexData>)
+            VertexCodec::QuantizePosition(in.pos, mesh.m_BoundsMin, mesh.m_BoundsMax, out.pos);
+        else
+            out.pos = in.pos;
+
+        float sign = Dot(Cross(in.normal, in.tangent), in.bitangent) < 0.0f ? -1.0f : 1.0f;
+        VertexCodec::PackNormal(in.normal, out.normal);
+        out.tangent = VertexCodec::PackTangent(in.tangent, sign);
+        VertexCodec::PackUV(in.uv, out.uv);
+    }
+
+    template <typename V> std::vector<char> EncodeVertices(const MeshData &mesh)
+    {
+        auto              source = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        std::vector<char> result(mesh.VertexCount() * sizeof(V));
+        auto              target = reinterpret_cast<V *>(result.data());
+        for (size_t i = 0; i < mesh.VertexCount(); ++i)
+            EncodeVertex(source[i], mesh, target[i]);
+        return result;
+    }
+} // namespace
+
+XMFLOAT2 VertexCodec::OctEncode(const XMFLOAT3 &v) noexcept
+{
+    float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1 == 0.0f)
+        return XMFLOAT2(0.0f, 0.0f);
+
+    float x = v.x / l1;
+    float y = v.y / l1;
+    if (v.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+        float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+        x             = foldedX;
+        y             = foldedY;
+    }
+    return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 VertexCodec::OctDecode(const XMFLOAT2 &e) noexcept
+{
+    XMFLOAT3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float    t = (std::max)(-v.z, 0.0f);
+    v.x -= SignNotZero(v.x) * t;
+    v.y -= SignNotZero(v.y) * t;
+    return Normalize(v);
+}
+
+void VertexCodec::PackNormal(const XMFLOAT3 &normal, int16_t out[2]) noexcept
+{
+    XMFLOAT2 e = OctEncode(normal);
+    out[0]     = static_cast<int16_t>(std::lround(Clamp(e.x, -1.0f, 1.0f) * 32767.0f));
+    out[1]     = static_cast<int16_t>(std::lround(Clamp(e.y, -1.0f, 1.0f) * 32767.0f));
+}
+
+XMFLOAT3 VertexCodec::UnpackNormal(const int16_t in[2]) noexcept
+{
+    // Same as the SNORM conversion, where -32768 and -32767 both map to -1
+    return OctDecode(XMFLOAT2((std::max)(in[0] / 32767.0f, -1.0f), (std::max)(in[1] / 32767.0f, -1.0f)));
+}
+
+uint32_t VertexCodec::PackTangent(const XMFLOAT3 &tangent, float bitangentSign) noexcept
+{
+    XMFLOAT2 e = OctEncode(tangent);
+    uint32_t x = ToUnorm(e.x * 0.5f + 0.5f, 1023);
+    uint32_t y = ToUnorm(e.y * 0.5f + 0.5f, 1023);
+    uint32_t w = bitangentSign < 0.0f ? 0 : 3;
+    return x | y << 10 | w << 30;
+}
+
+XMFLOAT3 VertexCodec::UnpackTangent(uint32_t packed, float &bitangentSign) noexcept
+{
+    float x       = (packed & 1023) / 1023.0f;
+    float y       = (packed >> 10 & 1023) / 1023.0f;
+    bitangentSign = (packed >> 30) != 0 ? 1.0f : -1.0f;
+    return OctDecode(XMFLOAT2(x * 2.0f - 1.0f, y * 2.0f - 1.0f));
+}
+
+void VertexCodec::PackUV(const XMFLOAT2 &uv, uint16_t out[2]) noexcept
+{
+    out[0] = PackedVector::XMConvertFloatToHalf(uv.x);
+    out[1] = PackedVector::XMConvertFloatToHalf(uv.y);
+}
+
+XMFLOAT2 VertexCodec::UnpackUV(const uint16_t in[2]) noexcept
+{
+    return XMFLOAT2(PackedVector::XMConvertHalfToFloat(in[0]), PackedVector::XMConvertHalfToFloat(in[1]));
+}
+
+void VertexCodec::QuantizePosition(const XMFLOAT3 &pos,
+                                   const XMFLOAT3 &boundsMin,
+                                   const XMFLOAT3 &boundsMax,
+                                   uint16_t        out[4]) noexcept
+{
+    auto quantize = [](float v, float lo, float hi) {
+        return static_cast<uint16_t>(hi > lo ? ToUnorm((v - lo) / (hi - lo), 65535) : 0);
+    };
+    out[0] = quantize(pos.x, boundsMin.x, boundsMax.x);
+    out[1] = quantize(pos.y, boundsMin.y, boundsMax.y);
+    out[2] = quantize(pos.z, boundsMin.z, boundsMax.z);
+    out[3] = 0;
+}
+
+XMFLOAT3 VertexCodec::DequantizePosition(const uint16_t  in[4],
+                                         const XMFLOAT3 &boundsMin,
+                                         const XMFLOAT3 &boundsMax) noexcept
+{
+    return XMFLOAT3(boundsMin.x + in[0] / 65535.0f * (boundsMax.x - boundsMin.x),
+                    boundsMin.y + in[1] / 65535.0f * (boundsMax.y - boundsMin.y),
+                    boundsMin.z + in[2] / 65535.0f * (boundsMax.z - boundsMin.z));
+}
+
+size_t VertexCodec::VertexSize(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FORMAT_FULL: return sizeof(VertexData);
+    case VERTEX_FORMAT_COMPACT: return sizeof(CompactVertexData);
+    case VERTEX_FORMAT_QUANTIZED: return sizeof(QuantizedVertexData);
+    default: throw std::exception("Unknown vertex format");
+    }
+}
+
+void VertexCodec::Encode(MeshData &mesh, VertexFormat format)
+{
+    if (mesh.m_VertexFormat != VERTEX_FORMAT_FULL || mesh.SingleVertexSize() != sizeof(VertexData))
+        throw std::exception("Only VertexData meshes can be re-encoded");
+
+    switch (format)
+    {
+    case VERTEX_FORMAT_FULL: return;
+    case VERTEX_FORMAT_COMPACT:
+        mesh.ReplaceVertices(EncodeVertices<CompactVertexData>(mesh), mesh.VertexCount(), sizeof(CompactVertexData));
+        break;
+    case VERTEX_FORMAT_QUANTIZED:
+        mesh.ReplaceVertices(
+            EncodeVertices<QuantizedVertexData>(mesh), mesh.VertexCount(), sizeof(QuantizedVertexData));
+        break;
+    default: throw std::exception("Unknown vertex format");
+    }
+    mesh.m_VertexFormat = format;
+}
+
+std::vector<XMFLOAT3> VertexCodec::DecodePositions(const MeshData &mesh)
+{
+    std::vector<XMFLOAT3> positions(mesh.VertexCount());
+    auto                  vertices = static_cast<const char *>(mesh.VertexBufferStart());
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const char *vertex = vertices + i * mesh.SingleVertexSize();
+        switch (mesh.m_VertexFormat)
+        {
+        case VERTEX_FORMAT_FULL: positions[i] = reinterpret_cast<const VertexData *>(vertex)->pos; break;
+        case VERTEX_FORMAT_COMPACT: positions[i] = reinterpret_cast<const CompactVertexData *>(vertex)->pos; break;
+        case VERTEX_FORMAT_QUANTIZED:
+            positions[i] = DequantizePosition(
+                reinterpret_cast<const QuantizedVertexData *>(vertex)->pos, mesh.m_BoundsMin, mesh.m_BoundsMax);
+            break;
+        default: throw std::exception("Unknown vertex format");
+        }
+    }
+    return positions;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> VertexCodec::InputLayout(VertexFormat format)
+{
+    auto element = [](const char *semantic, DXGI_FORMAT elementFormat) {
+        return D3D12_INPUT_ELEMENT_DESC{semantic,
+                                        0,
+                                        elementFormat,
+                                        0,
+                                        D3D12_APPEND_ALIGNED_ELEMENT,
+                                        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                        0};
+    };
+
+    switch (format)
+    {
+    case VERTEX_FORMAT_FULL:
+        return {
+            element("POSITION", DXGI_FORMAT_R32G32B32_FLOAT),
+            element("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT),
+            element("TANGENT", DXGI_FORMAT_R32G32B32_FLOAT),
+            element("BITANGENT", DXGI_FORMAT_R32G32B32_FLOAT),
+            element("UV", DXGI_FORMAT_R32G32_FLOAT),
+        };
+    case VERTEX_FORMAT_COMPACT:
+        return {
+            element("POSITION", DXGI_FORMAT_R32G32B32_FLOAT),
+            element("NORMAL", DXGI_FORMAT_R16G16_SNORM),
+            element("TANGENT", DXGI_FORMAT_R10G10B10A2_UNORM),
+            element("UV", DXGI_FORMAT_R16G16_FLOAT),
+        };
+    case VERTEX_FORMAT_QUANTIZED:
+        return {
+            element("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM),
+            element("NORMAL", DXGI_FORMAT_R16G16_SNORM),
+            element("TANGENT", DXGI_FORMAT_R10G10B10A2_UNORM),
+            element("UV", DXGI_FORMAT_R16G16_FLOAT),
+        };
+    default: throw std::exception("Unknown vertex format");
+    }
+}
+
+std::vector<std::wstring> VertexCodec::ShaderDefines(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FORMAT_FULL: return {};
+    case VERTEX_FORMAT_COMPACT: return {L"COMPACT_VERTEX"};
+    case VERTEX_FORMAT_QUANTIZED: return {L"COMPACT_VERTEX", L"QUANTIZED_POSITION"};
+    default: throw std::exception("Unknown vertex format");
+    }
+}
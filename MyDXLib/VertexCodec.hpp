@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pch.hpp"
+
+#include "SceneData.hpp"
+
+// 24 bytes instead of 56: the bitangent is rebuilt in the shader as cross(normal, tangent) * sign
+struct CompactVertexData
+{
+    DirectX::XMFLOAT3 pos;       // R32G32B32_FLOAT
+    int16_t           normal[2]; // R16G16_SNORM, octahedral
+    uint32_t          tangent;   // R10G10B10A2_UNORM, octahedral xy, bitangent sign in a
+    uint16_t          uv[2];     // R16G16_FLOAT
+};
+
+// 20 bytes, position is normalized to the mesh bounds
+struct QuantizedVertexData
+{
+    uint16_t pos[4];    // R16G16B16A16_UNORM, w is unused
+    int16_t  normal[2]; // R16G16_SNORM, octahedral
+    uint32_t tangent;   // R10G10B10A2_UNORM, octahedral xy, bitangent sign in a
+    uint16_t uv[2];     // R16G16_FLOAT
+};
+
+static_assert(sizeof(CompactVertexData) == 24);
+static_assert(sizeof(QuantizedVertexData) == 20);
+
+// Encoding of the vertex formats on the CPU side. The decode functions mirror
+// DecodeVertex in VertexSponza.hlsl and are what the input layout expands to.
+class VertexCodec
+{
+  public:
+    VertexCodec() = delete;
+
+    // Maps a unit vector onto the [-1, 1] square and back
+    static DirectX::XMFLOAT2 OctEncode(const DirectX::XMFLOAT3 &v) noexcept;
+    static DirectX::XMFLOAT3 OctDecode(const DirectX::XMFLOAT2 &e) noexcept;
+
+    static void              PackNormal(const DirectX::XMFLOAT3 &normal, int16_t out[2]) noexcept;
+    static DirectX::XMFLOAT3 UnpackNormal(const int16_t in[2]) noexcept;
+
+    static uint32_t          PackTangent(const DirectX::XMFLOAT3 &tangent, float bitangentSign) noexcept;
+    static DirectX::XMFLOAT3 UnpackTangent(uint32_t packed, float &bitangentSign) noexcept;
+
+    static void              PackUV(const DirectX::XMFLOAT2 &uv, uint16_t out[2]) noexcept;
+    static DirectX::XMFLOAT2 UnpackUV(const uint16_t in[2]) noexcept;
+
+    static void              QuantizePosition(const DirectX::XMFLOAT3 &pos,
+                                              const DirectX::XMFLOAT3 &boundsMin,
+                                              const DirectX::XMFLOAT3 &boundsMax,
+                                              uint16_t                 out[4]) noexcept;
+    static DirectX::XMFLOAT3 DequantizePosition(const uint16_t           in[4],
+                                                const DirectX::XMFLOAT3 &boundsMin,
+                                                const DirectX::XMFLOAT3 &boundsMax) noexcept;
+
+    static size_t VertexSize(VertexFormat format);
+
+    // Re-encodes a mesh holding VertexData, m_BoundsMin/m_BoundsMax have to be computed beforehand
+    static void Encode(MeshData &mesh, VertexFormat format);
+    // Object space positions of any vertex format
+    static std::vector<DirectX::XMFLOAT3> DecodePositions(const MeshData &mesh);
+
+    // Input layout and VertexSponza.hlsl defines that go with the format
+    static std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout(VertexFormat format);
+    static std::vector<std::wstring>             ShaderDefines(VertexFormat format);
+};
@@ -1,8 +1,16 @@
 #include "RootSignatureSponza.inc"
 
-Texture2D BaseColorTexture : register(t0);
+// Either the whole descriptor heap or a table starting at the texture of the material, see Scene::Record
+Texture2D Textures[] : register(t0);
 SamplerState DefaultSampler : register(s0);
 
+struct MaterialConstants
+{
+    uint BaseColor;
+};
+
+ConstantBuffer<MaterialConstants> MaterialCB : register(b3);
+
 struct VertexShaderOutput
 {
     float4 ScreenPos : SV_Position;
@@ -26,6 +34,7 @@ float4 main(VertexShaderOutput IN) : SV_Target
     
     float3 ambient = float3(0.25f, 0.25f, 0.25f);
     float3 lighting = ambient + diffuse;
+    Texture2D BaseColorTexture = Textures[MaterialCB.BaseColor];
     float4 base = BaseColorTexture.Sample(DefaultSampler, IN.uv);
     /*
     if ((int(IN.ScreenPos.x) + int(IN.ScreenPos.y)) % 2 == 0)
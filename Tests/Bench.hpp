@@ -0,0 +1,23 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Milliseconds per call of work, after a warm up call, over as many calls as fit in about half a second
+template <typename Work> double MeasureMs(Work &&work)
+{
+    using Clock = std::chrono::steady_clock;
+
+    work();
+
+    size_t            runs  = 0;
+    Clock::time_point start = Clock::now();
+    Clock::duration   elapsed;
+    do
+    {
+        work();
+        ++runs;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+
+    return std::chrono::duration<double, std::milli>(elapsed).count() / runs;
+}
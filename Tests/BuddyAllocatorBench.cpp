@@ -0,0 +1,89 @@
+#include "Bench.hpp"
+
+#include "MyDXLib/HeapAllocator.hpp"
+
+namespace
+{
+    constexpr size_t MIN_BLOCK = 64 << 10; // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+    constexpr size_t BATCH     = 1 << 20;
+
+    struct Allocation
+    {
+        size_t Offset;
+        size_t Size;
+    };
+
+    // Allocations and frees in random order, three allocations to a free below the target fill and frees above it.
+    // Sizes are log-uniform between half the minimum block and maxSize, like the vertex and index buffers of a scene.
+    void Run(size_t capacity, size_t maxSize, double fill)
+    {
+        BuddyAllocator          buddy(capacity, MIN_BLOCK);
+        std::vector<Allocation> live;
+        std::mt19937            random(3);
+
+        // Random numbers are drawn up front, the batches only time the allocator
+        std::vector<size_t>                    sizes(BATCH);
+        std::vector<uint32_t>                  picks(BATCH);
+        std::uniform_real_distribution<double> logSize(std::log2(double(MIN_BLOCK / 2)), std::log2(double(maxSize)));
+        for (size_t i = 0; i < BATCH; ++i)
+        {
+            sizes[i] = static_cast<size_t>(std::exp2(logSize(random)));
+            picks[i] = static_cast<uint32_t>(random());
+        }
+
+        size_t operations = 0;
+        size_t failures   = 0;
+        double fillSum    = 0.0;
+        double fragSum    = 0.0;
+        size_t samples    = 0;
+        double ms         = MeasureMs([&] {
+            for (size_t i = 0; i < BATCH; ++i)
+            {
+                bool full = buddy.GetAllocatedSize() > fill * capacity;
+                if (!live.empty() && (full || picks[i] % 4 == 0))
+                {
+                    size_t pick = picks[i] % live.size();
+                    buddy.Free(live[pick].Offset, live[pick].Size);
+                    live[pick] = live.back();
+                    live.pop_back();
+                }
+                else
+                {
+                    size_t offset = buddy.Allocate(sizes[i]);
+                    if (offset == BuddyAllocator::INVALID_OFFSET)
+                        ++failures;
+                    else
+                        live.push_back({offset, sizes[i]});
+                }
+            }
+            operations += BATCH;
+
+            HeapStats stats;
+            stats.HeapSize         = capacity;
+            stats.AllocatedSize    = buddy.GetAllocatedSize();
+            stats.LargestFreeBlock = buddy.GetLargestFreeBlock();
+            fillSum += static_cast<double>(stats.AllocatedSize) / capacity;
+            fragSum += stats.Fragmentation();
+            ++samples;
+        });
+
+        std::printf("%5zu MB heap %5zu MB max  %9zu ops %7.1f ns/op  %4.1f%% failed  %4.1f%% filled  "
+                    "%4.1f%% fragmented  %4.1f%% rounding\n",
+                    capacity >> 20,
+                    maxSize >> 20,
+                    operations,
+                    1e6 * ms / BATCH,
+                    100.0 * failures / operations,
+                    100.0 * fillSum / samples,
+                    100.0 * fragSum / samples,
+                    100.0 * (1.0 - static_cast<double>(buddy.GetRequestedSize()) / buddy.GetAllocatedSize()));
+    }
+} // namespace
+
+int main()
+{
+    Run(size_t(64) << 20, size_t(4) << 20, 0.7);  // Default HeapAllocator block
+    Run(size_t(1) << 30, size_t(16) << 20, 0.7);  // Large heap
+    Run(size_t(1) << 30, size_t(16) << 20, 0.95); // Nearly full
+    return 0;
+}
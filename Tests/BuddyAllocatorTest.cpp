@@ -0,0 +1,188 @@
+#include "Check.hpp"
+
+#include "MyDXLib/HeapAllocator.hpp"
+
+namespace
+{
+    constexpr size_t INVALID = BuddyAllocator::INVALID_OFFSET;
+
+    void TestConstruction()
+    {
+        CHECK_THROWS(BuddyAllocator(0, 64));
+        CHECK_THROWS(BuddyAllocator(1024, 0));
+        CHECK_THROWS(BuddyAllocator(1000, 64));
+        CHECK_THROWS(BuddyAllocator(3 * 64, 64));
+        CHECK_THROWS(BuddyAllocator(96 * 4, 96));
+
+        BuddyAllocator single(64, 64);
+        CHECK(single.GetCapacity() == 64);
+        CHECK(single.Allocate(64) == 0);
+        CHECK(single.Allocate(1) == INVALID);
+    }
+
+    void TestSplitAndMerge()
+    {
+        BuddyAllocator buddy(1024, 64);
+        CHECK(buddy.GetLargestFreeBlock() == 1024);
+
+        // Every split leaves the upper half free, smaller blocks fill the lowest free one first
+        CHECK(buddy.Allocate(64) == 0);
+        CHECK(buddy.Allocate(100) == 128);
+        CHECK(buddy.Allocate(64) == 64);
+        CHECK(buddy.Allocate(10, 512) == 512);
+        CHECK(buddy.Allocate(0) == INVALID);
+        CHECK(buddy.Allocate(200) == 256);
+        CHECK(buddy.Allocate(1) == INVALID);
+        CHECK(buddy.Allocate(1025) == INVALID);
+        CHECK(buddy.GetAllocationCount() == 5);
+        CHECK(buddy.GetAllocatedSize() == 1024);
+        CHECK(buddy.GetRequestedSize() == 64 + 100 + 64 + 10 + 200);
+        CHECK(buddy.GetLargestFreeBlock() == 0);
+
+        // Buddies merge back up once both are free
+        buddy.Free(0, 64);
+        CHECK(buddy.GetLargestFreeBlock() == 64);
+        buddy.Free(64, 64);
+        CHECK(buddy.GetLargestFreeBlock() == 128);
+        buddy.Free(128, 100);
+        CHECK(buddy.GetLargestFreeBlock() == 256);
+        buddy.Free(256, 200);
+        CHECK(buddy.GetLargestFreeBlock() == 512);
+        buddy.Free(512, 10);
+        CHECK(buddy.GetLargestFreeBlock() == 1024);
+        CHECK(buddy.GetAllocatedSize() == 0 && buddy.GetRequestedSize() == 0 && buddy.GetAllocationCount() == 0);
+        CHECK(buddy.Allocate(1024) == 0);
+    }
+
+    void TestInvalidFrees()
+    {
+        BuddyAllocator buddy(1024, 64);
+        size_t         a = buddy.Allocate(64);
+        CHECK_THROWS(buddy.Free(a + 1, 64));
+        CHECK_THROWS(buddy.Free(1024, 64));
+        CHECK_THROWS(buddy.Free(512, 64)); // Free block
+        CHECK_THROWS(buddy.Free(a, 65));   // Larger than the block
+        buddy.Free(a, 64);
+        CHECK_THROWS(buddy.Free(a, 64));
+        CHECK(buddy.GetLargestFreeBlock() == 1024);
+        CHECK(buddy.GetAllocationCount() == 0);
+    }
+
+    // Only the first minimum block of a block carries its order. Freeing any other minimum block of an allocated
+    // block has to throw instead of reading a stale order, whether it was never written or left by a merge.
+    void TestInteriorFrees()
+    {
+        BuddyAllocator buddy(1024, 64);
+        CHECK(buddy.Allocate(1024) == 0);
+        for (size_t offset = 64; offset < 1024; offset += 64)
+            CHECK_THROWS(buddy.Free(offset, 64));
+        buddy.Free(0, 1024);
+
+        // Leaves orders behind at 64 and 128 when merging, then allocates over them
+        size_t a = buddy.Allocate(64);
+        size_t b = buddy.Allocate(64);
+        size_t c = buddy.Allocate(128);
+        CHECK(a == 0 && b == 64 && c == 128);
+        buddy.Free(b, 64);
+        buddy.Free(c, 128);
+        buddy.Free(a, 64);
+        CHECK(buddy.Allocate(256) == 0);
+        CHECK_THROWS(buddy.Free(64, 64));
+        CHECK_THROWS(buddy.Free(128, 128));
+        CHECK(buddy.GetAllocationCount() == 1);
+        buddy.Free(0, 256);
+        CHECK(buddy.GetLargestFreeBlock() == 1024);
+    }
+
+    // Random allocations and frees against a map of the minimum blocks in use. With eager merging every free
+    // aligned range is covered by one free block, so an allocation may only fail when no aligned range is free.
+    void TestRandomized()
+    {
+        constexpr size_t MIN_BLOCK  = 256;
+        constexpr size_t BLOCKS     = 1024;
+        constexpr size_t OPERATIONS = 200000;
+
+        struct Allocation
+        {
+            size_t Offset;
+            size_t Size;
+            size_t Block; // Size rounded up to the block
+        };
+
+        BuddyAllocator          buddy(BLOCKS * MIN_BLOCK, MIN_BLOCK);
+        std::vector<uint8_t>    used(BLOCKS, 0);
+        std::vector<Allocation> live;
+        std::mt19937            random(5);
+        size_t                  allocatedSize = 0;
+        size_t                  failures      = 0;
+        bool                    valid         = true;
+
+        auto blockSize = [](size_t needed) {
+            size_t block = MIN_BLOCK;
+            while (block < needed)
+                block <<= 1;
+            return block;
+        };
+        auto alignedRangeFree = [&](size_t blocks) {
+            for (size_t first = 0; first < BLOCKS; first += blocks)
+                if (std::all_of(used.begin() + first, used.begin() + first + blocks, [](uint8_t u) { return !u; }))
+                    return true;
+            return false;
+        };
+
+        for (size_t i = 0; i < OPERATIONS; ++i)
+        {
+            // Keeps the heap around half full so that both allocations and frees fail to find space at times
+            if (!live.empty() && random() % 100 < (allocatedSize * 100 / (BLOCKS * MIN_BLOCK) > 50 ? 60 : 40))
+            {
+                size_t     pick       = random() % live.size();
+                Allocation allocation = live[pick];
+                live[pick]            = live.back();
+                live.pop_back();
+                buddy.Free(allocation.Offset, allocation.Size);
+                std::fill_n(used.begin() + allocation.Offset / MIN_BLOCK, allocation.Block / MIN_BLOCK, uint8_t(0));
+                allocatedSize -= allocation.Block;
+                continue;
+            }
+
+            // Sizes spread over orders, mostly small ones like vertex and index buffers
+            size_t size      = 1 + random() % (MIN_BLOCK << (random() % 7));
+            size_t alignment = random() % 4 == 0 ? MIN_BLOCK << (random() % 3) : 1;
+            size_t offset    = buddy.Allocate(size, alignment);
+            size_t block     = blockSize((std::max)(size, alignment));
+            if (offset == INVALID)
+            {
+                valid = valid && !alignedRangeFree(block / MIN_BLOCK);
+                ++failures;
+                continue;
+            }
+
+            valid = valid && offset % block == 0 && offset + block <= BLOCKS * MIN_BLOCK;
+            for (size_t b = offset / MIN_BLOCK; b < (offset + block) / MIN_BLOCK && b < BLOCKS; ++b)
+            {
+                valid   = valid && !used[b];
+                used[b] = 1;
+            }
+            live.push_back({offset, size, block});
+            allocatedSize += block;
+            valid = valid && buddy.GetAllocatedSize() == allocatedSize && buddy.GetAllocationCount() == live.size();
+        }
+
+        CHECK(valid);
+        CHECK(failures > 0 && failures < OPERATIONS / 10);
+        for (auto &&allocation : live)
+            buddy.Free(allocation.Offset, allocation.Size);
+        CHECK(buddy.GetAllocatedSize() == 0 && buddy.GetRequestedSize() == 0);
+        CHECK(buddy.GetLargestFreeBlock() == BLOCKS * MIN_BLOCK);
+    }
+} // namespace
+
+int main()
+{
+    TestConstruction();
+    TestSplitAndMerge();
+    TestInvalidFrees();
+    TestInteriorFrees();
+    TestRandomized();
+    return TestResult();
+}
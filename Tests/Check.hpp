@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Checks for the tests, which build without a test framework outside of Windows. A failed check is reported
+// and the test goes on, main returns TestResult().
+
+inline int g_FailedChecks = 0;
+
+inline void ReportFailure(const char *file, int line, const char *expression)
+{
+    std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+    ++g_FailedChecks;
+}
+
+#define CHECK(condition) ((condition) ? (void)0 : ReportFailure(__FILE__, __LINE__, #condition))
+
+#define CHECK_THROWS(statement)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        bool thrown = false;                                                                                           \
+        try                                                                                                            \
+        {                                                                                                              \
+            statement;                                                                                                 \
+        }                                                                                                              \
+        catch (const std::exception &)                                                                                 \
+        {                                                                                                              \
+            thrown = true;                                                                                             \
+        }                                                                                                              \
+        if (!thrown)                                                                                                   \
+            ReportFailure(__FILE__, __LINE__, "throws " #statement);                                                   \
+    } while (false)
+
+inline int TestResult()
+{
+    if (g_FailedChecks == 0)
+        return 0;
+    std::cerr << g_FailedChecks << " checks failed" << std::endl;
+    return 1;
+}
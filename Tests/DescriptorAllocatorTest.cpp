@@ -0,0 +1,198 @@
+#include "Check.hpp"
+
+#include "MyDXLib/DescriptorAllocator.hpp"
+
+namespace
+{
+    constexpr size_t INVALID = DescriptorRangeAllocator::INVALID_INDEX;
+
+    void TestMergeOnFree()
+    {
+        DescriptorRangeAllocator ranges(16, 8);
+        size_t                   a = ranges.AllocatePersistent(4);
+        size_t                   b = ranges.AllocatePersistent(4);
+        size_t                   c = ranges.AllocatePersistent(4);
+        CHECK(a == 0 && b == 4 && c == 8);
+        CHECK(ranges.GetFreePersistentCount() == 4);
+
+        // Free ranges [4, 8) and [12, 16), nothing fits 8 descriptors
+        ranges.Free(b, 4);
+        CHECK(ranges.GetFreePersistentCount() == 8);
+        CHECK(ranges.AllocatePersistent(8) == INVALID);
+
+        // Merges with the next range into [0, 8)
+        ranges.Free(a, 4);
+        size_t merged = ranges.AllocatePersistent(8);
+        CHECK(merged == 0);
+        ranges.Free(merged, 8);
+
+        // Merges with both neighbours into [0, 16)
+        ranges.Free(c, 4);
+        CHECK(ranges.GetFreePersistentCount() == 16);
+        CHECK(ranges.AllocatePersistent(16) == 0);
+        CHECK(ranges.AllocatePersistent(1) == INVALID);
+
+        // Merges with the previous range, first fit takes the lowest range that is large enough
+        ranges.Free(0, 16);
+        size_t d = ranges.AllocatePersistent(2);
+        size_t e = ranges.AllocatePersistent(6);
+        size_t f = ranges.AllocatePersistent(2);
+        ranges.Free(d, 2);
+        ranges.Free(e, 6);
+        CHECK(ranges.AllocatePersistent(8) == 0);
+        CHECK(ranges.AllocatePersistent(3) == f + 2);
+        CHECK(ranges.AllocatePersistent(0) == INVALID);
+    }
+
+    void TestInvalidFrees()
+    {
+        DescriptorRangeAllocator ranges(16, 8);
+        size_t                   a = ranges.AllocatePersistent(4);
+        size_t                   b = ranges.AllocatePersistent(4);
+
+        ranges.Free(a, 4);
+        CHECK_THROWS(ranges.Free(a, 4));
+        CHECK_THROWS(ranges.Free(a + 2, 1));
+        CHECK_THROWS(ranges.Free(b + 2, 4)); // Runs into the free range after b
+        CHECK_THROWS(ranges.Free(2, 4));     // Starts in the free range before b
+        CHECK(ranges.GetFreePersistentCount() == 12);
+
+        CHECK_THROWS(ranges.Free(15, 2));
+        CHECK_THROWS(ranges.Free(16, 1));
+        CHECK_THROWS(ranges.Free(SIZE_MAX, 2));
+        CHECK_THROWS(ranges.FreeDeferred(20, 1));
+        CHECK(ranges.GetFreePersistentCount() == 12);
+
+        // Nothing to free
+        ranges.Free(b, 0);
+        ranges.Free(100, 0);
+        ranges.Free(b, 4);
+        CHECK(ranges.GetFreePersistentCount() == 16);
+    }
+
+    void TestDeferredFrees()
+    {
+        DescriptorRangeAllocator ranges(16, 8);
+        size_t                   a = ranges.AllocatePersistent(4);
+        size_t                   b = ranges.AllocatePersistent(4);
+
+        ranges.FreeDeferred(a, 4);
+        CHECK(ranges.GetFreePersistentCount() == 8);
+        ranges.EndFrame(1);
+        ranges.FreeDeferred(b, 4);
+        ranges.EndFrame(2);
+
+        ranges.Retire(0);
+        CHECK(ranges.GetFreePersistentCount() == 8);
+        ranges.Retire(1);
+        CHECK(ranges.GetFreePersistentCount() == 12);
+        CHECK(ranges.AllocatePersistent(4) == a);
+        ranges.Retire(2);
+        CHECK(ranges.GetFreePersistentCount() == 12);
+
+        // A frame without frees ends without an entry, later retirements still free in order
+        ranges.EndFrame(3);
+        ranges.FreeDeferred(a, 4);
+        ranges.EndFrame(4);
+        ranges.Retire(4);
+        CHECK(ranges.GetFreePersistentCount() == 16);
+
+        // A range freed twice is only noticed once the second free is retired
+        CHECK(ranges.AllocatePersistent(4) == a);
+        ranges.FreeDeferred(a, 4);
+        ranges.FreeDeferred(a, 4);
+        ranges.EndFrame(5);
+        CHECK_THROWS(ranges.Retire(5));
+    }
+
+    void TestTransientWraparound()
+    {
+        DescriptorRangeAllocator ranges(16, 8);
+        CHECK(ranges.GetCapacity() == 24);
+
+        // The ring follows the persistent indices
+        CHECK(ranges.AllocateTransient(3) == 16);
+        CHECK(ranges.AllocateTransient(3) == 19);
+        ranges.EndFrame(1);
+        CHECK(ranges.GetUsedTransientCount() == 6);
+
+        // Doesn't fit before the end and the start is still in flight
+        CHECK(ranges.AllocateTransient(3) == INVALID);
+        ranges.Retire(1);
+        CHECK(ranges.GetUsedTransientCount() == 0);
+
+        // The empty ring starts over at its beginning
+        CHECK(ranges.AllocateTransient(5) == 16);
+        ranges.EndFrame(2);
+        CHECK(ranges.AllocateTransient(2) == 21);
+        ranges.EndFrame(3);
+        ranges.Retire(2);
+
+        // Skips the last descriptor of the ring, it is in use until the frame is retired
+        CHECK(ranges.AllocateTransient(2) == 16);
+        CHECK(ranges.GetUsedTransientCount() == 5);
+        ranges.EndFrame(4);
+        CHECK(ranges.AllocateTransient(4) == INVALID);
+        CHECK(ranges.AllocateTransient(3) == 18);
+        ranges.Retire(4);
+        CHECK(ranges.GetUsedTransientCount() == 3);
+        ranges.EndFrame(5);
+        ranges.Retire(5);
+        CHECK(ranges.GetUsedTransientCount() == 0);
+
+        CHECK(ranges.AllocateTransient(0) == INVALID);
+        CHECK(ranges.AllocateTransient(9) == INVALID);
+
+        // Transient indices are never freed like persistent ones
+        CHECK_THROWS(ranges.Free(16, 1));
+        CHECK(ranges.GetFreePersistentCount() == 16);
+
+        // Many frames around the ring stay inside of it
+        bool inside = true;
+        for (UINT64 frame = 6; frame < 1000; ++frame)
+        {
+            size_t count = 1 + frame % 5;
+            size_t index = ranges.AllocateTransient(count);
+            inside       = inside && index >= 16 && index + count <= 24;
+            ranges.EndFrame(frame);
+            ranges.Retire(frame - 1);
+        }
+        CHECK(inside);
+    }
+
+    void TestDescriptorAllocator()
+    {
+        DescriptorAllocator descriptors(PDevice(), 4, 4);
+
+        size_t a = descriptors.AllocatePersistent(3);
+        CHECK_THROWS(descriptors.AllocatePersistent(2));
+        size_t transient = descriptors.AllocateTransient(4);
+        CHECK(transient == 4);
+        CHECK_THROWS(descriptors.AllocateTransient());
+
+        // Handles step by the descriptor size from the start of the heap
+        UINT64 step = descriptors.GetGpuHandle(1).ptr - descriptors.GetGpuHandle(0).ptr;
+        CHECK(step != 0);
+        CHECK(descriptors.GetGpuHandle(transient).ptr == descriptors.GetGpuHandle(0).ptr + transient * step);
+        CHECK(descriptors.GetCpuHandle(transient).ptr == descriptors.GetCpuHandle(0).ptr + transient * step);
+
+        // Freeing is deferred to the retirement of the frame
+        descriptors.Free(a, 3);
+        CHECK(descriptors.GetRanges().GetFreePersistentCount() == 1);
+        descriptors.EndFrame(1);
+        descriptors.Retire(1);
+        CHECK(descriptors.GetRanges().GetFreePersistentCount() == 4);
+        CHECK(descriptors.GetRanges().GetUsedTransientCount() == 0);
+        CHECK(descriptors.AllocatePersistent(4) == 0);
+    }
+} // namespace
+
+int main()
+{
+    TestMergeOnFree();
+    TestInvalidFrees();
+    TestDeferredFrees();
+    TestTransientWraparound();
+    TestDescriptorAllocator();
+    return TestResult();
+}
@@ -0,0 +1,72 @@
+#include "Bench.hpp"
+
+#include "MyDXLib/DrawList.hpp"
+
+namespace
+{
+    // Keys like a scene gives them: a few pipelines, hundreds of materials, depths up to a kilometre
+    std::vector<DrawPacket> MakePackets(size_t count)
+    {
+        std::mt19937                          random(23);
+        std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+        std::vector<DrawPacket>               packets(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            packets[i].SortKey       = DrawList::MakeKey(random() % 4, random() % 500, depth(random));
+            packets[i].FirstInstance = static_cast<uint32_t>(i);
+            packets[i].InstanceCount = 1;
+        }
+        return packets;
+    }
+
+    void Run(size_t count)
+    {
+        std::vector<DrawPacket> packets = MakePackets(count);
+        auto byKey = [](const DrawPacket &a, const DrawPacket &b) { return a.SortKey < b.SortKey; };
+
+        // Every call refills the list, that copy is timed on its own and taken off
+        DrawList drawList;
+        double   fillMs  = MeasureMs([&] {
+            drawList.Clear();
+            for (auto &&packet : packets)
+                drawList.Add(packet);
+        });
+        double   radixMs = MeasureMs([&] {
+            drawList.Clear();
+            for (auto &&packet : packets)
+                drawList.Add(packet);
+            drawList.Sort();
+        });
+
+        std::vector<DrawPacket> copy;
+        double                  copyMs   = MeasureMs([&] { copy = packets; });
+        double                  stableMs = MeasureMs([&] {
+            copy = packets;
+            std::stable_sort(copy.begin(), copy.end(), byKey);
+        });
+        double                  sortMs   = MeasureMs([&] {
+            copy = packets;
+            std::sort(copy.begin(), copy.end(), byKey);
+        });
+
+        radixMs  -= fillMs;
+        stableMs -= copyMs;
+        sortMs   -= copyMs;
+        std::printf("%8zu draws  radix %8.3f ms %6.1f ns/draw  std::stable_sort %8.3f ms %6.1f ns/draw  "
+                    "std::sort %8.3f ms %6.1f ns/draw\n",
+                    count,
+                    radixMs,
+                    1e6 * radixMs / count,
+                    stableMs,
+                    1e6 * stableMs / count,
+                    sortMs,
+                    1e6 * sortMs / count);
+    }
+} // namespace
+
+int main()
+{
+    for (size_t count : {size_t(10000), size_t(100000), size_t(1000000)})
+        Run(count);
+    return 0;
+}
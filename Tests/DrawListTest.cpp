@@ -0,0 +1,117 @@
+#include "Check.hpp"
+
+#include "MyDXLib/DrawList.hpp"
+
+namespace
+{
+    bool SortedLikeStableSort(std::vector<uint64_t> keys)
+    {
+        DrawList                drawList;
+        std::vector<DrawPacket> packets;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            // FirstInstance tells packets with the same key apart
+            DrawPacket packet    = {};
+            packet.SortKey       = keys[i];
+            packet.FirstInstance = static_cast<uint32_t>(i);
+            drawList.Add(packet);
+            packets.push_back(packet);
+        }
+
+        drawList.Sort();
+        std::stable_sort(packets.begin(), packets.end(), [](const DrawPacket &a, const DrawPacket &b) {
+            return a.SortKey < b.SortKey;
+        });
+
+        auto &sorted = drawList.GetPackets();
+        if (sorted.size() != packets.size())
+            return false;
+        for (size_t i = 0; i < packets.size(); ++i)
+            if (sorted[i].SortKey != packets[i].SortKey || sorted[i].FirstInstance != packets[i].FirstInstance)
+                return false;
+        return true;
+    }
+
+    void TestSortMatchesStableSort()
+    {
+        std::mt19937_64 random(17);
+        CHECK(SortedLikeStableSort({}));
+        CHECK(SortedLikeStableSort({5}));
+        CHECK(SortedLikeStableSort({7, 3}));
+        CHECK(SortedLikeStableSort(std::vector<uint64_t>(1000, 42)));
+
+        for (size_t count : {size_t(2), size_t(100), size_t(10000), size_t(200000)})
+        {
+            std::vector<uint64_t> any(count), fewKeys(count), highBits(count), drawKeys(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                any[i]      = random();
+                fewKeys[i]  = random() % 5;
+                highBits[i] = (random() % 3) << 61;
+                drawKeys[i] = DrawList::MakeKey(static_cast<uint32_t>(random() % 6),
+                                                static_cast<uint32_t>(random() % 300),
+                                                static_cast<float>(random() % 100000) * 0.01f);
+            }
+            CHECK(SortedLikeStableSort(any));
+            CHECK(SortedLikeStableSort(fewKeys));
+            CHECK(SortedLikeStableSort(highBits));
+            CHECK(SortedLikeStableSort(drawKeys));
+
+            // Sorted and reversed input
+            std::sort(drawKeys.begin(), drawKeys.end());
+            CHECK(SortedLikeStableSort(drawKeys));
+            std::reverse(drawKeys.begin(), drawKeys.end());
+            CHECK(SortedLikeStableSort(drawKeys));
+        }
+    }
+
+    void TestMakeKey()
+    {
+        // Pipeline before material before depth
+        CHECK(DrawList::MakeKey(1, 0, 0.0f) > DrawList::MakeKey(0, 0xFFFFFF, 1e30f));
+        CHECK(DrawList::MakeKey(0, 2, 0.0f) > DrawList::MakeKey(0, 1, 1e30f));
+        CHECK(DrawList::MakeKey(0, 0, 2.0f) > DrawList::MakeKey(0, 0, 1.0f));
+        CHECK(DrawList::MakeKey(255, 0xFFFFFF, 1e30f) >> 48 == 0);
+
+        // Front to back, close depths may share a key
+        bool  monotonic = true;
+        float previous  = 0.0f;
+        for (float depth = 0.001f; depth < 1e6f; depth *= 1.01f)
+        {
+            monotonic = monotonic && DrawList::MakeKey(3, 4, depth) >= DrawList::MakeKey(3, 4, previous);
+            previous  = depth;
+        }
+        CHECK(monotonic);
+        CHECK(DrawList::MakeKey(0, 0, 1.0f) == DrawList::MakeKey(0, 0, 1.001f));
+        CHECK(DrawList::MakeKey(0, 0, 1.0f) != DrawList::MakeKey(0, 0, 1.01f));
+
+        // Behind the camera sorts first
+        CHECK(DrawList::MakeKey(0, 0, -5.0f) == DrawList::MakeKey(0, 0, 0.0f));
+    }
+
+    void TestPipelines()
+    {
+        DrawList drawList;
+        auto     pipeline = [](size_t i) { return reinterpret_cast<ID3D12PipelineState *>(0x1000 + i * 16); };
+
+        CHECK(drawList.PipelineId(pipeline(7)) == 0);
+        CHECK(drawList.PipelineId(pipeline(3)) == 1);
+        CHECK(drawList.PipelineId(pipeline(7)) == 0);
+        CHECK(drawList.GetPipeline(DrawList::MakeKey(1, 99, 5.0f)) == pipeline(3));
+
+        drawList.Clear();
+        CHECK(drawList.PipelineId(pipeline(3)) == 1);
+        for (size_t i = 0; i < 254; ++i)
+            drawList.PipelineId(pipeline(100 + i));
+        CHECK(drawList.PipelineId(pipeline(353)) == 255);
+        CHECK_THROWS(drawList.PipelineId(pipeline(1000)));
+    }
+} // namespace
+
+int main()
+{
+    TestSortMatchesStableSort();
+    TestMakeKey();
+    TestPipelines();
+    return TestResult();
+}
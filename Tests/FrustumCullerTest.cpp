@@ -0,0 +1,291 @@
+#include "Check.hpp"
+
+#include "MyDXLib/FrustumCuller.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float NEAR_PLANE = 0.1f; // The planes of Game::OnUpdate
+    constexpr float FAR_PLANE  = 1000.0f;
+    constexpr float TAN_FOV    = 0.45f;
+    constexpr float ASPECT     = 16.0f / 9.0f;
+
+    // Camera::CalcProjection with the depths Game sets: 0 to 1 for the less depth test, 1 to 0 for greater
+    XMMATRIX Projection(bool greater)
+    {
+        XMFLOAT3 xyz1(-TAN_FOV * ASPECT, -TAN_FOV, NEAR_PLANE);
+        XMFLOAT3 xyz2(TAN_FOV * ASPECT, TAN_FOV, FAR_PLANE);
+        float    depth1 = greater ? 1.0f : 0.0f;
+        float    depth2 = greater ? 0.0f : 1.0f;
+
+        float widthRev  = 1.0f / (xyz2.x - xyz1.x);
+        float heightRev = 1.0f / (xyz2.y - xyz1.y);
+        float depthRev  = 1.0f / (xyz2.z - xyz1.z);
+        return XMMatrixSet(2.0f * widthRev, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, 2.0f * heightRev, 0.0f, 0.0f, // row 1
+                           (xyz1.x + xyz2.x) * widthRev,
+                           (xyz1.y + xyz2.y) * heightRev,
+                           (depth2 * xyz2.z - depth1 * xyz1.z) * depthRev,
+                           1.0f, // row 2
+                           0.0f,
+                           0.0f,
+                           (depth1 - depth2) * xyz1.z * xyz2.z * depthRev,
+                           0.0f);
+    }
+
+    XMMATRIX RotationX(float angle)
+    {
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        return XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, c, s, 0.0f,       // row 1
+                           0.0f, -s, c, 0.0f,      // row 2
+                           0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    struct Box
+    {
+        XMFLOAT3 Min;
+        XMFLOAT3 Max;
+        XMMATRIX Transform;
+    };
+
+    enum class Reference
+    {
+        Inside,
+        Outside,
+        Unsure, // Within rounding of a plane
+    };
+
+    // A box is outside when all corners of its world space bounds are outside one clip plane, checked one box and
+    // one corner at a time in clip space instead of against the extracted planes
+    Reference Classify(const Box &box, FXMMATRIX viewProjection)
+    {
+        XMFLOAT3 worldMin(FLT_MAX, FLT_MAX, FLT_MAX);
+        XMFLOAT3 worldMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (size_t corner = 0; corner < 8; ++corner)
+        {
+            XMFLOAT3 local(corner & 1 ? box.Max.x : box.Min.x,
+                           corner & 2 ? box.Max.y : box.Min.y,
+                           corner & 4 ? box.Max.z : box.Min.z);
+            XMFLOAT3 world;
+            XMStoreFloat3(&world, XMVector3TransformCoord(XMLoadFloat3(&local), box.Transform));
+            worldMin = XMFLOAT3((std::min)(worldMin.x, world.x),
+                                (std::min)(worldMin.y, world.y),
+                                (std::min)(worldMin.z, world.z));
+            worldMax = XMFLOAT3((std::max)(worldMax.x, world.x),
+                                (std::max)(worldMax.y, world.y),
+                                (std::max)(worldMax.z, world.z));
+        }
+
+        // Clip planes as the rows x + w, w - x, y + w, w - y, z and w - z of the transposed matrix. The distances are
+        // divided by the length of the plane normals to compare them in world units.
+        XMFLOAT4X4 m;
+        XMStoreFloat4x4(&m, viewProjection);
+        const int signs[6][3] = {{0, 1, 3}, {0, -1, 3}, {1, 1, 3}, {1, -1, 3}, {2, 1, -1}, {2, -1, 3}};
+        double    planes[6][4];
+        for (size_t plane = 0; plane < 6; ++plane)
+        {
+            auto [column, sign, wColumn] = signs[plane];
+            for (size_t r = 0; r < 4; ++r)
+                planes[plane][r] = sign * double(m(r, column)) + (wColumn < 0 ? 0.0 : double(m(r, wColumn)));
+        }
+
+        bool outside = false;
+        for (auto &&plane : planes)
+        {
+            double largest = -DBL_MAX;
+            for (size_t corner = 0; corner < 8; ++corner)
+            {
+                double x = corner & 1 ? worldMax.x : worldMin.x;
+                double y = corner & 2 ? worldMax.y : worldMin.y;
+                double z = corner & 4 ? worldMax.z : worldMin.z;
+                largest  = (std::max)(largest, x * plane[0] + y * plane[1] + z * plane[2] + plane[3]);
+            }
+            largest /= std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            if (std::abs(largest) < 1e-3)
+                return Reference::Unsure;
+            outside = outside || largest < 0.0;
+        }
+        return outside ? Reference::Outside : Reference::Inside;
+    }
+
+    // Point on one of the six faces of the view volume, in world space
+    XMFLOAT3 PointOnPlane(size_t plane, FXMMATRIX inverseViewProjection, std::mt19937 &random)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+        XMFLOAT3 ndc(unit(random), unit(random), depth(random));
+        switch (plane)
+        {
+        case 0: ndc.x = -1.0f; break;
+        case 1: ndc.x = 1.0f; break;
+        case 2: ndc.y = -1.0f; break;
+        case 3: ndc.y = 1.0f; break;
+        case 4: ndc.z = 0.0f; break;
+        default: ndc.z = 1.0f; break;
+        }
+        XMFLOAT3 world;
+        XMStoreFloat3(&world, XMVector3TransformCoord(XMLoadFloat3(&ndc), inverseViewProjection));
+        return world;
+    }
+
+    // Random boxes around the camera, half of them centered on one of the planes so they straddle it or only
+    // just clear it
+    std::vector<Box> RandomBoxes(size_t count, FXMMATRIX viewProjection, CXMMATRIX view, std::mt19937 &random)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> size(0.01f, 3.0f);
+        XMMATRIX inverseViewProjection = XMMatrixInverse(nullptr, viewProjection);
+        XMMATRIX inverseView           = XMMatrixInverse(nullptr, view);
+
+        std::vector<Box> boxes(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            XMFLOAT3 center;
+            if (i % 2 == 0)
+            {
+                center = PointOnPlane(random() % 6, inverseViewProjection, random);
+                center = XMFLOAT3(center.x + unit(random) * 0.5f,
+                                  center.y + unit(random) * 0.5f,
+                                  center.z + unit(random) * 0.5f);
+            }
+            else
+            {
+                XMFLOAT3 local(unit(random) * 300.0f, unit(random) * 300.0f, unit(random) * 300.0f);
+                XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&local), inverseView));
+            }
+
+            XMFLOAT3 extent(size(random), size(random), size(random));
+            boxes[i].Min       = XMFLOAT3(-extent.x, -extent.y, -extent.z);
+            boxes[i].Max       = XMFLOAT3(extent.x, extent.y, extent.z);
+            boxes[i].Transform = XMMatrixScaling(1.0f, 1.0f + unit(random) * 0.5f, 1.0f)
+                               * XMMatrixRotationY(unit(random) * 3.0f) * RotationX(unit(random) * 1.5f)
+                               * XMMatrixTranslation(center.x, center.y, center.z);
+        }
+        return boxes;
+    }
+
+    void TestAgainstReference(bool greater)
+    {
+        std::mt19937                          random(greater ? 11 : 7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        XMMATRIX                              projection = Projection(greater);
+
+        size_t counts[3] = {};
+        for (size_t count : {size_t(1), size_t(2), size_t(3), size_t(5), size_t(6), size_t(7), size_t(13), size_t(999)})
+        {
+            for (size_t round = 0; round < 20; ++round)
+            {
+                // Camera::CalcMatrix: translation, then a turn and a tilt
+                XMMATRIX view = XMMatrixTranslation(unit(random) * 50.0f, unit(random) * 10.0f, unit(random) * 50.0f)
+                              * XMMatrixRotationY(unit(random) * 3.0f) * RotationX(unit(random) * 1.5f);
+                XMMATRIX viewProjection = view * projection;
+                Frustum  frustum        = Frustum::FromMatrix(viewProjection);
+
+                std::vector<Box> boxes = RandomBoxes(count, viewProjection, view, random);
+                BoundingBoxes    soa;
+                for (auto &&box : boxes)
+                    soa.Add(box.Min, box.Max, box.Transform);
+                CHECK(soa.Size() == count);
+
+                // Left over results must not survive, the vector is resized to the box count
+                std::vector<uint8_t> visible(count + 3, 2);
+                FrustumCuller::Test(frustum, soa, visible);
+                CHECK(visible.size() == count);
+
+                for (size_t i = 0; i < count && i < visible.size(); ++i)
+                {
+                    Reference reference = Classify(boxes[i], viewProjection);
+                    ++counts[static_cast<size_t>(reference)];
+                    if (reference != Reference::Unsure)
+                        CHECK(visible[i] == (reference == Reference::Inside ? 1 : 0));
+                }
+            }
+        }
+        std::printf("%s depth: %zu inside, %zu outside, %zu within rounding\n",
+                    greater ? "greater" : "less",
+                    counts[0],
+                    counts[1],
+                    counts[2]);
+        CHECK(counts[0] > 1000 && counts[1] > 1000);
+        CHECK(counts[2] < (counts[0] + counts[1]) / 100);
+    }
+
+    // Boxes straddling each plane are kept, the same boxes moved just past it are dropped
+    void TestStraddling(bool greater)
+    {
+        XMMATRIX projection = Projection(greater);
+        Frustum  frustum    = Frustum::FromMatrix(projection);
+
+        // Depths where clip z is 0 and where it is w, in the float matrix the GPU clips with. In the less projection
+        // the far plane is off by about a unit, f / (f - n) keeps only a few digits of its distance from 1.
+        XMFLOAT4X4 m;
+        XMStoreFloat4x4(&m, projection);
+        float zeroDepth = static_cast<float>(-double(m(3, 2)) / m(2, 2));
+        float wDepth    = static_cast<float>(double(m(3, 2)) / (1.0 - m(2, 2)));
+        float zOutward  = zeroDepth < wDepth ? -1.0f : 1.0f;
+
+        // Points in view space on the middle of every plane, with the direction out of the view volume
+        float    depth      = 100.0f;
+        float    halfWidth  = depth * TAN_FOV * ASPECT;
+        float    halfHeight = depth * TAN_FOV;
+        XMFLOAT3 onPlane[6] = {{-halfWidth, 0.0f, depth},
+                               {halfWidth, 0.0f, depth},
+                               {0.0f, -halfHeight, depth},
+                               {0.0f, halfHeight, depth},
+                               {0.0f, 0.0f, zeroDepth},
+                               {0.0f, 0.0f, wDepth}};
+        XMFLOAT3 outward[6] = {{-1.0f, 0.0f, 0.0f},
+                               {1.0f, 0.0f, 0.0f},
+                               {0.0f, -1.0f, 0.0f},
+                               {0.0f, 1.0f, 0.0f},
+                               {0.0f, 0.0f, zOutward},
+                               {0.0f, 0.0f, -zOutward}};
+
+        // Boxes of half size 0.05, on the plane and 0.2 past it, every lane of two batches takes a turn
+        BoundingBoxes  boxes;
+        const XMFLOAT3 boxMin(-0.05f, -0.05f, -0.05f);
+        const XMFLOAT3 boxMax(0.05f, 0.05f, 0.05f);
+        for (size_t plane = 0; plane < 6; ++plane)
+        {
+            const XMFLOAT3 &p = onPlane[plane];
+            const XMFLOAT3 &n = outward[plane];
+            boxes.Add(boxMin, boxMax, XMMatrixTranslation(p.x, p.y, p.z));
+            boxes.Add(boxMin, boxMax, XMMatrixTranslation(p.x + n.x * 0.2f, p.y + n.y * 0.2f, p.z + n.z * 0.2f));
+        }
+        // A box in the middle as the 13th, alone in the last batch with three padding lanes
+        boxes.Add(boxMin, boxMax, XMMatrixTranslation(0.0f, 0.0f, depth));
+
+        std::vector<uint8_t> visible;
+        FrustumCuller::Test(frustum, boxes, visible);
+        CHECK(visible.size() == 13);
+        for (size_t plane = 0; plane < 6 && visible.size() == 13; ++plane)
+        {
+            CHECK(visible[plane * 2] == 1);
+            CHECK(visible[plane * 2 + 1] == 0);
+        }
+        CHECK(visible.size() == 13 && visible[12] == 1);
+
+        // Set replaces a box in place, Clear starts over without the old padding
+        boxes.Set(1, boxMin, boxMax, XMMatrixTranslation(0.0f, 0.0f, depth));
+        FrustumCuller::Test(frustum, boxes, visible);
+        CHECK(visible[1] == 1);
+
+        boxes.Clear();
+        boxes.Add(boxMin, boxMax, XMMatrixTranslation(0.0f, 0.0f, -depth));
+        FrustumCuller::Test(frustum, boxes, visible);
+        CHECK(visible.size() == 1 && visible[0] == 0);
+    }
+} // namespace
+
+int main()
+{
+    for (bool greater : {false, true})
+    {
+        TestAgainstReference(greater);
+        TestStraddling(greater);
+    }
+    return TestResult();
+}
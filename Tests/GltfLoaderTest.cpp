@@ -0,0 +1,129 @@
+#include "Check.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/GltfLoader.hpp"
+
+namespace
+{
+    std::vector<uint32_t> Indices(const MeshData &mesh)
+    {
+        std::vector<uint32_t> result(mesh.IndexCount());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            if (mesh.SingleIndexSize() == sizeof(uint16_t))
+                result[i] = static_cast<const uint16_t *>(mesh.IndexBufferStart())[i];
+            else
+                result[i] = static_cast<const uint32_t *>(mesh.IndexBufferStart())[i];
+        }
+        return result;
+    }
+
+    bool SamePositions(const MeshData &mesh, const std::vector<DirectX::XMFLOAT3> &positions)
+    {
+        auto vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        if (mesh.VertexCount() != positions.size())
+            return false;
+        for (size_t i = 0; i < positions.size(); ++i)
+            if (vertices[i].pos.x != positions[i].x || vertices[i].pos.y != positions[i].y
+                || vertices[i].pos.z != positions[i].z)
+                return false;
+        return true;
+    }
+
+    // The same grid indexed and as a plain triangle list
+    void TestNonIndexed(const std::filesystem::path &directory)
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(4, positions, indices);
+        std::vector<DirectX::XMFLOAT3> unrolled;
+        for (uint32_t index : indices)
+            unrolled.push_back(positions[index]);
+
+        GltfWriter writer;
+        writer.AddNode(GltfWriter::NONE, writer.AddMesh(positions, indices));
+        writer.AddNode(GltfWriter::NONE, writer.AddMesh(unrolled, {}));
+        writer.Write(directory / "NonIndexed.gltf");
+
+        SceneData sceneData;
+        GltfLoader::Load(directory / "NonIndexed.gltf", sceneData);
+        CHECK(sceneData.GetMeshes().size() == 2);
+        const MeshData &indexed = sceneData.GetMeshes()[0];
+        const MeshData &list    = sceneData.GetMeshes()[1];
+        CHECK(SamePositions(indexed, positions));
+        CHECK(Indices(indexed) == indices);
+
+        std::vector<uint32_t> sequence(unrolled.size());
+        std::iota(sequence.begin(), sequence.end(), 0u);
+        CHECK(SamePositions(list, unrolled));
+        CHECK(list.SingleIndexSize() == sizeof(uint16_t));
+        CHECK(Indices(list) == sequence);
+    }
+
+    // 16 bit indices reach up to 65536 vertices
+    void TestNonIndexedWidth(const std::filesystem::path &directory)
+    {
+        for (size_t vertexCount : {size_t(65535), size_t(65538)})
+        {
+            std::vector<DirectX::XMFLOAT3> positions(vertexCount);
+            for (size_t i = 0; i < vertexCount; ++i)
+                positions[i] = DirectX::XMFLOAT3(static_cast<float>(i % 3), static_cast<float>(i / 3), 0.0f);
+
+            GltfWriter writer;
+            writer.AddNode(GltfWriter::NONE, writer.AddMesh(positions, {}));
+            writer.Write(directory / "Large.gltf");
+
+            SceneData sceneData;
+            GltfLoader::Load(directory / "Large.gltf", sceneData);
+            const MeshData &mesh = sceneData.GetMeshes()[0];
+            CHECK(mesh.IndexCount() == vertexCount);
+            CHECK(mesh.SingleIndexSize() == (vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t)));
+            auto indices = Indices(mesh);
+            CHECK(indices.front() == 0 && indices.back() == vertexCount - 1);
+        }
+    }
+
+    void TestNonIndexedIncomplete(const std::filesystem::path &directory)
+    {
+        std::vector<DirectX::XMFLOAT3> positions(4);
+        GltfWriter                     writer;
+        writer.AddNode(GltfWriter::NONE, writer.AddMesh(positions, {}));
+        writer.Write(directory / "Incomplete.gltf");
+
+        SceneData sceneData;
+        CHECK_THROWS(GltfLoader::Load(directory / "Incomplete.gltf", sceneData));
+    }
+
+    // Indices past the vertices, in 16 and 32 bits, and a dangling partial triangle
+    void TestMalformedIndices(const std::filesystem::path &directory)
+    {
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(2, positions, indices);
+        uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+        std::vector<std::vector<uint32_t>> malformed(3, indices);
+        malformed[0][4] = vertexCount;
+        malformed[1][4] = 70000;
+        malformed[2].pop_back();
+        for (size_t i = 0; i < malformed.size(); ++i)
+        {
+            GltfWriter writer;
+            writer.AddNode(GltfWriter::NONE, writer.AddMesh(positions, malformed[i]));
+            writer.Write(directory / "Malformed.gltf");
+
+            SceneData sceneData;
+            CHECK_THROWS(GltfLoader::Load(directory / "Malformed.gltf", sceneData));
+        }
+    }
+} // namespace
+
+int main()
+{
+    ScratchDirectory directory("GltfLoaderTest");
+    TestNonIndexed(directory.Path());
+    TestNonIndexedWidth(directory.Path());
+    TestNonIndexedIncomplete(directory.Path());
+    TestMalformedIndices(directory.Path());
+    return TestResult();
+}
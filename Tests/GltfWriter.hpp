@@ -0,0 +1,240 @@
+#pragma once
+
+#include "pch.hpp"
+
+// Writes generated glTF scenes for the tests and benches: a .gltf file and one .bin buffer next to it. Every mesh
+// has triangle primitives with the attributes GltfLoader needs, the normals, tangents and UVs are made up.
+class GltfWriter
+{
+  public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+  private:
+    // Every accessor has a buffer view of its own
+    struct Accessor
+    {
+        size_t      Offset;
+        size_t      Length;
+        size_t      Count;
+        uint32_t    ComponentType;
+        const char *Type;
+    };
+
+    struct Primitive
+    {
+        size_t Positions;
+        size_t Normals;
+        size_t Tangents;
+        size_t Uvs;
+        size_t Indices; // NONE for a primitive without indices
+        size_t Material;
+    };
+
+    struct Node
+    {
+        size_t              Mesh;
+        DirectX::XMFLOAT3   Translation;
+        std::vector<size_t> Children;
+    };
+
+    std::vector<char>                   m_Buffer;
+    std::vector<Accessor>               m_Accessors;
+    std::vector<std::string>            m_Images;
+    std::vector<size_t>                 m_Materials; // Base color image
+    std::vector<std::vector<Primitive>> m_Meshes;
+    std::vector<Node>                   m_Nodes;
+    std::vector<size_t>                 m_Roots;
+
+    size_t AddAccessor(const void *data, size_t size, size_t count, uint32_t componentType, const char *type)
+    {
+        size_t offset = m_Buffer.size();
+        m_Buffer.insert(m_Buffer.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+        m_Buffer.resize((m_Buffer.size() + 3) & ~size_t(3), 0);
+        m_Accessors.push_back({offset, size, count, componentType, type});
+        return m_Accessors.size() - 1;
+    }
+
+  public:
+    size_t AddMaterial(const std::string &baseColorImage)
+    {
+        auto found = std::find(m_Images.begin(), m_Images.end(), baseColorImage);
+        if (found == m_Images.end())
+            found = m_Images.insert(m_Images.end(), baseColorImage);
+        m_Materials.push_back(found - m_Images.begin());
+        return m_Materials.size() - 1;
+    }
+
+    // Mesh with a single primitive, see AddPrimitive
+    size_t AddMesh(const std::vector<DirectX::XMFLOAT3> &positions,
+                   const std::vector<uint32_t>          &indices,
+                   size_t                                material = NONE)
+    {
+        m_Meshes.emplace_back();
+        AddPrimitive(m_Meshes.size() - 1, positions, indices, material);
+        return m_Meshes.size() - 1;
+    }
+
+    // Without indices the positions are a plain triangle list. Indices below 65536 are stored in 16 bits.
+    void AddPrimitive(size_t                                mesh,
+                      const std::vector<DirectX::XMFLOAT3> &positions,
+                      const std::vector<uint32_t>          &indices,
+                      size_t                                material = NONE)
+    {
+        size_t                         count = positions.size();
+        std::vector<DirectX::XMFLOAT3> normals(count, DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f));
+        std::vector<DirectX::XMFLOAT4> tangents(count, DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+        std::vector<DirectX::XMFLOAT2> uvs(count);
+        for (size_t i = 0; i < count; ++i)
+            uvs[i] = DirectX::XMFLOAT2(positions[i].x, positions[i].z);
+
+        Primitive primitive;
+        primitive.Positions = AddAccessor(positions.data(), count * sizeof(DirectX::XMFLOAT3), count, 5126, "VEC3");
+        primitive.Normals   = AddAccessor(normals.data(), count * sizeof(DirectX::XMFLOAT3), count, 5126, "VEC3");
+        primitive.Tangents  = AddAccessor(tangents.data(), count * sizeof(DirectX::XMFLOAT4), count, 5126, "VEC4");
+        primitive.Uvs       = AddAccessor(uvs.data(), count * sizeof(DirectX::XMFLOAT2), count, 5126, "VEC2");
+        primitive.Indices   = NONE;
+        primitive.Material  = material;
+        if (!indices.empty())
+        {
+            if (*std::max_element(indices.begin(), indices.end()) <= UINT16_MAX)
+            {
+                std::vector<uint16_t> narrow(indices.begin(), indices.end());
+                primitive.Indices = AddAccessor(narrow.data(), narrow.size() * 2, narrow.size(), 5123, "SCALAR");
+            }
+            else
+            {
+                primitive.Indices = AddAccessor(indices.data(), indices.size() * 4, indices.size(), 5125, "SCALAR");
+            }
+        }
+        m_Meshes[mesh].push_back(primitive);
+    }
+
+    // parent NONE makes a root node of the scene
+    size_t AddNode(size_t parent, size_t mesh, const DirectX::XMFLOAT3 &translation = {})
+    {
+        m_Nodes.push_back({mesh, translation, {}});
+        size_t node = m_Nodes.size() - 1;
+        if (parent == NONE)
+            m_Roots.push_back(node);
+        else
+            m_Nodes[parent].Children.push_back(node);
+        return node;
+    }
+
+    // The buffer is written to the same path with the extension .bin
+    void Write(const std::filesystem::path &gltfPath) const
+    {
+        std::filesystem::path binPath = gltfPath;
+        binPath.replace_extension(".bin");
+        {
+            std::ofstream bin(binPath, std::ios::binary | std::ios::trunc);
+            bin.write(m_Buffer.data(), m_Buffer.size());
+        }
+
+        auto list = [](std::ostream &out, size_t count, auto &&element) {
+            for (size_t i = 0; i < count; ++i)
+            {
+                out << (i ? "," : "");
+                element(i);
+            }
+        };
+
+        std::ofstream out(gltfPath, std::ios::trunc);
+        out << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+        list(out, m_Roots.size(), [&](size_t i) { out << m_Roots[i]; });
+        out << "]}],\"buffers\":[{\"uri\":\"" << binPath.filename().u8string()
+            << "\",\"byteLength\":" << m_Buffer.size() << "}],\"bufferViews\":[";
+        list(out, m_Accessors.size(), [&](size_t i) {
+            const Accessor &accessor = m_Accessors[i];
+            out << "{\"buffer\":0,\"byteOffset\":" << accessor.Offset << ",\"byteLength\":" << accessor.Length << "}";
+        });
+        out << "],\"accessors\":[";
+        list(out, m_Accessors.size(), [&](size_t i) {
+            const Accessor &accessor = m_Accessors[i];
+            out << "{\"bufferView\":" << i << ",\"componentType\":" << accessor.ComponentType
+                << ",\"count\":" << accessor.Count << ",\"type\":\"" << accessor.Type << "\"}";
+        });
+        out << "],\"images\":[";
+        list(out, m_Images.size(), [&](size_t i) { out << "{\"uri\":\"" << m_Images[i] << "\"}"; });
+        out << "],\"textures\":[";
+        list(out, m_Images.size(), [&](size_t i) { out << "{\"source\":" << i << "}"; });
+        out << "],\"materials\":[";
+        list(out, m_Materials.size(), [&](size_t i) {
+            out << "{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":" << m_Materials[i] << "}}}";
+        });
+        out << "],\"meshes\":[";
+        list(out, m_Meshes.size(), [&](size_t i) {
+            out << "{\"primitives\":[";
+            list(out, m_Meshes[i].size(), [&](size_t p) {
+                const Primitive &primitive = m_Meshes[i][p];
+                out << "{\"attributes\":{\"POSITION\":" << primitive.Positions << ",\"NORMAL\":" << primitive.Normals
+                    << ",\"TANGENT\":" << primitive.Tangents << ",\"TEXCOORD_0\":" << primitive.Uvs << "}";
+                if (primitive.Indices != NONE)
+                    out << ",\"indices\":" << primitive.Indices;
+                if (primitive.Material != NONE)
+                    out << ",\"material\":" << primitive.Material;
+                out << "}";
+            });
+            out << "]}";
+        });
+        out << "],\"nodes\":[";
+        list(out, m_Nodes.size(), [&](size_t i) {
+            const Node &node = m_Nodes[i];
+            out << "{\"translation\":[" << node.Translation.x << "," << node.Translation.y << ","
+                << node.Translation.z << "]";
+            if (node.Mesh != NONE)
+                out << ",\"mesh\":" << node.Mesh;
+            if (!node.Children.empty())
+            {
+                out << ",\"children\":[";
+                list(out, node.Children.size(), [&](size_t c) { out << node.Children[c]; });
+                out << "]";
+            }
+            out << "}";
+        });
+        out << "]}";
+    }
+};
+
+// Grid of n x n quads in the xz plane, front facing from above
+inline void MakeGrid(size_t n, std::vector<DirectX::XMFLOAT3> &positions, std::vector<uint32_t> &indices)
+{
+    positions.clear();
+    indices.clear();
+    for (size_t z = 0; z <= n; ++z)
+        for (size_t x = 0; x <= n; ++x)
+            positions.emplace_back(static_cast<float>(x), 0.0f, static_cast<float>(z));
+    for (uint32_t z = 0; z < n; ++z)
+    {
+        for (uint32_t x = 0; x < n; ++x)
+        {
+            uint32_t corner = z * static_cast<uint32_t>(n + 1) + x;
+            uint32_t above  = corner + static_cast<uint32_t>(n + 1);
+            indices.insert(indices.end(), {above, above + 1, corner + 1, above, corner + 1, corner});
+        }
+    }
+}
+
+// Directory under the system temporary directory, removed with everything in it on destruction
+class ScratchDirectory
+{
+    std::filesystem::path m_Path;
+
+  public:
+    explicit ScratchDirectory(const std::string &name)
+    {
+        std::random_device random;
+        m_Path = std::filesystem::temp_directory_path() / (name + "-" + std::to_string(random()));
+        std::filesystem::create_directories(m_Path);
+    }
+    ~ScratchDirectory()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(m_Path, ec);
+    }
+
+    ScratchDirectory(const ScratchDirectory &)            = delete;
+    ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+
+    const std::filesystem::path &Path() const noexcept { return m_Path; }
+};
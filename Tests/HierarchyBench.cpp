@@ -0,0 +1,155 @@
+#include "Bench.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/Scene.hpp"
+
+namespace
+{
+    constexpr size_t SPONZA_PRIMITIVES = 103; // Of the single mesh of 3rd-party/Sponza/glTF/Sponza.gltf
+    constexpr size_t SYNTHETIC_NODES   = 100000;
+
+    // The hierarchy the scene had before it was flattened: a heap allocated node per object, its children
+    // behind pointers, and a recursive walk multiplying the transforms on the way down
+    struct TreeNode
+    {
+        std::vector<std::unique_ptr<TreeNode>> Children;
+        std::vector<const Mesh *>              Meshes;
+        DirectX::XMMATRIX                      Transform;
+    };
+
+    std::unique_ptr<TreeNode> BuildTree(const SceneData &data, const std::vector<Mesh> &meshes)
+    {
+        auto &&objects      = data.GetObjects();
+        auto &&objectMeshes = data.GetObjectMeshes();
+
+        // Parent order, so the nodes are allocated in the same depth first order as the recursive import did
+        std::vector<TreeNode *>   nodes(objects.size());
+        std::unique_ptr<TreeNode> root;
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            auto node       = std::make_unique<TreeNode>();
+            node->Transform = DirectX::XMLoadFloat4x4(&objects[i].Transform);
+            for (uint32_t j = 0; j < objects[i].MeshCount; ++j)
+                node->Meshes.push_back(&meshes[objectMeshes[objects[i].MeshOffset + j]]);
+            nodes[i] = node.get();
+            if (objects[i].Parent == ObjectData::NO_PARENT)
+                root = std::move(node);
+            else
+                nodes[objects[i].Parent]->Children.push_back(std::move(node));
+        }
+        return root;
+    }
+
+    // Returns the number of meshes visited, so the walk can't be optimized away
+    size_t Traverse(const TreeNode &node, const DirectX::XMMATRIX &model, DirectX::XMMATRIX &last)
+    {
+        DirectX::XMMATRIX world = node.Transform * model;
+        size_t            count = 0;
+        for (const Mesh *mesh : node.Meshes)
+            count += mesh != nullptr;
+        last = world;
+        for (auto &child : node.Children)
+            count += Traverse(*child, world, last);
+        return count;
+    }
+
+    void WriteSponzaShape(const std::filesystem::path &path)
+    {
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        size_t                         materials[8];
+        for (size_t i = 0; i < 8; ++i)
+            materials[i] = writer.AddMaterial("texture" + std::to_string(i) + ".png");
+
+        MakeGrid(1, positions, indices);
+        size_t mesh = writer.AddMesh(positions, indices, materials[0]);
+        for (size_t i = 1; i < SPONZA_PRIMITIVES; ++i)
+            writer.AddPrimitive(mesh, positions, indices, materials[i % 8]);
+        writer.AddNode(GltfWriter::NONE, mesh);
+        writer.Write(path);
+    }
+
+    // Random tree, the parent of every node is any of the nodes before it, which keeps it a few dozen levels deep
+    void WriteSyntheticTree(const std::filesystem::path &path)
+    {
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        size_t                         meshes[8];
+        for (size_t i = 0; i < 8; ++i)
+        {
+            MakeGrid(1, positions, indices);
+            meshes[i] = writer.AddMesh(positions, indices, writer.AddMaterial("texture.png"));
+        }
+
+        std::mt19937 random(9);
+        writer.AddNode(GltfWriter::NONE, meshes[0]);
+        for (size_t i = 1; i < SYNTHETIC_NODES; ++i)
+        {
+            // Every other node is a group without a mesh
+            size_t mesh = i % 2 == 0 ? meshes[i % 8] : GltfWriter::NONE;
+            writer.AddNode(random() % i, mesh, {1.0f, 0.0f, 0.0f});
+        }
+        writer.Write(path);
+    }
+
+    void Run(const char *name, const std::filesystem::path &path)
+    {
+        SceneImportOptions options;
+        options.Importer = SCENE_IMPORTER_GLTF;
+        SceneData data;
+        data.LoadFromFile(path, options);
+
+        DescriptorAllocator descriptors(PDevice(), 16, 16);
+        Scene               scene;
+        scene.Describe(descriptors, data);
+
+        // Only the mesh addresses are kept in the tree, a vector of the right size will do
+        std::vector<Mesh>         meshes(data.GetMeshes().size());
+        std::unique_ptr<TreeNode> tree = BuildTree(data, meshes);
+
+        // The model moves every frame, so every world transform is recomputed by both
+        DirectX::XMMATRIX model = DirectX::XMMatrixIdentity();
+        DirectX::XMMATRIX last;
+        size_t            visited = 0;
+        double            treeMs  = MeasureMs([&] {
+            model   = model * DirectX::XMMatrixTranslation(0.0f, 0.0f, 1.0f);
+            visited = Traverse(*tree, model, last);
+        });
+        double            flatMs  = MeasureMs([&] {
+            model = model * DirectX::XMMatrixTranslation(0.0f, 0.0f, 1.0f);
+            scene.UpdateTransforms(model);
+        });
+
+        size_t objects = scene.GetObjectCount();
+        std::printf("%-9s %6zu objects %6zu meshes  tree %8.4f ms %6.2f ns/object  flat %8.4f ms %6.2f ns/object  "
+                    "%4.1fx\n",
+                    name,
+                    objects,
+                    visited,
+                    treeMs,
+                    1e6 * treeMs / objects,
+                    flatMs,
+                    1e6 * flatMs / objects,
+                    treeMs / flatMs);
+    }
+} // namespace
+
+// World transforms of the whole hierarchy through the old recursive pointer tree and through the flat parent
+// ordered arrays of Scene. Takes a scene to use instead of the Sponza shaped one, for example the real Sponza.
+int main(int argc, char **argv)
+{
+    ScratchDirectory      directory("HierarchyBench");
+    std::filesystem::path sponza = directory.Path() / "Sponza.gltf";
+    std::filesystem::path tree   = directory.Path() / "Tree.gltf";
+    if (argc > 1)
+        sponza = std::filesystem::u8path(argv[1]);
+    else
+        WriteSponzaShape(sponza);
+    WriteSyntheticTree(tree);
+
+    Run("Sponza", sponza);
+    Run("Synthetic", tree);
+    return 0;
+}
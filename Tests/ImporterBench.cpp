@@ -0,0 +1,67 @@
+#include "Bench.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/SceneData.hpp"
+
+namespace
+{
+    constexpr size_t MESHES    = 64;
+    constexpr size_t GRID_SIZE = 100;
+
+    void WriteScene(const std::filesystem::path &path)
+    {
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(GRID_SIZE, positions, indices);
+        size_t group = writer.AddNode(GltfWriter::NONE, GltfWriter::NONE);
+        for (size_t i = 0; i < MESHES; ++i)
+        {
+            size_t material = writer.AddMaterial("texture" + std::to_string(i % 8) + ".png");
+            size_t mesh     = writer.AddMesh(positions, indices, material);
+            writer.AddNode(group, mesh, {static_cast<float>(i * GRID_SIZE), 0.0f, 0.0f});
+        }
+        writer.Write(path);
+    }
+
+    void Run(const std::filesystem::path &scenePath, SceneImporter importer, const char *name)
+    {
+        size_t meshes   = 0;
+        size_t vertices = 0;
+        double ms       = 0.0;
+        try
+        {
+            // ImportFromFile skips the scene cache and the mesh processing of LoadFromFile
+            ms = MeasureMs([&] {
+                SceneData sceneData;
+                sceneData.ImportFromFile(scenePath, importer);
+                meshes   = sceneData.GetMeshes().size();
+                vertices = 0;
+                for (auto &&mesh : sceneData.GetMeshes())
+                    vertices += mesh.VertexCount();
+            });
+        }
+        catch (const std::exception &e)
+        {
+            std::printf("%-6s failed: %s\n", name, e.what());
+            return;
+        }
+        std::printf("%-6s %9.3f ms  %5zu meshes %9zu vertices\n", name, ms, meshes, vertices);
+    }
+} // namespace
+
+// GltfLoader against Assimp on the same file. Takes a .gltf or .glb scene, a generated one without arguments.
+int main(int argc, char **argv)
+{
+    ScratchDirectory      directory("ImporterBench");
+    std::filesystem::path scenePath = directory.Path() / "Scene.gltf";
+    if (argc > 1)
+        scenePath = std::filesystem::u8path(argv[1]);
+    else
+        WriteScene(scenePath);
+
+    std::printf("%s\n", scenePath.u8string().c_str());
+    Run(scenePath, SCENE_IMPORTER_GLTF, "glTF");
+    Run(scenePath, SCENE_IMPORTER_ASSIMP, "Assimp");
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include "pch.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/material.h>
+
+// Only the Windows build of Assimp ships with the repo. Without a system Assimp every import fails and
+// the tests load scenes through GltfLoader.
+
+Assimp::Importer::Importer() : pimpl(nullptr)
+{
+}
+
+Assimp::Importer::~Importer()
+{
+}
+
+const aiScene *Assimp::Importer::ReadFile(const char *, unsigned int)
+{
+    return nullptr;
+}
+
+// Referenced by the inline aiMaterial methods, never called without a scene
+unsigned int aiGetMaterialTextureCount(const aiMaterial *, aiTextureType)
+{
+    return 0;
+}
+
+aiReturn aiGetMaterialTexture(const aiMaterial *, aiTextureType, unsigned int, aiString *, aiTextureMapping *,
+                              unsigned int *, ai_real *, aiTextureOp *, aiTextureMapMode *, unsigned int *)
+{
+    return aiReturn_FAILURE;
+}
@@ -0,0 +1,103 @@
+#include "pch.hpp"
+
+HANDLE CreateEventW(void *, BOOL, BOOL, const wchar_t *)
+{
+    static char event;
+    return &event;
+}
+
+DWORD WaitForSingleObject(HANDLE, DWORD)
+{
+    return 0;
+}
+
+BOOL CloseHandle(HANDLE)
+{
+    return TRUE;
+}
+
+void OutputDebugStringA(const char *)
+{
+}
+
+void OutputDebugStringW(const wchar_t *)
+{
+}
+
+namespace
+{
+    // Heap whose handles are plain numbers, nothing may write through them. DescriptorAllocator only needs
+    // the handle arithmetic of DescriptorHeap.
+    class NullDescriptorHeap final : public ID3D12DescriptorHeap
+    {
+        std::atomic<ULONG>         m_RefCount = 1;
+        D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+
+      public:
+        static constexpr SIZE_T CPU_START = 0x10000;
+        static constexpr UINT64 GPU_START = 0x100000000;
+
+        explicit NullDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC &desc) : m_Desc(desc) {}
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void **object) override
+        {
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG count = --m_RefCount;
+            if (count == 0)
+                delete this;
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT *, void *) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void *) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown *) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID, void **device) override
+        {
+            *device = nullptr;
+            return E_NOTIMPL;
+        }
+
+        D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE  GetDesc() override { return m_Desc; }
+        D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+        {
+            return {CPU_START};
+        }
+        D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+        {
+            return {GPU_START};
+        }
+    };
+} // namespace
+
+// DirectXTK12 is only available for Windows, the tests get heaps without a device
+DirectX::DescriptorHeap::DescriptorHeap(ID3D12Device *,
+                                        D3D12_DESCRIPTOR_HEAP_TYPE  type,
+                                        D3D12_DESCRIPTOR_HEAP_FLAGS flags,
+                                        size_t                      count) noexcept(false)
+    : m_desc{type, static_cast<UINT>(count), flags, 0},
+      m_hCPU{},
+      m_hGPU{},
+      m_increment(32)
+{
+    m_pHeap.Attach(new NullDescriptorHeap(m_desc));
+    m_hCPU = m_pHeap->GetCPUDescriptorHandleForHeapStart();
+    if (flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+        m_hGPU = m_pHeap->GetGPUDescriptorHandleForHeapStart();
+}
+
+HRESULT DirectX::LoadWICTextureFromFile(ID3D12Device *,
+                                        const wchar_t *,
+                                        ID3D12Resource **texture,
+                                        std::unique_ptr<uint8_t[]> &,
+                                        D3D12_SUBRESOURCE_DATA &,
+                                        size_t) noexcept
+{
+    *texture = nullptr;
+    return E_NOTIMPL;
+}
@@ -0,0 +1,432 @@
+#pragma once
+
+// Scalar stand-in for the part of DirectXMath the tested modules use, DirectXMath itself isn't available
+// outside of Windows here. Same conventions: row vectors, matrices multiplied left to right, comparisons
+// returning all bits set per lane.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace DirectX
+{
+    struct XMVECTOR
+    {
+        union
+        {
+            float    f[4];
+            uint32_t u[4];
+        };
+    };
+
+    struct XMMATRIX
+    {
+        XMVECTOR r[4];
+    };
+
+    using FXMVECTOR = XMVECTOR;
+    using GXMVECTOR = XMVECTOR;
+    using HXMVECTOR = XMVECTOR;
+    using CXMVECTOR = const XMVECTOR &;
+    using FXMMATRIX = XMMATRIX;
+    using CXMMATRIX = const XMMATRIX &;
+
+    struct XMFLOAT2
+    {
+        float x, y;
+
+        XMFLOAT2() = default;
+        constexpr XMFLOAT2(float x_, float y_) : x(x_), y(y_) {}
+    };
+
+    struct XMFLOAT3
+    {
+        float x, y, z;
+
+        XMFLOAT3() = default;
+        constexpr XMFLOAT3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+    };
+
+    struct XMFLOAT4
+    {
+        float x, y, z, w;
+
+        XMFLOAT4() = default;
+        constexpr XMFLOAT4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+    };
+
+    struct XMFLOAT4X4
+    {
+        union
+        {
+            struct
+            {
+                float _11, _12, _13, _14;
+                float _21, _22, _23, _24;
+                float _31, _32, _33, _34;
+                float _41, _42, _43, _44;
+            };
+            float m[4][4];
+        };
+
+        float  operator()(size_t row, size_t column) const noexcept { return m[row][column]; }
+        float &operator()(size_t row, size_t column) noexcept { return m[row][column]; }
+    };
+
+    inline XMVECTOR XMVectorSet(float x, float y, float z, float w) noexcept
+    {
+        XMVECTOR v;
+        v.f[0] = x;
+        v.f[1] = y;
+        v.f[2] = z;
+        v.f[3] = w;
+        return v;
+    }
+
+    inline XMVECTOR XMVectorSetInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w) noexcept
+    {
+        XMVECTOR v;
+        v.u[0] = x;
+        v.u[1] = y;
+        v.u[2] = z;
+        v.u[3] = w;
+        return v;
+    }
+
+    inline XMVECTOR XMVectorZero() noexcept { return XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f); }
+    inline XMVECTOR XMVectorReplicate(float value) noexcept { return XMVectorSet(value, value, value, value); }
+    inline XMVECTOR XMVectorFalseInt() noexcept { return XMVectorSetInt(0, 0, 0, 0); }
+
+    inline float XMVectorGetX(FXMVECTOR v) noexcept { return v.f[0]; }
+    inline float XMVectorGetY(FXMVECTOR v) noexcept { return v.f[1]; }
+    inline float XMVectorGetZ(FXMVECTOR v) noexcept { return v.f[2]; }
+    inline float XMVectorGetW(FXMVECTOR v) noexcept { return v.f[3]; }
+
+    inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w) noexcept { return XMVectorSet(v.f[0], v.f[1], v.f[2], w); }
+
+    inline XMVECTOR XMVectorSplatX(FXMVECTOR v) noexcept { return XMVectorReplicate(v.f[0]); }
+    inline XMVECTOR XMVectorSplatY(FXMVECTOR v) noexcept { return XMVectorReplicate(v.f[1]); }
+    inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) noexcept { return XMVectorReplicate(v.f[2]); }
+    inline XMVECTOR XMVectorSplatW(FXMVECTOR v) noexcept { return XMVectorReplicate(v.f[3]); }
+
+    template <class Op> inline XMVECTOR XMVectorPerLane(FXMVECTOR a, FXMVECTOR b, Op op) noexcept
+    {
+        return XMVectorSet(op(a.f[0], b.f[0]), op(a.f[1], b.f[1]), op(a.f[2], b.f[2]), op(a.f[3], b.f[3]));
+    }
+
+    template <class Op> inline XMVECTOR XMVectorCompare(FXMVECTOR a, FXMVECTOR b, Op op) noexcept
+    {
+        XMVECTOR v;
+        for (int i = 0; i < 4; ++i)
+            v.u[i] = op(a.f[i], b.f[i]) ? 0xFFFFFFFFu : 0u;
+        return v;
+    }
+
+    inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x + y; });
+    }
+
+    inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x - y; });
+    }
+
+    inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x * y; });
+    }
+
+    inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x / y; });
+    }
+
+    inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) noexcept
+    {
+        return XMVectorAdd(XMVectorMultiply(a, b), c);
+    }
+
+    inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x > y ? x : y; });
+    }
+
+    inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorPerLane(a, b, [](float x, float y) { return x < y ? x : y; });
+    }
+
+    inline XMVECTOR XMVectorAbs(FXMVECTOR v) noexcept
+    {
+        return XMVectorSet(std::fabs(v.f[0]), std::fabs(v.f[1]), std::fabs(v.f[2]), std::fabs(v.f[3]));
+    }
+
+    inline XMVECTOR XMVectorLerp(FXMVECTOR v0, FXMVECTOR v1, float t) noexcept
+    {
+        return XMVectorMultiplyAdd(XMVectorSubtract(v1, v0), XMVectorReplicate(t), v0);
+    }
+
+    inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorCompare(a, b, [](float x, float y) { return x < y; });
+    }
+
+    inline XMVECTOR XMVectorGreater(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorCompare(a, b, [](float x, float y) { return x > y; });
+    }
+
+    inline XMVECTOR XMVectorGreaterOrEqual(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorCompare(a, b, [](float x, float y) { return x >= y; });
+    }
+
+    inline XMVECTOR XMVectorAndInt(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorSetInt(a.u[0] & b.u[0], a.u[1] & b.u[1], a.u[2] & b.u[2], a.u[3] & b.u[3]);
+    }
+
+    inline XMVECTOR XMVectorOrInt(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorSetInt(a.u[0] | b.u[0], a.u[1] | b.u[1], a.u[2] | b.u[2], a.u[3] | b.u[3]);
+    }
+
+    // Bits of b where the control is set, of a elsewhere
+    inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control) noexcept
+    {
+        XMVECTOR v;
+        for (int i = 0; i < 4; ++i)
+            v.u[i] = (a.u[i] & ~control.u[i]) | (b.u[i] & control.u[i]);
+        return v;
+    }
+
+    inline bool XMVector4Greater(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return a.f[0] > b.f[0] && a.f[1] > b.f[1] && a.f[2] > b.f[2] && a.f[3] > b.f[3];
+    }
+
+    inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) noexcept
+    {
+        return XMVectorReplicate(v.f[0] * v.f[0] + v.f[1] * v.f[1] + v.f[2] * v.f[2]);
+    }
+
+    inline XMVECTOR XMVector3Length(FXMVECTOR v) noexcept
+    {
+        return XMVectorReplicate(std::sqrt(XMVectorGetX(XMVector3LengthSq(v))));
+    }
+
+    inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorReplicate(a.f[0] * b.f[0] + a.f[1] * b.f[1] + a.f[2] * b.f[2]);
+    }
+
+    inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b) noexcept
+    {
+        return XMVectorSet(a.f[1] * b.f[2] - a.f[2] * b.f[1],
+                           a.f[2] * b.f[0] - a.f[0] * b.f[2],
+                           a.f[0] * b.f[1] - a.f[1] * b.f[0],
+                           0.0f);
+    }
+
+    inline XMVECTOR XMVector3Normalize(FXMVECTOR v) noexcept
+    {
+        float length = XMVectorGetX(XMVector3Length(v));
+        return length > 0.0f ? XMVectorMultiply(v, XMVectorReplicate(1.0f / length)) : XMVectorZero();
+    }
+
+    // w = 1
+    inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) noexcept
+    {
+        XMVECTOR result = m.r[3];
+        result          = XMVectorMultiplyAdd(XMVectorSplatZ(v), m.r[2], result);
+        result          = XMVectorMultiplyAdd(XMVectorSplatY(v), m.r[1], result);
+        return XMVectorMultiplyAdd(XMVectorSplatX(v), m.r[0], result);
+    }
+
+    inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m) noexcept
+    {
+        XMVECTOR result = XMVector3Transform(v, m);
+        return XMVectorDivide(result, XMVectorSplatW(result));
+    }
+
+    inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) noexcept
+    {
+        XMVECTOR result = XMVectorMultiply(XMVectorSplatW(v), m.r[3]);
+        result          = XMVectorMultiplyAdd(XMVectorSplatZ(v), m.r[2], result);
+        result          = XMVectorMultiplyAdd(XMVectorSplatY(v), m.r[1], result);
+        return XMVectorMultiplyAdd(XMVectorSplatX(v), m.r[0], result);
+    }
+
+    inline XMVECTOR XMLoadFloat3(const XMFLOAT3 *source) noexcept
+    {
+        return XMVectorSet(source->x, source->y, source->z, 0.0f);
+    }
+
+    inline XMVECTOR XMLoadFloat4(const XMFLOAT4 *source) noexcept
+    {
+        return XMVectorSet(source->x, source->y, source->z, source->w);
+    }
+
+    inline void XMStoreFloat3(XMFLOAT3 *destination, FXMVECTOR v) noexcept
+    {
+        *destination = XMFLOAT3(v.f[0], v.f[1], v.f[2]);
+    }
+
+    inline void XMStoreFloat4(XMFLOAT4 *destination, FXMVECTOR v) noexcept
+    {
+        *destination = XMFLOAT4(v.f[0], v.f[1], v.f[2], v.f[3]);
+    }
+
+    inline void XMStoreInt4(uint32_t *destination, FXMVECTOR v) noexcept { std::memcpy(destination, v.u, sizeof(v.u)); }
+
+    inline XMMATRIX XMMatrixSet(float m00,
+                                float m01,
+                                float m02,
+                                float m03,
+                                float m10,
+                                float m11,
+                                float m12,
+                                float m13,
+                                float m20,
+                                float m21,
+                                float m22,
+                                float m23,
+                                float m30,
+                                float m31,
+                                float m32,
+                                float m33) noexcept
+    {
+        return {XMVectorSet(m00, m01, m02, m03),
+                XMVectorSet(m10, m11, m12, m13),
+                XMVectorSet(m20, m21, m22, m23),
+                XMVectorSet(m30, m31, m32, m33)};
+    }
+
+    inline XMMATRIX XMMatrixIdentity() noexcept
+    {
+        return XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, 1.0f, 0.0f, 0.0f, // row 1
+                           0.0f, 0.0f, 1.0f, 0.0f, // row 2
+                           0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    inline XMMATRIX XMMatrixTranslation(float x, float y, float z) noexcept
+    {
+        XMMATRIX m = XMMatrixIdentity();
+        m.r[3]     = XMVectorSet(x, y, z, 1.0f);
+        return m;
+    }
+
+    inline XMMATRIX XMMatrixScaling(float x, float y, float z) noexcept
+    {
+        return XMMatrixSet(x, 0.0f, 0.0f, 0.0f, 0.0f, y, 0.0f, 0.0f, 0.0f, 0.0f, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    inline XMMATRIX XMMatrixRotationY(float angle) noexcept
+    {
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        return XMMatrixSet(c, 0.0f, -s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, s, 0.0f, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) noexcept
+    {
+        XMMATRIX result;
+        for (int i = 0; i < 4; ++i)
+            result.r[i] = XMVector4Transform(a.r[i], b);
+        return result;
+    }
+
+    inline XMMATRIX XMMatrixTranspose(FXMMATRIX m) noexcept
+    {
+        XMMATRIX result;
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                result.r[i].f[j] = m.r[j].f[i];
+        return result;
+    }
+
+    // Cofactor expansion, the determinant is returned replicated
+    inline XMMATRIX XMMatrixInverse(XMVECTOR *determinant, FXMMATRIX m) noexcept
+    {
+        float a[16];
+        for (int i = 0; i < 16; ++i)
+            a[i] = m.r[i / 4].f[i % 4];
+
+        float inv[16];
+        inv[0]  = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14]
+               + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+        inv[4]  = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14]
+               - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+        inv[8]  = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13]
+               + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+        inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13]
+                - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+        inv[1]  = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14]
+               - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+        inv[5]  = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14]
+               + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+        inv[9]  = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13]
+               - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+        inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13]
+                + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+        inv[2]  = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14]
+               + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+        inv[6]  = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14]
+               - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+        inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13]
+                + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+        inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13]
+                - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+        inv[3]  = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10]
+               - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+        inv[7]  = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10]
+               + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+        inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9]
+                - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+        inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9]
+                + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+        float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+        if (determinant)
+            *determinant = XMVectorReplicate(det);
+
+        XMMATRIX result;
+        for (int i = 0; i < 16; ++i)
+            result.r[i / 4].f[i % 4] = inv[i] / det;
+        return result;
+    }
+
+    inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4 *source) noexcept
+    {
+        XMMATRIX m;
+        for (int i = 0; i < 4; ++i)
+            m.r[i] = XMVectorSet(source->m[i][0], source->m[i][1], source->m[i][2], source->m[i][3]);
+        return m;
+    }
+
+    inline void XMStoreFloat4x4(XMFLOAT4X4 *destination, FXMMATRIX m) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                destination->m[i][j] = m.r[i].f[j];
+    }
+
+    inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) noexcept { return XMVectorAdd(a, b); }
+    inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) noexcept { return XMVectorSubtract(a, b); }
+    inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) noexcept { return XMVectorMultiply(a, b); }
+    inline XMVECTOR operator/(FXMVECTOR a, FXMVECTOR b) noexcept { return XMVectorDivide(a, b); }
+    inline XMVECTOR operator*(FXMVECTOR v, float s) noexcept { return XMVectorMultiply(v, XMVectorReplicate(s)); }
+    inline XMVECTOR operator*(float s, FXMVECTOR v) noexcept { return XMVectorMultiply(v, XMVectorReplicate(s)); }
+    inline XMVECTOR operator/(FXMVECTOR v, float s) noexcept { return XMVectorDivide(v, XMVectorReplicate(s)); }
+    inline XMVECTOR operator-(FXMVECTOR v) noexcept { return XMVectorSubtract(XMVectorZero(), v); }
+
+    inline XMVECTOR &operator+=(XMVECTOR &a, FXMVECTOR b) noexcept { return a = a + b; }
+    inline XMVECTOR &operator-=(XMVECTOR &a, FXMVECTOR b) noexcept { return a = a - b; }
+    inline XMVECTOR &operator*=(XMVECTOR &a, FXMVECTOR b) noexcept { return a = a * b; }
+    inline XMVECTOR &operator*=(XMVECTOR &a, float s) noexcept { return a = a * s; }
+
+    inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) noexcept { return XMMatrixMultiply(a, b); }
+    inline XMMATRIX &operator*=(XMMATRIX &a, CXMMATRIX b) noexcept { return a = XMMatrixMultiply(a, b); }
+} // namespace DirectX
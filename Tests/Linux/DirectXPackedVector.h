@@ -0,0 +1,82 @@
+#pragma once
+
+// Scalar half conversions matching DirectXMath's non-F16C code path, rounding to nearest even
+
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+    namespace PackedVector
+    {
+        using HALF = uint16_t;
+
+        inline HALF XMConvertFloatToHalf(float value) noexcept
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            uint32_t sign   = (bits & 0x80000000u) >> 16u;
+            uint32_t result = 0;
+            bits            = bits & 0x7FFFFFFFu;
+            if (bits > 0x7F800000u)
+            {
+                // NaN keeps some of its payload
+                result = 0x7C00u | ((bits >> 13u) & 0x3FFu) | 0x200u;
+            }
+            else if (bits >= 0x47800000u)
+            {
+                // Too large becomes infinity
+                result = 0x7C00u;
+            }
+            else
+            {
+                if (bits < 0x38800000u)
+                {
+                    // Denormal in half precision
+                    uint32_t shift = 113u - (bits >> 23u);
+                    bits           = shift < 24u ? (0x800000u | (bits & 0x7FFFFFu)) >> shift : 0u;
+                }
+                else
+                {
+                    bits += 0xC8000000u;
+                }
+                result = ((bits + 0x0FFFu + ((bits >> 13u) & 1u)) >> 13u) & 0x7FFFu;
+            }
+            return static_cast<HALF>(result | sign);
+        }
+
+        inline float XMConvertHalfToFloat(HALF value) noexcept
+        {
+            uint32_t mantissa = value & 0x03FFu;
+            uint32_t exponent = value & 0x7C00u;
+            if (exponent == 0x7C00u)
+            {
+                exponent = 0x8Fu;
+            }
+            else if (exponent != 0)
+            {
+                exponent = (value >> 10u) & 0x1Fu;
+            }
+            else if (mantissa != 0)
+            {
+                // Normalizes the denormal
+                exponent = 1;
+                do
+                {
+                    --exponent;
+                    mantissa <<= 1u;
+                } while ((mantissa & 0x0400u) == 0);
+                mantissa &= 0x03FFu;
+            }
+            else
+            {
+                exponent = static_cast<uint32_t>(-112);
+            }
+
+            uint32_t bits = ((value & 0x8000u) << 16u) | ((exponent + 112u) << 23u) | (mantissa << 13u);
+            float    result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+    } // namespace PackedVector
+} // namespace DirectX
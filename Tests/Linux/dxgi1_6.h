@@ -0,0 +1,81 @@
+#pragma once
+
+// The DXGI declarations CommandQueue's swap chain helper names. DXGI doesn't exist outside of Windows, so none of
+// these can be created, the tests never get to a swap chain.
+
+#include <dxgicommon.h>
+#include <dxgiformat.h>
+
+typedef UINT DXGI_USAGE;
+
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT (1UL << (1 + 4))
+#define DXGI_MWA_NO_ALT_ENTER           (1 << 1)
+
+enum DXGI_SCALING
+{
+    DXGI_SCALING_STRETCH              = 0,
+    DXGI_SCALING_NONE                 = 1,
+    DXGI_SCALING_ASPECT_RATIO_STRETCH = 2
+};
+
+enum DXGI_SWAP_EFFECT
+{
+    DXGI_SWAP_EFFECT_DISCARD         = 0,
+    DXGI_SWAP_EFFECT_SEQUENTIAL      = 1,
+    DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL = 3,
+    DXGI_SWAP_EFFECT_FLIP_DISCARD    = 4
+};
+
+enum DXGI_ALPHA_MODE
+{
+    DXGI_ALPHA_MODE_UNSPECIFIED   = 0,
+    DXGI_ALPHA_MODE_PREMULTIPLIED = 1,
+    DXGI_ALPHA_MODE_STRAIGHT      = 2,
+    DXGI_ALPHA_MODE_IGNORE        = 3
+};
+
+enum DXGI_SWAP_CHAIN_FLAG
+{
+    DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING = 2048
+};
+
+struct DXGI_SWAP_CHAIN_DESC1
+{
+    UINT             Width;
+    UINT             Height;
+    DXGI_FORMAT      Format;
+    BOOL             Stereo;
+    DXGI_SAMPLE_DESC SampleDesc;
+    DXGI_USAGE       BufferUsage;
+    UINT             BufferCount;
+    DXGI_SCALING     Scaling;
+    DXGI_SWAP_EFFECT SwapEffect;
+    DXGI_ALPHA_MODE  AlphaMode;
+    UINT             Flags;
+};
+
+struct DXGI_SWAP_CHAIN_FULLSCREEN_DESC;
+struct IDXGIOutput;
+
+struct IDXGISwapChain1 : public IUnknown
+{
+};
+
+struct IDXGISwapChain4 : public IDXGISwapChain1
+{
+};
+
+struct IDXGIFactory4 : public IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE CreateSwapChainForHwnd(IUnknown                              *device,
+                                                             HWND                                   hWnd,
+                                                             const DXGI_SWAP_CHAIN_DESC1           *desc,
+                                                             const DXGI_SWAP_CHAIN_FULLSCREEN_DESC *fullscreenDesc,
+                                                             IDXGIOutput                           *restrictToOutput,
+                                                             IDXGISwapChain1                      **swapChain) = 0;
+    virtual HRESULT STDMETHODCALLTYPE MakeWindowAssociation(HWND windowHandle, UINT flags)                 = 0;
+};
+
+__CRT_UUID_DECL(IDXGISwapChain1, 0x790a45f7, 0x0d42, 0x4876, 0x98, 0x3a, 0x0a, 0x55, 0xcf, 0xe6, 0xf4, 0xaa)
+__CRT_UUID_DECL(IDXGISwapChain4, 0x3d585d5a, 0xbd4a, 0x489e, 0xb1, 0xf4, 0x3d, 0xbc, 0xb6, 0x45, 0x2f, 0xfb)
+__CRT_UUID_DECL(IDXGIFactory4, 0x1bc6ea02, 0xef36, 0x464f, 0xbf, 0x0c, 0x21, 0xca, 0x39, 0xe5, 0x16, 0x8a)
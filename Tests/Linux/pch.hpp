@@ -0,0 +1,88 @@
+#pragma once
+
+// Stands in for the root pch.hpp when the modules are built for the tests outside of Windows. The D3D12 types
+// come from the WSL adapter of DirectX-Headers, DirectXMath and DXGI from the headers next to this one and the
+// Windows and DirectXTK12 functions the modules call from Compat.cpp.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <codecvt>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <ios>
+#include <iostream>
+#include <locale>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <wsl/winadapter.h>
+#include <wsl/wrladapter.h>
+
+#include <d3d12.h>
+#include <d3dx12.h>
+#include <dxgi1_6.h>
+#include <dxguids/dxguids.h>
+
+#include <DirectXMath.h>
+#include <directxtk12/DescriptorHeap.h>
+#include <directxtk12/WICTextureLoader.h>
+
+using std::size_t;
+using std::uint64_t;
+
+using Microsoft::WRL::ComPtr;
+
+using PFactory   = ComPtr<IDXGIFactory4>;
+using PDevice    = ComPtr<ID3D12Device2>;
+using PSwapChain = ComPtr<IDXGISwapChain4>;
+using PFence     = ComPtr<ID3D12Fence>;
+
+using PCommandAllocator    = ComPtr<ID3D12CommandAllocator>;
+using PCommandQueue        = ComPtr<ID3D12CommandQueue>;
+using PGraphicsCommandList = ComPtr<ID3D12GraphicsCommandList>;
+
+using PHeap          = ComPtr<ID3D12Heap>;
+using PPipelineState = ComPtr<ID3D12PipelineState>;
+using PResource      = ComPtr<ID3D12Resource>;
+using PRootSignature = ComPtr<ID3D12RootSignature>;
+
+using DirectX::DescriptorHeap;
+
+#define DWORD_MAX 0xFFFFFFFFul
+
+// Windows functions of the modules, without a GPU there is never anything to wait for
+HANDLE CreateEventW(void *attributes, BOOL manualReset, BOOL initialState, const wchar_t *name);
+DWORD  WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+BOOL   CloseHandle(HANDLE handle);
+void   OutputDebugStringA(const char *message);
+void   OutputDebugStringW(const wchar_t *message);
+
+// MSVC's std::exception takes a message and the modules throw it like that. Every standard header is included
+// above, so only the uses in the modules are replaced.
+#define exception(message) runtime_error(message)
@@ -0,0 +1,229 @@
+#include "Check.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/MeshOptimizer.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t GRID_SIZE = 200; // 80k triangles
+
+    // Triangles by their vertex positions, rotated to start at the smallest one so the winding is kept
+    using Triangle = std::array<std::tuple<float, float, float>, 3>;
+
+    std::vector<Triangle> Triangles(const MeshData &mesh)
+    {
+        auto                  vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        std::vector<uint32_t> indices  = mesh.GetIndices();
+        std::vector<Triangle> triangles;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            Triangle triangle;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const XMFLOAT3 &p = vertices[indices[t + k]].pos;
+                triangle[k]       = {p.x, p.y, p.z};
+            }
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        return triangles;
+    }
+
+    std::vector<Triangle> SortedTriangles(const MeshData &mesh)
+    {
+        std::vector<Triangle> triangles = Triangles(mesh);
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Grid with its triangles and vertices shuffled, the worst case for the post-transform cache. The height
+    // makes the overdraw pass see different facings.
+    MeshData ShuffledGrid(size_t n, size_t indexSize, size_t unusedVertices = 0)
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        MakeGrid(n, positions, indices);
+
+        std::mt19937          random(5);
+        std::vector<uint32_t> order(positions.size() + unusedVertices);
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), random);
+
+        std::vector<VertexData> vertices(order.size());
+        for (size_t v = 0; v < order.size(); ++v)
+        {
+            // The unused vertices sit below the grid where no triangle has a corner
+            XMFLOAT3 p         = order[v] < positions.size() ? positions[order[v]] : XMFLOAT3(0.0f, -1.0f, float(v));
+            vertices[v].pos    = XMFLOAT3(p.x, std::sin(p.x * 0.3f) * std::cos(p.z * 0.2f) * 4.0f, p.z);
+            vertices[v].normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+            vertices[v].uv     = XMFLOAT2(p.x, p.z);
+        }
+        std::vector<uint32_t> inverse(order.size());
+        for (size_t v = 0; v < order.size(); ++v)
+            inverse[order[v]] = static_cast<uint32_t>(v);
+
+        std::vector<size_t> triangleOrder(indices.size() / 3);
+        std::iota(triangleOrder.begin(), triangleOrder.end(), size_t(0));
+        std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+        std::vector<uint32_t> shuffled;
+        for (size_t t : triangleOrder)
+            for (size_t k = 0; k < 3; ++k)
+                shuffled.push_back(inverse[indices[t * 3 + k]]);
+
+        MeshData mesh;
+        mesh.InitVertices(vertices.data(), vertices.size());
+        mesh.SetIndices(shuffled, indexSize);
+        return mesh;
+    }
+
+    void TestAnalyzeVertexCache()
+    {
+        uint32_t         twice[] = {0, 1, 2, 2, 1, 0};
+        VertexCacheStats stats   = MeshOptimizer::AnalyzeVertexCache(twice, 6, 3);
+        CHECK(stats.TriangleCount == 2);
+        CHECK(stats.Misses == 3);
+        CHECK(stats.ACMR() == 1.5);
+        CHECK(stats.ATVR() == 1.0);
+
+        // Vertex 0 is pushed out of a cache of 4 by the time it comes back
+        uint32_t evicted[] = {0, 1, 2, 3, 4, 5, 0, 4, 5};
+        CHECK(MeshOptimizer::AnalyzeVertexCache(evicted, 9, 6, 4).Misses == 7);
+        CHECK(MeshOptimizer::AnalyzeVertexCache(evicted, 9, 6, 8).Misses == 6);
+    }
+
+    void TestOptimize(size_t indexSize)
+    {
+        MeshData mesh        = ShuffledGrid(GRID_SIZE, indexSize);
+        size_t   vertexCount = mesh.VertexCount();
+        auto     triangles   = SortedTriangles(mesh);
+
+        VertexCacheStats before;
+        VertexCacheStats after;
+        MeshOptimizer::Optimize(mesh, before, after);
+        std::printf("%zu-bit indices: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+                    indexSize * 8,
+                    before.ACMR(),
+                    after.ACMR(),
+                    before.ATVR(),
+                    after.ATVR());
+
+        CHECK(before.TriangleCount == GRID_SIZE * GRID_SIZE * 2);
+        CHECK(after.TriangleCount == before.TriangleCount);
+        CHECK(before.ACMR() > 2.5);
+        CHECK(after.ACMR() < 0.8);
+        CHECK(after.ATVR() < 1.5);
+        std::vector<uint32_t> indices = mesh.GetIndices();
+        CHECK(MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount).Misses == after.Misses);
+
+        CHECK(mesh.SingleIndexSize() == indexSize);
+        CHECK(mesh.VertexCount() == vertexCount);
+        CHECK(SortedTriangles(mesh) == triangles);
+
+        // Vertices are stored in the order of first use
+        uint32_t next = 0;
+        for (uint32_t index : indices)
+        {
+            CHECK(index <= next);
+            next = (std::max)(next, index + 1);
+        }
+    }
+
+    void TestUnusedVertices()
+    {
+        MeshData mesh      = ShuffledGrid(10, sizeof(uint32_t), 7);
+        auto     triangles = SortedTriangles(mesh);
+        CHECK(mesh.VertexCount() == 11 * 11 + 7);
+
+        VertexCacheStats before;
+        VertexCacheStats after;
+        MeshOptimizer::Optimize(mesh, before, after);
+        CHECK(mesh.VertexCount() == 11 * 11);
+        CHECK(SortedTriangles(mesh) == triangles);
+    }
+
+    void TestPasses()
+    {
+        MeshData              mesh      = ShuffledGrid(50, sizeof(uint32_t));
+        std::vector<uint32_t> indices   = mesh.GetIndices();
+        auto                  triangles = SortedTriangles(mesh);
+        auto                  acmr      = [&] {
+            return MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), mesh.VertexCount()).ACMR();
+        };
+
+        // Every pass only reorders whole triangles
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), mesh.VertexCount());
+        mesh.SetIndices(indices, sizeof(uint32_t));
+        CHECK(SortedTriangles(mesh) == triangles);
+        double cacheAcmr = acmr();
+
+        MeshOptimizer::OptimizeOverdraw(
+            indices.data(), indices.size(), mesh.VertexBufferStart(), mesh.SingleVertexSize(), mesh.VertexCount());
+        mesh.SetIndices(indices, sizeof(uint32_t));
+        CHECK(SortedTriangles(mesh) == triangles);
+        CHECK(acmr() <= cacheAcmr * MeshOptimizer::OVERDRAW_THRESHOLD + 0.05);
+
+        uint32_t              used[] = {3, 1, 3, 4, 1, 0};
+        std::vector<uint32_t> remap  = MeshOptimizer::VertexFetchRemap(used, 6, 6);
+        CHECK((remap == std::vector<uint32_t>{3, 1, UINT32_MAX, 0, 2, UINT32_MAX}));
+    }
+
+    void TestNarrowIndices()
+    {
+        std::vector<VertexData> vertices(MeshOptimizer::MAX_16BIT_VERTICES + 1);
+        std::vector<uint32_t>   indices = {0, 1, static_cast<uint32_t>(MeshOptimizer::MAX_16BIT_VERTICES - 1)};
+
+        MeshData fits;
+        fits.InitVertices(vertices.data(), MeshOptimizer::MAX_16BIT_VERTICES);
+        fits.SetIndices(indices, sizeof(uint32_t));
+        CHECK(MeshOptimizer::NarrowIndices(fits));
+        CHECK(fits.SingleIndexSize() == sizeof(uint16_t));
+        CHECK(fits.GetIndices() == indices);
+
+        MeshData tooLarge;
+        tooLarge.InitVertices(vertices.data(), vertices.size());
+        tooLarge.SetIndices(indices, sizeof(uint32_t));
+        CHECK(!MeshOptimizer::NarrowIndices(tooLarge));
+        CHECK(tooLarge.SingleIndexSize() == sizeof(uint32_t));
+    }
+
+    void TestSplit()
+    {
+        MeshData mesh      = ShuffledGrid(100, sizeof(uint32_t));
+        auto     triangles = Triangles(mesh);
+
+        std::vector<MeshData> parts = MeshOptimizer::Split(mesh, 1000);
+        CHECK(parts.size() > 1);
+
+        // Triangle order is kept across the parts, every vertex of a part is used
+        std::vector<Triangle> joined;
+        for (auto &&part : parts)
+        {
+            CHECK(part.VertexCount() <= 1000);
+            CHECK(part.SingleIndexSize() == sizeof(uint32_t));
+            std::vector<uint32_t> indices = part.GetIndices();
+            std::vector<uint32_t> remap =
+                MeshOptimizer::VertexFetchRemap(indices.data(), indices.size(), part.VertexCount());
+            CHECK(std::count(remap.begin(), remap.end(), UINT32_MAX) == 0);
+
+            auto partTriangles = Triangles(part);
+            joined.insert(joined.end(), partTriangles.begin(), partTriangles.end());
+        }
+        CHECK(joined == triangles);
+
+        CHECK(MeshOptimizer::Split(mesh).size() == 1);
+    }
+} // namespace
+
+int main()
+{
+    TestAnalyzeVertexCache();
+    TestOptimize(sizeof(uint32_t));
+    TestOptimize(sizeof(uint16_t));
+    TestUnusedVertices();
+    TestPasses();
+    TestNarrowIndices();
+    TestSplit();
+    return TestResult();
+}
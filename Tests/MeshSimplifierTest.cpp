@@ -0,0 +1,208 @@
+#include "Check.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/MeshSimplifier.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t GRID_SIZE = 100; // 20k triangles
+
+    // Gently rolling grid. With a seam the triangles right of the middle column use copies of its vertices
+    // with other UVs, like a texture seam.
+    MeshData RollingGrid(size_t n, bool seam, std::vector<uint32_t> &seamVertices)
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        MakeGrid(n, positions, indices);
+
+        std::vector<VertexData> vertices(positions.size());
+        for (size_t v = 0; v < positions.size(); ++v)
+        {
+            XMFLOAT3 p         = positions[v];
+            vertices[v].pos    = XMFLOAT3(p.x, std::sin(p.x * 0.15f) * std::cos(p.z * 0.1f) * 3.0f, p.z);
+            vertices[v].normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+            vertices[v].uv     = XMFLOAT2(p.x, p.z);
+        }
+
+        seamVertices.clear();
+        if (seam)
+        {
+            float                 middle = static_cast<float>(n / 2);
+            std::vector<uint32_t> copies(positions.size(), UINT32_MAX);
+            for (size_t t = 0; t < indices.size(); t += 3)
+            {
+                float right = positions[indices[t]].x + positions[indices[t + 1]].x + positions[indices[t + 2]].x;
+                if (right <= middle * 3.0f)
+                    continue;
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    uint32_t &index = indices[t + k];
+                    if (positions[index].x != middle)
+                        continue;
+                    if (copies[index] == UINT32_MAX)
+                    {
+                        copies[index] = static_cast<uint32_t>(vertices.size());
+                        VertexData copy = vertices[index];
+                        copy.uv.x       += 0.5f;
+                        vertices.push_back(copy);
+                        seamVertices.insert(seamVertices.end(), {index, copies[index]});
+                    }
+                    index = copies[index];
+                }
+            }
+        }
+
+        MeshData mesh;
+        mesh.InitData(vertices.data(), vertices.size(), indices.data(), indices.size());
+        return mesh;
+    }
+
+    // Vertices on the outline of the grid
+    std::vector<uint32_t> BorderVertices(const MeshData &mesh, size_t n)
+    {
+        auto                  vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        float                 last     = static_cast<float>(n);
+        std::vector<uint32_t> border;
+        for (uint32_t v = 0; v < mesh.VertexCount(); ++v)
+        {
+            const XMFLOAT3 &p = vertices[v].pos;
+            if (p.x == 0.0f || p.z == 0.0f || p.x == last || p.z == last)
+                border.push_back(v);
+        }
+        return border;
+    }
+
+    void TestLods()
+    {
+        std::vector<uint32_t> seamVertices;
+        MeshData              mesh     = RollingGrid(GRID_SIZE, true, seamVertices);
+        std::vector<uint32_t> original = mesh.GetIndices();
+        std::vector<uint32_t> border   = BorderVertices(mesh, GRID_SIZE);
+        CHECK(seamVertices.size() == (GRID_SIZE + 1) * 2);
+
+        MeshSimplifier::GenerateLods(mesh);
+        auto                  vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        std::vector<uint32_t> indices  = mesh.GetIndices();
+        CHECK(mesh.m_Lods.size() == MeshSimplifier::MAX_LODS);
+        CHECK(!mesh.m_Lods.empty() && mesh.m_Lods[0].IndexOffset == 0);
+        CHECK(!mesh.m_Lods.empty() && mesh.m_Lods[0].IndexCount == original.size());
+        CHECK(!mesh.m_Lods.empty() && mesh.m_Lods[0].Error == 0.0f);
+        CHECK(std::equal(original.begin(), original.end(), indices.begin()));
+
+        uint32_t nextOffset = 0;
+        float    target     = static_cast<float>(original.size());
+        for (size_t level = 0; level < mesh.m_Lods.size(); ++level)
+        {
+            const MeshLod &lod = mesh.m_Lods[level];
+            std::printf("level %zu: %6u indices, error %.4f\n", level, lod.IndexCount, lod.Error);
+
+            // The levels are appended one after the other and fill the index buffer
+            CHECK(lod.IndexOffset == nextOffset);
+            CHECK(lod.IndexCount % 3 == 0);
+            nextOffset = lod.IndexOffset + lod.IndexCount;
+            CHECK(nextOffset <= indices.size());
+            if (nextOffset > indices.size())
+                break;
+
+            // Every level is about LOD_RATIO of the one before, the locked outline keeps it from getting much lower
+            CHECK(lod.IndexCount <= target * 1.05f);
+            CHECK(lod.IndexCount >= target * 0.8f);
+            target *= MeshSimplifier::LOD_RATIO;
+            if (level != 0)
+                CHECK(lod.Error >= mesh.m_Lods[level - 1].Error);
+
+            std::vector<bool> used(mesh.VertexCount(), false);
+            bool              inRange = true;
+            for (uint32_t i = lod.IndexOffset; i < nextOffset; ++i)
+            {
+                inRange = inRange && indices[i] < mesh.VertexCount();
+                if (indices[i] < mesh.VertexCount())
+                    used[indices[i]] = true;
+            }
+            CHECK(inRange);
+
+            // Seam and border vertices are locked, every one of them keeps its place in every level
+            CHECK(std::all_of(border.begin(), border.end(), [&](uint32_t v) { return used[v]; }));
+            CHECK(std::all_of(seamVertices.begin(), seamVertices.end(), [&](uint32_t v) { return used[v]; }));
+
+            // No triangle turns over, seen from above none of them faces down. Chains of collapses leave a few
+            // vertical slivers, those are allowed.
+            size_t flipped = 0;
+            for (uint32_t i = lod.IndexOffset; inRange && i < nextOffset; i += 3)
+            {
+                XMFLOAT3 p0 = vertices[indices[i]].pos;
+                XMFLOAT3 p1 = vertices[indices[i + 1]].pos;
+                XMFLOAT3 p2 = vertices[indices[i + 2]].pos;
+                float    y  = (p1.z - p0.z) * (p2.x - p0.x) - (p1.x - p0.x) * (p2.z - p0.z);
+                flipped    += y < 0.0f;
+            }
+            CHECK(flipped == 0);
+        }
+        CHECK(nextOffset == indices.size());
+    }
+
+    // Simplify on its own reaches the target and reports the error it made
+    void TestSimplify()
+    {
+        std::vector<uint32_t> seamVertices;
+        MeshData              mesh    = RollingGrid(GRID_SIZE, false, seamVertices);
+        std::vector<uint32_t> indices = mesh.GetIndices();
+
+        float                 error      = -1.0f;
+        size_t                target     = indices.size() / 4;
+        std::vector<uint32_t> simplified = MeshSimplifier::Simplify(indices.data(),
+                                                                    indices.size(),
+                                                                    mesh.VertexBufferStart(),
+                                                                    mesh.SingleVertexSize(),
+                                                                    mesh.VertexCount(),
+                                                                    target,
+                                                                    &error);
+        CHECK(simplified.size() <= target);
+        CHECK(simplified.size() >= target * 3 / 4);
+        CHECK(error > 0.0f && error < 3.0f);
+
+        // A flat grid collapses without any error
+        std::vector<XMFLOAT3> positions;
+        MakeGrid(GRID_SIZE, positions, indices);
+        simplified = MeshSimplifier::Simplify(
+            indices.data(), indices.size(), positions.data(), sizeof(XMFLOAT3), positions.size(), target, &error);
+        CHECK(simplified.size() <= target);
+        CHECK(error == 0.0f);
+    }
+
+    // Levels that remove too little end the chain, when nothing can go there are no levels at all
+    void TestChainEnd()
+    {
+        std::vector<uint32_t> seamVertices;
+        MeshData              locked   = RollingGrid(1, false, seamVertices);
+        std::vector<uint32_t> original = locked.GetIndices();
+        MeshSimplifier::GenerateLods(locked);
+        CHECK(locked.m_Lods.empty());
+        CHECK(locked.GetIndices() == original);
+
+        // Only the 9 inner vertices of a 4 x 4 grid can go, that allows one or two levels
+        MeshData small = RollingGrid(4, false, seamVertices);
+        MeshSimplifier::GenerateLods(small);
+        CHECK(small.m_Lods.size() >= 2);
+        CHECK(small.m_Lods.size() < MeshSimplifier::MAX_LODS);
+        for (size_t level = 1; level < small.m_Lods.size(); ++level)
+            CHECK(small.m_Lods[level].IndexCount <= small.m_Lods[level - 1].IndexCount * 0.85f);
+
+        MeshData single = RollingGrid(GRID_SIZE, false, seamVertices);
+        MeshSimplifier::GenerateLods(single, 1);
+        CHECK(single.m_Lods.empty());
+
+        single.m_VertexFormat = VERTEX_FORMAT_COMPACT;
+        CHECK_THROWS(MeshSimplifier::GenerateLods(single));
+    }
+} // namespace
+
+int main()
+{
+    TestLods();
+    TestSimplify();
+    TestChainEnd();
+    return TestResult();
+}
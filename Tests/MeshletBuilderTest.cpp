@@ -0,0 +1,292 @@
+#include "Check.hpp"
+
+#include "MyDXLib/MeshOptimizer.hpp"
+#include "MyDXLib/MeshletBuilder.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float PI = 3.14159265f;
+
+    XMFLOAT3 Sub(const XMFLOAT3 &a, const XMFLOAT3 &b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    // Left handed perspective with w = view depth, like Camera::CalcProjection
+    XMMATRIX Perspective(float nearPlane, float farPlane)
+    {
+        float a = farPlane / (farPlane - nearPlane);
+        return XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, 1.0f, 0.0f, 0.0f, // row 1
+                           0.0f, 0.0f, a, 1.0f,    // row 2
+                           0.0f, 0.0f, -a * nearPlane, 0.0f);
+    }
+
+    // UV sphere of the given radius around the origin with outward normals. Rows of quads go around
+    // the axis, the rows at the poles are triangle fans.
+    MeshData MakeSphere(float radius, size_t rings, size_t segments)
+    {
+        std::vector<VertexData> vertices;
+        for (size_t r = 0; r <= rings; ++r)
+        {
+            float theta = PI * r / rings;
+            for (size_t s = 0; s <= segments; ++s)
+            {
+                float      phi = 2.0f * PI * s / segments;
+                XMFLOAT3   n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                VertexData v  = {};
+                v.pos         = XMFLOAT3(n.x * radius, n.y * radius, n.z * radius);
+                v.normal      = n;
+                v.uv          = XMFLOAT2(static_cast<float>(s) / segments, static_cast<float>(r) / rings);
+                vertices.push_back(v);
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        auto vertex = [&](size_t r, size_t s) { return static_cast<uint32_t>(r * (segments + 1) + s); };
+        for (size_t r = 0; r < rings; ++r)
+        {
+            for (size_t s = 0; s < segments; ++s)
+            {
+                if (r != 0)
+                    indices.insert(indices.end(), {vertex(r, s), vertex(r, s + 1), vertex(r + 1, s)});
+                if (r + 1 != rings)
+                    indices.insert(indices.end(), {vertex(r, s + 1), vertex(r + 1, s + 1), vertex(r + 1, s)});
+            }
+        }
+
+        // Cache order keeps the meshlets compact patches instead of long strips along the rows
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+        MeshData mesh;
+        mesh.InitData(vertices.data(), vertices.size(), indices.data(), indices.size());
+        return mesh;
+    }
+
+    // Corners of the triangles of a meshlet through its vertex list and local indices
+    std::vector<const VertexData *> MeshletCorners(const MeshData &mesh, const Meshlet &meshlet)
+    {
+        auto                            vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+        std::vector<const VertexData *> corners;
+        for (size_t i = 0; i < meshlet.TriangleCount * 3; ++i)
+        {
+            uint8_t local = mesh.m_MeshletTriangles[meshlet.TriangleOffset * 3 + i];
+            corners.push_back(&vertices[mesh.m_MeshletVertices[meshlet.VertexOffset + local]]);
+        }
+        return corners;
+    }
+
+    // Face normal oriented by the vertex normals, the way ComputeBounds does it
+    XMFLOAT3 FaceNormal(const VertexData *const *corners)
+    {
+        XMFLOAT3 n = Cross(Sub(corners[1]->pos, corners[0]->pos), Sub(corners[2]->pos, corners[0]->pos));
+        if (Dot(n, corners[0]->normal) + Dot(n, corners[1]->normal) + Dot(n, corners[2]->normal) < 0.0f)
+            n = XMFLOAT3(-n.x, -n.y, -n.z);
+        return n;
+    }
+
+    void TestSphereMeshlets()
+    {
+        MeshData mesh = MakeSphere(2.0f, 48, 96);
+        MeshletBuilder::Build(mesh);
+        std::vector<uint32_t> indices = mesh.GetIndices();
+        CHECK(!mesh.m_Meshlets.empty());
+
+        // The meshlets are consecutive ranges of the index buffer, their local triangles are the same triangles
+        uint32_t indexOffset = 0;
+        size_t   coneCount   = 0;
+        for (auto &&meshlet : mesh.m_Meshlets)
+        {
+            CHECK(meshlet.IndexOffset == indexOffset);
+            CHECK(meshlet.VertexCount <= MeshletBuilder::MAX_VERTICES);
+            CHECK(meshlet.TriangleCount <= MeshletBuilder::MAX_TRIANGLES);
+            CHECK(meshlet.TriangleCount > 0);
+
+            auto vertices = static_cast<const VertexData *>(mesh.VertexBufferStart());
+            auto corners  = MeshletCorners(mesh, meshlet);
+            for (size_t i = 0; i < corners.size(); ++i)
+            {
+                CHECK(corners[i] == &vertices[indices[meshlet.IndexOffset + i]]);
+
+                XMFLOAT3 d = Sub(corners[i]->pos, XMFLOAT3(meshlet.Sphere.x, meshlet.Sphere.y, meshlet.Sphere.z));
+                CHECK(std::sqrt(Dot(d, d)) <= meshlet.Sphere.w * 1.0001f);
+            }
+            indexOffset += meshlet.TriangleCount * 3;
+            coneCount   += meshlet.Cone.w < 1.0f;
+        }
+        CHECK(indexOffset == mesh.IndexCount());
+        CHECK(mesh.m_MeshletTriangles.size() == mesh.IndexCount());
+        // Small patches of a sphere are nearly flat, every one of them gets a cone
+        CHECK(coneCount == mesh.m_Meshlets.size());
+    }
+
+    // A meshlet the cone culls must not have a single triangle facing the camera. From outside, up to half of the
+    // sphere faces away, the cones of the patches catch a good part of that.
+    void TestSphereCones()
+    {
+        MeshData mesh = MakeSphere(2.0f, 48, 96);
+        MeshletBuilder::Build(mesh);
+
+        std::mt19937                          random(3);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        size_t                                cameras = 0;
+        size_t                                culled  = 0;
+        while (cameras < 200)
+        {
+            // From right outside of the sphere up to far away
+            XMFLOAT3 direction(distribution(random), distribution(random), distribution(random));
+            float    length = std::sqrt(Dot(direction, direction));
+            if (length < 0.01f)
+                continue;
+            ++cameras;
+            float       distance = 2.5f + 100.0f * (distribution(random) + 1.0f);
+            MeshletView view     = {};
+            view.CameraPos       = XMFLOAT3(direction.x * distance / length,
+                                      direction.y * distance / length,
+                                      direction.z * distance / length);
+
+            for (auto &&meshlet : mesh.m_Meshlets)
+            {
+                if (!MeshletBuilder::IsBackFacing(meshlet, view))
+                    continue;
+                ++culled;
+                auto corners = MeshletCorners(mesh, meshlet);
+                for (size_t t = 0; t < corners.size(); t += 3)
+                    CHECK(Dot(FaceNormal(&corners[t]), Sub(view.CameraPos, corners[t]->pos)) <= 1e-4f);
+            }
+        }
+        CHECK(culled > cameras * mesh.m_Meshlets.size() / 4);
+        CHECK(culled < cameras * mesh.m_Meshlets.size() / 2);
+    }
+
+    // The frustum test may keep meshlets that are outside, but never drops one with a corner inside
+    void TestSphereFrustum()
+    {
+        MeshData mesh = MakeSphere(2.0f, 48, 96);
+        MeshletBuilder::Build(mesh);
+
+        XMMATRIX projection = Perspective(0.5f, 50.0f);
+        for (float x : {0.0f, 3.0f, 6.0f, 20.0f})
+        {
+            // Sphere 6 units in front of the camera, moved sideways out of view step by step
+            XMMATRIX    modelView = XMMatrixTranslation(x, 0.0f, 6.0f);
+            XMMATRIX    clip      = XMMatrixMultiply(modelView, projection);
+            MeshletView view      = MeshletView::FromMatrices(modelView, projection);
+            CHECK(std::abs(view.CameraPos.x + x) < 1e-4f && std::abs(view.CameraPos.z + 6.0f) < 1e-4f);
+
+            size_t inFrustum = 0;
+            for (auto &&meshlet : mesh.m_Meshlets)
+            {
+                bool visible = false;
+                for (const VertexData *corner : MeshletCorners(mesh, meshlet))
+                {
+                    XMFLOAT4 p;
+                    XMStoreFloat4(&p, XMVector3Transform(XMLoadFloat3(&corner->pos), clip));
+                    visible |= std::abs(p.x) <= p.w && std::abs(p.y) <= p.w && p.z >= 0.0f && p.z <= p.w;
+                }
+                bool kept  = MeshletBuilder::IsInFrustum(meshlet, view);
+                inFrustum += kept;
+                CHECK(kept || !visible);
+            }
+            if (x == 0.0f)
+                CHECK(inFrustum == mesh.m_Meshlets.size());
+            if (x == 20.0f)
+                CHECK(inFrustum == 0);
+        }
+    }
+
+    void TestCone()
+    {
+        // One triangle in the xz plane, its vertex normals point up
+        VertexData triangle[3] = {};
+        triangle[0].pos        = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        triangle[1].pos        = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        triangle[2].pos        = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        for (auto &v : triangle)
+            v.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+        Meshlet meshlet = {};
+        MeshletBuilder::ComputeBounds(meshlet, triangle, 1);
+        CHECK(std::abs(meshlet.Cone.y - 1.0f) < 1e-6f);
+        CHECK(std::abs(meshlet.Cone.w) < 1e-3f);
+        CHECK(std::abs(meshlet.ConeApex.y) < 1e-6f);
+
+        MeshletView above = {};
+        MeshletView below = {};
+        above.CameraPos   = XMFLOAT3(0.3f, 1.0f, 0.3f);
+        below.CameraPos   = XMFLOAT3(0.3f, -1.0f, 0.3f);
+        CHECK(!MeshletBuilder::IsBackFacing(meshlet, above));
+        CHECK(MeshletBuilder::IsBackFacing(meshlet, below));
+
+        // The other winding gives the same cone, the vertex normals decide
+        std::swap(triangle[1], triangle[2]);
+        Meshlet flipped = {};
+        MeshletBuilder::ComputeBounds(flipped, triangle, 1);
+        CHECK(std::abs(flipped.Cone.y - 1.0f) < 1e-6f);
+
+        // Two faces at right angles: the axis is between them, seen from the open side nothing is culled
+        VertexData corner[6] = {};
+        corner[0].pos        = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        corner[1].pos        = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        corner[2].pos        = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        corner[3].pos        = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        corner[4].pos        = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        corner[5].pos        = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        for (size_t i = 0; i < 6; ++i)
+            corner[i].normal = i < 3 ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+        Meshlet bent = {};
+        MeshletBuilder::ComputeBounds(bent, corner, 2);
+        CHECK(std::abs(bent.Cone.x - bent.Cone.y) < 1e-5f && bent.Cone.x > 0.0f);
+        CHECK(bent.Cone.w < 1.0f);
+        above.CameraPos = XMFLOAT3(2.0f, 2.0f, 0.5f);
+        below.CameraPos = XMFLOAT3(-2.0f, -2.0f, 0.5f);
+        CHECK(!MeshletBuilder::IsBackFacing(bent, above));
+        CHECK(MeshletBuilder::IsBackFacing(bent, below));
+        // Behind one face but in front of the other
+        MeshletView side = {};
+        side.CameraPos   = XMFLOAT3(2.0f, -0.5f, 0.5f);
+        CHECK(!MeshletBuilder::IsBackFacing(bent, side));
+
+        // Opposite faces make a cone too wide to ever cull
+        corner[3].pos = XMFLOAT3(0.0f, -1.0f, 0.0f);
+        corner[4].pos = XMFLOAT3(0.0f, -1.0f, 1.0f);
+        corner[5].pos = XMFLOAT3(1.0f, -1.0f, 0.0f);
+        for (size_t i = 3; i < 6; ++i)
+            corner[i].normal = XMFLOAT3(0.0f, -1.0f, 0.0f);
+        Meshlet slab = {};
+        MeshletBuilder::ComputeBounds(slab, corner, 2);
+        CHECK(slab.Cone.w == 1.0f);
+        CHECK(!MeshletBuilder::IsBackFacing(slab, below));
+    }
+
+    void TestLimits()
+    {
+        MeshData mesh = MakeSphere(1.0f, 8, 16);
+        CHECK_THROWS(MeshletBuilder::Build(mesh, 257, 10));
+        CHECK_THROWS(MeshletBuilder::Build(mesh, 2, 10));
+
+        // Smaller limits give more meshlets within them
+        MeshletBuilder::Build(mesh, 16, 8);
+        for (auto &&meshlet : mesh.m_Meshlets)
+            CHECK(meshlet.VertexCount <= 16 && meshlet.TriangleCount <= 8);
+        CHECK(mesh.m_Meshlets.size() >= mesh.IndexCount() / 3 / 8);
+
+        mesh.m_VertexFormat = VERTEX_FORMAT_COMPACT;
+        CHECK_THROWS(MeshletBuilder::Build(mesh));
+    }
+} // namespace
+
+int main()
+{
+    TestSphereMeshlets();
+    TestSphereCones();
+    TestSphereFrustum();
+    TestCone();
+    TestLimits();
+    return TestResult();
+}
@@ -0,0 +1,143 @@
+#include "Bench.hpp"
+
+#include "MyDXLib/OcclusionCuller.hpp"
+#include "MyDXLib/ThreadPool.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float  NEAR_PLANE    = 0.5f;
+    constexpr size_t BLOCKS        = 24; // Per side of the city
+    constexpr float  BLOCK_SIZE    = 10.0f;
+    constexpr float  BUILDING_SIZE = 7.0f;
+    constexpr size_t OBJECTS       = 50000;
+
+    // Unit cube with every face clockwise as seen from outside
+    struct Cube
+    {
+        std::vector<XMFLOAT3> Positions;
+        std::vector<uint32_t> Indices;
+
+        Cube()
+        {
+            AddQuad({0, 1, 0}, {1, 1, 0}, {1, 0, 0}, {0, 0, 0}); // -z
+            AddQuad({1, 1, 1}, {0, 1, 1}, {0, 0, 1}, {1, 0, 1}); // +z
+            AddQuad({0, 1, 1}, {0, 1, 0}, {0, 0, 0}, {0, 0, 1}); // -x
+            AddQuad({1, 1, 0}, {1, 1, 1}, {1, 0, 1}, {1, 0, 0}); // +x
+            AddQuad({0, 1, 1}, {1, 1, 1}, {1, 1, 0}, {0, 1, 0}); // +y
+            AddQuad({0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}); // -y
+        }
+
+        void AddQuad(const XMFLOAT3 &a, const XMFLOAT3 &b, const XMFLOAT3 &c, const XMFLOAT3 &d)
+        {
+            uint32_t first = static_cast<uint32_t>(Positions.size());
+            Positions.insert(Positions.end(), {a, b, c, d});
+            Indices.insert(Indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+        }
+    };
+
+    struct Box
+    {
+        XMFLOAT3 Min;
+        XMFLOAT3 Max;
+    };
+
+    // Reversed depth with the far plane at infinity
+    XMMATRIX Projection(float aspect)
+    {
+        return XMMatrixSet(1.0f / aspect, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, 1.0f, 0.0f, 0.0f,          // row 1
+                           0.0f, 0.0f, 0.0f, 1.0f,          // row 2
+                           0.0f, 0.0f, NEAR_PLANE, 0.0f);
+    }
+
+    // Camera at position looking along +z, tilted down by pitch
+    XMMATRIX View(const XMFLOAT3 &position, float pitch)
+    {
+        XMMATRIX translation = XMMatrixTranslation(-position.x, -position.y, -position.z);
+        float    c           = std::cos(pitch);
+        float    s           = std::sin(pitch);
+        XMMATRIX rotation    = XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                                        0.0f, c, -s, 0.0f,      // row 1
+                                        0.0f, s, c, 0.0f,       // row 2
+                                        0.0f, 0.0f, 0.0f, 1.0f);
+        return translation * rotation;
+    }
+
+    void Run(const char *name, const XMFLOAT3 &cameraPosition, float pitch, size_t width, size_t height)
+    {
+        Cube                                  cube;
+        std::vector<XMMATRIX>                 buildings;
+        std::mt19937                          random(7);
+        std::uniform_real_distribution<float> storeys(5.0f, 40.0f);
+        float                                 offset = -0.5f * BLOCKS * BLOCK_SIZE;
+        for (size_t z = 0; z < BLOCKS; ++z)
+        {
+            for (size_t x = 0; x < BLOCKS; ++x)
+            {
+                XMMATRIX scaling     = XMMatrixScaling(BUILDING_SIZE, storeys(random), BUILDING_SIZE);
+                XMMATRIX translation = XMMatrixTranslation(offset + x * BLOCK_SIZE, 0.0f, offset + z * BLOCK_SIZE);
+                buildings.push_back(scaling * translation);
+            }
+        }
+
+        // Small objects in the streets between the buildings
+        std::vector<Box>                      objects;
+        std::uniform_real_distribution<float> position(offset, -offset);
+        std::uniform_real_distribution<float> size(0.3f, 2.0f);
+        while (objects.size() < OBJECTS)
+        {
+            XMFLOAT3 min(position(random), 0.0f, position(random));
+            XMFLOAT3 max(min.x + size(random), size(random), min.z + size(random));
+            float    inBlockX = std::fmod(min.x - offset, BLOCK_SIZE);
+            float    inBlockZ = std::fmod(min.z - offset, BLOCK_SIZE);
+            if (inBlockX < BUILDING_SIZE && inBlockZ < BUILDING_SIZE)
+                continue;
+            objects.push_back({min, max});
+        }
+
+        XMMATRIX        viewProjection = View(cameraPosition, pitch) * Projection(float(width) / height);
+        float           nearDepth      = OcclusionCuller::NearDepth(Projection(1.0f));
+        OcclusionCuller culler(width, height);
+
+        std::vector<OcclusionCuller::Occluder> occluders;
+        for (auto &&world : buildings)
+        {
+            XMMATRIX worldViewProjection = world * viewProjection;
+            occluders.push_back({worldViewProjection, cube.Positions.data(), cube.Indices.data(), cube.Indices.size()});
+        }
+
+        size_t rejected = 0;
+        double renderMs = MeasureMs([&] { culler.Render(occluders, nearDepth); });
+        double testMs   = MeasureMs([&] {
+            rejected = 0;
+            for (auto &&object : objects)
+                rejected += culler.IsOccluded(object.Min, object.Max, viewProjection);
+        });
+
+        std::printf("%-8s %4zux%-4zu %6zu occluder triangles %6zu boxes  render %7.3f ms  test %7.3f ms  "
+                    "%7.3f ms/frame  %5.1f%% rejected\n",
+                    name,
+                    culler.GetWidth(),
+                    culler.GetHeight(),
+                    occluders.size() * cube.Indices.size() / 3,
+                    objects.size(),
+                    renderMs,
+                    testMs,
+                    renderMs + testMs,
+                    100.0 * rejected / objects.size());
+    }
+} // namespace
+
+int main()
+{
+    std::printf("%zu threads\n", ThreadPool::Shared().ThreadCount());
+    for (auto [width, height] : {std::pair<size_t, size_t>{256, 144}, {512, 288}})
+    {
+        // In the middle of a street, looking down it from the edge of the city
+        Run("street", XMFLOAT3(8.5f, 1.7f, -125.0f), 0.0f, width, height);
+        Run("aerial", XMFLOAT3(0.0f, 60.0f, -150.0f), 0.35f, width, height);
+    }
+    return 0;
+}
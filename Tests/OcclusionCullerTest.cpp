@@ -0,0 +1,307 @@
+#include "Check.hpp"
+
+#include "MyDXLib/OcclusionCuller.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float NEAR_PLANE = 0.5f;
+    constexpr float FAR_PLANE  = 200.0f;
+    constexpr float SCALE_X    = 0.5625f; // Aspect ratio of the default buffer
+    constexpr float SCALE_Y    = 1.0f;
+
+    // Left handed perspective with w = view depth. The depth goes from 0 at the near plane to 1 at the far
+    // plane, reversed the other way around, like Camera::CalcProjection with swapped depths.
+    XMMATRIX Perspective(bool reversed)
+    {
+        // z = a * depth + b is 0 at the plane where it starts
+        float a = reversed ? NEAR_PLANE / (NEAR_PLANE - FAR_PLANE) : FAR_PLANE / (FAR_PLANE - NEAR_PLANE);
+        float b = -a * (reversed ? FAR_PLANE : NEAR_PLANE);
+        return XMMatrixSet(SCALE_X, 0.0f, 0.0f, 0.0f, // row 0
+                           0.0f, SCALE_Y, 0.0f, 0.0f, // row 1
+                           0.0f, 0.0f, a, 1.0f,       // row 2
+                           0.0f, 0.0f, b, 0.0f);
+    }
+
+    struct Mesh
+    {
+        std::vector<XMFLOAT3> Positions;
+        std::vector<uint32_t> Indices;
+
+        // Corners clockwise as seen by the camera make a front facing quad
+        void AddQuad(const XMFLOAT3 &a, const XMFLOAT3 &b, const XMFLOAT3 &c, const XMFLOAT3 &d)
+        {
+            uint32_t first = static_cast<uint32_t>(Positions.size());
+            Positions.insert(Positions.end(), {a, b, c, d});
+            Indices.insert(Indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+        }
+
+        OcclusionCuller::Occluder AsOccluder(FXMMATRIX worldViewProjection) const
+        {
+            return {worldViewProjection, Positions.data(), Indices.data(), Indices.size()};
+        }
+    };
+
+    bool BufferIsEmpty(const OcclusionCuller &culler)
+    {
+        const float *depth = culler.GetDepth();
+        return std::all_of(depth, depth + culler.GetWidth() * culler.GetHeight(), [](float d) { return d == 0.0f; });
+    }
+
+    void TestNearDepth()
+    {
+        CHECK(std::abs(OcclusionCuller::NearDepth(Perspective(false)) - NEAR_PLANE) < 1e-4f);
+        CHECK(std::abs(OcclusionCuller::NearDepth(Perspective(true)) - NEAR_PLANE) < 1e-4f);
+
+        // Reversed with the far plane at infinity, z = near / depth
+        XMMATRIX infinite = XMMatrixSet(SCALE_X, 0.0f, 0.0f, 0.0f, // row 0
+                                        0.0f, SCALE_Y, 0.0f, 0.0f, // row 1
+                                        0.0f, 0.0f, 0.0f, 1.0f,    // row 2
+                                        0.0f, 0.0f, NEAR_PLANE, 0.0f);
+        CHECK(std::abs(OcclusionCuller::NearDepth(infinite) - NEAR_PLANE) < 1e-4f);
+    }
+
+    void TestWalls(bool reversed)
+    {
+        XMMATRIX        projection = Perspective(reversed);
+        OcclusionCuller culler;
+
+        Mesh front;
+        front.AddQuad({-4.0f, 4.0f, 10.0f}, {4.0f, 4.0f, 10.0f}, {4.0f, -4.0f, 10.0f}, {-4.0f, -4.0f, 10.0f});
+        culler.Render({front.AsOccluder(projection)}, OcclusionCuller::NearDepth(projection));
+
+        CHECK(!BufferIsEmpty(culler));
+        CHECK(culler.IsOccluded({-1.0f, -1.0f, 20.0f}, {1.0f, 1.0f, 21.0f}, projection));
+        CHECK(culler.IsOccluded({-3.0f, -3.0f, 10.5f}, {3.0f, 3.0f, 11.0f}, projection));
+        CHECK(!culler.IsOccluded({-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 6.0f}, projection));
+        CHECK(!culler.IsOccluded({-1.0f, -1.0f, 9.0f}, {1.0f, 1.0f, 11.0f}, projection));
+        CHECK(!culler.IsOccluded({12.0f, -1.0f, 20.0f}, {14.0f, 1.0f, 21.0f}, projection));
+        CHECK(!culler.IsOccluded({-10.0f, -1.0f, 20.0f}, {10.0f, 1.0f, 21.0f}, projection));
+        CHECK(!culler.IsOccluded({-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}, projection));
+
+        // The same wall seen from behind writes nothing
+        Mesh back;
+        back.AddQuad({-4.0f, 4.0f, 10.0f}, {-4.0f, -4.0f, 10.0f}, {4.0f, -4.0f, 10.0f}, {4.0f, 4.0f, 10.0f});
+        culler.Render({back.AsOccluder(projection)}, OcclusionCuller::NearDepth(projection));
+
+        CHECK(BufferIsEmpty(culler));
+        CHECK(!culler.IsOccluded({-1.0f, -1.0f, 20.0f}, {1.0f, 1.0f, 21.0f}, projection));
+    }
+
+    std::vector<float> TestFloorCrossingNearPlane(bool reversed)
+    {
+        XMMATRIX        projection = Perspective(reversed);
+        OcclusionCuller culler;
+
+        // Starts behind the camera, so every triangle is clipped at the near plane
+        Mesh floor;
+        floor.AddQuad({-50.0f, -1.0f, 100.0f}, {50.0f, -1.0f, 100.0f}, {50.0f, -1.0f, -5.0f}, {-50.0f, -1.0f, -5.0f});
+        culler.Render({floor.AsOccluder(projection)}, OcclusionCuller::NearDepth(projection));
+
+        size_t       width  = culler.GetWidth();
+        size_t       height = culler.GetHeight();
+        const float *depth  = culler.GetDepth();
+        CHECK(std::all_of(depth, depth + width * height, [](float d) {
+            return std::isfinite(d) && d >= 0.0f && d <= 1.0f / NEAR_PLANE * 1.0001f;
+        }));
+
+        // Below the horizon down to the bottom edge of the screen, above it empty
+        CHECK(depth[(height - 1) * width + width / 2] > 0.0f);
+        CHECK(depth[(height / 2 + 4) * width + width / 2] > 0.0f);
+        CHECK(depth[(height / 2 - 4) * width + width / 2] == 0.0f);
+        CHECK(depth[width / 2] == 0.0f);
+
+        CHECK(culler.IsOccluded({-1.0f, -3.0f, 20.0f}, {1.0f, -2.0f, 22.0f}, projection));
+        CHECK(culler.IsOccluded({-1.0f, -3.0f, 2.0f}, {1.0f, -2.0f, 3.0f}, projection));
+        CHECK(!culler.IsOccluded({-1.0f, 0.0f, 20.0f}, {1.0f, 1.0f, 22.0f}, projection));
+        CHECK(!culler.IsOccluded({-1.0f, -1.5f, 20.0f}, {1.0f, -0.5f, 22.0f}, projection));
+
+        return std::vector<float>(depth, depth + width * height);
+    }
+
+    // Depth buffer of one front facing triangle per pixel center, computed in double precision and without
+    // clipping. Centers within a small margin of an edge are covered in loose but not in strict, the culler has
+    // to fall between the two.
+    struct Reference
+    {
+        size_t              Width;
+        size_t              Height;
+        std::vector<double> Strict;
+        std::vector<double> Loose;
+
+        Reference(size_t width, size_t height)
+            : Width(width), Height(height), Strict(width * height, 0.0), Loose(width * height, 0.0)
+        {
+        }
+
+        void Add(const XMFLOAT3 (&triangle)[3], FXMMATRIX projection)
+        {
+            XMFLOAT4X4 m;
+            XMStoreFloat4x4(&m, projection);
+
+            double x[3], y[3], z[3];
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const XMFLOAT3 &p  = triangle[k];
+                double          cx = p.x * double(m(0, 0)) + p.y * double(m(1, 0)) + p.z * double(m(2, 0)) + m(3, 0);
+                double          cy = p.x * double(m(0, 1)) + p.y * double(m(1, 1)) + p.z * double(m(2, 1)) + m(3, 1);
+                double          cw = p.x * double(m(0, 3)) + p.y * double(m(1, 3)) + p.z * double(m(2, 3)) + m(3, 3);
+                x[k]               = (cx / cw * 0.5 + 0.5) * Width;
+                y[k]               = (0.5 - cy / cw * 0.5) * Height;
+                z[k]               = 1.0 / cw;
+            }
+
+            double area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+            if (area <= 0.0)
+                return;
+
+            // The plane of 1 / w is linear on screen, so its farthest point within a pixel is one of the corners
+            double za = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+            double zb = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+            double zc = z[0] - za * x[0] - zb * y[0] - 0.5 * (std::abs(za) + std::abs(zb));
+
+            for (size_t py = 0; py < Height; ++py)
+            {
+                for (size_t px = 0; px < Width; ++px)
+                {
+                    double cx = px + 0.5;
+                    double cy = py + 0.5;
+
+                    // Distance of the center to the nearest edge, positive inside
+                    double inside = INFINITY;
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        size_t next   = (k + 1) % 3;
+                        double ex     = x[next] - x[k];
+                        double ey     = y[next] - y[k];
+                        double length = std::sqrt(ex * ex + ey * ey);
+                        inside        = (std::min)(inside, (ex * (cy - y[k]) - ey * (cx - x[k])) / length);
+                    }
+
+                    double depth = za * cx + zb * cy + zc;
+                    size_t pixel = py * Width + px;
+                    if (inside >= 1e-3)
+                        Strict[pixel] = (std::max)(Strict[pixel], depth);
+                    if (inside >= -1e-3)
+                        Loose[pixel] = (std::max)(Loose[pixel], depth);
+                }
+            }
+        }
+    };
+
+    void TestAgainstReference()
+    {
+        XMMATRIX        projection = Perspective(true);
+        OcclusionCuller culler;
+        Reference       reference(culler.GetWidth(), culler.GetHeight());
+
+        // Triangles inside the guard band and behind the near plane, so the culler doesn't clip them either
+        std::mt19937                          random(12345);
+        std::uniform_real_distribution<float> screen(-1.2f, 1.2f);
+        std::uniform_real_distribution<float> depth(2.0f, 50.0f);
+        Mesh                                  mesh;
+        for (uint32_t t = 0; t < 300; ++t)
+        {
+            XMFLOAT3 triangle[3];
+            for (auto &p : triangle)
+            {
+                float d = depth(random);
+                p       = XMFLOAT3(screen(random) * d / SCALE_X, screen(random) * d / SCALE_Y, d);
+            }
+            reference.Add(triangle, projection);
+
+            uint32_t first = static_cast<uint32_t>(mesh.Positions.size());
+            mesh.Positions.insert(mesh.Positions.end(), std::begin(triangle), std::end(triangle));
+            mesh.Indices.insert(mesh.Indices.end(), {first, first + 1, first + 2});
+        }
+        culler.Render({mesh.AsOccluder(projection)}, OcclusionCuller::NearDepth(projection));
+
+        const float *buffer  = culler.GetDepth();
+        size_t       outside = 0;
+        for (size_t pixel = 0; pixel < reference.Strict.size(); ++pixel)
+        {
+            double tolerance = 1e-5 * reference.Loose[pixel] + 1e-7;
+            if (buffer[pixel] < reference.Strict[pixel] - tolerance)
+                ++outside;
+            if (buffer[pixel] > reference.Loose[pixel] + tolerance)
+                ++outside;
+        }
+        CHECK(outside == 0);
+
+        // Boxes with their nearest point clearly behind the reference in every pixel they touch have to be
+        // occluded, boxes clearly in front of it anywhere must not be
+        std::uniform_real_distribution<float> size(0.1f, 4.0f);
+        size_t                                occluded = 0;
+        for (size_t b = 0; b < 2000; ++b)
+        {
+            float    d = depth(random);
+            XMFLOAT3 boundsMin(screen(random) * d / SCALE_X, screen(random) * d / SCALE_Y, d);
+            XMFLOAT3 boundsMax(boundsMin.x + size(random), boundsMin.y + size(random), boundsMin.z + size(random));
+
+            // Same rectangle as IsOccluded, which tests whole groups of four pixels
+            float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY, nearest = 0.0f;
+            for (size_t k = 0; k < 8; ++k)
+            {
+                XMFLOAT3 corner((k & 1) ? boundsMax.x : boundsMin.x,
+                                (k & 2) ? boundsMax.y : boundsMin.y,
+                                (k & 4) ? boundsMax.z : boundsMin.z);
+                XMFLOAT4 clip;
+                XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corner), projection));
+                float invW = 1.0f / clip.w;
+                float x    = (clip.x * invW * 0.5f + 0.5f) * culler.GetWidth();
+                float y    = (0.5f - clip.y * invW * 0.5f) * culler.GetHeight();
+                minX       = (std::min)(minX, x);
+                minY       = (std::min)(minY, y);
+                maxX       = (std::max)(maxX, x);
+                maxY       = (std::max)(maxY, y);
+                nearest    = (std::max)(nearest, invW);
+            }
+            int32_t pixelMinX = (std::max)(static_cast<int32_t>(std::floor(minX)), 0) & ~3;
+            int32_t pixelMinY = (std::max)(static_cast<int32_t>(std::floor(minY)), 0);
+            int32_t pixelMaxX = (std::min)(static_cast<int32_t>(std::ceil(maxX)), int32_t(culler.GetWidth())) - 1;
+            int32_t pixelMaxY = (std::min)(static_cast<int32_t>(std::ceil(maxY)), int32_t(culler.GetHeight())) - 1;
+            if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+                continue;
+
+            bool behindStrict = true;
+            bool behindLoose  = true;
+            for (int32_t y = pixelMinY; y <= pixelMaxY; ++y)
+            {
+                for (int32_t x = pixelMinX; x <= (pixelMaxX | 3); ++x)
+                {
+                    size_t pixel = y * culler.GetWidth() + x;
+                    behindStrict = behindStrict && nearest < reference.Strict[pixel] * (1.0 - 1e-4);
+                    behindLoose  = behindLoose && nearest < reference.Loose[pixel] * (1.0 + 1e-4);
+                }
+            }
+
+            bool result = culler.IsOccluded(boundsMin, boundsMax, projection);
+            CHECK(!behindStrict || result);
+            CHECK(!result || behindLoose);
+            occluded += result;
+        }
+
+        // Otherwise the comparison proves little
+        CHECK(occluded > 100);
+    }
+} // namespace
+
+int main()
+{
+    TestNearDepth();
+    TestWalls(false);
+    TestWalls(true);
+
+    std::vector<float> standard = TestFloorCrossingNearPlane(false);
+    std::vector<float> reversed = TestFloorCrossingNearPlane(true);
+
+    // The buffer holds 1 / view depth, so it doesn't depend on the depth direction
+    bool same = true;
+    for (size_t i = 0; i < standard.size(); ++i)
+        same = same && std::abs(standard[i] - reversed[i]) <= 1e-4f * (std::max)(standard[i], reversed[i]);
+    CHECK(same);
+
+    TestAgainstReference();
+    return TestResult();
+}
@@ -0,0 +1,99 @@
+#include "Bench.hpp"
+
+#include "MyDXLib/ParallelRecorder.hpp"
+
+namespace
+{
+    constexpr size_t DRAWS = 100000;
+
+    // Sorted like the draw list: pipelines, then materials, geometry buffers changing every few draws
+    struct SyntheticDraw
+    {
+        ID3D12PipelineState      *Pipeline;
+        UINT                      Material;
+        UINT                      Geometry;
+        UINT                      IndexCount;
+        UINT                      StartIndex;
+        D3D12_GPU_VIRTUAL_ADDRESS Transforms;
+    };
+
+    std::vector<SyntheticDraw> MakeDraws()
+    {
+        std::mt19937               random(31);
+        std::vector<SyntheticDraw> draws(DRAWS);
+        for (size_t i = 0; i < DRAWS; ++i)
+        {
+            draws[i].Pipeline   = reinterpret_cast<ID3D12PipelineState *>(0x1000 + (i * 4 / DRAWS) * 16);
+            draws[i].Material   = static_cast<UINT>(i / 200);
+            draws[i].Geometry   = static_cast<UINT>(i / 8);
+            draws[i].IndexCount = 3 * (1 + random() % 5000);
+            draws[i].StartIndex = random() % 100000;
+            draws[i].Transforms = 0x100000 + i * 64;
+        }
+        return draws;
+    }
+
+    // The commands Scene::Record issues for a range
+    template <class Target>
+    void Record(Target &target, const std::vector<SyntheticDraw> &draws, size_t begin, size_t end)
+    {
+        ID3D12PipelineState *boundPipeline = nullptr;
+        UINT                 boundMaterial = UINT_MAX;
+        UINT                 boundGeometry = UINT_MAX;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const SyntheticDraw &draw = draws[i];
+            if (draw.Pipeline != boundPipeline)
+            {
+                boundPipeline = draw.Pipeline;
+                target.SetPipelineState(boundPipeline);
+            }
+            target.SetRootShaderResourceView(0, draw.Transforms);
+            if (draw.Geometry != boundGeometry)
+            {
+                boundGeometry = draw.Geometry;
+                target.SetVertexBuffer({0x200000 + boundGeometry * UINT64(1 << 20), 1 << 20, 56});
+                target.SetIndexBuffer({0x80000000 + boundGeometry * UINT64(1 << 20), 1 << 20, DXGI_FORMAT_R32_UINT});
+            }
+            if (draw.Material != boundMaterial)
+            {
+                boundMaterial = draw.Material;
+                target.SetRootConstants(4, 1, &boundMaterial);
+            }
+            target.DrawIndexed(draw.IndexCount, 1, draw.StartIndex, 0);
+        }
+    }
+} // namespace
+
+int main()
+{
+    std::vector<SyntheticDraw> draws = MakeDraws();
+
+    // Straight into the backend without a command stream, the floor for one thread
+    NullRenderBackend direct;
+    double            directMs = MeasureMs([&] { Record(direct, draws, 0, draws.size()); });
+
+    auto record = [&](RenderCommands &commands, size_t begin, size_t end) { Record(commands, draws, begin, end); };
+
+    ThreadPool                   single(1);
+    ParallelRecorder             serial(single);
+    NullRenderBackend            serialBackend;
+    std::vector<RenderBackend *> serialBackends = {&serialBackend};
+    double                       serialMs = MeasureMs([&] { serial.Record(draws.size(), serialBackends, record); });
+
+    ParallelRecorder               parallel;
+    std::vector<NullRenderBackend> parallelBackends(parallel.ChunkCount(draws.size()));
+    std::vector<RenderBackend *>   pointers;
+    for (auto &backend : parallelBackends)
+        pointers.push_back(&backend);
+    double parallelMs = MeasureMs([&] { parallel.Record(draws.size(), pointers, record); });
+
+    std::printf("%zu draws, %zu commands, %zu threads\n", draws.size(), serial.GetCommandCount(), pointers.size());
+    std::printf("direct   %7.3f ms %6.1f ns/draw\n", directMs, 1e6 * directMs / draws.size());
+    std::printf("serial   %7.3f ms %6.1f ns/draw\n", serialMs, 1e6 * serialMs / draws.size());
+    std::printf("parallel %7.3f ms %6.1f ns/draw  %4.2fx serial\n",
+                parallelMs,
+                1e6 * parallelMs / draws.size(),
+                serialMs / parallelMs);
+    return 0;
+}
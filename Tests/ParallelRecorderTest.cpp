@@ -0,0 +1,145 @@
+#include "Check.hpp"
+
+#include "MyDXLib/ParallelRecorder.hpp"
+
+namespace
+{
+    // Keeps the start index of every draw and the thread it was replayed on
+    class DrawLogBackend : public NullRenderBackend
+    {
+      public:
+        std::vector<UINT>            StartIndices;
+        std::vector<UINT>            Constants;
+        std::vector<std::thread::id> Threads;
+
+        void SetRootConstants(UINT rootIndex, UINT count, const void *values) override
+        {
+            NullRenderBackend::SetRootConstants(rootIndex, count, values);
+            UINT value;
+            std::memcpy(&value, values, sizeof(value));
+            Constants.push_back(value);
+        }
+        void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex) override
+        {
+            NullRenderBackend::DrawIndexed(indexCount, instanceCount, startIndex, baseVertex);
+            StartIndices.push_back(startIndex);
+            Threads.push_back(std::this_thread::get_id());
+        }
+    };
+
+    // Every draw sets its index as a root constant and draws from it
+    void RecordDraws(RenderCommands &commands, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            UINT index = static_cast<UINT>(i);
+            commands.SetRootConstants(2, 1, &index);
+            commands.DrawIndexed(3, 1, index, 0);
+        }
+    }
+
+    void TestChunkCount()
+    {
+        ThreadPool       single(1);
+        ThreadPool       four(4);
+        ParallelRecorder serial(single);
+        ParallelRecorder parallel(four);
+
+        CHECK(serial.ChunkCount(0) == 1);
+        CHECK(serial.ChunkCount(100000) == 1);
+        CHECK(parallel.ChunkCount(0) == 1);
+        CHECK(parallel.ChunkCount(ParallelRecorder::MIN_CHUNK_DRAWS - 1) == 1);
+        CHECK(parallel.ChunkCount(ParallelRecorder::MIN_CHUNK_DRAWS * 3) == 3);
+        CHECK(parallel.ChunkCount(100000) == 4);
+    }
+
+    // Backends in chunk order see every draw once and in order, every chunk on one thread
+    void TestOrder(ThreadPool &threadPool, size_t drawCount)
+    {
+        ParallelRecorder             recorder(threadPool);
+        size_t                       chunkCount = recorder.ChunkCount(drawCount);
+        std::vector<DrawLogBackend>  backends(chunkCount);
+        std::vector<RenderBackend *> pointers;
+        for (auto &backend : backends)
+            pointers.push_back(&backend);
+
+        // Threads by the first draw of their chunk
+        std::mutex                                  mutex;
+        std::unordered_map<size_t, std::thread::id> recordThreads;
+        recorder.Record(drawCount, pointers, [&](RenderCommands &commands, size_t begin, size_t end) {
+            RecordDraws(commands, begin, end);
+            std::lock_guard lock(mutex);
+            recordThreads[begin] = std::this_thread::get_id();
+        });
+
+        std::vector<UINT> starts;
+        std::vector<UINT> constants;
+        bool              sameThread = true;
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            const DrawLogBackend &backend = backends[chunk];
+            starts.insert(starts.end(), backend.StartIndices.begin(), backend.StartIndices.end());
+            constants.insert(constants.end(), backend.Constants.begin(), backend.Constants.end());
+            for (auto &&thread : backend.Threads)
+                sameThread = sameThread && thread == recordThreads[backend.StartIndices.front()];
+        }
+
+        std::vector<UINT> expected(drawCount);
+        std::iota(expected.begin(), expected.end(), 0u);
+        CHECK(starts == expected);
+        CHECK(constants == expected);
+        CHECK(sameThread);
+        CHECK(recorder.GetCommandCount() == drawCount * 2);
+    }
+
+    void TestRecordAgain()
+    {
+        ThreadPool       threadPool(4);
+        ParallelRecorder recorder(threadPool);
+
+        NullRenderBackend            backends[4];
+        std::vector<RenderBackend *> four = {&backends[0], &backends[1], &backends[2], &backends[3]};
+        recorder.Record(10000, four, RecordDraws);
+        CHECK(recorder.GetCommandCount() == 20000);
+        size_t draws = 0;
+        for (auto &&backend : backends)
+            draws += backend.GetCounts().Draws;
+        CHECK(draws == 10000);
+
+        // Chunks of the previous frame don't count, fewer backends take fewer chunks
+        NullRenderBackend            last;
+        std::vector<RenderBackend *> one = {&last};
+        recorder.Record(100, one, RecordDraws);
+        CHECK(recorder.GetCommandCount() == 200);
+        CHECK(last.GetCounts().Draws == 100);
+    }
+
+    void TestException()
+    {
+        ThreadPool                   threadPool(4);
+        ParallelRecorder             recorder(threadPool);
+        NullRenderBackend            backends[4];
+        std::vector<RenderBackend *> pointers = {&backends[0], &backends[1], &backends[2], &backends[3]};
+        CHECK_THROWS(recorder.Record(1000, pointers, [](RenderCommands &, size_t begin, size_t) {
+            if (begin != 0)
+                throw std::runtime_error("Recording failed");
+        }));
+    }
+} // namespace
+
+int main()
+{
+    TestChunkCount();
+
+    ThreadPool single(1);
+    ThreadPool four(4);
+    TestOrder(single, 0);
+    TestOrder(single, 1000);
+    TestOrder(four, 10);
+    TestOrder(four, 1000);
+    TestOrder(four, 100001);
+
+    TestRecordAgain();
+    TestException();
+    return TestResult();
+}
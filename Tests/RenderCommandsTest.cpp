@@ -0,0 +1,289 @@
+#include "Check.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/Scene.hpp"
+
+namespace
+{
+    // Every call with all of its arguments, root constants with their values
+    struct Call
+    {
+        RenderCommands::Type  Type;
+        std::vector<uint64_t> Arguments;
+
+        bool operator==(const Call &other) const { return Type == other.Type && Arguments == other.Arguments; }
+    };
+
+    class LogBackend : public RenderBackend
+    {
+        void Log(RenderCommands::Type type, std::vector<uint64_t> arguments)
+        {
+            Calls.push_back({type, std::move(arguments)});
+        }
+
+      public:
+        std::vector<Call> Calls;
+        size_t            Barriers = 0;
+
+        void SetPipelineState(ID3D12PipelineState *pipelineState) override
+        {
+            Log(RenderCommands::Type::SetPipelineState, {reinterpret_cast<uintptr_t>(pipelineState)});
+        }
+        void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW &view) override
+        {
+            Log(RenderCommands::Type::SetVertexBuffer, {view.BufferLocation, view.SizeInBytes, view.StrideInBytes});
+        }
+        void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW &view) override
+        {
+            Log(RenderCommands::Type::SetIndexBuffer,
+                {view.BufferLocation, view.SizeInBytes, static_cast<uint64_t>(view.Format)});
+        }
+        void SetRootConstants(UINT rootIndex, UINT count, const void *values) override
+        {
+            std::vector<uint64_t> arguments = {rootIndex, count};
+            for (UINT i = 0; i < count; ++i)
+            {
+                UINT value;
+                std::memcpy(&value, static_cast<const uint8_t *>(values) + i * sizeof(UINT), sizeof(value));
+                arguments.push_back(value);
+            }
+            Log(RenderCommands::Type::SetRootConstants, std::move(arguments));
+        }
+        void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) override
+        {
+            Log(RenderCommands::Type::SetRootDescriptorTable, {rootIndex, table.ptr});
+        }
+        void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override
+        {
+            Log(RenderCommands::Type::SetRootConstantBufferView, {rootIndex, address});
+        }
+        void SetRootShaderResourceView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override
+        {
+            Log(RenderCommands::Type::SetRootShaderResourceView, {rootIndex, address});
+        }
+        void DrawIndexed(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex) override
+        {
+            Log(RenderCommands::Type::DrawIndexed,
+                {indexCount, instanceCount, startIndex, static_cast<uint64_t>(static_cast<int64_t>(baseVertex))});
+        }
+        void Draw(UINT vertexCount, UINT instanceCount, UINT startVertex) override
+        {
+            Log(RenderCommands::Type::Draw, {vertexCount, instanceCount, startVertex});
+        }
+        void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *) override { Barriers += count; }
+
+        size_t Count(RenderCommands::Type type) const
+        {
+            return std::count_if(Calls.begin(), Calls.end(), [&](const Call &call) { return call.Type == type; });
+        }
+    };
+
+    // One of every command with arguments that use the full width of their types. The odd number of
+    // root constants leaves the arguments after them unaligned in the stream.
+    template <class Target> void RecordEverything(Target &target)
+    {
+        D3D12_VERTEX_BUFFER_VIEW vertexBuffer = {0x123456789ABCull, 0xFFFFFFF0u, 48};
+        D3D12_INDEX_BUFFER_VIEW  indexBuffer  = {0xFEDCBA9876540ull, 0x10000u, DXGI_FORMAT_R16_UINT};
+        UINT                     constants[7] = {0, 1, 0xFFFFFFFFu, 0x80000000u, 42, 0xDEADBEEFu, 7};
+        UINT                     single       = 3;
+
+        target.SetPipelineState(reinterpret_cast<ID3D12PipelineState *>(uintptr_t(0xABCDEF0123450ull)));
+        target.SetRootConstants(2, 7, constants);
+        target.SetVertexBuffer(vertexBuffer);
+        target.SetIndexBuffer(indexBuffer);
+        target.SetRootDescriptorTable(1, D3D12_GPU_DESCRIPTOR_HANDLE{0xFFFFFFFFFFFFFFF0ull});
+        target.SetRootConstantBufferView(3, 0x1000000000ull);
+        target.SetRootShaderResourceView(0, 0x2000000040ull);
+        target.DrawIndexed(36, 5, 0xFFFFFFFFu, -7);
+        target.SetRootConstants(4, 1, &single);
+        target.Draw(3, 1, 4);
+        target.SetRootConstants(4, 0, nullptr);
+        target.DrawIndexed(0, 0, 0, INT_MIN);
+    }
+
+    // Replaying the stream makes the same calls with the same arguments as calling the backend directly
+    void TestRoundTrip()
+    {
+        LogBackend direct;
+        RecordEverything(direct);
+
+        RenderCommands commands;
+        RecordEverything(commands);
+        CHECK(commands.GetCommandCount() == direct.Calls.size());
+
+        LogBackend replayed;
+        commands.Replay(replayed);
+        CHECK(replayed.Calls == direct.Calls);
+        CHECK(replayed.Barriers == 0);
+
+        // Replay doesn't consume the stream
+        LogBackend again;
+        commands.Replay(again);
+        CHECK(again.Calls == direct.Calls);
+
+        // The values are copied when they are recorded
+        UINT           value = 1;
+        RenderCommands copied;
+        copied.SetRootConstants(2, 1, &value);
+        value = 2;
+        LogBackend constants;
+        copied.Replay(constants);
+        CHECK(constants.Calls.size() == 1 && constants.Calls[0].Arguments == (std::vector<uint64_t>{2, 1, 1}));
+
+        commands.Clear();
+        CHECK(commands.GetCommandCount() == 0 && commands.GetSize() == 0);
+        LogBackend empty;
+        commands.Replay(empty);
+        CHECK(empty.Calls.empty());
+    }
+
+    // A type byte and the arguments, root constants add their values
+    void TestSize()
+    {
+        RenderCommands commands;
+        commands.DrawIndexed(3, 1, 0, 0);
+        CHECK(commands.GetSize() == 1 + 4 * sizeof(UINT));
+
+        UINT constants[48] = {};
+        commands.Clear();
+        commands.SetRootConstants(2, 48, constants);
+        CHECK(commands.GetSize() == 1 + 2 * sizeof(UINT) + sizeof(constants));
+    }
+
+    void TestNullBackend()
+    {
+        RenderCommands commands;
+        RecordEverything(commands);
+
+        NullRenderBackend backend;
+        commands.Replay(backend);
+        commands.Replay(backend);
+        const NullRenderBackend::Counts &counts = backend.GetCounts();
+        CHECK(counts.PipelineStates == 2);
+        CHECK(counts.VertexBuffers == 2);
+        CHECK(counts.IndexBuffers == 2);
+        CHECK(counts.RootConstants == 6);
+        CHECK(counts.DescriptorTables == 2);
+        CHECK(counts.ConstantBufferViews == 2);
+        CHECK(counts.ShaderResourceViews == 2);
+        CHECK(counts.Draws == 6);
+        CHECK(counts.Instances == 2 * (5 + 1));
+        CHECK(counts.Triangles == 2 * (12 * 5 + 1));
+
+        D3D12_RESOURCE_BARRIER barriers[3] = {};
+        backend.ResourceBarrier(3, barriers);
+        CHECK(backend.GetCounts().BarrierCalls == 1 && backend.GetCounts().Barriers == 3);
+
+        backend.Reset();
+        CHECK(backend.GetCounts().Draws == 0 && backend.GetCounts().PipelineStates == 0);
+    }
+
+    // The draw path of a scene recorded without a device: one instanced draw per mesh, every draw with its
+    // instance transforms and geometry bound before it. Recording in ranges gives the same draws.
+    void TestSceneRecord()
+    {
+        constexpr size_t MESHES    = 3;
+        constexpr size_t INSTANCES = 4;
+
+        ScratchDirectory               directory("RenderCommandsTest");
+        std::filesystem::path          path = directory.Path() / "Scene.gltf";
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(2, positions, indices);
+        for (size_t i = 0; i < MESHES; ++i)
+            writer.AddMesh(positions, indices, writer.AddMaterial("texture" + std::to_string(i) + ".png"));
+        for (size_t i = 0; i < MESHES * INSTANCES; ++i)
+            writer.AddNode(GltfWriter::NONE, i % MESHES, {static_cast<float>(i) * 3.0f, 0.0f, 0.0f});
+        writer.Write(path);
+
+        SceneImportOptions options;
+        options.Importer = SCENE_IMPORTER_GLTF;
+        SceneData data;
+        data.LoadFromFile(path, options);
+
+        DescriptorAllocator descriptors(PDevice(), 16, 16);
+        Scene               scene;
+        scene.Describe(descriptors, data);
+
+        // Looking down the z axis from 20 units in front of the row, which fits the 90 degree field of view
+        constexpr float   NEAR_PLANE = 1.0f;
+        constexpr float   FAR_PLANE  = 100.0f;
+        float             a          = FAR_PLANE / (FAR_PLANE - NEAR_PLANE);
+        DirectX::XMMATRIX view       = DirectX::XMMatrixTranslation(-16.5f, 0.0f, 20.0f);
+        DirectX::XMMATRIX projection = DirectX::XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                                                            0.0f, 1.0f, 0.0f, 0.0f, // row 1
+                                                            0.0f, 0.0f, a, 1.0f,    // row 2
+                                                            0.0f, 0.0f, -a * NEAR_PLANE, 0.0f);
+        auto              pipeline   = reinterpret_cast<ID3D12PipelineState *>(uintptr_t(0x1000));
+        UploadRing        uploadRing(UploadRing::DEFAULT_CAPACITY);
+        scene.Prepare(uploadRing, pipeline, DirectX::XMMatrixIdentity(), view, projection);
+        CHECK(scene.GetDrawCount() == MESHES);
+
+        RenderCommands commands;
+        scene.Record(commands, 0, scene.GetDrawCount());
+        LogBackend backend;
+        commands.Replay(backend);
+
+        CHECK(backend.Count(RenderCommands::Type::DrawIndexed) == MESHES);
+        CHECK(backend.Count(RenderCommands::Type::SetPipelineState) == 1);
+        CHECK(backend.Count(RenderCommands::Type::SetRootConstantBufferView) == 1);
+        CHECK(!backend.Calls.empty() && backend.Calls[0].Type == RenderCommands::Type::SetRootConstantBufferView);
+
+        size_t instances      = 0;
+        bool   transformsSet  = false;
+        bool   geometryBound  = false;
+        bool   pipelineSet    = false;
+        size_t drawnTriangles = 0;
+        for (auto &&call : backend.Calls)
+        {
+            switch (call.Type)
+            {
+            case RenderCommands::Type::SetPipelineState:
+                pipelineSet = call.Arguments[0] == reinterpret_cast<uintptr_t>(pipeline);
+                break;
+            case RenderCommands::Type::SetRootShaderResourceView:
+                transformsSet = call.Arguments[0] == 0;
+                break;
+            case RenderCommands::Type::SetIndexBuffer: geometryBound = true; break;
+            case RenderCommands::Type::DrawIndexed:
+                CHECK(pipelineSet && transformsSet && geometryBound);
+                instances      += call.Arguments[1];
+                drawnTriangles += call.Arguments[0] / 3 * call.Arguments[1];
+                transformsSet   = false;
+                break;
+            default: break;
+            }
+        }
+        CHECK(instances == MESHES * INSTANCES);
+        CHECK(drawnTriangles == MESHES * INSTANCES * indices.size() / 3);
+
+        // Every range starts without bound state, so the ranges replay to the same draws
+        RenderCommands first;
+        RenderCommands second;
+        scene.Record(first, 0, 1);
+        scene.Record(second, 1, scene.GetDrawCount());
+        LogBackend split;
+        first.Replay(split);
+        second.Replay(split);
+        std::vector<Call> draws;
+        std::vector<Call> splitDraws;
+        std::copy_if(backend.Calls.begin(), backend.Calls.end(), std::back_inserter(draws), [](const Call &call) {
+            return call.Type == RenderCommands::Type::DrawIndexed;
+        });
+        std::copy_if(split.Calls.begin(), split.Calls.end(), std::back_inserter(splitDraws), [](const Call &call) {
+            return call.Type == RenderCommands::Type::DrawIndexed;
+        });
+        CHECK(splitDraws == draws);
+        CHECK(split.Count(RenderCommands::Type::SetPipelineState) == 2);
+    }
+} // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestSize();
+    TestNullBackend();
+    TestSceneRecord();
+    return TestResult();
+}
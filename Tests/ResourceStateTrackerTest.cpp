@@ -0,0 +1,255 @@
+#include "Check.hpp"
+
+#include "MyDXLib/ResourceStateTracker.hpp"
+
+namespace
+{
+    // Keeps the barriers of every call on top of the counts
+    class RecordingBackend : public NullRenderBackend
+    {
+      public:
+        std::vector<std::vector<D3D12_RESOURCE_BARRIER>> Calls;
+
+        void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER *barriers) override
+        {
+            NullRenderBackend::ResourceBarrier(count, barriers);
+            Calls.emplace_back(barriers, barriers + count);
+        }
+    };
+
+    // The tracker only compares and passes on the pointers, nothing dereferences them
+    ID3D12Resource *FakeResource(size_t index)
+    {
+        static int resources[8];
+        return reinterpret_cast<ID3D12Resource *>(&resources[index]);
+    }
+
+    bool IsTransition(const D3D12_RESOURCE_BARRIER &barrier,
+                      ID3D12Resource               *resource,
+                      D3D12_RESOURCE_STATES         before,
+                      D3D12_RESOURCE_STATES         after,
+                      UINT                          subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Transition.pResource == resource
+            && barrier.Transition.StateBefore == before && barrier.Transition.StateAfter == after
+            && barrier.Transition.Subresource == subresource;
+    }
+
+    void TestBeforeStateInference()
+    {
+        ID3D12Resource      *buffer = FakeResource(0);
+        ResourceStateTracker tracker;
+        RecordingBackend     backend;
+
+        tracker.SetState(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.Transition(buffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetState(buffer) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetPendingCount() == 1);
+        tracker.Flush(backend);
+
+        tracker.Transition(buffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Flush(backend);
+
+        CHECK(backend.Calls.size() == 2);
+        CHECK(IsTransition(backend.Calls[0][0],
+                           buffer,
+                           D3D12_RESOURCE_STATE_COPY_DEST,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+        CHECK(IsTransition(backend.Calls[1][0],
+                           buffer,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_RENDER_TARGET));
+        CHECK(backend.GetCounts().BarrierCalls == 2);
+        CHECK(backend.GetCounts().Barriers == 2);
+        CHECK(tracker.GetPendingCount() == 0);
+
+        // Registering again replaces the known state
+        tracker.SetState(buffer, D3D12_RESOURCE_STATE_COMMON);
+        CHECK(tracker.GetState(buffer) == D3D12_RESOURCE_STATE_COMMON);
+    }
+
+    void TestRedundantAndCancelled()
+    {
+        ID3D12Resource      *texture = FakeResource(0);
+        ResourceStateTracker tracker;
+        RecordingBackend     backend;
+
+        tracker.SetState(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetPendingCount() == 0);
+
+        // There and back again before the flush
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetPendingCount() == 0);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.empty());
+        CHECK(backend.GetCounts().BarrierCalls == 0);
+
+        const BarrierStats &stats = tracker.GetStats();
+        CHECK(stats.Transitions == 3);
+        CHECK(stats.RedundantTransitions == 2);
+        CHECK(stats.Barriers == 0);
+        CHECK(stats.BarrierCalls == 0);
+
+        // The cancelled barrier isn't merged into, the next transition gets a barrier of its own
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        CHECK(tracker.GetPendingCount() == 1);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 1 && backend.Calls[0].size() == 1);
+        CHECK(IsTransition(backend.Calls[0][0],
+                           texture,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+        tracker.ResetStats();
+        CHECK(tracker.GetStats().Transitions == 0);
+    }
+
+    void TestLastBarrierMerge()
+    {
+        ID3D12Resource      *a = FakeResource(0);
+        ID3D12Resource      *b = FakeResource(1);
+        ResourceStateTracker tracker;
+        RecordingBackend     backend;
+
+        // Barriers of other resources in between don't keep the transitions of a from merging
+        tracker.SetState(a, D3D12_RESOURCE_STATE_COMMON);
+        tracker.SetState(b, D3D12_RESOURCE_STATE_COMMON);
+        tracker.Transition(a, D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.Transition(b, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        tracker.Transition(a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetPendingCount() == 2);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 1 && backend.Calls[0].size() == 2);
+        CHECK(IsTransition(
+            backend.Calls[0][0], a, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+        CHECK(IsTransition(backend.Calls[0][1], b, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+        // Nothing merges into barriers that were already issued
+        tracker.Transition(a, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 2);
+        CHECK(IsTransition(backend.Calls[1][0],
+                           a,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+        // Only the latest barrier of the resource merges, one of another subresource in between is ordered
+        // against the earlier one
+        ID3D12Resource *texture = FakeResource(2);
+        tracker.SetState(texture, D3D12_RESOURCE_STATE_COMMON, 2);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST, 0);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST, 1);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 3 && backend.Calls[2].size() == 3);
+        CHECK(IsTransition(
+            backend.Calls[2][0], texture, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST, 0));
+        CHECK(IsTransition(
+            backend.Calls[2][1], texture, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST, 1));
+        CHECK(IsTransition(backend.Calls[2][2],
+                           texture,
+                           D3D12_RESOURCE_STATE_COPY_DEST,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           0));
+        CHECK(backend.GetCounts().Barriers == 6);
+        CHECK(tracker.GetStats().Barriers == 6);
+        CHECK(tracker.GetStats().BarrierCalls == 3);
+    }
+
+    void TestSubresourceSplitAndMerge()
+    {
+        ID3D12Resource      *texture = FakeResource(0);
+        ResourceStateTracker tracker;
+        RecordingBackend     backend;
+
+        tracker.SetState(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 3);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET, 1);
+        CHECK(tracker.GetState(texture, 0) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        CHECK(tracker.GetState(texture, 1) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+        CHECK(tracker.GetState(texture, 2) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Flush(backend);
+
+        // The whole resource moves by subresource from diverged states, each from its own state
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 2 && backend.Calls[1].size() == 3);
+        CHECK(IsTransition(backend.Calls[1][0],
+                           texture,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_COPY_SOURCE,
+                           0));
+        CHECK(IsTransition(
+            backend.Calls[1][1], texture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE, 1));
+        CHECK(IsTransition(backend.Calls[1][2],
+                           texture,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                           D3D12_RESOURCE_STATE_COPY_SOURCE,
+                           2));
+
+        // Merged again, so the next one is a single barrier for all subresources
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 3 && backend.Calls[2].size() == 1);
+        CHECK(IsTransition(backend.Calls[2][0],
+                           texture,
+                           D3D12_RESOURCE_STATE_COPY_SOURCE,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+        // Moving every subresource separately into the same state merges them as well
+        for (UINT i = 0; i < 3; ++i)
+            tracker.Transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET, i);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 4 && backend.Calls[3].size() == 3);
+        tracker.Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 5 && backend.Calls[4].size() == 1);
+        CHECK(IsTransition(backend.Calls[4][0],
+                           texture,
+                           D3D12_RESOURCE_STATE_RENDER_TARGET,
+                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+        CHECK_THROWS(tracker.Transition(texture, D3D12_RESOURCE_STATE_RENDER_TARGET, 3));
+        CHECK_THROWS(tracker.GetState(texture, 3));
+    }
+
+    void TestUntracked()
+    {
+        ID3D12Resource      *tracked   = FakeResource(0);
+        ID3D12Resource      *untracked = FakeResource(1);
+        ResourceStateTracker tracker;
+        RecordingBackend     backend;
+
+        tracker.SetState(tracked, D3D12_RESOURCE_STATE_COMMON);
+        CHECK(tracker.IsTracked(tracked));
+        CHECK(!tracker.IsTracked(untracked));
+        CHECK_THROWS(tracker.Transition(untracked, D3D12_RESOURCE_STATE_COPY_DEST));
+        CHECK_THROWS(tracker.GetState(untracked));
+        CHECK(tracker.GetStats().Transitions == 0);
+
+        // Pending barriers of a forgotten resource are still issued
+        tracker.Transition(tracked, D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.Forget(tracked);
+        CHECK(!tracker.IsTracked(tracked));
+        CHECK_THROWS(tracker.Transition(tracked, D3D12_RESOURCE_STATE_COMMON));
+        tracker.Flush(backend);
+        CHECK(backend.Calls.size() == 1 && backend.Calls[0].size() == 1);
+
+        tracker.SetState(tracked, D3D12_RESOURCE_STATE_COMMON);
+        tracker.Clear();
+        CHECK(!tracker.IsTracked(tracked));
+    }
+} // namespace
+
+int main()
+{
+    TestBeforeStateInference();
+    TestRedundantAndCancelled();
+    TestLastBarrierMerge();
+    TestSubresourceSplitAndMerge();
+    TestUntracked();
+    return TestResult();
+}
@@ -0,0 +1,175 @@
+#include "Check.hpp"
+
+#include "MyDXLib/UploadRing.hpp"
+
+namespace
+{
+    constexpr size_t INVALID = RingAllocator::INVALID_OFFSET;
+
+    void TestAlignment()
+    {
+        RingAllocator ring(1024);
+        CHECK(ring.Allocate(10, 1) == 0);
+        CHECK(ring.Allocate(10, 256) == 256);
+        CHECK(ring.Allocate(1, 4) == 268);
+        CHECK(ring.GetUsedSize() == 269);
+
+        // The alignment has to divide the capacity, the size has to fit the ring
+        CHECK(ring.Allocate(1, 3) == INVALID);
+        CHECK(ring.Allocate(1, 2048) == INVALID);
+        CHECK(ring.Allocate(1025, 1) == INVALID);
+        CHECK(ring.GetUsedSize() == 269);
+    }
+
+    void TestWraparound()
+    {
+        RingAllocator ring(1024);
+        CHECK(ring.Allocate(400, 256) == 0);
+        ring.EndFrame(1);
+        CHECK(ring.Allocate(400, 256) == 512);
+        ring.EndFrame(2);
+
+        // Doesn't fit before the end, and the start is still in use by frame 1
+        CHECK(ring.Allocate(200, 256) == INVALID);
+        ring.Retire(1);
+        CHECK(ring.GetUsedSize() == 512 - 400 + 400);
+
+        // Skips the rest of the ring, the skipped bytes stay in use until frame 3 retires
+        CHECK(ring.Allocate(200, 256) == 0);
+        CHECK(ring.GetUsedSize() == 1024 - 400 + 200);
+        ring.EndFrame(3);
+        // The tail is at the end of frame 1, only the bytes up to it are free
+        CHECK(ring.Allocate(201, 1) == INVALID);
+        CHECK(ring.Allocate(200, 1) == 200);
+        CHECK(ring.Allocate(1, 1) == INVALID);
+
+        ring.Retire(2);
+        CHECK(ring.Allocate(100, 256) == 512);
+        ring.EndFrame(4);
+        ring.Retire(4);
+        CHECK(ring.GetUsedSize() == 0);
+
+        // An empty ring starts over at 0 and fits the whole capacity
+        CHECK(ring.Allocate(1024, 1024) == 0);
+        CHECK(ring.Allocate(1, 1) == INVALID);
+        ring.EndFrame(5);
+        ring.Retire(5);
+        CHECK(ring.Allocate(1000, 1) == 0);
+        CHECK(ring.Allocate(24, 1) == 1000);
+        CHECK(ring.GetUsedSize() == 1024);
+    }
+
+    void TestRetireOrder()
+    {
+        RingAllocator ring(1024);
+        ring.Allocate(100, 1);
+        ring.EndFrame(1);
+        ring.Allocate(100, 1);
+        ring.EndFrame(2);
+        ring.Allocate(100, 1);
+        ring.EndFrame(3);
+
+        ring.Retire(0);
+        CHECK(ring.GetUsedSize() == 300);
+        ring.Retire(2);
+        CHECK(ring.GetUsedSize() == 100);
+        ring.Retire(2);
+        CHECK(ring.GetUsedSize() == 100);
+
+        // Allocations after the last EndFrame are not retired with it
+        ring.Allocate(50, 1);
+        ring.Retire(3);
+        CHECK(ring.GetUsedSize() == 50);
+        ring.EndFrame(4);
+        ring.Retire(UINT64_MAX);
+        CHECK(ring.GetUsedSize() == 0);
+
+        // A frame ended on the empty ring retires without moving the tail back before the start over
+        ring.EndFrame(5);
+        CHECK(ring.Allocate(1024, 1) == 0);
+        ring.Retire(5);
+        CHECK(ring.GetUsedSize() == 1024);
+        ring.EndFrame(6);
+        ring.Retire(6);
+        CHECK(ring.GetUsedSize() == 0);
+    }
+
+    // Random allocations over frames retired with a random lag, checked against a map of the bytes in use
+    void TestRandomized()
+    {
+        constexpr size_t CAPACITY    = 4096;
+        constexpr size_t ALLOCATIONS = 200000;
+
+        using Range = std::pair<size_t, size_t>;
+        RingAllocator                  ring(CAPACITY);
+        std::vector<uint8_t>           used(CAPACITY, 0);
+        std::deque<std::vector<Range>> inFlight; // Allocations of every frame not retired yet, oldest first
+        std::vector<Range>             current;
+        std::mt19937                   random(11);
+        UINT64                         fence     = 0;
+        UINT64                         completed = 0;
+        size_t                         usedBytes = 0;
+        size_t                         failures  = 0;
+        bool                           valid     = true;
+
+        for (size_t allocations = 0; allocations < ALLOCATIONS;)
+        {
+            for (size_t count = 1 + random() % 8; count > 0; --count, ++allocations)
+            {
+                size_t size      = 1 + random() % 600;
+                size_t alignment = size_t(1) << (random() % 9);
+                size_t offset    = ring.Allocate(size, alignment);
+                if (offset == INVALID)
+                {
+                    // Only a ring with something in use may be full
+                    valid = valid && !(inFlight.empty() && current.empty());
+                    ++failures;
+                    continue;
+                }
+
+                valid = valid && offset % alignment == 0 && offset + size <= CAPACITY;
+                for (size_t b = offset; b < offset + size && b < CAPACITY; ++b)
+                {
+                    valid   = valid && !used[b];
+                    used[b] = 1;
+                }
+                usedBytes += size;
+                current.push_back({offset, size});
+            }
+
+            ring.EndFrame(++fence);
+            inFlight.push_back(std::move(current));
+            current.clear();
+
+            // The GPU runs up to three frames behind
+            UINT64 target = fence - std::min<UINT64>(fence, random() % 4);
+            for (; completed < target; ++completed)
+            {
+                for (auto [offset, size] : inFlight.front())
+                {
+                    std::fill(used.begin() + offset, used.begin() + offset + size, 0);
+                    usedBytes -= size;
+                }
+                inFlight.pop_front();
+            }
+            ring.Retire(completed);
+            valid = valid && ring.GetUsedSize() >= usedBytes && ring.GetUsedSize() <= CAPACITY;
+        }
+
+        CHECK(valid);
+        // Full rings have to come up for the test to mean anything, but not all the time
+        CHECK(failures > 0 && failures < ALLOCATIONS / 4);
+        ring.Retire(fence);
+        CHECK(ring.GetUsedSize() == 0);
+        CHECK(ring.Allocate(CAPACITY, CAPACITY) == 0);
+    }
+} // namespace
+
+int main()
+{
+    TestAlignment();
+    TestWraparound();
+    TestRetireOrder();
+    TestRandomized();
+    return TestResult();
+}
@@ -0,0 +1,95 @@
+#include "Bench.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/GltfLoader.hpp"
+#include "MyDXLib/MappedFile.hpp"
+#include "MyDXLib/SceneCache.hpp"
+
+namespace
+{
+    constexpr size_t MESHES    = 32;
+    constexpr size_t GRID_SIZE = 180; // 181 x 181 vertices per mesh
+    constexpr size_t PAGE_SIZE = 4096;
+
+    void WriteScene(const std::filesystem::path &path)
+    {
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(GRID_SIZE, positions, indices);
+        for (size_t i = 0; i < MESHES; ++i)
+        {
+            size_t material = writer.AddMaterial("texture" + std::to_string(i) + ".png");
+            size_t mesh     = writer.AddMesh(positions, indices, material);
+            writer.AddNode(GltfWriter::NONE, mesh, {static_cast<float>(i * GRID_SIZE), 0.0f, 0.0f});
+        }
+        writer.Write(path);
+    }
+} // namespace
+
+// What a cache hit costs next to an import, and how much of it is copying the blobs out of the mapping
+int main()
+{
+    ScratchDirectory      directory("SceneCacheBench");
+    std::filesystem::path scene = directory.Path() / "Scene.gltf";
+    std::filesystem::path cache = directory.Path() / "Scene.scenecache";
+    WriteScene(scene);
+
+    SceneData imported;
+    GltfLoader::Load(scene, imported);
+    SceneCache::Key key = SceneCache::MakeKey(scene, 0);
+    SceneCache::Save(cache, key, imported);
+    size_t cacheSize = std::filesystem::file_size(cache);
+
+    double importMs = MeasureMs([&] {
+        SceneData sceneData;
+        GltfLoader::Load(scene, sceneData);
+    });
+    double loadMs = MeasureMs([&] {
+        SceneData sceneData;
+        SceneCache::Load(cache, key, sceneData);
+    });
+
+    // What the cache saves with processing on, a miss imports, processes and saves
+    SceneImportOptions options;
+    options.Importer      = SCENE_IMPORTER_GLTF;
+    options.Format        = VERTEX_FORMAT_QUANTIZED;
+    options.BuildMeshlets = true;
+    double missMs         = MeasureMs([&] {
+        std::filesystem::remove(SceneCache::CachePathFor(scene));
+        SceneData sceneData;
+        sceneData.LoadFromFile(scene, options);
+    });
+    double hitMs          = MeasureMs([&] {
+        SceneData sceneData;
+        sceneData.LoadFromFile(scene, options);
+    });
+
+    // Lower bound of a cache that keeps views into the mapping: map the file and fault in every page
+    volatile char sink  = 0;
+    double        mapMs = MeasureMs([&] {
+        MappedFile file(cache);
+        char       sum = 0;
+        for (size_t offset = 0; offset < file.Size(); offset += PAGE_SIZE)
+            sum += file.Data()[offset];
+        sink = sum;
+    });
+    double copyMs = MeasureMs([&] {
+        MappedFile        file(cache);
+        std::vector<char> bytes(file.Data(), file.Data() + file.Size());
+        if (!bytes.empty())
+            sink = bytes.back();
+    });
+
+    std::printf("%zu meshes %zu vertices, cache %.1f MB\n",
+                imported.GetMeshes().size(),
+                MESHES * (GRID_SIZE + 1) * (GRID_SIZE + 1),
+                cacheSize / (1024.0 * 1024.0));
+    std::printf("glTF import     %9.3f ms\n", importMs);
+    std::printf("cache load      %9.3f ms\n", loadMs);
+    std::printf("processed miss  %9.3f ms\n", missMs);
+    std::printf("processed hit   %9.3f ms\n", hitMs);
+    std::printf("map and touch   %9.3f ms\n", mapMs);
+    std::printf("map and copy    %9.3f ms\n", copyMs);
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "Check.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/SceneCache.hpp"
+
+namespace
+{
+    // Same counts for every scale, so the .gltf file stays the same and only the .bin file changes
+    void WriteScene(const std::filesystem::path &path, float scale)
+    {
+        GltfWriter writer;
+        size_t     stone = writer.AddMaterial("stone.png");
+        size_t     wood  = writer.AddMaterial("wood.png");
+
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        size_t                         meshes[3];
+        size_t                         sizes[3]     = {8, 40, 3};
+        size_t                         materials[3] = {stone, wood, GltfWriter::NONE};
+        for (size_t i = 0; i < 3; ++i)
+        {
+            MakeGrid(sizes[i], positions, indices);
+            for (auto &p : positions)
+                p = DirectX::XMFLOAT3(p.x * scale, std::sin(p.x + p.z) * scale, p.z * scale);
+            meshes[i] = writer.AddMesh(positions, indices, materials[i]);
+        }
+
+        size_t root  = writer.AddNode(GltfWriter::NONE, meshes[0]);
+        size_t child = writer.AddNode(root, meshes[1], {10.0f, 0.0f, 0.0f});
+        writer.AddNode(child, meshes[2], {0.0f, 5.0f, 0.0f});
+        size_t group = writer.AddNode(GltfWriter::NONE, GltfWriter::NONE, {-20.0f, 0.0f, 0.0f});
+        writer.AddNode(group, meshes[0]);
+        writer.AddNode(group, meshes[2], {0.0f, 0.0f, 3.0f});
+        writer.Write(path);
+    }
+
+    template <typename T> bool SameBytes(const std::vector<T> &a, const std::vector<T> &b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+    }
+
+    bool SameFloat3(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    bool SameScene(const SceneData &a, const SceneData &b)
+    {
+        if (a.GetTexturePaths() != b.GetTexturePaths() || a.GetMaterials().size() != b.GetMaterials().size()
+            || a.GetMeshes().size() != b.GetMeshes().size())
+            return false;
+        for (size_t i = 0; i < a.GetMaterials().size(); ++i)
+            for (size_t t = 0; t < TEXTURE_TYPE_COUNT; ++t)
+                if (a.GetMaterials()[i].TexturePaths[t] != b.GetMaterials()[i].TexturePaths[t])
+                    return false;
+
+        for (size_t i = 0; i < a.GetMeshes().size(); ++i)
+        {
+            const MeshData &x = a.GetMeshes()[i];
+            const MeshData &y = b.GetMeshes()[i];
+            if (x.VertexCount() != y.VertexCount() || x.SingleVertexSize() != y.SingleVertexSize()
+                || x.IndexCount() != y.IndexCount() || x.SingleIndexSize() != y.SingleIndexSize()
+                || x.VertexBufferSize() != y.VertexBufferSize() || x.IndexBufferSize() != y.IndexBufferSize())
+                return false;
+            if (std::memcmp(x.VertexBufferStart(), y.VertexBufferStart(), x.VertexBufferSize()) != 0
+                || std::memcmp(x.IndexBufferStart(), y.IndexBufferStart(), x.IndexBufferSize()) != 0)
+                return false;
+            if (x.m_MaterialIndex != y.m_MaterialIndex || x.m_VertexFormat != y.m_VertexFormat
+                || !SameFloat3(x.m_BoundsMin, y.m_BoundsMin) || !SameFloat3(x.m_BoundsMax, y.m_BoundsMax))
+                return false;
+            if (!SameBytes(x.m_Meshlets, y.m_Meshlets) || !SameBytes(x.m_MeshletVertices, y.m_MeshletVertices)
+                || !SameBytes(x.m_MeshletTriangles, y.m_MeshletTriangles) || !SameBytes(x.m_Lods, y.m_Lods))
+                return false;
+        }
+        return SameBytes(a.GetObjects(), b.GetObjects()) && SameBytes(a.GetObjectMeshes(), b.GetObjectMeshes());
+    }
+
+    void TestRoundTrip(const std::filesystem::path &scene, const SceneImportOptions &options)
+    {
+        std::filesystem::path cachePath = SceneCache::CachePathFor(scene);
+        std::filesystem::remove(cachePath);
+
+        // The first load imports and writes the cache, the second one reads it back
+        SceneData imported;
+        imported.LoadFromFile(scene, options);
+        CHECK(std::filesystem::exists(cachePath));
+        CHECK(imported.GetMeshes().size() >= 3);
+        CHECK(imported.GetObjects().size() == 7);
+        CHECK(imported.TextureCount() == 2);
+
+        SceneData cached;
+        cached.LoadFromFile(scene, options);
+        CHECK(SameScene(imported, cached));
+
+        SceneCache::Key       key       = {1, 2};
+        std::filesystem::path otherPath = cachePath;
+        otherPath += ".other";
+        SceneCache::Save(otherPath, key, imported);
+        SceneData loaded;
+        CHECK(SceneCache::Load(otherPath, key, loaded));
+        CHECK(SameScene(imported, loaded));
+        std::filesystem::remove(otherPath);
+    }
+
+    void TestStaleAndCorrupted(const std::filesystem::path &scene)
+    {
+        std::filesystem::path binPath = scene;
+        binPath.replace_extension(".bin");
+        std::filesystem::path cachePath = scene.parent_path() / "Manual.scenecache";
+
+        SceneImportOptions options;
+        options.Importer = SCENE_IMPORTER_GLTF;
+        SceneData original;
+        original.LoadFromFile(scene, options);
+
+        SceneCache::Key key = SceneCache::MakeKey(scene, 7);
+        CHECK(SceneCache::MakeKey(scene, 7).SourceHash == key.SourceHash);
+        CHECK(SceneCache::MakeKey(scene, 8).ImportFlags != key.ImportFlags);
+        SceneCache::Save(cachePath, key, original);
+
+        SceneData loaded;
+        CHECK(SceneCache::Load(cachePath, key, loaded));
+        CHECK(!SceneCache::Load(cachePath, SceneCache::MakeKey(scene, 8), loaded));
+
+        // Only the buffer changes, the .gltf file is the same byte for byte. Its write time is moved on, two
+        // writes in a row may get the same one on coarse file systems.
+        auto writeTime = std::filesystem::last_write_time(binPath);
+        WriteScene(scene, 2.0f);
+        std::filesystem::last_write_time(binPath, writeTime + std::chrono::seconds(2));
+        SceneCache::Key changed = SceneCache::MakeKey(scene, 7);
+        CHECK(changed.SourceHash != key.SourceHash);
+        CHECK(!SceneCache::Load(cachePath, changed, loaded));
+
+        SceneData reloaded;
+        reloaded.LoadFromFile(scene, options);
+        CHECK(reloaded.GetMeshes()[1].m_BoundsMax.x == 2.0f * original.GetMeshes()[1].m_BoundsMax.x);
+
+        // A missing buffer changes the key as well instead of failing
+        std::filesystem::path movedPath = binPath;
+        movedPath += ".moved";
+        std::filesystem::rename(binPath, movedPath);
+        CHECK(SceneCache::MakeKey(scene, 7).SourceHash != changed.SourceHash);
+        std::filesystem::rename(movedPath, binPath);
+
+        // Truncated and damaged caches are rejected
+        SceneCache::Save(cachePath, changed, reloaded);
+        std::vector<char> bytes(std::filesystem::file_size(cachePath));
+        std::ifstream(cachePath, std::ios::binary).read(bytes.data(), bytes.size());
+
+        std::ofstream(cachePath, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() / 2);
+        CHECK(!SceneCache::Load(cachePath, changed, loaded));
+
+        std::vector<char> damaged = bytes;
+        damaged[4] ^= 1; // Version
+        std::ofstream(cachePath, std::ios::binary | std::ios::trunc).write(damaged.data(), damaged.size());
+        CHECK(!SceneCache::Load(cachePath, changed, loaded));
+
+        std::ofstream(cachePath, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+        CHECK(SceneCache::Load(cachePath, changed, loaded));
+        CHECK(SameScene(reloaded, loaded));
+    }
+} // namespace
+
+int main()
+{
+    ScratchDirectory      directory("SceneCacheTest");
+    std::filesystem::path scene = directory.Path() / "Scene.gltf";
+    WriteScene(scene, 1.0f);
+
+    std::vector<SceneImporter> importers = {SCENE_IMPORTER_GLTF};
+#ifdef TESTS_HAVE_ASSIMP
+    importers.push_back(SCENE_IMPORTER_ASSIMP);
+#else
+    std::cout << "Assimp not found, only the glTF importer is round tripped" << std::endl;
+#endif
+
+    for (SceneImporter importer : importers)
+    {
+        SceneImportOptions options;
+        options.Importer = importer;
+        TestRoundTrip(scene, options);
+
+        options.Format = VERTEX_FORMAT_COMPACT;
+        TestRoundTrip(scene, options);
+
+        options.Format         = VERTEX_FORMAT_QUANTIZED;
+        options.OptimizeMeshes = true;
+        options.NarrowIndices  = true;
+        options.SplitMeshes    = true;
+        options.BuildMeshlets  = true;
+        options.GenerateLods   = true;
+        TestRoundTrip(scene, options);
+    }
+
+    TestStaleAndCorrupted(scene);
+    return TestResult();
+}
@@ -0,0 +1,110 @@
+#include "Bench.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/Scene.hpp"
+
+namespace
+{
+    constexpr size_t GRID      = 100; // 100 x 100 instances
+    constexpr size_t MATERIALS = 8;
+    constexpr float  SPACING   = 4.0f;
+
+    // Every node references one of uniqueMeshes small meshes, laid out on a grid in the xz plane
+    void WriteScene(const std::filesystem::path &path, size_t uniqueMeshes)
+    {
+        GltfWriter writer;
+        size_t     materials[MATERIALS];
+        for (size_t i = 0; i < MATERIALS; ++i)
+            materials[i] = writer.AddMaterial("texture" + std::to_string(i) + ".png");
+
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        MakeGrid(2, positions, indices);
+        for (size_t i = 0; i < uniqueMeshes; ++i)
+            writer.AddMesh(positions, indices, materials[i % MATERIALS]);
+
+        for (size_t i = 0; i < GRID * GRID; ++i)
+        {
+            DirectX::XMFLOAT3 translation(static_cast<float>(i % GRID) * SPACING,
+                                          0.0f,
+                                          static_cast<float>(i / GRID) * SPACING);
+            writer.AddNode(GltfWriter::NONE, i % uniqueMeshes, translation);
+        }
+        writer.Write(path);
+    }
+} // namespace
+
+// 10k instances through Scene::Prepare and Scene::Record, replayed into a NullRenderBackend. The scene reuses
+// fewer and fewer meshes, so the instanced draws follow the number of unique meshes instead of the instances.
+int main()
+{
+    ScratchDirectory directory("SceneInstancingBench");
+
+    // Straight down onto the middle of the grid with a 90 degree field of view, every instance is in view. View x
+    // is world x, view y world z and the depth falls with world y. Depth 0 at 1 unit, 1 at 1000 units.
+    constexpr float   NEAR_PLANE = 1.0f;
+    constexpr float   FAR_PLANE  = 1000.0f;
+    float             center     = GRID * SPACING * 0.5f;
+    float             a          = FAR_PLANE / (FAR_PLANE - NEAR_PLANE);
+    DirectX::XMMATRIX model      = DirectX::XMMatrixIdentity();
+    DirectX::XMMATRIX view       = DirectX::XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f,  // row 0
+                                                        0.0f, 0.0f, -1.0f, 0.0f, // row 1
+                                                        0.0f, 1.0f, 0.0f, 0.0f,  // row 2
+                                                        -center, -center, 2.0f * center, 1.0f);
+    DirectX::XMMATRIX projection = DirectX::XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, // row 0
+                                                        0.0f, 1.0f, 0.0f, 0.0f, // row 1
+                                                        0.0f, 0.0f, a, 1.0f,    // row 2
+                                                        0.0f, 0.0f, -a * NEAR_PLANE, 0.0f);
+    auto              pipeline   = reinterpret_cast<ID3D12PipelineState *>(0x1000);
+
+    for (size_t uniqueMeshes : {size_t(10000), size_t(1000), size_t(100), size_t(10), size_t(1)})
+    {
+        std::filesystem::path path = directory.Path() / ("Scene" + std::to_string(uniqueMeshes) + ".gltf");
+        WriteScene(path, uniqueMeshes);
+
+        SceneImportOptions options;
+        options.Importer = SCENE_IMPORTER_GLTF;
+        SceneData data;
+        data.LoadFromFile(path, options);
+
+        DescriptorAllocator descriptors(PDevice(), 16, 16);
+        Scene               scene;
+        scene.Describe(descriptors, data);
+
+        UploadRing uploadRing(UploadRing::DEFAULT_CAPACITY);
+        UINT64     frame     = 0;
+        double     prepareMs = MeasureMs([&] {
+            scene.Prepare(uploadRing, pipeline, model, view, projection);
+            uploadRing.EndFrame(++frame);
+            uploadRing.Retire(frame);
+        });
+
+        RenderCommands commands;
+        double         recordMs = MeasureMs([&] {
+            commands.Clear();
+            scene.Record(commands, 0, scene.GetDrawCount());
+        });
+
+        NullRenderBackend backend;
+        double            replayMs = MeasureMs([&] {
+            backend.Reset();
+            commands.Replay(backend);
+        });
+
+        const SceneDrawStats            &stats  = scene.GetStats();
+        const NullRenderBackend::Counts &counts = backend.GetCounts();
+        std::printf("%5zu meshes %5zu visible %5zu draws %5zu instances  prepare %6.3f ms (cull %6.3f occlude %6.3f "
+                    "sort %6.3f)  record %6.3f ms  replay %6.3f ms\n",
+                    uniqueMeshes,
+                    stats.Draws,
+                    counts.Draws,
+                    counts.Instances,
+                    prepareMs,
+                    stats.CullingMilliseconds,
+                    stats.OcclusionMilliseconds,
+                    stats.SortMilliseconds,
+                    recordMs,
+                    replayMs);
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "Bench.hpp"
+#include "GltfWriter.hpp"
+
+#include "MyDXLib/Scene.hpp"
+
+namespace
+{
+    constexpr size_t GROUPS         = 1000;
+    constexpr size_t GROUP_CHILDREN = 99; // 100k objects in groups of a root and its children
+
+    void WriteScene(const std::filesystem::path &path)
+    {
+        GltfWriter                     writer;
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<uint32_t>          indices;
+        size_t                         meshes[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            MakeGrid(i + 1, positions, indices);
+            meshes[i] = writer.AddMesh(positions, indices, writer.AddMaterial("texture.png"));
+        }
+        for (size_t g = 0; g < GROUPS; ++g)
+        {
+            size_t root = writer.AddNode(GltfWriter::NONE, meshes[g % 4], {static_cast<float>(g) * 10.0f, 0.0f, 0.0f});
+            for (size_t c = 0; c < GROUP_CHILDREN; ++c)
+                writer.AddNode(root, meshes[c % 4], {0.0f, static_cast<float>(c) * 2.0f, 0.0f});
+        }
+        writer.Write(path);
+    }
+} // namespace
+
+// Cost of UpdateTransforms against the share of objects whose local transform changed since the last call.
+// The changed objects are picked at random, a changed root drags its children along.
+int main()
+{
+    ScratchDirectory      directory("SceneTransformsBench");
+    std::filesystem::path path = directory.Path() / "Scene.gltf";
+    WriteScene(path);
+
+    SceneImportOptions options;
+    options.Importer = SCENE_IMPORTER_GLTF;
+    SceneData data;
+    data.LoadFromFile(path, options);
+
+    DescriptorAllocator descriptors(PDevice(), 16, 16);
+    Scene               scene;
+    scene.Describe(descriptors, data);
+    size_t objects = scene.GetObjectCount();
+
+    DirectX::XMMATRIX model = DirectX::XMMatrixIdentity();
+    scene.UpdateTransforms(model);
+
+    std::printf("%zu objects\n", objects);
+
+    std::mt19937 random(1);
+    for (double fraction : {0.0, 0.001, 0.01, 0.1, 0.5, 1.0})
+    {
+        std::vector<size_t> changed(objects);
+        std::iota(changed.begin(), changed.end(), size_t(0));
+        std::shuffle(changed.begin(), changed.end(), random);
+        changed.resize(static_cast<size_t>(fraction * objects));
+        std::sort(changed.begin(), changed.end());
+
+        size_t updated = 0;
+        double ms      = MeasureMs([&] {
+            for (size_t i : changed)
+                scene.SetLocalTransform(i, scene.GetLocalTransform(i));
+            scene.UpdateTransforms(model);
+            updated = scene.GetStats().UpdatedTransforms;
+        });
+        std::printf("%5.1f%% changed %7zu updated %8.3f ms %6.2f ns/object\n",
+                    fraction * 100.0,
+                    updated,
+                    ms,
+                    1e6 * ms / objects);
+    }
+
+    // A new model matrix moves every object, the baseline the dirty flags save
+    double ms = MeasureMs([&] {
+        model = model * DirectX::XMMatrixTranslation(0.0f, 0.0f, 1.0f);
+        scene.UpdateTransforms(model);
+    });
+    std::printf("model changed %7zu updated %8.3f ms %6.2f ns/object\n", objects, ms, 1e6 * ms / objects);
+    return 0;
+}
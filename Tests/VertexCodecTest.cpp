@@ -0,0 +1,263 @@
+#include "Check.hpp"
+
+#include "MyDXLib/VertexCodec.hpp"
+
+using namespace DirectX;
+
+namespace
+{
+    // Bounds the compact formats were designed to, in degrees for the directions
+    constexpr float NORMAL_ERROR  = 0.04f;
+    constexpr float TANGENT_ERROR = 0.24f;
+    constexpr float HALF_ERROR    = 1.0f / 2048.0f; // Relative, half of the 10 bit mantissa step
+
+    constexpr size_t RANDOM_VECTORS = 1000000;
+    constexpr float  PI             = 3.14159265f;
+
+    float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    XMFLOAT3 Normalize(const XMFLOAT3 &v)
+    {
+        float length = std::sqrt(Dot(v, v));
+        return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+    }
+
+    float AngleDegrees(const XMFLOAT3 &a, const XMFLOAT3 &b)
+    {
+        // atan2 stays accurate for the tiny angles, acos of the dot product doesn't
+        return std::atan2(std::sqrt(Dot(Cross(a, b), Cross(a, b))), Dot(a, b)) * 180.0f / PI;
+    }
+
+    // Random unit vectors, plus the axes, the diagonals and the fold of the octahedron where z is 0
+    std::vector<XMFLOAT3> Directions()
+    {
+        std::vector<XMFLOAT3> directions;
+        for (float x : {-1.0f, 0.0f, 1.0f})
+            for (float y : {-1.0f, 0.0f, 1.0f})
+                for (float z : {-1.0f, 0.0f, 1.0f})
+                    if (x != 0.0f || y != 0.0f || z != 0.0f)
+                        directions.push_back(Normalize(XMFLOAT3(x, y, z)));
+        for (int i = 0; i < 360; ++i)
+        {
+            float angle = i * PI / 180.0f;
+            directions.push_back(XMFLOAT3(std::cos(angle), std::sin(angle), 0.0f));
+            directions.push_back(Normalize(XMFLOAT3(std::cos(angle), std::sin(angle), -1e-4f)));
+        }
+
+        std::mt19937                    random(4);
+        std::normal_distribution<float> normal;
+        while (directions.size() < RANDOM_VECTORS)
+        {
+            XMFLOAT3 v(normal(random), normal(random), normal(random));
+            if (Dot(v, v) > 1e-6f)
+                directions.push_back(Normalize(v));
+        }
+        return directions;
+    }
+
+    void TestOctahedral(const std::vector<XMFLOAT3> &directions)
+    {
+        // Without quantization the mapping only loses float precision
+        float worst = 0.0f;
+        for (auto &&v : directions)
+        {
+            XMFLOAT2 e = VertexCodec::OctEncode(v);
+            CHECK(std::abs(e.x) <= 1.0f && std::abs(e.y) <= 1.0f);
+            worst = (std::max)(worst, AngleDegrees(v, VertexCodec::OctDecode(e)));
+        }
+        CHECK(worst < 0.001f);
+    }
+
+    void TestNormals(const std::vector<XMFLOAT3> &directions)
+    {
+        float worst = 0.0f;
+        for (auto &&v : directions)
+        {
+            int16_t packed[2];
+            VertexCodec::PackNormal(v, packed);
+            worst = (std::max)(worst, AngleDegrees(v, VertexCodec::UnpackNormal(packed)));
+        }
+        std::printf("normals:  worst %.4f degrees\n", worst);
+        CHECK(worst <= NORMAL_ERROR);
+    }
+
+    void TestTangents(const std::vector<XMFLOAT3> &directions)
+    {
+        float worst = 0.0f;
+        for (size_t i = 0; i < directions.size(); ++i)
+        {
+            float    sign         = i % 2 ? -1.0f : 1.0f;
+            uint32_t packed       = VertexCodec::PackTangent(directions[i], sign);
+            float    unpackedSign = 0.0f;
+            XMFLOAT3 unpacked     = VertexCodec::UnpackTangent(packed, unpackedSign);
+            worst                 = (std::max)(worst, AngleDegrees(directions[i], unpacked));
+            CHECK(unpackedSign == sign);
+        }
+        std::printf("tangents: worst %.4f degrees\n", worst);
+        CHECK(worst <= TANGENT_ERROR);
+    }
+
+    void TestUVs()
+    {
+        std::mt19937                          random(5);
+        std::uniform_real_distribution<float> distribution(-8.0f, 8.0f);
+        for (size_t i = 0; i < 100000; ++i)
+        {
+            XMFLOAT2 uv(distribution(random), i % 100 == 0 ? 0.0f : distribution(random));
+            uint16_t packed[2];
+            VertexCodec::PackUV(uv, packed);
+            XMFLOAT2 unpacked = VertexCodec::UnpackUV(packed);
+            // Subnormal halves below 2^-14 have an absolute step of 2^-24
+            CHECK(std::abs(unpacked.x - uv.x) <= (std::max)(std::abs(uv.x) * HALF_ERROR, 1.0f / (1 << 25)));
+            CHECK(std::abs(unpacked.y - uv.y) <= (std::max)(std::abs(uv.y) * HALF_ERROR, 1.0f / (1 << 25)));
+        }
+
+        // Texture coordinates in [0, 1] land on the same half, the corners exactly
+        for (float v : {0.0f, 0.5f, 1.0f})
+        {
+            uint16_t packed[2];
+            VertexCodec::PackUV(XMFLOAT2(v, v), packed);
+            CHECK(VertexCodec::UnpackUV(packed).x == v);
+        }
+    }
+
+    void TestPositions()
+    {
+        std::mt19937                          random(6);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (float extent : {0.01f, 1.0f, 1000.0f})
+        {
+            XMFLOAT3 boundsMin(-3.0f * extent, 5.0f, 0.0f);
+            XMFLOAT3 boundsMax(boundsMin.x + extent, boundsMin.y + 2.0f * extent, boundsMin.z + extent / 2.0f);
+            XMFLOAT3 size(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z);
+
+            // Half a step of the 16 bit grid, with room for the float rounding of the bounds
+            auto bound = [&](float axisSize, float lo) {
+                return axisSize / 65535.0f * 0.5f + (std::abs(lo) + axisSize) * 4.0f * FLT_EPSILON;
+            };
+            for (size_t i = 0; i < 100000; ++i)
+            {
+                XMFLOAT3 p(boundsMin.x + unit(random) * size.x,
+                           boundsMin.y + unit(random) * size.y,
+                           boundsMin.z + unit(random) * size.z);
+                if (i == 0)
+                    p = boundsMin;
+                if (i == 1)
+                    p = boundsMax;
+
+                uint16_t packed[4];
+                VertexCodec::QuantizePosition(p, boundsMin, boundsMax, packed);
+                XMFLOAT3 q = VertexCodec::DequantizePosition(packed, boundsMin, boundsMax);
+                CHECK(std::abs(q.x - p.x) <= bound(size.x, boundsMin.x));
+                CHECK(std::abs(q.y - p.y) <= bound(size.y, boundsMin.y));
+                CHECK(std::abs(q.z - p.z) <= bound(size.z, boundsMin.z));
+                CHECK(packed[3] == 0);
+            }
+        }
+
+        // A flat axis keeps its single value
+        XMFLOAT3 flatMin(0.0f, 2.0f, 0.0f);
+        XMFLOAT3 flatMax(1.0f, 2.0f, 1.0f);
+        uint16_t packed[4];
+        VertexCodec::QuantizePosition(XMFLOAT3(0.5f, 2.0f, 0.25f), flatMin, flatMax, packed);
+        CHECK(VertexCodec::DequantizePosition(packed, flatMin, flatMax).y == 2.0f);
+    }
+
+    // Whole meshes through Encode, with both bitangent signs
+    void TestEncodeMesh(VertexFormat format)
+    {
+        std::mt19937                          random(7);
+        std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+        std::vector<VertexData>               vertices(3000);
+        std::vector<uint32_t>                 indices(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            VertexData &v = vertices[i];
+            v.pos         = XMFLOAT3(distribution(random), distribution(random), distribution(random));
+            v.normal      = Normalize(XMFLOAT3(distribution(random), distribution(random), distribution(random)));
+            XMFLOAT3 t    = Normalize(XMFLOAT3(distribution(random), distribution(random), distribution(random)));
+            v.tangent     = Normalize(Cross(Cross(v.normal, t), v.normal));
+            v.bitangent   = Cross(v.normal, v.tangent);
+            if (i % 3 == 0)
+                v.bitangent = XMFLOAT3(-v.bitangent.x, -v.bitangent.y, -v.bitangent.z);
+            v.uv       = XMFLOAT2(distribution(random), distribution(random));
+            indices[i] = static_cast<uint32_t>(i);
+        }
+
+        MeshData mesh;
+        mesh.InitData(vertices.data(), vertices.size(), indices.data(), indices.size());
+        mesh.ComputeBounds();
+        VertexCodec::Encode(mesh, format);
+        CHECK(mesh.m_VertexFormat == format);
+        CHECK(mesh.SingleVertexSize() == VertexCodec::VertexSize(format));
+        CHECK(mesh.VertexBufferSize() == vertices.size() * VertexCodec::VertexSize(format));
+        CHECK(mesh.GetIndices() == indices);
+
+        XMFLOAT3 size(mesh.m_BoundsMax.x - mesh.m_BoundsMin.x,
+                      mesh.m_BoundsMax.y - mesh.m_BoundsMin.y,
+                      mesh.m_BoundsMax.z - mesh.m_BoundsMin.z);
+        float positionError = format == VERTEX_FORMAT_QUANTIZED
+                                  ? (std::max)({size.x, size.y, size.z}) / 65535.0f * 0.5f + 1e-5f
+                                  : 0.0f;
+        std::vector<XMFLOAT3> positions = VertexCodec::DecodePositions(mesh);
+        CHECK(positions.size() == vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const VertexData &v = vertices[i];
+            CHECK(std::abs(positions[i].x - v.pos.x) <= positionError);
+            CHECK(std::abs(positions[i].y - v.pos.y) <= positionError);
+            CHECK(std::abs(positions[i].z - v.pos.z) <= positionError);
+
+            // The normal, tangent and UV are the same fields in both formats
+            const int16_t  *normal;
+            uint32_t        tangent;
+            const uint16_t *uv;
+            if (format == VERTEX_FORMAT_QUANTIZED)
+            {
+                auto &encoded = static_cast<const QuantizedVertexData *>(mesh.VertexBufferStart())[i];
+                normal        = encoded.normal;
+                tangent       = encoded.tangent;
+                uv            = encoded.uv;
+            }
+            else
+            {
+                auto &encoded = static_cast<const CompactVertexData *>(mesh.VertexBufferStart())[i];
+                normal        = encoded.normal;
+                tangent       = encoded.tangent;
+                uv            = encoded.uv;
+            }
+
+            // The shader rebuilds the bitangent as cross(normal, tangent) * sign
+            float    sign       = 0.0f;
+            XMFLOAT3 n          = VertexCodec::UnpackNormal(normal);
+            XMFLOAT3 t          = VertexCodec::UnpackTangent(tangent, sign);
+            XMFLOAT3 cross      = Cross(n, t);
+            XMFLOAT3 b          = XMFLOAT3(cross.x * sign, cross.y * sign, cross.z * sign);
+            XMFLOAT2 unpackedUv = VertexCodec::UnpackUV(uv);
+            CHECK(AngleDegrees(v.normal, n) <= NORMAL_ERROR);
+            CHECK(AngleDegrees(v.tangent, t) <= TANGENT_ERROR);
+            CHECK(AngleDegrees(v.bitangent, b) <= NORMAL_ERROR + TANGENT_ERROR);
+            CHECK(std::abs(unpackedUv.x - v.uv.x) <= std::abs(v.uv.x) * HALF_ERROR + 1e-7f);
+            CHECK(std::abs(unpackedUv.y - v.uv.y) <= std::abs(v.uv.y) * HALF_ERROR + 1e-7f);
+        }
+    }
+} // namespace
+
+int main()
+{
+    std::vector<XMFLOAT3> directions = Directions();
+    TestOctahedral(directions);
+    TestNormals(directions);
+    TestTangents(directions);
+    TestUVs();
+    TestPositions();
+    TestEncodeMesh(VERTEX_FORMAT_COMPACT);
+    TestEncodeMesh(VERTEX_FORMAT_QUANTIZED);
+    return TestResult();
+}
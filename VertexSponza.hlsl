@@ -1,5 +1,19 @@
 #include "RootSignatureSponza.inc"
 
+// The layout is picked by VertexCodec::InputLayout, see VertexCodec.hpp for the packing
+#ifdef COMPACT_VERTEX
+struct VertexPosColor
+{
+#ifdef QUANTIZED_POSITION
+    float4 Position : POSITION;
+#else
+    float3 Position : POSITION;
+#endif
+    float2 Normal : NORMAL;
+    float4 Tangent : TANGENT;
+    float2 UV : UV;
+};
+#else
 struct VertexPosColor
 {
     float3 Position : POSITION;
@@ -8,15 +22,69 @@ struct VertexPosColor
     float3 Bitangent : BITANGENT;
     float2 UV : UV;
 };
+#endif
 
-struct ModelViewProjection
+// One per instance, see Scene::Prepare. The root view points at the first instance of the draw.
+struct InstanceData
 {
     matrix Model;
+};
+
+// Bound once per frame, see Scene::Prepare
+struct FrameConstants
+{
     matrix View;
     matrix Projection;
 };
 
-ConstantBuffer<ModelViewProjection> MVP_CB : register(b0);
+struct PositionDecode
+{
+    float4 Offset;
+    float4 Scale;
+};
+
+StructuredBuffer<InstanceData> Instances : register(t1);
+ConstantBuffer<PositionDecode> PositionDecodeCB : register(b1);
+ConstantBuffer<FrameConstants> FrameCB : register(b2);
+
+struct Vertex
+{
+    float3 Position;
+    float3 Normal;
+    float3 Tangent;
+    float3 Bitangent;
+    float2 UV;
+};
+
+float3 OctDecode(float2 e)
+{
+    float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy -= (step(0.0f, v.xy) * 2.0f - 1.0f) * t;
+    return normalize(v);
+}
+
+Vertex DecodeVertex(VertexPosColor IN)
+{
+    Vertex v;
+#ifdef COMPACT_VERTEX
+#ifdef QUANTIZED_POSITION
+    v.Position = PositionDecodeCB.Offset.xyz + IN.Position.xyz * PositionDecodeCB.Scale.xyz;
+#else
+    v.Position = IN.Position;
+#endif
+    v.Normal = OctDecode(IN.Normal);
+    v.Tangent = OctDecode(IN.Tangent.xy * 2.0f - 1.0f);
+    v.Bitangent = cross(v.Normal, v.Tangent) * (IN.Tangent.w * 2.0f - 1.0f);
+#else
+    v.Position = IN.Position;
+    v.Normal = IN.Normal;
+    v.Tangent = IN.Tangent;
+    v.Bitangent = IN.Bitangent;
+#endif
+    v.UV = IN.UV;
+    return v;
+}
 
 struct VertexShaderOutput
 {
@@ -27,15 +95,17 @@ struct VertexShaderOutput
 };
 
 [RootSignature(ROOT_SIGNATURE_SPONZA)]
-VertexShaderOutput main(VertexPosColor IN)
+VertexShaderOutput main(VertexPosColor IN, uint InstanceID : SV_InstanceID)
 {
+    Vertex vertex = DecodeVertex(IN);
+
     VertexShaderOutput OUT;
-    matrix MV = mul(MVP_CB.View, MVP_CB.Model);
-    matrix MVP = mul(MVP_CB.Projection, MV);
-    float4 view = mul(MV, float4(IN.Position, 1.0f));
-    OUT.ScreenPos = mul(MVP_CB.Projection, view);
+    matrix MV = mul(FrameCB.View, Instances[InstanceID].Model);
+    matrix MVP = mul(FrameCB.Projection, MV);
+    float4 view = mul(MV, float4(vertex.Position, 1.0f));
+    OUT.ScreenPos = mul(FrameCB.Projection, view);
     OUT.ViewPos = view.xyz;
-    OUT.Normal = mul(MV, float4(IN.Normal, 0.0f)).xyz;
-    OUT.uv = IN.UV;
+    OUT.Normal = mul(MV, float4(vertex.Normal, 0.0f)).xyz;
+    OUT.uv = vertex.UV;
     return OUT;
 }
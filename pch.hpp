@@ -4,6 +4,7 @@
 #include <chrono>
 #include <cmath>
 #include <codecvt>
+#include <cstring>
 #include <deque>
 #include <filesystem>
 #include <fstream>
@@ -11,14 +12,18 @@
 #include <ios>
 #include <iostream>
 #include <locale>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <optional>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
 
 #include <Windows.h>
 #include <wrl.h>
@@ -48,6 +53,7 @@ using PCommandAllocator    = ComPtr<ID3D12CommandAllocator>;
 using PCommandQueue        = ComPtr<ID3D12CommandQueue>;
 using PGraphicsCommandList = ComPtr<ID3D12GraphicsCommandList>;
 
+using PHeap          = ComPtr<ID3D12Heap>;
 using PPipelineState = ComPtr<ID3D12PipelineState>;
 using PResource      = ComPtr<ID3D12Resource>;
 using PRootSignature = ComPtr<ID3D12RootSignature>;